@@ -0,0 +1,159 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file arm_math.cpp
+ *
+ * Portable reference implementations of the CMSIS DSP matrix functions
+ * used by mathlib, so that mathlib can be linked on the host.
+ *
+ * The target links the optimized versions from libarm_cortexM4lf_math.a,
+ * so absolute host timings of these functions are only indicative.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <mathlib/CMSIS/Include/arm_math.h>
+
+arm_status arm_mat_mult_f32(const arm_matrix_instance_f32 *pSrcA,
+			    const arm_matrix_instance_f32 *pSrcB,
+			    arm_matrix_instance_f32 *pDst)
+{
+	if (pSrcA->numCols != pSrcB->numRows ||
+	    pSrcA->numRows != pDst->numRows ||
+	    pSrcB->numCols != pDst->numCols) {
+		return ARM_MATH_SIZE_MISMATCH;
+	}
+
+	for (unsigned i = 0; i < pSrcA->numRows; i++) {
+		for (unsigned j = 0; j < pSrcB->numCols; j++) {
+			float sum = 0.0f;
+
+			for (unsigned k = 0; k < pSrcA->numCols; k++) {
+				sum += pSrcA->pData[i * pSrcA->numCols + k] * pSrcB->pData[k * pSrcB->numCols + j];
+			}
+
+			pDst->pData[i * pDst->numCols + j] = sum;
+		}
+	}
+
+	return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_mat_trans_f32(const arm_matrix_instance_f32 *pSrc,
+			     arm_matrix_instance_f32 *pDst)
+{
+	if (pSrc->numRows != pDst->numCols || pSrc->numCols != pDst->numRows) {
+		return ARM_MATH_SIZE_MISMATCH;
+	}
+
+	for (unsigned i = 0; i < pSrc->numRows; i++) {
+		for (unsigned j = 0; j < pSrc->numCols; j++) {
+			pDst->pData[j * pDst->numCols + i] = pSrc->pData[i * pSrc->numCols + j];
+		}
+	}
+
+	return ARM_MATH_SUCCESS;
+}
+
+/**
+ * Gauss-Jordan elimination with partial pivoting.
+ *
+ * Like the CMSIS version the source matrix is used as scratch space.
+ */
+arm_status arm_mat_inverse_f32(const arm_matrix_instance_f32 *src,
+			       arm_matrix_instance_f32 *dst)
+{
+	const unsigned n = src->numRows;
+
+	if (src->numRows != src->numCols || dst->numRows != n || dst->numCols != n) {
+		return ARM_MATH_SIZE_MISMATCH;
+	}
+
+	float *a = src->pData;
+	float *inv = dst->pData;
+
+	for (unsigned i = 0; i < n; i++) {
+		for (unsigned j = 0; j < n; j++) {
+			inv[i * n + j] = (i == j) ? 1.0f : 0.0f;
+		}
+	}
+
+	for (unsigned c = 0; c < n; c++) {
+		/* find pivot */
+		unsigned p = c;
+
+		for (unsigned r = c + 1; r < n; r++) {
+			if (fabsf(a[r * n + c]) > fabsf(a[p * n + c])) {
+				p = r;
+			}
+		}
+
+		if (a[p * n + c] == 0.0f) {
+			return ARM_MATH_SINGULAR;
+		}
+
+		if (p != c) {
+			for (unsigned j = 0; j < n; j++) {
+				float t = a[c * n + j];
+				a[c * n + j] = a[p * n + j];
+				a[p * n + j] = t;
+				t = inv[c * n + j];
+				inv[c * n + j] = inv[p * n + j];
+				inv[p * n + j] = t;
+			}
+		}
+
+		float d = 1.0f / a[c * n + c];
+
+		for (unsigned j = 0; j < n; j++) {
+			a[c * n + j] *= d;
+			inv[c * n + j] *= d;
+		}
+
+		for (unsigned r = 0; r < n; r++) {
+			if (r == c) {
+				continue;
+			}
+
+			float f = a[r * n + c];
+
+			for (unsigned j = 0; j < n; j++) {
+				a[r * n + j] -= f * a[c * n + j];
+				inv[r * n + j] -= f * inv[c * n + j];
+			}
+		}
+	}
+
+	return ARM_MATH_SUCCESS;
+}
@@ -0,0 +1,313 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file bench.cpp
+ *
+ * Minimal host benchmark framework.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <systemlib/err.h>
+
+#include "bench.h"
+
+#define BENCH_MAX_OPS		256
+#define BENCH_MAX_RUNS		100
+#define BENCH_TITLE_LEN		80
+
+struct bench_result {
+	char	title[BENCH_TITLE_LEN];
+	double	mean;		/**< mean ns/op over all runs */
+	double	stddev;		/**< standard deviation of ns/op over all runs */
+	double	min;		/**< fastest run in ns/op */
+};
+
+static unsigned		_iterations = 60000;
+static unsigned		_runs = 15;
+static const char	*_output_file = nullptr;
+static const char	*_compare_file = nullptr;
+static float		_tolerance = 10.0f;
+static const char	*_filter = nullptr;
+
+static bench_result	_results[BENCH_MAX_OPS];
+static unsigned		_num_results;
+
+static bench_result	*_current;
+static double		_samples[BENCH_MAX_RUNS];
+static unsigned		_run;
+static bool		_skip;
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "usage: %s [-n iterations] [-r runs] [-o baseline_out] [-c baseline_in] [-t tolerance_percent] [-f filter]\n",
+		progname);
+}
+
+int
+bench_init(int argc, char *argv[])
+{
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:r:o:c:t:f:h")) != EOF) {
+		switch (ch) {
+		case 'n':
+			_iterations = strtoul(optarg, nullptr, 0);
+			break;
+
+		case 'r':
+			_runs = strtoul(optarg, nullptr, 0);
+			break;
+
+		case 'o':
+			_output_file = optarg;
+			break;
+
+		case 'c':
+			_compare_file = optarg;
+			break;
+
+		case 't':
+			_tolerance = strtof(optarg, nullptr);
+			break;
+
+		case 'f':
+			_filter = optarg;
+			break;
+
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (_iterations < 1 || _runs < 1 || _runs > BENCH_MAX_RUNS) {
+		warnx("iterations must be > 0, runs 1..%u", BENCH_MAX_RUNS);
+		return -1;
+	}
+
+	printf("%-50s %12s %12s %12s\n", "operation", "mean ns/op", "stddev", "min ns/op");
+	return 0;
+}
+
+uint64_t
+bench_time_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+bench_begin(const char *title)
+{
+	_run = 0;
+	_skip = (_filter != nullptr && strstr(title, _filter) == nullptr) || _num_results >= BENCH_MAX_OPS;
+
+	if (_skip) {
+		_current = nullptr;
+		return;
+	}
+
+	_current = &_results[_num_results];
+	strncpy(_current->title, title, sizeof(_current->title) - 1);
+	_current->title[sizeof(_current->title) - 1] = '\0';
+}
+
+unsigned
+bench_iterations()
+{
+	return _skip ? 0 : _iterations;
+}
+
+void
+bench_sample(uint64_t elapsed_ns)
+{
+	if (!_skip) {
+		_samples[_run] = (double)elapsed_ns / _iterations;
+	}
+}
+
+bool
+bench_next_run()
+{
+	if (_skip) {
+		return false;
+	}
+
+	return ++_run < _runs;
+}
+
+void
+bench_end()
+{
+	if (_skip) {
+		return;
+	}
+
+	double sum = 0.0;
+	double min = _samples[0];
+
+	for (unsigned i = 0; i < _runs; i++) {
+		sum += _samples[i];
+
+		if (_samples[i] < min) {
+			min = _samples[i];
+		}
+	}
+
+	double mean = sum / _runs;
+	double var = 0.0;
+
+	for (unsigned i = 0; i < _runs; i++) {
+		var += (_samples[i] - mean) * (_samples[i] - mean);
+	}
+
+	_current->mean = mean;
+	_current->stddev = (_runs > 1) ? sqrt(var / (_runs - 1)) : 0.0;
+	_current->min = min;
+	_num_results++;
+
+	printf("%-50s %12.2f %12.2f %12.2f\n", _current->title, _current->mean, _current->stddev, _current->min);
+}
+
+static const bench_result *
+find_result(const char *title)
+{
+	for (unsigned i = 0; i < _num_results; i++) {
+		if (strcmp(_results[i].title, title) == 0) {
+			return &_results[i];
+		}
+	}
+
+	return nullptr;
+}
+
+/*
+ * Baseline format: one operation per line,
+ * "<mean>\t<stddev>\t<min>\t<title>", title last as it may contain spaces and commas.
+ */
+static int
+write_baseline(const char *path)
+{
+	FILE *fp = fopen(path, "w");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return -1;
+	}
+
+	for (unsigned i = 0; i < _num_results; i++) {
+		fprintf(fp, "%.3f\t%.3f\t%.3f\t%s\n", _results[i].mean, _results[i].stddev, _results[i].min, _results[i].title);
+	}
+
+	fclose(fp);
+	warnx("baseline written to %s (%u operations)", path, _num_results);
+	return 0;
+}
+
+static int
+compare_baseline(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return -1;
+	}
+
+	char line[BENCH_TITLE_LEN + 64];
+	unsigned compared = 0;
+	unsigned regressions = 0;
+
+	printf("\n%-50s %12s %12s %8s\n", "operation", "base min", "min", "change");
+
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		double mean, stddev, min;
+		int title_offset = 0;
+
+		if (sscanf(line, "%lf\t%lf\t%lf\t%n", &mean, &stddev, &min, &title_offset) != 3 || title_offset == 0) {
+			continue;
+		}
+
+		char *title = &line[title_offset];
+		title[strcspn(title, "\r\n")] = '\0';
+
+		const bench_result *res = find_result(title);
+
+		if (res == nullptr || min <= 0.0) {
+			continue;
+		}
+
+		/* compare the fastest runs, they are least affected by scheduling noise */
+		double change = (res->min - min) / min * 100.0;
+		bool regressed = change > _tolerance;
+
+		printf("%-50s %12.2f %12.2f %+7.1f%%%s\n", title, min, res->min, change, regressed ? "  REGRESSION" : "");
+
+		compared++;
+
+		if (regressed) {
+			regressions++;
+		}
+	}
+
+	fclose(fp);
+
+	warnx("compared %u operations against %s, %u regressions (tolerance %.1f%%)",
+	      compared, path, regressions, (double)_tolerance);
+
+	return (regressions > 0) ? 1 : 0;
+}
+
+int
+bench_finish()
+{
+	int ret = 0;
+
+	if (_output_file != nullptr && write_baseline(_output_file) != 0) {
+		ret = 1;
+	}
+
+	if (_compare_file != nullptr && compare_baseline(_compare_file) != 0) {
+		ret = 1;
+	}
+
+	return ret;
+}
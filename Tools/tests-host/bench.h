@@ -0,0 +1,144 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file bench.h
+ *
+ * Minimal host benchmark framework.
+ *
+ * Each benchmarked operation is executed in a number of runs of a fixed
+ * number of iterations. The per-operation time of every run is recorded,
+ * and mean, standard deviation and minimum over all runs are reported in
+ * nanoseconds per operation.
+ *
+ * Results can be written to a baseline file and later compared against it,
+ * so that performance regressions in shared code are caught on a
+ * workstation before they reach the hardware.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Prevent the compiler from optimizing away a benchmarked result.
+ */
+template <typename T>
+inline void bench_keep(const T &value)
+{
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * Benchmark an expression.
+ *
+ * The result of the expression is kept alive so that it is not
+ * eliminated as dead code by the optimizer.
+ */
+#define BENCH_OP(_title, ...) { \
+		bench_begin(_title); \
+		do { \
+			uint64_t _t0 = bench_time_ns(); \
+			for (unsigned _j = 0; _j < bench_iterations(); _j++) { bench_keep(__VA_ARGS__); } \
+			bench_sample(bench_time_ns() - _t0); \
+		} while (bench_next_run()); \
+		bench_end(); \
+	}
+
+/**
+ * Benchmark a statement or block that does not yield a value.
+ */
+#define BENCH_STMT(_title, ...) { \
+		bench_begin(_title); \
+		do { \
+			uint64_t _t0 = bench_time_ns(); \
+			for (unsigned _j = 0; _j < bench_iterations(); _j++) { __VA_ARGS__; asm volatile("" : : : "memory"); } \
+			bench_sample(bench_time_ns() - _t0); \
+		} while (bench_next_run()); \
+		bench_end(); \
+	}
+
+/**
+ * Parse the common benchmark command line options.
+ *
+ *   -n <iterations>	iterations per run (default 60000)
+ *   -r <runs>		number of runs per operation (default 15)
+ *   -o <file>		write results as a baseline to file
+ *   -c <file>		compare results against a baseline file
+ *   -t <percent>	allowed slowdown against the baseline (default 10)
+ *   -f <filter>	only run operations whose title contains filter
+ *
+ * @return		0 on success, -1 on invalid options
+ */
+int	bench_init(int argc, char *argv[]);
+
+/**
+ * Finish the benchmark session.
+ *
+ * Writes the baseline file if requested and compares against a baseline.
+ *
+ * @return		0 if no regression was detected, 1 otherwise
+ */
+int	bench_finish();
+
+/**
+ * Monotonic time in nanoseconds.
+ */
+uint64_t bench_time_ns();
+
+/**
+ * Start a new benchmarked operation.
+ */
+void	bench_begin(const char *title);
+
+/**
+ * Record the duration of one run of the current operation.
+ */
+void	bench_sample(uint64_t elapsed_ns);
+
+/**
+ * Advance to the next run.
+ *
+ * @return		true if another run of the current operation is due
+ */
+bool	bench_next_run();
+
+/**
+ * Report the current operation.
+ */
+void	bench_end();
+
+/**
+ * Number of iterations per run.
+ */
+unsigned bench_iterations();
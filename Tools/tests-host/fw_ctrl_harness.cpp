@@ -0,0 +1,754 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file fw_ctrl_harness.cpp
+ *
+ * Host harness for the fixed wing control stack.
+ *
+ * Runs the ECL roll, pitch and yaw controllers, the L1 position controller
+ * and TECS against the FixedWingSim dynamics model, called in the same
+ * order and at the same rates as fw_att_control and fw_pos_control_l1.
+ * Time is simulated (hrt_sim), so runs are deterministic and as fast as
+ * the host allows.
+ *
+ * The flight is given as a setpoint sequence, built in or read from a
+ * file (-s), one item per line:
+ *
+ *   start <north> <east> <alt> <airspeed> <heading_deg>
+ *   param <NAME> <value>			set a controller parameter
+ *   att <seconds> <roll_deg> <pitch_deg> <throttle>
+ *   wp <north> <east> <alt> [airspeed]
+ *   loiter <north> <east> <alt> <radius> <seconds>
+ *
+ * Reported are the per-call cost of each controller in flight and the
+ * tracking errors; the run fails if an error exceeds its limit. The trace of states, setpoints and outputs can be
+ * written (-o) and compared against an earlier trace (-c), to see the
+ * effect of a controller change before flying it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <float.h>
+#include <systemlib/err.h>
+#include <mathlib/mathlib.h>
+#include <ecl/attitude_fw/ecl_roll_controller.h>
+#include <ecl/attitude_fw/ecl_pitch_controller.h>
+#include <ecl/attitude_fw/ecl_yaw_controller.h>
+#include <ecl/l1/ecl_l1_pos_controller.h>
+#include <external_lgpl/tecs/tecs.h>
+
+#include "bench.h"
+#include "hrt_sim.h"
+#include "sim_trace.h"
+#include "fw_sim.h"
+
+/* simulation step and controller rates: 500 Hz dynamics, 250 Hz attitude, 50 Hz position */
+static const float	sim_dt = 0.002f;
+static const unsigned	att_divider = 2;
+static const unsigned	pos_divider = 10;
+static const unsigned	trace_divider = 50;
+
+/* waypoint acceptance radius, as the navigator default */
+static const float	acceptance_radius = 25.0f;
+
+/*
+ * Pass limits on the settled tracking errors. Deliberately loose, they
+ * catch a broken controller or model, not a worse tuning.
+ */
+static const float	max_att_rms = 5.0f;		/**< deg */
+static const float	max_xtrack_rms = 20.0f;		/**< m, waypoint legs */
+static const float	max_xtrack = 50.0f;		/**< m, waypoint legs */
+static const float	max_loiter_rms = 15.0f;		/**< m, distance from the loiter circle */
+static const float	max_alt_rms = 5.0f;		/**< m */
+static const float	max_spd_rms = 2.0f;		/**< m/s */
+static const float	max_sideslip = 5.0f;		/**< deg */
+
+/* errors are counted once the item has settled, a loiter captures its circle in about one L1 period */
+static const float	settle_wp = 10.0f;		/**< s */
+static const float	settle_loiter = 30.0f;		/**< s */
+
+/**
+ * Controller parameters, named and defaulted like the flight parameters
+ * except for the airspeeds and the cruise throttle, which match the
+ * simulated airframe.
+ */
+static struct {
+	const char	*name;
+	float		value;
+} params[] = {
+	{ "FW_ATT_TC",		0.5f },
+	{ "FW_PR_P",		0.05f },
+	{ "FW_PR_I",		0.0f },
+	{ "FW_P_RMAX_POS",	0.0f },
+	{ "FW_P_RMAX_NEG",	0.0f },
+	{ "FW_PR_IMAX",		0.2f },
+	{ "FW_P_ROLLFF",	0.0f },
+	{ "FW_RR_P",		0.05f },
+	{ "FW_RR_I",		0.0f },
+	{ "FW_RR_IMAX",		0.2f },
+	{ "FW_R_RMAX",		0.0f },
+	{ "FW_YR_P",		0.05f },
+	{ "FW_YR_I",		0.0f },
+	{ "FW_YR_IMAX",		0.2f },
+	{ "FW_Y_RMAX",		0.0f },
+	{ "FW_RR_FF",		0.3f },
+	{ "FW_PR_FF",		0.4f },
+	{ "FW_YR_FF",		0.3f },
+	{ "FW_YCO_VMIN",	1000.0f },
+	{ "FW_AIRSPD_MIN",	13.0f },
+	{ "FW_AIRSPD_TRIM",	18.0f },
+	{ "FW_AIRSPD_MAX",	30.0f },
+	{ "FW_L1_PERIOD",	25.0f },
+	{ "FW_L1_DAMPING",	0.75f },
+	{ "FW_THR_CRUISE",	0.35f },
+	{ "FW_P_LIM_MIN",	-45.0f },
+	{ "FW_P_LIM_MAX",	45.0f },
+	{ "FW_R_LIM",		45.0f },
+	{ "FW_THR_MAX",		1.0f },
+	{ "FW_THR_MIN",		0.0f },
+	{ "FW_T_CLMB_MAX",	5.0f },
+	{ "FW_T_SINK_MIN",	2.0f },
+	{ "FW_T_SINK_MAX",	5.0f },
+	{ "FW_T_TIME_CONST",	5.0f },
+	{ "FW_T_THR_DAMP",	0.5f },
+	{ "FW_T_INTEG_GAIN",	0.1f },
+	{ "FW_T_VERT_ACC",	7.0f },
+	{ "FW_T_HGT_OMEGA",	3.0f },
+	{ "FW_T_SPD_OMEGA",	2.0f },
+	{ "FW_T_RLL2THR",	10.0f },
+	{ "FW_T_SPDWEIGHT",	1.0f },
+	{ "FW_T_PTCH_DAMP",	0.0f },
+	{ "FW_T_HRATE_P",	0.05f },
+	{ "FW_T_SRATE_P",	0.05f },
+};
+
+static float *
+param_ptr(const char *name)
+{
+	for (unsigned i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+		if (strcmp(params[i].name, name) == 0) {
+			return &params[i].value;
+		}
+	}
+
+	return nullptr;
+}
+
+static float
+param(const char *name)
+{
+	float *p = param_ptr(name);
+
+	if (p == nullptr) {
+		errx(1, "unknown parameter %s", name);
+	}
+
+	return *p;
+}
+
+enum item_type {
+	ITEM_ATT,
+	ITEM_WP,
+	ITEM_LOITER
+};
+
+struct item {
+	item_type	type;
+	float		north;
+	float		east;
+	float		alt;
+	float		airspeed;
+	float		radius;
+	float		duration;
+	float		roll;
+	float		pitch;
+	float		throttle;
+};
+
+#define MAX_ITEMS	64
+
+static item	items[MAX_ITEMS];
+static unsigned	num_items;
+static float	start[5] = { 0.0f, 0.0f, 100.0f, 18.0f, 0.0f };
+
+/* attitude steps, then a climbing box and a loiter back at the start */
+static const char *default_sequence[] = {
+	"att 4 30 0 0.35",
+	"att 4 -30 0 0.35",
+	"att 4 0 10 0.7",
+	"att 4 0 0 0.35",
+	"wp 500 0 100",
+	"wp 500 500 130",
+	"wp 0 500 130",
+	"wp 0 0 100",
+	"loiter 0 0 100 80 60",
+};
+
+/**
+ * Parse one sequence line.
+ *
+ * @return		0 on success, -1 on a syntax error
+ */
+static int
+parse_line(const char *line)
+{
+	char cmd[16];
+	char name[32];
+	float v[5];
+	int n;
+
+	while (*line == ' ' || *line == '\t') {
+		line++;
+	}
+
+	if (*line == '\0' || *line == '\n' || *line == '#') {
+		return 0;
+	}
+
+	if (sscanf(line, "%15s", cmd) != 1) {
+		return -1;
+	}
+
+	if (strcmp(cmd, "param") == 0) {
+		float *p;
+
+		if (sscanf(line, "%*s %31s %f", name, &v[0]) != 2 || (p = param_ptr(name)) == nullptr) {
+			return -1;
+		}
+
+		*p = v[0];
+		return 0;
+	}
+
+	n = sscanf(line, "%*s %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4]);
+
+	if (strcmp(cmd, "start") == 0 && n == 5) {
+		memcpy(start, v, sizeof(start));
+		return 0;
+	}
+
+	if (num_items >= MAX_ITEMS) {
+		warnx("more than %u items", MAX_ITEMS);
+		return -1;
+	}
+
+	item &it = items[num_items];
+	memset(&it, 0, sizeof(it));
+
+	if (strcmp(cmd, "att") == 0 && n == 4) {
+		it.type = ITEM_ATT;
+		it.duration = v[0];
+		it.roll = math::radians(v[1]);
+		it.pitch = math::radians(v[2]);
+		it.throttle = v[3];
+
+	} else if (strcmp(cmd, "wp") == 0 && (n == 3 || n == 4)) {
+		it.type = ITEM_WP;
+		it.north = v[0];
+		it.east = v[1];
+		it.alt = v[2];
+		it.airspeed = (n == 4) ? v[3] : 0.0f;
+
+	} else if (strcmp(cmd, "loiter") == 0 && n == 5) {
+		it.type = ITEM_LOITER;
+		it.north = v[0];
+		it.east = v[1];
+		it.alt = v[2];
+		it.radius = v[3];
+		it.duration = v[4];
+
+	} else {
+		return -1;
+	}
+
+	num_items++;
+	return 0;
+}
+
+static int
+load_sequence(const char *path)
+{
+	if (path == nullptr) {
+		for (unsigned i = 0; i < sizeof(default_sequence) / sizeof(default_sequence[0]); i++) {
+			if (parse_line(default_sequence[i]) != 0) {
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	FILE *fp = fopen(path, "r");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return -1;
+	}
+
+	char line[128];
+	unsigned lineno = 0;
+	int ret = 0;
+
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		lineno++;
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (parse_line(line) != 0) {
+			warnx("%s:%u: invalid line: %s", path, lineno, line);
+			ret = -1;
+			break;
+		}
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+/**
+ * Cost of one controller call in flight.
+ */
+struct call_stats {
+	const char	*name;
+	unsigned	count;
+	double		sum_ns;
+	double		max_ns;
+};
+
+static call_stats	cost_att = { "attitude control cycle (roll, pitch, yaw)", 0, 0.0, 0.0 };
+static call_stats	cost_l1 = { "L1 navigate", 0, 0.0, 0.0 };
+static call_stats	cost_tecs_50hz = { "TECS update_50hz", 0, 0.0, 0.0 };
+static call_stats	cost_tecs = { "TECS update_pitch_throttle", 0, 0.0, 0.0 };
+
+static void
+cost_add(call_stats &c, uint64_t t0)
+{
+	double ns = (double)(bench_time_ns() - t0);
+	c.count++;
+	c.sum_ns += ns;
+
+	if (ns > c.max_ns) {
+		c.max_ns = ns;
+	}
+}
+
+static void
+cost_print(const call_stats &c)
+{
+	printf("%-50s %10u %12.1f %12.1f\n", c.name, c.count, (c.count > 0) ? c.sum_ns / c.count : 0.0, c.max_ns);
+}
+
+/*
+ * Trace, one row every trace_divider steps.
+ */
+#define TRACE_COLUMNS	16
+
+static const char *const trace_columns[TRACE_COLUMNS] = {
+	"t", "north", "east", "alt", "airspeed", "roll", "pitch", "yaw",
+	"roll_sp", "pitch_sp", "alt_sp", "airspeed_sp", "ail", "elev", "rud", "thr"
+};
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "usage: %s [-s sequence] [-o trace_out] [-c trace_in] [-t tolerance] [-T time_limit]\n", progname);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *sequence_file = nullptr;
+	const char *trace_out = nullptr;
+	const char *trace_in = nullptr;
+	float tolerance = 1e-3f;
+	float time_limit = 600.0f;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "s:o:c:t:T:h")) != EOF) {
+		switch (ch) {
+		case 's':
+			sequence_file = optarg;
+			break;
+
+		case 'o':
+			trace_out = optarg;
+			break;
+
+		case 'c':
+			trace_in = optarg;
+			break;
+
+		case 't':
+			tolerance = strtof(optarg, nullptr);
+			break;
+
+		case 'T':
+			time_limit = strtof(optarg, nullptr);
+			break;
+
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (load_sequence(sequence_file) != 0 || num_items == 0) {
+		errx(1, "no valid sequence");
+	}
+
+	/* controllers, configured like fw_att_control and fw_pos_control_l1 */
+	ECL_RollController roll_ctrl;
+	ECL_PitchController pitch_ctrl;
+	ECL_YawController yaw_ctrl;
+	ECL_L1_Pos_Controller l1;
+	TECS tecs;
+
+	pitch_ctrl.set_time_constant(param("FW_ATT_TC"));
+	pitch_ctrl.set_k_p(param("FW_PR_P"));
+	pitch_ctrl.set_k_i(param("FW_PR_I"));
+	pitch_ctrl.set_k_ff(param("FW_PR_FF"));
+	pitch_ctrl.set_integrator_max(param("FW_PR_IMAX"));
+	pitch_ctrl.set_max_rate_pos(math::radians(param("FW_P_RMAX_POS")));
+	pitch_ctrl.set_max_rate_neg(math::radians(param("FW_P_RMAX_NEG")));
+	pitch_ctrl.set_roll_ff(param("FW_P_ROLLFF"));
+
+	roll_ctrl.set_time_constant(param("FW_ATT_TC"));
+	roll_ctrl.set_k_p(param("FW_RR_P"));
+	roll_ctrl.set_k_i(param("FW_RR_I"));
+	roll_ctrl.set_k_ff(param("FW_RR_FF"));
+	roll_ctrl.set_integrator_max(param("FW_RR_IMAX"));
+	roll_ctrl.set_max_rate(math::radians(param("FW_R_RMAX")));
+
+	yaw_ctrl.set_k_p(param("FW_YR_P"));
+	yaw_ctrl.set_k_i(param("FW_YR_I"));
+	yaw_ctrl.set_k_ff(param("FW_YR_FF"));
+	yaw_ctrl.set_integrator_max(param("FW_YR_IMAX"));
+	yaw_ctrl.set_coordinated_min_speed(param("FW_YCO_VMIN"));
+	yaw_ctrl.set_max_rate(math::radians(param("FW_Y_RMAX")));
+
+	l1.set_l1_damping(param("FW_L1_DAMPING"));
+	l1.set_l1_period(param("FW_L1_PERIOD"));
+	l1.set_l1_roll_limit(math::radians(param("FW_R_LIM")));
+
+	tecs.set_time_const(param("FW_T_TIME_CONST"));
+	tecs.set_min_sink_rate(param("FW_T_SINK_MIN"));
+	tecs.set_max_sink_rate(param("FW_T_SINK_MAX"));
+	tecs.set_throttle_damp(param("FW_T_THR_DAMP"));
+	tecs.set_integrator_gain(param("FW_T_INTEG_GAIN"));
+	tecs.set_vertical_accel_limit(param("FW_T_VERT_ACC"));
+	tecs.set_height_comp_filter_omega(param("FW_T_HGT_OMEGA"));
+	tecs.set_speed_comp_filter_omega(param("FW_T_SPD_OMEGA"));
+	tecs.set_roll_throttle_compensation(param("FW_T_RLL2THR"));
+	tecs.set_speed_weight(param("FW_T_SPDWEIGHT"));
+	tecs.set_pitch_damping(param("FW_T_PTCH_DAMP"));
+	tecs.set_indicated_airspeed_min(param("FW_AIRSPD_MIN"));
+	tecs.set_indicated_airspeed_max(param("FW_AIRSPD_MAX"));
+	tecs.set_max_climb_rate(param("FW_T_CLMB_MAX"));
+	tecs.set_heightrate_p(param("FW_T_HRATE_P"));
+	tecs.set_speedrate_p(param("FW_T_SRATE_P"));
+	tecs.enable_airspeed(true);
+
+	const float airspeed_min = param("FW_AIRSPD_MIN");
+	const float airspeed_trim = param("FW_AIRSPD_TRIM");
+	const float airspeed_max = param("FW_AIRSPD_MAX");
+
+	FixedWingSim sim;
+	sim.reset(start[0], start[1], start[2], start[3], math::radians(start[4]));
+
+	/* start the simulated clock away from zero, the controllers treat zero as never run */
+	hrt_sim_set_time(1000000);
+	sim_trace_init(trace_columns, TRACE_COLUMNS);
+
+	float controls[4] = { 0.0f, 0.0f, 0.0f, start[3] > 0.0f ? param("FW_THR_CRUISE") : 0.0f };
+	float roll_sp = 0.0f;
+	float pitch_sp = 0.0f;
+	float throttle_sp = controls[3];
+	float alt_sp = start[2];
+	float airspeed_sp = airspeed_trim;
+
+	unsigned current = 0;
+	float item_start = 0.0f;
+	math::Vector<2> prev_wp(start[0], start[1]);
+
+	/* tracking errors */
+	double att_err_sq = 0.0;
+	unsigned att_err_n = 0;
+	double xtrack_sq = 0.0;
+	unsigned xtrack_n = 0;
+	float xtrack_max = 0.0f;
+	double loiter_sq = 0.0;
+	unsigned loiter_n = 0;
+	double alt_err_sq = 0.0;
+	double spd_err_sq = 0.0;
+	unsigned pos_err_n = 0;
+	float max_roll = 0.0f;
+	float max_beta = 0.0f;
+	bool failed = false;
+
+	uint64_t wall_start = bench_time_ns();
+	unsigned step = 0;
+	float t = 0.0f;
+
+	for (; current < num_items; step++) {
+		t = step * sim_dt;
+		const item &it = items[current];
+
+		if (t > time_limit) {
+			warnx("FAIL: time limit of %.0f s reached in item %u", (double)time_limit, current + 1);
+			failed = true;
+			break;
+		}
+
+		const math::Vector<3> &pos = sim.position();
+		const math::Vector<3> &vel = sim.velocity();
+		const math::Vector<3> &euler = sim.euler();
+		const math::Vector<3> &rates = sim.rates();
+		math::Vector<2> position(pos(0), pos(1));
+		math::Vector<2> ground_speed(vel(0), vel(1));
+		float airspeed = sim.airspeed();
+
+		if (!isfinite(pos(0)) || !isfinite(euler(0)) || sim.altitude() < 0.0f) {
+			warnx("FAIL: vehicle lost at t=%.2f s in item %u", (double)t, current + 1);
+			failed = true;
+			break;
+		}
+
+		/* position control at 50 Hz, as fw_pos_control_l1 */
+		if (it.type != ITEM_ATT && step % pos_divider == 0) {
+			math::Vector<2> curr_wp(it.north, it.east);
+			math::Vector<3> accel_body = sim.accel_body();
+			math::Vector<3> accel_earth = sim.R() * accel_body;
+
+			uint64_t t0 = bench_time_ns();
+			tecs.update_50hz(sim.altitude(), airspeed, sim.R(), accel_body, accel_earth);
+			cost_add(cost_tecs_50hz, t0);
+
+			t0 = bench_time_ns();
+
+			if (it.type == ITEM_WP) {
+				l1.navigate_waypoints_local(prev_wp, curr_wp, position, ground_speed);
+
+			} else {
+				l1.navigate_loiter_local(curr_wp, position, it.radius, 1, ground_speed);
+			}
+
+			cost_add(cost_l1, t0);
+
+			roll_sp = l1.nav_roll();
+			alt_sp = it.alt;
+			airspeed_sp = (it.airspeed > 0.0f) ? it.airspeed : airspeed_trim;
+
+			t0 = bench_time_ns();
+			tecs.update_pitch_throttle(sim.R(), euler(1), sim.altitude(), alt_sp, airspeed_sp,
+						   airspeed, 1.0f, false, math::radians(param("FW_P_LIM_MIN")),
+						   param("FW_THR_MIN"), param("FW_THR_MAX"), param("FW_THR_CRUISE"),
+						   math::radians(param("FW_P_LIM_MIN")), math::radians(param("FW_P_LIM_MAX")));
+			cost_add(cost_tecs, t0);
+
+			pitch_sp = tecs.get_pitch_demand();
+			throttle_sp = tecs.get_throttle_demand();
+
+			if (t - item_start > ((it.type == ITEM_WP) ? settle_wp : settle_loiter)) {
+				if (it.type == ITEM_WP) {
+					float xtrack = l1.crosstrack_error();
+					xtrack_sq += xtrack * xtrack;
+					xtrack_n++;
+
+					if (fabsf(xtrack) > xtrack_max) {
+						xtrack_max = fabsf(xtrack);
+					}
+
+				} else {
+					float e = (position - curr_wp).length() - it.radius;
+					loiter_sq += e * e;
+					loiter_n++;
+				}
+
+				math::Vector<3> v_body = sim.velocity_body();
+				float beta = (airspeed > 1.0f) ? fabsf(asinf(v_body(1) / airspeed)) : 0.0f;
+
+				if (beta > max_beta) {
+					max_beta = beta;
+				}
+
+				alt_err_sq += (sim.altitude() - alt_sp) * (sim.altitude() - alt_sp);
+				spd_err_sq += (airspeed - airspeed_sp) * (airspeed - airspeed_sp);
+				pos_err_n++;
+			}
+
+		} else if (it.type == ITEM_ATT) {
+			roll_sp = it.roll;
+			pitch_sp = it.pitch;
+			throttle_sp = it.throttle;
+			alt_sp = sim.altitude();
+			airspeed_sp = airspeed;
+
+			/* settled attitude error over the last second of the step */
+			if (t - item_start > it.duration - 1.0f) {
+				float e_roll = euler(0) - roll_sp;
+				float e_pitch = euler(1) - pitch_sp;
+				att_err_sq += e_roll * e_roll + e_pitch * e_pitch;
+				att_err_n += 2;
+			}
+		}
+
+		/* attitude control at 250 Hz, as fw_att_control */
+		if (step % att_divider == 0) {
+			float airspeed_scaling = airspeed_trim / ((airspeed < airspeed_min) ? airspeed_min : airspeed);
+			math::Vector<3> v_body = sim.velocity_body();
+
+			uint64_t t0 = bench_time_ns();
+
+			roll_ctrl.control_attitude(roll_sp, euler(0));
+			pitch_ctrl.control_attitude(pitch_sp, euler(0), euler(1), airspeed);
+			yaw_ctrl.control_attitude(euler(0), euler(1), v_body(0), v_body(1), v_body(2),
+						  roll_ctrl.get_desired_rate(), pitch_ctrl.get_desired_rate());
+
+			float roll_u = roll_ctrl.control_bodyrate(euler(1), rates(0), rates(2),
+					yaw_ctrl.get_desired_rate(), airspeed_min, airspeed_max, airspeed, airspeed_scaling, false);
+			float pitch_u = pitch_ctrl.control_bodyrate(euler(0), euler(1), rates(1), rates(2),
+					yaw_ctrl.get_desired_rate(), airspeed_min, airspeed_max, airspeed, airspeed_scaling, false);
+			float yaw_u = yaw_ctrl.control_bodyrate(euler(0), euler(1), rates(1), rates(2),
+								pitch_ctrl.get_desired_rate(), airspeed_min, airspeed_max, airspeed, airspeed_scaling, false);
+
+			cost_add(cost_att, t0);
+
+			controls[0] = isfinite(roll_u) ? roll_u : 0.0f;
+			controls[1] = isfinite(pitch_u) ? pitch_u : 0.0f;
+			controls[2] = isfinite(yaw_u) ? yaw_u : 0.0f;
+			controls[3] = isfinite(throttle_sp) ? throttle_sp : 0.0f;
+		}
+
+		if (fabsf(euler(0)) > max_roll) {
+			max_roll = fabsf(euler(0));
+		}
+
+		if (step % trace_divider == 0) {
+			float row[TRACE_COLUMNS] = {
+				t, pos(0), pos(1), sim.altitude(), airspeed, euler(0), euler(1), euler(2),
+				roll_sp, pitch_sp, alt_sp, airspeed_sp, controls[0], controls[1], controls[2], controls[3]
+			};
+			sim_trace_add(row);
+		}
+
+		sim.update(controls, sim_dt);
+		hrt_sim_advance((hrt_abstime)(sim_dt * 1e6f + 0.5f));
+
+		/* advance the sequence */
+		bool done = false;
+
+		switch (it.type) {
+		case ITEM_ATT:
+		case ITEM_LOITER:
+			done = (t - item_start >= it.duration);
+			break;
+
+		case ITEM_WP: {
+				math::Vector<2> to_wp = math::Vector<2>(it.north, it.east) - position;
+				done = (to_wp.length() < math::max(acceptance_radius, l1.switch_distance(acceptance_radius)));
+				break;
+			}
+		}
+
+		if (done) {
+			if (it.type != ITEM_ATT) {
+				prev_wp = math::Vector<2>(it.north, it.east);
+
+			} else {
+				prev_wp = position;
+			}
+
+			current++;
+			item_start = t;
+		}
+	}
+
+	double wall_s = (bench_time_ns() - wall_start) * 1e-9;
+
+	printf("%-50s %10s %12s %12s\n", "controller", "calls", "mean ns", "max ns");
+	cost_print(cost_att);
+	cost_print(cost_l1);
+	cost_print(cost_tecs_50hz);
+	cost_print(cost_tecs);
+
+	float att_rms = (att_err_n > 0) ? math::degrees(sqrtf(att_err_sq / att_err_n)) : 0.0f;
+	float xtrack_rms = (xtrack_n > 0) ? sqrtf(xtrack_sq / xtrack_n) : 0.0f;
+	float loiter_rms = (loiter_n > 0) ? sqrtf(loiter_sq / loiter_n) : 0.0f;
+	float alt_rms = (pos_err_n > 0) ? sqrtf(alt_err_sq / pos_err_n) : 0.0f;
+	float spd_rms = (pos_err_n > 0) ? sqrtf(spd_err_sq / pos_err_n) : 0.0f;
+
+	printf("\nflew %u of %u items in %.1f s simulated, %.3f s wall clock (%.0fx real time)\n",
+	       current, num_items, (double)t, wall_s, (double)t / wall_s);
+	printf("attitude error RMS %.2f deg (settled), max roll %.1f deg, max sideslip %.1f deg\n",
+	       (double)att_rms, (double)math::degrees(max_roll), (double)math::degrees(max_beta));
+	printf("crosstrack RMS %.2f m (max %.1f m), loiter radius RMS %.2f m, altitude RMS %.2f m, airspeed RMS %.2f m/s\n",
+	       (double)xtrack_rms, (double)xtrack_max, (double)loiter_rms, (double)alt_rms, (double)spd_rms);
+
+	struct {
+		const char	*name;
+		float		value;
+		float		limit;
+	} const limits[] = {
+		{ "attitude error RMS", att_rms, max_att_rms },
+		{ "crosstrack RMS", xtrack_rms, max_xtrack_rms },
+		{ "max crosstrack", xtrack_max, max_xtrack },
+		{ "loiter radius RMS", loiter_rms, max_loiter_rms },
+		{ "altitude RMS", alt_rms, max_alt_rms },
+		{ "airspeed RMS", spd_rms, max_spd_rms },
+		{ "max sideslip", math::degrees(max_beta), max_sideslip },
+	};
+
+	for (unsigned i = 0; i < sizeof(limits) / sizeof(limits[0]); i++) {
+		if (!(limits[i].value <= limits[i].limit)) {
+			warnx("FAIL: %s %.2f above %.2f", limits[i].name, (double)limits[i].value, (double)limits[i].limit);
+			failed = true;
+		}
+	}
+
+	int ret = failed ? 1 : 0;
+
+	if (trace_out != nullptr && sim_trace_write(trace_out) != 0) {
+		ret = 1;
+	}
+
+	if (trace_in != nullptr && sim_trace_compare(trace_in, tolerance) != 0) {
+		ret = 1;
+	}
+
+	sim_trace_free();
+	return ret;
+}
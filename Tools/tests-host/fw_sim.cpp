@@ -0,0 +1,154 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file fw_sim.cpp
+ *
+ * Simple fixed wing flight dynamics model for host controller harnesses.
+ */
+
+#include "fw_sim.h"
+
+#include <math.h>
+
+static const float	rho = 1.225f;		/**< air density, kg/m^3 */
+static const float	g = 9.80665f;
+static const float	v_prop_max = 40.0f;	/**< airspeed at which the thrust has dropped to zero */
+
+FixedWingSim::FixedWingSim() :
+	_airspeed(0.0f),
+	_alpha(0.0f)
+{
+	_af.mass = 2.5f;
+	_af.wing_area = 0.6f;
+	_af.cl0 = 0.25f;
+	_af.cl_alpha = 4.5f;
+	_af.cl_max = 1.2f;
+	_af.cl_q = 6.0f;
+	_af.chord = 0.25f;
+	_af.cd0 = 0.03f;
+	_af.cd_k = 0.05f;
+	_af.cy_beta = -0.3f;
+	_af.thrust_max = 20.0f;
+	_af.v_ref = 18.0f;
+	_af.roll_ctrl = 20.0f;
+	_af.roll_damp = 6.0f;
+	_af.pitch_ctrl = 25.0f;
+	_af.pitch_damp = 8.0f;
+	_af.pitch_stab = 8.0f;
+	_af.alpha_trim = 0.0f;
+	_af.yaw_ctrl = 10.0f;
+	_af.yaw_damp = 2.0f;
+	_af.yaw_stab = 40.0f;
+
+	reset(0.0f, 0.0f, 100.0f, _af.v_ref, 0.0f);
+}
+
+void
+FixedWingSim::reset(float north, float east, float alt, float airspeed, float heading)
+{
+	/* angle of attack for level flight at this airspeed */
+	float cl = _af.mass * g / (0.5f * rho * airspeed * airspeed * _af.wing_area);
+	float alpha = (cl - _af.cl0) / _af.cl_alpha;
+
+	_pos = math::Vector<3>(north, east, -alt);
+	_vel = math::Vector<3>(airspeed * cosf(heading), airspeed * sinf(heading), 0.0f);
+	_q.from_euler(0.0f, alpha, heading);
+	_rates.zero();
+
+	_update_outputs();
+}
+
+void
+FixedWingSim::update(const float controls[4], float dt)
+{
+	math::Vector<3> v_body = _R.transposed() * _vel;
+	float v = v_body.length();
+	float alpha = 0.0f;
+	float beta = 0.0f;
+
+	if (v > 1.0f) {
+		alpha = atan2f(v_body(2), v_body(0));
+		beta = asinf(v_body(1) / v);
+	}
+
+	/* aerodynamic forces in the body frame */
+	float qs = 0.5f * rho * v * v * _af.wing_area;
+	float q_hat = (v > 1.0f) ? _rates(1) * _af.chord / (2.0f * v) : 0.0f;
+	float cl = math::constrain(_af.cl0 + _af.cl_alpha * alpha + _af.cl_q * q_hat, -_af.cl_max, _af.cl_max);
+	float lift = qs * cl;
+	float drag = qs * (_af.cd0 + _af.cd_k * cl * cl);
+	float side = qs * _af.cy_beta * beta;
+
+	float throttle = math::constrain(controls[3], 0.0f, 1.0f);
+	float thrust = _af.thrust_max * throttle * math::max(1.0f - v / v_prop_max, 0.0f);
+
+	math::Vector<3> force(lift * sinf(alpha) - drag * cosf(alpha) + thrust,
+			      side,
+			      -lift * cosf(alpha) - drag * sinf(alpha));
+	_accel_body = force / _af.mass;
+
+	math::Vector<3> accel = _R * _accel_body;
+	accel(2) += g;
+
+	/* rate dynamics, control power with dynamic pressure, damping with airspeed */
+	float s = v / _af.v_ref;
+	float n = s * s;
+	float ail = math::constrain(controls[0], -1.0f, 1.0f);
+	float elev = math::constrain(controls[1], -1.0f, 1.0f);
+	float rud = math::constrain(controls[2], -1.0f, 1.0f);
+
+	math::Vector<3> rates_dot(_af.roll_ctrl * n * ail - _af.roll_damp * s * _rates(0),
+				  _af.pitch_ctrl * n * elev - _af.pitch_damp * s * _rates(1) - _af.pitch_stab * n * (alpha - _af.alpha_trim),
+				  _af.yaw_ctrl * n * rud - _af.yaw_damp * s * _rates(2) + _af.yaw_stab * n * beta);
+
+	/* explicit Euler, the harness steps at 500 Hz or faster */
+	_pos += _vel * dt;
+	_vel += accel * dt;
+	_q += _q.derivative(_rates) * dt;
+	_q.normalize();
+	_rates += rates_dot * dt;
+
+	_update_outputs();
+}
+
+void
+FixedWingSim::_update_outputs()
+{
+	_R = _q.to_dcm();
+	_euler = _R.to_euler();
+
+	math::Vector<3> v_body = _R.transposed() * _vel;
+	_airspeed = v_body.length();
+	_alpha = (_airspeed > 1.0f) ? atan2f(v_body(2), v_body(0)) : 0.0f;
+}
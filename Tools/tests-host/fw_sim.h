@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file fw_sim.h
+ *
+ * Simple fixed wing flight dynamics model for host controller harnesses.
+ *
+ * Rigid body with lift and drag from a linear lift curve and a parabolic
+ * drag polar, sideslip force, propeller thrust along the body x axis and
+ * first order rate dynamics for the three control surfaces, scaled with
+ * dynamic pressure. No wind, flat earth, constant air density.
+ *
+ * The directional stability is much stiffer than the yaw damping, so the
+ * nose follows the flight path with a small sideslip and a banked vehicle
+ * turns at the coordinated rate g tan(roll) / V. The pitch rate of the
+ * turn adds lift through cl_q.
+ *
+ * Conventions follow the estimator outputs: NED earth frame, FRD body
+ * frame, body rates in rad/s. Positive surface deflections command
+ * positive body rates.
+ */
+
+#pragma once
+
+#include <mathlib/mathlib.h>
+
+class FixedWingSim
+{
+public:
+	/** airframe constants, default is a 2.5 kg trainer */
+	struct Airframe {
+		float	mass;		/**< kg */
+		float	wing_area;	/**< m^2 */
+		float	cl0;		/**< lift coefficient at zero angle of attack */
+		float	cl_alpha;	/**< lift curve slope, 1/rad */
+		float	cl_max;		/**< stall lift coefficient */
+		float	cl_q;		/**< lift increment with the normalized pitch rate q c / 2V */
+		float	chord;		/**< mean aerodynamic chord, m */
+		float	cd0;		/**< zero lift drag coefficient */
+		float	cd_k;		/**< induced drag factor */
+		float	cy_beta;	/**< side force slope, 1/rad */
+		float	thrust_max;	/**< static thrust at full throttle, N */
+		float	v_ref;		/**< reference airspeed of the rate dynamics, m/s */
+		float	roll_ctrl;	/**< roll acceleration per unit aileron at v_ref, rad/s^2 */
+		float	roll_damp;	/**< roll rate damping at v_ref, 1/s */
+		float	pitch_ctrl;	/**< pitch acceleration per unit elevator at v_ref */
+		float	pitch_damp;	/**< pitch rate damping at v_ref */
+		float	pitch_stab;	/**< pitch stiffness in angle of attack at v_ref, 1/s^2 */
+		float	alpha_trim;	/**< angle of attack with zero elevator, rad */
+		float	yaw_ctrl;	/**< yaw acceleration per unit rudder at v_ref */
+		float	yaw_damp;	/**< yaw rate damping at v_ref */
+		float	yaw_stab;	/**< weathercock stability in sideslip at v_ref, 1/s^2 */
+	};
+
+	FixedWingSim();
+
+	/**
+	 * Start in level flight.
+	 *
+	 * @param north		position, m
+	 * @param east		position, m
+	 * @param alt		altitude above the origin, m
+	 * @param airspeed	m/s
+	 * @param heading	rad
+	 */
+	void	reset(float north, float east, float alt, float airspeed, float heading);
+
+	/**
+	 * Integrate the model over one step.
+	 *
+	 * @param controls	roll, pitch, yaw in -1..1 and throttle in 0..1
+	 * @param dt		step in seconds
+	 */
+	void	update(const float controls[4], float dt);
+
+	Airframe &airframe() { return _af; }
+
+	const math::Vector<3> &position() const { return _pos; }
+	const math::Vector<3> &velocity() const { return _vel; }
+	const math::Matrix<3, 3> &R() const { return _R; }
+	const math::Vector<3> &rates() const { return _rates; }
+	const math::Vector<3> &euler() const { return _euler; }
+
+	/** specific force in the body frame, as measured by an accelerometer */
+	const math::Vector<3> &accel_body() const { return _accel_body; }
+
+	float	altitude() const { return -_pos(2); }
+	float	airspeed() const { return _airspeed; }
+	float	alpha() const { return _alpha; }
+
+	/** body frame velocity */
+	math::Vector<3> velocity_body() const { return _R.transposed() * _vel; }
+
+private:
+	Airframe		_af;
+
+	math::Vector<3>		_pos;
+	math::Vector<3>		_vel;
+	math::Quaternion	_q;
+	math::Vector<3>		_rates;
+
+	/* outputs derived from the state */
+	math::Matrix<3, 3>	_R;
+	math::Vector<3>		_euler;
+	math::Vector<3>		_accel_body;
+	float			_airspeed;
+	float			_alpha;
+
+	void	_update_outputs();
+};
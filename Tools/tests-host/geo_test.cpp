@@ -0,0 +1,335 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file geo_test.cpp
+ *
+ * Host accuracy test and benchmark of the single precision great circle
+ * functions in lib/geo.
+ *
+ * The results are compared against the same spherical formulas evaluated
+ * in long double, across latitudes, headings and distances from one meter
+ * to a few hundred kilometers. The previous double precision implementation
+ * is kept here as reference and benchmarked side by side; note that on the
+ * host double is native, the gain on the Cortex-M4 (double emulated in
+ * software) is much larger than shown here.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <systemlib/err.h>
+#include <geo/geo.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+typedef long double ld;
+
+static const ld	deg_to_rad_l = 3.14159265358979323846264338327950288L / 180.0L;
+
+/*
+ * Ground truth: the spherical formulas in extended precision.
+ */
+static ld
+ref_distance(ld lat_now, ld lon_now, ld lat_next, ld lon_next)
+{
+	ld lat_now_rad = lat_now * deg_to_rad_l;
+	ld lat_next_rad = lat_next * deg_to_rad_l;
+	ld d_lat = (lat_next - lat_now) * deg_to_rad_l;
+	ld d_lon = (lon_next - lon_now) * deg_to_rad_l;
+
+	ld a = sinl(d_lat / 2) * sinl(d_lat / 2) + sinl(d_lon / 2) * sinl(d_lon / 2) * cosl(lat_now_rad) * cosl(lat_next_rad);
+	return CONSTANTS_RADIUS_OF_EARTH * 2 * atan2l(sqrtl(a), sqrtl(1 - a));
+}
+
+static void
+ref_vector(ld lat_now, ld lon_now, ld lat_next, ld lon_next, ld *v_n, ld *v_e)
+{
+	ld lat_now_rad = lat_now * deg_to_rad_l;
+	ld lat_next_rad = lat_next * deg_to_rad_l;
+	ld d_lon = (lon_next - lon_now) * deg_to_rad_l;
+
+	*v_n = CONSTANTS_RADIUS_OF_EARTH * (cosl(lat_now_rad) * sinl(lat_next_rad) - sinl(lat_now_rad) * cosl(lat_next_rad) * cosl(d_lon));
+	*v_e = CONSTANTS_RADIUS_OF_EARTH * sinl(d_lon) * cosl(lat_next_rad);
+}
+
+static void
+ref_project(ld lat_0, ld lon_0, ld lat, ld lon, ld *x, ld *y)
+{
+	ld c = ref_distance(lat_0, lon_0, lat, lon) / CONSTANTS_RADIUS_OF_EARTH;
+	ld k = (c == 0) ? 1 : c / sinl(c);
+	ld v_n, v_e;
+
+	ref_vector(lat_0, lon_0, lat, lon, &v_n, &v_e);
+	*x = k * v_n;
+	*y = k * v_e;
+}
+
+/*
+ * The double precision implementation replaced by the single precision one.
+ */
+static float
+double_distance(double lat_now, double lon_now, double lat_next, double lon_next)
+{
+	double lat_now_rad = lat_now / 180.0 * M_PI;
+	double lon_now_rad = lon_now / 180.0 * M_PI;
+	double lat_next_rad = lat_next / 180.0 * M_PI;
+	double lon_next_rad = lon_next / 180.0 * M_PI;
+
+	double d_lat = lat_next_rad - lat_now_rad;
+	double d_lon = lon_next_rad - lon_now_rad;
+
+	double a = sin(d_lat / 2.0) * sin(d_lat / 2.0) + sin(d_lon / 2.0) * sin(d_lon / 2.0) * cos(lat_now_rad) * cos(lat_next_rad);
+	double c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
+
+	return CONSTANTS_RADIUS_OF_EARTH * c;
+}
+
+static float
+double_bearing(double lat_now, double lon_now, double lat_next, double lon_next)
+{
+	double lat_now_rad = lat_now * M_DEG_TO_RAD;
+	double lon_now_rad = lon_now * M_DEG_TO_RAD;
+	double lat_next_rad = lat_next * M_DEG_TO_RAD;
+	double lon_next_rad = lon_next * M_DEG_TO_RAD;
+
+	double d_lon = lon_next_rad - lon_now_rad;
+
+	return atan2f(sin(d_lon) * cos(lat_next_rad), cos(lat_now_rad) * sin(lat_next_rad) - sin(lat_now_rad) * cos(lat_next_rad) * cos(d_lon));
+}
+
+static void
+double_project(const struct map_projection_reference_s *ref, double lat, double lon, float *x, float *y)
+{
+	double lat_rad = lat / 180.0 * M_PI;
+	double lon_rad = lon / 180.0 * M_PI;
+
+	double sin_lat = sin(lat_rad);
+	double cos_lat = cos(lat_rad);
+	double cos_d_lon = cos(lon_rad - ref->lon);
+
+	double c = acos(ref->sin_lat * sin_lat + ref->cos_lat * cos_lat * cos_d_lon);
+	double k = (c == 0.0) ? 1.0 : (c / sin(c));
+
+	*x = k * (ref->cos_lat * sin_lat - ref->sin_lat * cos_lat * cos_d_lon) * CONSTANTS_RADIUS_OF_EARTH;
+	*y = k * cos_lat * sin(lon_rad - ref->lon) * CONSTANTS_RADIUS_OF_EARTH;
+}
+
+struct error_stats {
+	const char	*name;
+	double		max_abs;	/**< max absolute error, m or rad */
+	double		max_rel;	/**< max error relative to the distance */
+};
+
+static void
+record(struct error_stats *s, double err, double dist)
+{
+	err = fabs(err);
+
+	if (err > s->max_abs) {
+		s->max_abs = err;
+	}
+
+	if (dist > 0.0 && err / dist > s->max_rel) {
+		s->max_rel = err / dist;
+	}
+}
+
+static void
+report(const struct error_stats *s, const char *unit)
+{
+	printf("%-36s max abs %10.3g %-3s max rel %10.3g\n", s->name, s->max_abs, unit, s->max_rel);
+}
+
+/*
+ * Sweep start latitude, heading and distance and compare against the
+ * extended precision reference.
+ */
+static void
+test_accuracy()
+{
+	struct error_stats dist = { "get_distance_to_next_waypoint", 0, 0 };
+	struct error_stats dist_d = { "  (double implementation)", 0, 0 };
+	struct error_stats vec = { "get_vector_to_next_waypoint", 0, 0 };
+	struct error_stats bearing = { "get_bearing_to_next_waypoint", 0, 0 };
+	struct error_stats bearing_d = { "  (double implementation)", 0, 0 };
+	struct error_stats proj = { "map_projection_project", 0, 0 };
+	struct error_stats proj_d = { "  (double implementation)", 0, 0 };
+
+	static const double distances[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 500000.0 };
+
+	for (double lat_0 = -80.0; lat_0 <= 80.0; lat_0 += 10.0) {
+		/* a non-round reference position, as a GPS fix would be */
+		double lat_now = lat_0 + 0.1234567;
+		double lon_now = 8.5455938 + lat_0;
+
+		struct map_projection_reference_s ref;
+		map_projection_init(&ref, lat_now, lon_now);
+
+		for (unsigned i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+			for (double heading = 0.0; heading < 360.0; heading += 15.0) {
+				double d = distances[i];
+				double hdg = heading * M_DEG_TO_RAD;
+				double lat_next = lat_now + d * cos(hdg) / CONSTANTS_RADIUS_OF_EARTH * M_RAD_TO_DEG;
+				double lon_next = lon_now + d * sin(hdg) / (CONSTANTS_RADIUS_OF_EARTH * cos(lat_now * M_DEG_TO_RAD)) * M_RAD_TO_DEG;
+
+				ld r_dist = ref_distance(lat_now, lon_now, lat_next, lon_next);
+				ld r_n, r_e;
+				ref_vector(lat_now, lon_now, lat_next, lon_next, &r_n, &r_e);
+				ld r_bearing = atan2l(r_e, r_n);
+				ld r_x, r_y;
+				ref_project(lat_now, lon_now, lat_next, lon_next, &r_x, &r_y);
+
+				record(&dist, get_distance_to_next_waypoint(lat_now, lon_now, lat_next, lon_next) - r_dist, r_dist);
+				record(&dist_d, double_distance(lat_now, lon_now, lat_next, lon_next) - r_dist, r_dist);
+
+				float v_n, v_e;
+				get_vector_to_next_waypoint(lat_now, lon_now, lat_next, lon_next, &v_n, &v_e);
+				/* the vector is scaled by sin(c), compare relative to its length */
+				record(&vec, hypotl(v_n - r_n, v_e - r_e), hypotl(r_n, r_e));
+
+				/* bearing error in rad, relative to the angle subtended by one meter */
+				ld b_err = remainderl(get_bearing_to_next_waypoint(lat_now, lon_now, lat_next, lon_next) - r_bearing, 2 * M_PI);
+				ld b_err_d = remainderl(double_bearing(lat_now, lon_now, lat_next, lon_next) - r_bearing, 2 * M_PI);
+				record(&bearing, b_err * r_dist, r_dist);
+				record(&bearing_d, b_err_d * r_dist, r_dist);
+
+				float x, y;
+				map_projection_project(&ref, lat_next, lon_next, &x, &y);
+				record(&proj, hypotl(x - r_x, y - r_y), r_dist);
+				double_project(&ref, lat_next, lon_next, &x, &y);
+				record(&proj_d, hypotl(x - r_x, y - r_y), r_dist);
+			}
+		}
+	}
+
+	printf("\nerror against extended precision, distances 1 m .. 500 km, latitudes -80 .. 80 deg\n");
+	report(&dist, "m");
+	report(&dist_d, "m");
+	report(&vec, "m");
+	report(&bearing, "m");
+	report(&bearing_d, "m");
+	report(&proj, "m");
+	report(&proj_d, "m");
+	printf("(bearing errors are given as the lateral offset at the target)\n\n");
+
+	/* bounds documented in geo.h: 0.5 mm per km of distance */
+	CHECK(dist.max_rel < 5e-7);
+	CHECK(vec.max_rel < 5e-7);
+	CHECK(bearing.max_rel < 5e-7);
+	CHECK(proj.max_rel < 5e-7);
+}
+
+/*
+ * Special positions: identical points, the date line and near the poles.
+ */
+static void
+test_special()
+{
+	CHECK(get_distance_to_next_waypoint(47.3977419, 8.5455938, 47.3977419, 8.5455938) == 0.0f);
+
+	float x = 1.0f, y = 1.0f;
+	struct map_projection_reference_s ref;
+	map_projection_init(&ref, 47.3977419, 8.5455938);
+	map_projection_project(&ref, 47.3977419, 8.5455938, &x, &y);
+	CHECK(fabsf(x) < 1e-6f && fabsf(y) < 1e-6f);
+
+	/* crossing the date line is a short hop east, not around the globe */
+	float d = get_distance_to_next_waypoint(0.0, 179.9999, 0.0, -179.9999);
+	CHECK(fabsf(d - (float)ref_distance(0.0, 179.9999, 0.0, 180.0001)) < 0.01f);
+	float b = get_bearing_to_next_waypoint(0.0, 179.9999, 0.0, -179.9999);
+	CHECK(fabsf(b - M_PI_2_F) < 1e-4f);
+
+	/* round trip through the projection */
+	double lat, lon;
+	map_projection_project(&ref, 47.40, 8.55, &x, &y);
+	map_projection_reproject(&ref, x, y, &lat, &lon);
+	CHECK(fabs(lat - 47.40) < 1e-7 && fabs(lon - 8.55) < 1e-7);
+
+	/* close to the pole */
+	d = get_distance_to_next_waypoint(89.999, 0.0, 89.999, 90.0);
+	CHECK(fabsf(d - (float)ref_distance(89.999, 0.0, 89.999, 90.0)) < 0.01f);
+}
+
+static void
+bench()
+{
+	struct map_projection_reference_s ref;
+	map_projection_init(&ref, 47.3977419, 8.5455938);
+
+	volatile double lat = 47.3989419;
+	volatile double lon = 8.5460938;
+	float x, y;
+
+	BENCH_OP("distance float", get_distance_to_next_waypoint(47.3977419, 8.5455938, lat, lon));
+	BENCH_OP("distance double (previous)", double_distance(47.3977419, 8.5455938, lat, lon));
+	BENCH_OP("bearing float", get_bearing_to_next_waypoint(47.3977419, 8.5455938, lat, lon));
+	BENCH_OP("bearing double (previous)", double_bearing(47.3977419, 8.5455938, lat, lon));
+	BENCH_STMT("project float", map_projection_project(&ref, lat, lon, &x, &y));
+	BENCH_STMT("project double (previous)", double_project(&ref, lat, lon, &x, &y));
+}
+
+int
+main(int argc, char *argv[])
+{
+	warnx("geo: single precision great circle functions");
+
+	if (bench_init(argc, argv) != 0) {
+		return 1;
+	}
+
+	test_special();
+	test_accuracy();
+	bench();
+
+	int ret = bench_finish();
+
+	if (failures > 0) {
+		warnx("%u checks FAILED", failures);
+		return 1;
+	}
+
+	warnx("all checks passed");
+	return ret;
+}
@@ -0,0 +1,370 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file hrt_queue_test.cpp
+ *
+ * Host test and benchmark of the HRT callout queue.
+ *
+ * The queue is checked against random insert/cancel sequences and a
+ * model of the HRT dispatcher, and its re-arm cost is compared with the
+ * sorted list it replaced at increasing numbers of registered callouts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <systemlib/err.h>
+#include <drivers/drv_hrt.h>
+#include <stm32/hrt_queue.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static struct hrt_queue	queue;
+static struct hrt_call	calls[HRT_QUEUE_MAX];
+
+/*
+ * Pop everything and check the deadlines come out in order.
+ */
+static unsigned
+drain_in_order()
+{
+	unsigned popped = 0;
+	hrt_abstime last = 0;
+	struct hrt_call *call;
+
+	while ((call = hrt_queue_pop(&queue)) != nullptr) {
+		CHECK(call->deadline >= last);
+		CHECK(!hrt_queue_contains(&queue, call));
+		last = call->deadline;
+		popped++;
+	}
+
+	return popped;
+}
+
+static void
+test_order()
+{
+	hrt_queue_init(&queue);
+	CHECK(hrt_queue_peek(&queue) == nullptr);
+	CHECK(hrt_queue_pop(&queue) == nullptr);
+
+	/* descending deadlines, every insert becomes the new head */
+	for (unsigned i = 0; i < HRT_QUEUE_MAX; i++) {
+		calls[i].deadline = 1000 * (HRT_QUEUE_MAX - i);
+		CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+		CHECK(hrt_queue_peek(&queue) == &calls[i]);
+	}
+
+	CHECK(drain_in_order() == HRT_QUEUE_MAX);
+
+	/* equal deadlines are all delivered */
+	for (unsigned i = 0; i < 8; i++) {
+		calls[i].deadline = 5000;
+		CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+	}
+
+	CHECK(drain_in_order() == 8);
+}
+
+static void
+test_random()
+{
+	bool queued[HRT_QUEUE_MAX] = {};
+	unsigned count = 0;
+
+	hrt_queue_init(&queue);
+	srand(1);
+
+	for (unsigned step = 0; step < 100000; step++) {
+		unsigned i = rand() % HRT_QUEUE_MAX;
+
+		if (queued[i]) {
+			/* cancel, or re-arm like hrt_call_internal() */
+			hrt_queue_remove(&queue, &calls[i]);
+			queued[i] = false;
+			count--;
+
+			if (rand() & 1) {
+				calls[i].deadline = 1 + rand() % 100000;
+				CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+				queued[i] = true;
+				count++;
+			}
+
+		} else {
+			calls[i].deadline = 1 + rand() % 100000;
+			CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+			queued[i] = true;
+			count++;
+		}
+
+		CHECK(queue.count == count);
+
+		/* the head is the earliest queued deadline */
+		if (step % 97 == 0) {
+			hrt_abstime earliest = 0;
+
+			for (unsigned j = 0; j < HRT_QUEUE_MAX; j++) {
+				CHECK(hrt_queue_contains(&queue, &calls[j]) == queued[j]);
+
+				if (queued[j] && (earliest == 0 || calls[j].deadline < earliest))
+					earliest = calls[j].deadline;
+			}
+
+			CHECK(count == 0 || hrt_queue_peek(&queue)->deadline == earliest);
+		}
+	}
+
+	CHECK(drain_in_order() == count);
+}
+
+static void
+test_uninitialised()
+{
+	struct hrt_call garbage;
+
+	hrt_queue_init(&queue);
+	calls[0].deadline = 1;
+	CHECK(hrt_queue_insert(&queue, &calls[0]) == 0);
+
+	/* an entry that was never initialised claims some slot, it must not be acted on */
+	memset(&garbage, 0xa5, sizeof(garbage));
+	CHECK(!hrt_queue_contains(&queue, &garbage));
+	hrt_queue_remove(&queue, &garbage);
+
+	garbage.queue_index = 0;
+	CHECK(!hrt_queue_contains(&queue, &garbage));
+	hrt_queue_remove(&queue, &garbage);
+
+	CHECK(queue.count == 1);
+	CHECK(hrt_queue_peek(&queue) == &calls[0]);
+
+	/* removing twice is harmless */
+	hrt_queue_remove(&queue, &calls[0]);
+	hrt_queue_remove(&queue, &calls[0]);
+	CHECK(queue.count == 0);
+}
+
+static void
+test_overflow()
+{
+	struct hrt_call extra;
+
+	hrt_queue_init(&queue);
+
+	for (unsigned i = 0; i < HRT_QUEUE_MAX; i++) {
+		calls[i].deadline = i + 1;
+		CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+	}
+
+	extra.deadline = 1;
+	CHECK(hrt_queue_insert(&queue, &extra) == -ENOSPC);
+	CHECK(queue.overflows == 1);
+	CHECK(!hrt_queue_contains(&queue, &extra));
+	CHECK(hrt_queue_peek(&queue) == &calls[0]);
+}
+
+/*
+ * Model of hrt_call_invoke(): periodic callouts run in deadline order
+ * and are re-entered at their next period, some cancel their neighbour.
+ */
+static unsigned	fired[HRT_QUEUE_MAX];
+
+static void
+test_dispatch()
+{
+	const unsigned ncalls = 16;
+	const hrt_abstime start = hrt_absolute_time();
+	const hrt_abstime duration = 1000000;
+
+	hrt_queue_init(&queue);
+	memset(fired, 0, sizeof(fired));
+
+	for (unsigned i = 0; i < ncalls; i++) {
+		calls[i].deadline = start + 1000;
+		calls[i].period = 1000 * (i + 1);
+		calls[i].arg = (void *)(uintptr_t)i;
+		CHECK(hrt_queue_insert(&queue, &calls[i]) == 0);
+	}
+
+	hrt_abstime now = start;
+	hrt_abstime last = 0;
+
+	while (now < start + duration) {
+		now += 250;
+
+		struct hrt_call *call;
+
+		while ((call = hrt_queue_peek(&queue)) != nullptr && call->deadline <= now) {
+			hrt_queue_pop(&queue);
+			CHECK(call->deadline >= last);
+			last = call->deadline;
+
+			hrt_abstime deadline = call->deadline;
+			call->deadline = 0;
+			fired[(uintptr_t)call->arg]++;
+
+			if (call->period != 0) {
+				call->deadline = deadline + call->period;
+				CHECK(hrt_queue_insert(&queue, call) == 0);
+			}
+		}
+	}
+
+	/* every call ran once per period over the simulated second */
+	for (unsigned i = 0; i < ncalls; i++) {
+		CHECK(fired[i] == (duration - 1000) / calls[i].period + 1);
+	}
+}
+
+/*
+ * The sorted singly linked list the queue replaced, for comparison.
+ */
+struct list_call {
+	list_call	*next;
+	hrt_abstime	deadline;
+};
+
+static list_call	*list_head;
+
+static void
+list_enter(list_call *entry)
+{
+	list_call **link = &list_head;
+
+	while (*link != nullptr && (*link)->deadline <= entry->deadline)
+		link = &(*link)->next;
+
+	entry->next = *link;
+	*link = entry;
+}
+
+static void
+list_rem(list_call *entry)
+{
+	for (list_call **link = &list_head; *link != nullptr; link = &(*link)->next) {
+		if (*link == entry) {
+			*link = entry->next;
+			return;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("HRT callout queue test started");
+
+	test_order();
+	test_random();
+	test_uninitialised();
+	test_overflow();
+	test_dispatch();
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	/* cost of re-arming a callout, as hrt_call_every()/hrt_call_internal() do */
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	static list_call list_calls[HRT_QUEUE_MAX];
+	const unsigned sizes[] = { 4, 16, HRT_QUEUE_MAX };
+
+	for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		const unsigned n = sizes[s];
+		char title[50];
+		unsigned k = 0;
+		hrt_abstime t = 0;
+
+		hrt_queue_init(&queue);
+		list_head = nullptr;
+
+		for (unsigned i = 0; i < n; i++) {
+			calls[i].deadline = list_calls[i].deadline = 1 + (i * 7919) % 10007;
+			hrt_queue_insert(&queue, &calls[i]);
+			list_enter(&list_calls[i]);
+		}
+
+		/* re-arm the callouts in turn with a deadline later than all others */
+		snprintf(title, sizeof(title), "hrt queue re-arm, %u callouts", n);
+		BENCH_STMT(title, {
+			struct hrt_call *c = &calls[k++ % n];
+			hrt_queue_remove(&queue, c);
+			c->deadline = 20000 + t++;
+			hrt_queue_insert(&queue, c);
+		});
+
+		snprintf(title, sizeof(title), "sorted list re-arm, %u callouts", n);
+		k = 0;
+		t = 0;
+		BENCH_STMT(title, {
+			list_call *c = &list_calls[k++ % n];
+			list_rem(c);
+			c->deadline = 20000 + t++;
+			list_enter(c);
+		});
+
+		/* dispatch the earliest callout and re-enter it one period later */
+		snprintf(title, sizeof(title), "hrt queue dispatch periodic, %u callouts", n);
+		BENCH_STMT(title, {
+			struct hrt_call *c = hrt_queue_pop(&queue);
+			c->deadline += 1000 + (k++ % n);
+			hrt_queue_insert(&queue, c);
+		});
+
+		snprintf(title, sizeof(title), "sorted list dispatch periodic, %u callouts", n);
+		BENCH_STMT(title, {
+			list_call *c = list_head;
+			list_head = c->next;
+			c->deadline += 1000 + (k++ % n);
+			list_enter(c);
+		});
+	}
+
+	return bench_finish();
+}
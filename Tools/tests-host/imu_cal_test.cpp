@@ -0,0 +1,377 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file imu_cal_test.cpp
+ *
+ * Host test and benchmark of the accumulators, rest detection and six
+ * position solve used by the accelerometer and gyro calibration.
+ *
+ * The six position solve is compared against the previous one, kept here
+ * as reference, which took the transform from three of the six
+ * orientations only.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <systemlib/err.h>
+#include <modules/commander/calibration_routines.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static const float	one_g = 9.80665f;
+
+/* approximately normal distributed noise with standard deviation sigma */
+static float
+noise(float sigma)
+{
+	float sum = 0.0f;
+
+	for (unsigned i = 0; i < 12; i++) {
+		sum += (float)rand() / (float)RAND_MAX;
+	}
+
+	return (sum - 6.0f) * sigma;
+}
+
+/*
+ * The previous solve: offsets from the diagonal of the pairs, the
+ * transform from the positive orientations only.
+ */
+static int
+legacy_solve(const float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g)
+{
+	for (int i = 0; i < 3; i++) {
+		accel_offs[i] = (accel_ref[i * 2][i] + accel_ref[i * 2 + 1][i]) / 2;
+	}
+
+	float a[3][3];
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			a[i][j] = accel_ref[i * 2][j] - accel_offs[j];
+		}
+	}
+
+	float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+		    a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+		    a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+
+	if (det == 0.0f) {
+		return 1;
+	}
+
+	/* only the diagonal of the inverse is compared */
+	accel_T[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) / det * g;
+	accel_T[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) / det * g;
+	accel_T[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) / det * g;
+
+	return 0;
+}
+
+static void
+test_stats()
+{
+	/* accelerometer at rest: large mean, small variance */
+	const unsigned count = 100000;
+	const float sigma = 0.05f;
+	static float samples[count];
+	struct calibration_stats_s stats, first, second;
+
+	srand(1);
+	calibration_stats_reset(&stats);
+	calibration_stats_reset(&first);
+	calibration_stats_reset(&second);
+
+	double sum = 0.0;
+
+	for (unsigned i = 0; i < count; i++) {
+		samples[i] = -one_g + 0.3f + noise(sigma);
+		sum += samples[i];
+		calibration_stats_add(&stats, samples[i], 0.0f, 1.0f);
+		calibration_stats_add((i < count / 3) ? &first : &second, samples[i], 0.0f, 1.0f);
+	}
+
+	double mean = sum / count;
+	double m2 = 0.0;
+
+	for (unsigned i = 0; i < count; i++) {
+		m2 += (samples[i] - mean) * (samples[i] - mean);
+	}
+
+	double var = m2 / (count - 1);
+
+	calibration_stats_merge(&first, &second);
+
+	printf("stats, %u samples: mean error %.2e, variance error %.3f%%, merged %.3f%%\n", count,
+	       fabs(stats.mean[0] - mean), fabs(calibration_stats_variance(&stats) - var) / var * 100.0,
+	       fabs(calibration_stats_variance(&first) - var) / var * 100.0);
+
+	CHECK(stats.count == count);
+	CHECK(fabs(stats.mean[0] - mean) < 1e-4);
+	CHECK(fabs(calibration_stats_variance(&stats) - var) / var < 0.01);
+	CHECK(stats.mean[2] == 1.0f && stats.m2[2] == 0.0f);
+	CHECK(first.count == count);
+	CHECK(fabs(first.mean[0] - mean) < 1e-4);
+	CHECK(fabs(calibration_stats_variance(&first) - var) / var < 0.01);
+
+	/* merging into or from empty statistics */
+	struct calibration_stats_s empty;
+	calibration_stats_reset(&empty);
+	calibration_stats_merge(&first, &empty);
+	CHECK(first.count == count);
+	calibration_stats_merge(&empty, &stats);
+	CHECK(empty.count == count && empty.mean[0] == stats.mean[0]);
+	calibration_stats_reset(&empty);
+	CHECK(calibration_stats_variance(&empty) == 0.0f);
+}
+
+static void
+test_still_detector()
+{
+	struct still_detector_s det;
+	const float threshold = 0.25f * 0.25f;
+	still_detector_init(&det, 250000, threshold);
+
+	srand(2);
+	uint64_t t = 0;
+	int last = 0;
+	unsigned windows = 0;
+
+	/* 1 s at rest at 1 kHz: four still windows */
+	for (unsigned i = 0; i < 1000; i++, t += 1000) {
+		int ret = still_detector_add(&det, t, noise(0.05f), noise(0.05f), -one_g + noise(0.05f));
+
+		if (ret != 0) {
+			CHECK(ret > 0);
+			last = ret;
+			windows++;
+		}
+	}
+
+	CHECK(windows >= 3 && windows <= 4);
+	CHECK(last == (int)windows);
+	CHECK(fabsf(det.mean[2] + one_g) < 0.02f);
+
+	/* slightly noisier than the threshold while at rest: undecided, keeps the count */
+	unsigned undecided = 0;
+
+	for (unsigned i = 0; i < 500; i++, t += 1000) {
+		int ret = still_detector_add(&det, t, noise(0.35f), 0.0f, -one_g);
+
+		if (ret == STILL_DETECTOR_UNDECIDED) {
+			undecided++;
+
+		} else if (ret != 0) {
+			/* the window still holding samples at rest */
+			CHECK(ret > 0);
+			windows = ret;
+		}
+	}
+
+	CHECK(undecided > 0);
+	CHECK(det.still_windows == windows);
+
+	/* shaking: motion, once a window is mostly made of it */
+	last = 0;
+
+	for (unsigned i = 0; i < 500; i++, t += 1000) {
+		int ret = still_detector_add(&det, t, noise(1.0f), 0.0f, -one_g);
+
+		if (ret != 0) {
+			last = ret;
+		}
+	}
+
+	CHECK(last < 0);
+	CHECK(det.still_windows == 0);
+
+	/* slightly noisier than the threshold while not at rest: not still */
+	for (unsigned i = 0; i < 500; i++, t += 1000) {
+		CHECK(still_detector_add(&det, t, noise(0.35f), 0.0f, -one_g) <= 0);
+	}
+}
+
+/*
+ * Measure the six orientations of an accelerometer with offsets, scale
+ * errors and cross coupling, averaging n noisy samples each.
+ */
+static void
+measure_orientations(const float raw_T[3][3], const float offs[3], unsigned n, float sigma, float ref[6][3])
+{
+	for (unsigned o = 0; o < 6; o++) {
+		float g[3] = { 0.0f, 0.0f, 0.0f };
+		g[o / 2] = (o % 2 == 0) ? one_g : -one_g;
+
+		struct calibration_stats_s stats;
+		calibration_stats_reset(&stats);
+
+		for (unsigned k = 0; k < n; k++) {
+			float m[3];
+
+			for (unsigned i = 0; i < 3; i++) {
+				m[i] = offs[i] + raw_T[i][0] * g[0] + raw_T[i][1] * g[1] + raw_T[i][2] * g[2] + noise(sigma);
+			}
+
+			calibration_stats_add(&stats, m[0], m[1], m[2]);
+		}
+
+		memcpy(ref[o], stats.mean, sizeof(ref[o]));
+	}
+}
+
+static void
+test_accel_solve()
+{
+	/* raw = raw_T * accel + offs */
+	const float raw_T[3][3] = {
+		{ 1.03f, 0.01f, -0.02f },
+		{ -0.01f, 0.97f, 0.015f },
+		{ 0.02f, 0.0f, 1.05f }
+	};
+	const float offs[3] = { 0.4f, -0.25f, 0.8f };
+	float ref[6][3];
+
+	/* noiseless: exact */
+	measure_orientations(raw_T, offs, 1, 0.0f, ref);
+
+	float T[3][3], o[3];
+	CHECK(accel_calibration_solve(ref, T, o, one_g) == 0);
+
+	/* T must invert raw_T */
+	float err = 0.0f;
+
+	for (unsigned i = 0; i < 3; i++) {
+		CHECK(fabsf(o[i] - offs[i]) < 1e-4f);
+
+		for (unsigned j = 0; j < 3; j++) {
+			float p = T[i][0] * raw_T[0][j] + T[i][1] * raw_T[1][j] + T[i][2] * raw_T[2][j];
+			err = fmaxf(err, fabsf(p - ((i == j) ? 1.0f : 0.0f)));
+		}
+	}
+
+	CHECK(err < 1e-4f);
+
+	/* noisy: offsets and scales against the previous solve, over many trials */
+	srand(3);
+	const unsigned trials = 200;
+	double offs_err = 0.0, offs_err_legacy = 0.0;
+	double scale_err = 0.0, scale_err_legacy = 0.0;
+
+	for (unsigned t = 0; t < trials; t++) {
+		measure_orientations(raw_T, offs, 50, 0.3f, ref);
+
+		float Tl[3][3], ol[3];
+		CHECK(accel_calibration_solve(ref, T, o, one_g) == 0);
+		CHECK(legacy_solve(ref, Tl, ol, one_g) == 0);
+
+		for (unsigned i = 0; i < 3; i++) {
+			/* true diagonal of raw_T^-1, to first order */
+			float scale = 1.0f / raw_T[i][i];
+			offs_err += (o[i] - offs[i]) * (o[i] - offs[i]);
+			offs_err_legacy += (ol[i] - offs[i]) * (ol[i] - offs[i]);
+			scale_err += (T[i][i] - scale) * (T[i][i] - scale);
+			scale_err_legacy += (Tl[i][i] - scale) * (Tl[i][i] - scale);
+		}
+	}
+
+	offs_err = sqrt(offs_err / (3 * trials));
+	offs_err_legacy = sqrt(offs_err_legacy / (3 * trials));
+	scale_err = sqrt(scale_err / (3 * trials));
+	scale_err_legacy = sqrt(scale_err_legacy / (3 * trials));
+
+	printf("six position solve: offset RMS error %.4f m/s^2 (previous %.4f), scale RMS error %.5f (previous %.5f)\n",
+	       offs_err, offs_err_legacy, scale_err, scale_err_legacy);
+
+	CHECK(offs_err < offs_err_legacy);
+	CHECK(scale_err < 0.005);
+
+	/* degenerate measurements are rejected */
+	memset(ref, 0, sizeof(ref));
+	CHECK(accel_calibration_solve(ref, T, o, one_g) != 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (bench_init(argc, argv) != 0) {
+		return 1;
+	}
+
+	test_stats();
+	test_still_detector();
+	test_accel_solve();
+
+	struct calibration_stats_s stats;
+	calibration_stats_reset(&stats);
+	float x = 0.1f;
+	BENCH_STMT("calibration_stats_add", calibration_stats_add(&stats, x, -x, 9.81f); x = -x);
+
+	struct calibration_stats_s other = stats;
+	BENCH_STMT("calibration_stats_merge", calibration_stats_merge(&stats, &other));
+
+	struct still_detector_s det;
+	still_detector_init(&det, 250000, 0.25f * 0.25f);
+	uint64_t t = 0;
+	BENCH_STMT("still_detector_add", still_detector_add(&det, t, x, -x, 9.81f); t += 1000; x = -x);
+
+	float ref[6][3] = {
+		{ 9.9f, 0.1f, 0.2f }, { -9.7f, 0.1f, 0.3f },
+		{ 0.1f, 9.8f, 0.2f }, { 0.0f, -9.8f, 0.1f },
+		{ 0.2f, 0.1f, 10.0f }, { 0.1f, 0.2f, -9.6f }
+	};
+	float T[3][3], o[3];
+	BENCH_OP("accel_calibration_solve", accel_calibration_solve(ref, T, o, one_g));
+
+	int ret = bench_finish();
+
+	if (failures > 0) {
+		warnx("%u checks FAILED", failures);
+		return 1;
+	}
+
+	warnx("all checks passed");
+	return ret;
+}
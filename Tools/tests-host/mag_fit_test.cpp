@@ -0,0 +1,295 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mag_fit_test.cpp
+ *
+ * Host accuracy test and benchmark of the incremental ellipsoid fit used
+ * by the magnetometer calibration.
+ *
+ * Synthetic magnetometer data is generated from a known hard iron offset,
+ * per axis scale and a small soft iron rotation, with noise. The fit is
+ * checked against the ground truth and against the batch sphere fit it
+ * replaces, and data that only covers a plane must not be reported as
+ * covering enough directions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <systemlib/err.h>
+#include <modules/commander/calibration_routines.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* ground truth of the synthetic sensor, in Gauss */
+static const float	true_offset[3] = { 0.12f, -0.31f, 0.07f };
+static const float	true_gain[3] = { 1.08f, 0.93f, 0.99f };
+static const float	field = 0.5f;
+static const float	noise = 0.003f;
+
+static float
+randf()
+{
+	return (float)rand() / (float)RAND_MAX;
+}
+
+/*
+ * Measure the field in a random (or planar) attitude: the unit vector is
+ * scaled by the per axis gain, rotated slightly about x (soft iron
+ * cross coupling) and offset, then noise is added.
+ */
+static void
+measure(bool planar, float m[3])
+{
+	float v[3];
+
+	if (planar) {
+		float a = randf() * 2.0f * (float)M_PI;
+		v[0] = cosf(a);
+		v[1] = sinf(a);
+		v[2] = 0.2f;
+
+	} else {
+		float u = randf() * 2.0f - 1.0f;
+		float a = randf() * 2.0f * (float)M_PI;
+		float s = sqrtf(1.0f - u * u);
+		v[0] = s * cosf(a);
+		v[1] = s * sinf(a);
+		v[2] = u;
+	}
+
+	float g[3];
+
+	for (unsigned i = 0; i < 3; i++) {
+		g[i] = v[i] * field * true_gain[i];
+	}
+
+	const float c = cosf(0.03f);
+	const float s = sinf(0.03f);
+	m[0] = g[0];
+	m[1] = c * g[1] - s * g[2];
+	m[2] = s * g[1] + c * g[2];
+
+	for (unsigned i = 0; i < 3; i++) {
+		m[i] += true_offset[i] + (randf() - 0.5f) * 2.0f * noise;
+	}
+}
+
+static void
+test_ellipsoid(unsigned count)
+{
+	static ellipsoid_fit_s fit;
+	float *x = new float[count];
+	float *y = new float[count];
+	float *z = new float[count];
+
+	srand(1);
+	ellipsoid_fit_init(&fit);
+
+	for (unsigned i = 0; i < count; i++) {
+		float m[3];
+		measure(false, m);
+		x[i] = m[0];
+		y[i] = m[1];
+		z[i] = m[2];
+		ellipsoid_fit_add(&fit, m[0], m[1], m[2]);
+	}
+
+	float center[3], scale[3], radius, residual;
+	CHECK(ellipsoid_fit_solve(&fit, false, center, scale, &radius, &residual) == 0);
+
+	/* the returned scales are normalized, their product is one */
+	float gain_mean = cbrtf(true_gain[0] * true_gain[1] * true_gain[2]);
+	float offset_err = 0.0f;
+	float scale_err = 0.0f;
+
+	for (unsigned i = 0; i < 3; i++) {
+		offset_err = fmaxf(offset_err, fabsf(center[i] - true_offset[i]));
+		scale_err = fmaxf(scale_err, fabsf(scale[i] * true_gain[i] / gain_mean - 1.0f));
+	}
+
+	float sx, sy, sz, sr;
+	CHECK(sphere_fit_least_squares(x, y, z, count, 100, 0.0f, &sx, &sy, &sz, &sr) == 0);
+	float sphere_err = fmaxf(fabsf(sx - true_offset[0]), fmaxf(fabsf(sy - true_offset[1]), fabsf(sz - true_offset[2])));
+
+	printf("ellipsoid, %u points: offset error %.4f (batch sphere fit %.4f), scale error %.2f%%, "
+	       "residual %.2f%%, radius %.3f, %u/%u directions\n",
+	       count, (double)offset_err, (double)sphere_err, (double)(scale_err * 100.0f),
+	       (double)(residual * 100.0f), (double)radius, ellipsoid_fit_coverage(&fit), ELLIPSOID_FIT_SECTORS);
+
+	CHECK(offset_err < 0.005f);
+	CHECK(offset_err <= sphere_err);
+	CHECK(scale_err < 0.01f);
+	CHECK(residual < 0.02f);
+	CHECK(fabsf(radius - field * gain_mean) < 0.01f);
+	CHECK(ellipsoid_fit_coverage(&fit) == ELLIPSOID_FIT_SECTORS);
+
+	/* a sphere from the same sums still finds the offset roughly */
+	CHECK(ellipsoid_fit_solve(&fit, true, center, scale, &radius, &residual) == 0);
+	CHECK(scale[0] == 1.0f && scale[1] == 1.0f && scale[2] == 1.0f);
+	CHECK(fabsf(center[0] - true_offset[0]) < 0.03f);
+	CHECK(fabsf(center[1] - true_offset[1]) < 0.03f);
+	CHECK(fabsf(center[2] - true_offset[2]) < 0.03f);
+
+	delete[] x;
+	delete[] y;
+	delete[] z;
+}
+
+static void
+test_order_independent()
+{
+	static ellipsoid_fit_s fwd, rev;
+	const unsigned count = 500;
+	float m[count][3];
+
+	srand(2);
+
+	for (unsigned i = 0; i < count; i++) {
+		measure(false, m[i]);
+	}
+
+	ellipsoid_fit_init(&fwd);
+	ellipsoid_fit_init(&rev);
+
+	for (unsigned i = 0; i < count; i++) {
+		ellipsoid_fit_add(&fwd, m[i][0], m[i][1], m[i][2]);
+		ellipsoid_fit_add(&rev, m[count - 1 - i][0], m[count - 1 - i][1], m[count - 1 - i][2]);
+	}
+
+	float c1[3], s1[3], r1, e1;
+	float c2[3], s2[3], r2, e2;
+	CHECK(ellipsoid_fit_solve(&fwd, false, c1, s1, &r1, &e1) == 0);
+	CHECK(ellipsoid_fit_solve(&rev, false, c2, s2, &r2, &e2) == 0);
+
+	for (unsigned i = 0; i < 3; i++) {
+		CHECK(fabsf(c1[i] - c2[i]) < 1e-5f);
+		CHECK(fabsf(s1[i] - s2[i]) < 1e-5f);
+	}
+}
+
+static void
+test_degenerate()
+{
+	static ellipsoid_fit_s fit;
+	float center[3], scale[3], radius, residual;
+
+	/* no points at all */
+	ellipsoid_fit_init(&fit);
+	CHECK(ellipsoid_fit_solve(&fit, false, center, scale, &radius, &residual) != 0);
+	CHECK(ellipsoid_fit_coverage(&fit) == 0);
+
+	/* rotation about one axis only leaves most directions unseen */
+	srand(3);
+
+	for (unsigned i = 0; i < 1000; i++) {
+		float m[3];
+		measure(true, m);
+		ellipsoid_fit_add(&fit, m[0], m[1], m[2]);
+	}
+
+	unsigned coverage = ellipsoid_fit_coverage(&fit);
+	int ret = ellipsoid_fit_solve(&fit, false, center, scale, &radius, &residual);
+	printf("planar, 1000 points: %u/%u directions, ellipsoid fit %s\n", coverage, ELLIPSOID_FIT_SECTORS,
+	       ret == 0 ? "solved" : "rejected");
+	CHECK(coverage <= ELLIPSOID_FIT_SECTORS / 2);
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (bench_init(argc, argv) != 0) {
+		return 1;
+	}
+
+	test_ellipsoid(240);
+	test_ellipsoid(2000);
+	test_order_independent();
+	test_degenerate();
+
+	/* benchmark data: a full rotation worth of samples */
+	const unsigned count = 240;
+	static float x[count], y[count], z[count];
+	static ellipsoid_fit_s fit;
+
+	srand(4);
+
+	for (unsigned i = 0; i < count; i++) {
+		float m[3];
+		measure(false, m);
+		x[i] = m[0];
+		y[i] = m[1];
+		z[i] = m[2];
+	}
+
+	ellipsoid_fit_init(&fit);
+	unsigned k = 0;
+	BENCH_STMT("ellipsoid_fit_add", ellipsoid_fit_add(&fit, x[k], y[k], z[k]); k = (k + 1) % count);
+
+	ellipsoid_fit_init(&fit);
+
+	for (unsigned i = 0; i < count; i++) {
+		ellipsoid_fit_add(&fit, x[i], y[i], z[i]);
+	}
+
+	float center[3], scale[3], radius, residual;
+	BENCH_OP("ellipsoid_fit_solve", ellipsoid_fit_solve(&fit, false, center, scale, &radius, &residual));
+	BENCH_OP("ellipsoid_fit_solve, sphere", ellipsoid_fit_solve(&fit, true, center, scale, &radius, &residual));
+	BENCH_OP("ellipsoid_fit_coverage", ellipsoid_fit_coverage(&fit));
+
+	float sx, sy, sz, sr;
+	BENCH_OP("sphere_fit_least_squares, 240 points", sphere_fit_least_squares(x, y, z, count, 100, 0.0f,
+			&sx, &sy, &sz, &sr));
+
+	int ret = bench_finish();
+
+	if (failures > 0) {
+		warnx("%u checks FAILED", failures);
+		return 1;
+	}
+
+	warnx("all checks passed");
+	return ret;
+}
@@ -0,0 +1,292 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mathlib_bench.cpp
+ *
+ * Host benchmark of the shared math: mathlib vectors, matrices and
+ * quaternions, the second order low pass filter, the geo projections
+ * and the mixer.
+ *
+ * Covers the operations of the on-target test_mathlib TEST_OP loop, but
+ * reports ns/op with run-to-run variance and can write and compare a
+ * baseline, e.g.:
+ *
+ *   ./mathlib_bench -o baseline.txt
+ *   ./mathlib_bench -c baseline.txt -t 15
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mathlib/mathlib.h>
+#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/LowPassFilter2pVector.hpp>
+#include <geo/geo.h>
+#include <systemlib/err.h>
+#include <systemlib/mixer/mixer.h>
+#include <systemlib/mixer/mixer_load.h>
+
+#include "bench.h"
+
+using namespace math;
+
+static float actuator_controls[8];
+
+static int
+mixer_callback(uintptr_t handle, uint8_t control_group, uint8_t control_index, float &control)
+{
+	if (control_group != 0 || control_index >= sizeof(actuator_controls) / sizeof(actuator_controls[0])) {
+		return -1;
+	}
+
+	control = actuator_controls[control_index];
+	return 0;
+}
+
+static void
+bench_vector()
+{
+	{
+		Vector<2> v(0.5f, 0.5f);
+		Vector<2> v1(1.0f, 2.0f);
+		Vector<2> v2(1.0f, -1.0f);
+		float data[2] = {1.0f, 2.0f};
+		BENCH_OP("Constructor Vector<2>(Vector<2>)", Vector<2>(v1));
+		BENCH_OP("Constructor Vector<2>(float[])", Vector<2>(data));
+		BENCH_OP("Constructor Vector<2>(float, float)", Vector<2>(1.0f, 2.0f));
+		BENCH_OP("Vector<2> = Vector<2>", v = v1);
+		BENCH_OP("Vector<2> + Vector<2>", v + v1);
+		BENCH_OP("Vector<2> - Vector<2>", v - v1);
+		BENCH_OP("Vector<2> += Vector<2>", v += v1);
+		BENCH_OP("Vector<2> -= Vector<2>", v -= v1);
+		BENCH_OP("Vector<2> * Vector<2>", v * v1);
+		BENCH_OP("Vector<2> % Vector<2>", v1 % v2);
+	}
+
+	{
+		Vector<3> v(0.5f, 0.5f, 0.5f);
+		Vector<3> v1(1.0f, 2.0f, 0.0f);
+		Vector<3> v2(1.0f, -1.0f, 2.0f);
+		float data[3] = {1.0f, 2.0f, 3.0f};
+		BENCH_OP("Constructor Vector<3>(Vector<3>)", Vector<3>(v1));
+		BENCH_OP("Constructor Vector<3>(float[])", Vector<3>(data));
+		BENCH_OP("Constructor Vector<3>(float, float, float)", Vector<3>(1.0f, 2.0f, 3.0f));
+		BENCH_OP("Vector<3> = Vector<3>", v = v1);
+		BENCH_OP("Vector<3> + Vector<3>", v + v1);
+		BENCH_OP("Vector<3> - Vector<3>", v - v1);
+		BENCH_OP("Vector<3> += Vector<3>", v += v1);
+		BENCH_OP("Vector<3> -= Vector<3>", v -= v1);
+		BENCH_OP("Vector<3> * float", v1 * 2.0f);
+		BENCH_OP("Vector<3> / float", v1 / 2.0f);
+		BENCH_OP("Vector<3> *= float", v1 *= 2.0f);
+		BENCH_OP("Vector<3> /= float", v1 /= 2.0f);
+		BENCH_OP("Vector<3> * Vector<3>", v * v1);
+		BENCH_OP("Vector<3> % Vector<3>", v1 % v2);
+		BENCH_OP("Vector<3> length", v1.length());
+		BENCH_OP("Vector<3> length squared", v1.length_squared());
+		BENCH_OP("Vector<3> normalized", v2.normalized());
+	}
+
+	{
+		Vector<4> v(0.5f, 0.5f, 0.5f, 0.5f);
+		Vector<4> v1(1.0f, 2.0f, 0.0f, -1.0f);
+		float data[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+		BENCH_OP("Constructor Vector<4>(Vector<4>)", Vector<4>(v1));
+		BENCH_OP("Constructor Vector<4>(float[])", Vector<4>(data));
+		BENCH_OP("Vector<4> = Vector<4>", v = v1);
+		BENCH_OP("Vector<4> + Vector<4>", v + v1);
+		BENCH_OP("Vector<4> - Vector<4>", v - v1);
+		BENCH_OP("Vector<4> * Vector<4>", v * v1);
+	}
+
+	{
+		float data[10] = {};
+		Vector<10> v1(data);
+		BENCH_OP("Constructor Vector<10>(Vector<10>)", Vector<10>(v1));
+		BENCH_OP("Constructor Vector<10>(float[])", Vector<10>(data));
+	}
+}
+
+static void
+bench_matrix()
+{
+	{
+		Matrix<3, 3> m1;
+		m1.from_euler(0.1f, 0.2f, 0.3f);
+		Matrix<3, 3> m2;
+		m2.from_euler(-0.3f, 0.1f, 1.2f);
+		Vector<3> v1(1.0f, 2.0f, 0.0f);
+		BENCH_OP("Matrix<3, 3> * Vector<3>", m1 * v1);
+		BENCH_OP("Matrix<3, 3> + Matrix<3, 3>", m1 + m2);
+		BENCH_OP("Matrix<3, 3> * Matrix<3, 3>", m1 * m2);
+		BENCH_OP("Matrix<3, 3> transposed", m1.transposed());
+		BENCH_STMT("Matrix<3, 3> from_euler", m2.from_euler(0.1f, 0.2f, 0.3f));
+		BENCH_OP("Matrix<3, 3> to_euler", m1.to_euler());
+	}
+
+	{
+		Matrix<10, 10> m1;
+		m1.identity();
+		Matrix<10, 10> m2;
+		m2.identity();
+		Vector<10> v1;
+		v1.zero();
+		BENCH_OP("Matrix<10, 10> * Vector<10>", m1 * v1);
+		BENCH_OP("Matrix<10, 10> + Matrix<10, 10>", m1 + m2);
+		BENCH_OP("Matrix<10, 10> * Matrix<10, 10>", m1 * m2);
+	}
+}
+
+static void
+bench_quaternion()
+{
+	Quaternion q1;
+	q1.from_euler(0.1f, 0.2f, 0.3f);
+	Quaternion q2;
+	q2.from_euler(-0.3f, 0.1f, 1.2f);
+	Matrix<3, 3> R;
+	R.from_euler(0.1f, 0.2f, 0.3f);
+	Vector<3> w(0.1f, -0.2f, 0.3f);
+
+	BENCH_OP("Quaternion * Quaternion", q1 * q2);
+	BENCH_STMT("Quaternion from_euler", q2.from_euler(0.1f, 0.2f, 0.3f));
+	BENCH_STMT("Quaternion from_dcm", q2.from_dcm(R));
+	BENCH_OP("Quaternion to_dcm", q1.to_dcm());
+	BENCH_OP("Quaternion derivative", q1.derivative(w));
+	BENCH_OP("Quaternion normalized", q1.normalized());
+}
+
+static void
+bench_filter()
+{
+	LowPassFilter2p lpf(1000.0f, 30.0f);
+	float sample = 0.0f;
+
+	BENCH_OP("LowPassFilter2p apply", lpf.apply(sample += 0.001f));
+	BENCH_STMT("LowPassFilter2p set_cutoff_frequency", lpf.set_cutoff_frequency(1000.0f, 30.0f));
+
+	/* six channels, as for an accel and gyro triple */
+	LowPassFilter2p lpf6[6] = {
+		LowPassFilter2p(1000.0f, 30.0f), LowPassFilter2p(1000.0f, 30.0f), LowPassFilter2p(1000.0f, 30.0f),
+		LowPassFilter2p(1000.0f, 30.0f), LowPassFilter2p(1000.0f, 30.0f), LowPassFilter2p(1000.0f, 30.0f)
+	};
+	LowPassFilter2pVector<6> lpfv(1000.0f, 30.0f);
+	float in[6] = {0.1f, 0.2f, 9.81f, 0.01f, -0.02f, 0.03f};
+	float out[6];
+
+	BENCH_STMT("LowPassFilter2p apply x6", for (unsigned c = 0; c < 6; c++) { out[c] = lpf6[c].apply(in[c]); });
+	BENCH_STMT("LowPassFilter2pVector<6> apply", lpfv.apply(in, out));
+
+	/* a burst of 16 samples, as read from a sensor FIFO */
+	float burst[16 * 6];
+
+	for (unsigned i = 0; i < sizeof(burst) / sizeof(burst[0]); i++) {
+		burst[i] = 0.01f * i;
+	}
+
+	float burst_out[16 * 6];
+	BENCH_STMT("LowPassFilter2pVector<6> apply_block 16", lpfv.apply_block(burst, burst_out, 16));
+}
+
+static void
+bench_geo()
+{
+	struct map_projection_reference_s ref;
+	map_projection_init(&ref, 47.3977419, 8.5455938);
+
+	const double lat = 47.3987419;
+	const double lon = 8.5475938;
+	float x, y;
+	double lat_res, lon_res;
+	struct crosstrack_error_s crosstrack;
+
+	BENCH_STMT("map_projection_project", map_projection_project(&ref, lat, lon, &x, &y));
+	BENCH_STMT("map_projection_reproject", map_projection_reproject(&ref, 111.0f, 150.0f, &lat_res, &lon_res));
+	BENCH_OP("get_distance_to_next_waypoint", get_distance_to_next_waypoint(47.3977419, 8.5455938, lat, lon));
+	BENCH_OP("get_bearing_to_next_waypoint", get_bearing_to_next_waypoint(47.3977419, 8.5455938, lat, lon));
+	BENCH_STMT("get_vector_to_next_waypoint", get_vector_to_next_waypoint(47.3977419, 8.5455938, lat, lon, &x, &y));
+	BENCH_OP("get_distance_to_line", get_distance_to_line(&crosstrack, 47.3980000, 8.5460000,
+			47.3977419, 8.5455938, lat, lon));
+}
+
+static void
+bench_mixer(const char *path)
+{
+	char buf[2048];
+
+	if (load_mixer_file(path, &buf[0], sizeof(buf)) < 0) {
+		warnx("mixer: failed loading %s, skipping", path);
+		return;
+	}
+
+	MixerGroup mixer_group(mixer_callback, 0);
+	unsigned len = strlen(buf);
+	mixer_group.load_from_buf(&buf[0], len);
+
+	if (mixer_group.count() == 0) {
+		warnx("mixer: no mixers in %s, skipping", path);
+		return;
+	}
+
+	for (unsigned i = 0; i < sizeof(actuator_controls) / sizeof(actuator_controls[0]); i++) {
+		actuator_controls[i] = 0.1f * i;
+	}
+
+	actuator_controls[3] = 0.6f;
+
+	float outputs[16];
+	char title[80];
+	const char *name = strrchr(path, '/');
+	snprintf(title, sizeof(title), "MixerGroup mix %s", (name != nullptr) ? name + 1 : path);
+
+	BENCH_OP(title, mixer_group.mix(&outputs[0], sizeof(outputs) / sizeof(outputs[0])));
+}
+
+int main(int argc, char *argv[])
+{
+	if (bench_init(argc, argv) != 0) {
+		return 1;
+	}
+
+	bench_vector();
+	bench_matrix();
+	bench_quaternion();
+	bench_filter();
+	bench_geo();
+	bench_mixer("../../ROMFS/px4fmu_common/mixers/FMU_quad_x.mix");
+	bench_mixer("../../ROMFS/px4fmu_common/mixers/FMU_octo_x.mix");
+	bench_mixer("../../ROMFS/px4fmu_common/mixers/FMU_AERT.mix");
+
+	return bench_finish();
+}
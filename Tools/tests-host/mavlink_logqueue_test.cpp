@@ -0,0 +1,340 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mavlink_logqueue_test.cpp
+ *
+ * Host test and benchmark of the shared MAVLink text message queue.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <systemlib/err.h>
+
+__BEGIN_DECLS
+#include <mavlink/mavlink_log.h>
+__END_DECLS
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* MAV_SEVERITY values used by the queue */
+#define SEV_CRITICAL	2
+#define SEV_INFO	6
+
+static void
+test_order()
+{
+	static struct mavlink_logqueue q;
+	struct mavlink_logmessage msg;
+
+	int r = mavlink_logqueue_attach(&q);
+	CHECK(r == 0);
+	CHECK(mavlink_logqueue_read(&q, r, &msg) == 1);
+
+	char text[32];
+
+	for (unsigned i = 0; i < 10; i++) {
+		snprintf(text, sizeof(text), "msg %u", i);
+		CHECK(mavlink_logqueue_write(&q, SEV_CRITICAL, text) == 0);
+	}
+
+	for (unsigned i = 0; i < 10; i++) {
+		snprintf(text, sizeof(text), "msg %u", i);
+		CHECK(mavlink_logqueue_read(&q, r, &msg) == 0);
+		CHECK(strcmp(msg.text, text) == 0);
+		CHECK(msg.severity == SEV_CRITICAL);
+	}
+
+	CHECK(mavlink_logqueue_read(&q, r, &msg) == 1);
+	CHECK(q.readers[r].read == 10 && q.readers[r].lost == 0);
+
+	/* over-long text is truncated */
+	char longtext[MAVLINK_LOG_MAXLEN + 20];
+	memset(longtext, 'x', sizeof(longtext) - 1);
+	longtext[sizeof(longtext) - 1] = '\0';
+	CHECK(mavlink_logqueue_write(&q, SEV_INFO, longtext) == 0);
+	CHECK(mavlink_logqueue_read(&q, r, &msg) == 0);
+	CHECK(strlen(msg.text) == MAVLINK_LOG_MAXLEN);
+
+	mavlink_logqueue_detach(&q, r);
+}
+
+static void
+test_readers()
+{
+	static struct mavlink_logqueue q;
+	struct mavlink_logmessage msg;
+	int readers[MAVLINK_LOGQUEUE_READERS];
+
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_READERS; i++) {
+		readers[i] = mavlink_logqueue_attach(&q);
+		CHECK(readers[i] == (int)i);
+	}
+
+	CHECK(mavlink_logqueue_attach(&q) == -1);
+
+	CHECK(mavlink_logqueue_write(&q, SEV_INFO, "first") == 0);
+	CHECK(mavlink_logqueue_write(&q, SEV_INFO, "second") == 0);
+
+	/* every reader sees every message */
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_READERS; i++) {
+		CHECK(mavlink_logqueue_read(&q, readers[i], &msg) == 0 && strcmp(msg.text, "first") == 0);
+		CHECK(mavlink_logqueue_read(&q, readers[i], &msg) == 0 && strcmp(msg.text, "second") == 0);
+		CHECK(mavlink_logqueue_read(&q, readers[i], &msg) == 1);
+	}
+
+	/* a reader attached later only sees new messages */
+	mavlink_logqueue_detach(&q, readers[2]);
+	CHECK(mavlink_logqueue_attach(&q) == 2);
+	CHECK(mavlink_logqueue_read(&q, 2, &msg) == 1);
+	CHECK(mavlink_logqueue_write(&q, SEV_INFO, "third") == 0);
+	CHECK(mavlink_logqueue_read(&q, 2, &msg) == 0 && strcmp(msg.text, "third") == 0);
+
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_READERS; i++) {
+		mavlink_logqueue_detach(&q, readers[i]);
+	}
+}
+
+static void
+test_overflow()
+{
+	static struct mavlink_logqueue q;
+	struct mavlink_logmessage msg;
+	char text[32];
+
+	int r = mavlink_logqueue_attach(&q);
+
+	/* informational messages stop before the reserved slots */
+	unsigned queued = 0;
+
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_SIZE; i++) {
+		snprintf(text, sizeof(text), "info %u", i);
+
+		if (mavlink_logqueue_write(&q, SEV_INFO, text) == 0)
+			queued++;
+	}
+
+	CHECK(queued == MAVLINK_LOGQUEUE_SIZE - MAVLINK_LOGQUEUE_RESERVE);
+	CHECK(q.dropped == MAVLINK_LOGQUEUE_RESERVE);
+
+	/* critical messages still get through and overwrite the oldest */
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_SIZE; i++) {
+		snprintf(text, sizeof(text), "crit %u", i);
+		CHECK(mavlink_logqueue_write(&q, SEV_CRITICAL, text) == 0);
+	}
+
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_SIZE; i++) {
+		snprintf(text, sizeof(text), "crit %u", i);
+		CHECK(mavlink_logqueue_read(&q, r, &msg) == 0);
+		CHECK(strcmp(msg.text, text) == 0);
+	}
+
+	CHECK(mavlink_logqueue_read(&q, r, &msg) == 1);
+	CHECK(q.readers[r].lost == queued);
+	CHECK(q.readers[r].read == MAVLINK_LOGQUEUE_SIZE);
+
+	mavlink_logqueue_detach(&q, r);
+}
+
+/*
+ * Several writer threads against one reader thread. Every message
+ * carries its writer and a per-writer counter, the reader checks that
+ * the messages of each writer arrive intact and in order and that
+ * everything written is either read or counted as lost. The writers
+ * fill the queue faster than it is read, so overwrites are exercised too.
+ */
+#define STRESS_WRITERS	4
+#define STRESS_MESSAGES	20000
+
+static struct mavlink_logqueue	stress_q;
+static volatile bool		stress_done;
+
+static void *
+stress_writer(void *arg)
+{
+	unsigned id = (unsigned)(uintptr_t)arg;
+	char text[MAVLINK_LOG_MAXLEN + 1];
+
+	for (unsigned i = 0; i < STRESS_MESSAGES; i++) {
+		/* pad to the full length so torn copies would show */
+		snprintf(text, sizeof(text), "%u %u %c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c%c", id, i,
+			 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id,
+			 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id,
+			 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id, 'a' + id);
+		mavlink_logqueue_write(&stress_q, SEV_CRITICAL, text);
+
+		/* bursts of messages with pauses, like real writers */
+		if ((i % 8) == 7)
+			usleep(1);
+	}
+
+	return NULL;
+}
+
+static unsigned	stress_read;
+static unsigned	stress_bad;
+
+static bool
+stress_check(const struct mavlink_logmessage *msg, int last[STRESS_WRITERS])
+{
+	unsigned id, i;
+	int n = 0;
+
+	if (sscanf(msg->text, "%u %u %n", &id, &i, &n) != 2 || id >= STRESS_WRITERS)
+		return false;
+
+	for (const char *p = &msg->text[n]; *p != '\0'; p++) {
+		if (*p != (char)('a' + id))
+			return false;
+	}
+
+	if ((int)i <= last[id])
+		return false;
+
+	last[id] = i;
+	return true;
+}
+
+static void *
+stress_reader(void *arg)
+{
+	int r = (int)(uintptr_t)arg;
+	int last[STRESS_WRITERS];
+	struct mavlink_logmessage msg;
+
+	for (unsigned i = 0; i < STRESS_WRITERS; i++)
+		last[i] = -1;
+
+	for (;;) {
+		bool done = stress_done;
+
+		while (mavlink_logqueue_read(&stress_q, r, &msg) == 0) {
+			stress_read++;
+
+			if (!stress_check(&msg, last))
+				stress_bad++;
+		}
+
+		if (done)
+			break;
+	}
+
+	return NULL;
+}
+
+static void
+test_stress()
+{
+	int r = mavlink_logqueue_attach(&stress_q);
+	pthread_t reader;
+	pthread_t writers[STRESS_WRITERS];
+
+	pthread_create(&reader, NULL, stress_reader, (void *)(uintptr_t)r);
+
+	for (unsigned i = 0; i < STRESS_WRITERS; i++)
+		pthread_create(&writers[i], NULL, stress_writer, (void *)(uintptr_t)i);
+
+	for (unsigned i = 0; i < STRESS_WRITERS; i++)
+		pthread_join(writers[i], NULL);
+
+	stress_done = true;
+	pthread_join(reader, NULL);
+
+	const struct mavlink_logqueue_reader *rd = &stress_q.readers[r];
+
+	warnx("stress: %u written, %u read, %u lost", (unsigned)stress_q.head, (unsigned)rd->read, (unsigned)rd->lost);
+
+	CHECK(stress_q.head == STRESS_WRITERS * STRESS_MESSAGES);
+	CHECK(stress_bad == 0);
+	CHECK(stress_read == rd->read);
+	CHECK(rd->read + rd->lost == STRESS_WRITERS * STRESS_MESSAGES);
+
+	mavlink_logqueue_detach(&stress_q, r);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("mavlink log queue test started");
+
+	test_order();
+	test_readers();
+	test_overflow();
+	test_stress();
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	static struct mavlink_logqueue q;
+	struct mavlink_logmessage msg;
+	int readers[3];
+
+	for (unsigned i = 0; i < 3; i++)
+		readers[i] = mavlink_logqueue_attach(&q);
+
+	BENCH_STMT("logqueue write + read, 1 reader", {
+		mavlink_logqueue_write(&q, SEV_CRITICAL, "[cmd] arming denied: not in manual mode");
+		mavlink_logqueue_read(&q, readers[0], &msg);
+	});
+
+	mavlink_logqueue_detach(&q, readers[0]);
+	readers[0] = mavlink_logqueue_attach(&q);
+
+	BENCH_STMT("logqueue write + read, 3 readers", {
+		mavlink_logqueue_write(&q, SEV_CRITICAL, "[cmd] arming denied: not in manual mode");
+		mavlink_logqueue_read(&q, readers[0], &msg);
+		mavlink_logqueue_read(&q, readers[1], &msg);
+		mavlink_logqueue_read(&q, readers[2], &msg);
+	});
+
+	BENCH_OP("logqueue read empty", mavlink_logqueue_read(&q, readers[0], &msg));
+
+	return bench_finish();
+}
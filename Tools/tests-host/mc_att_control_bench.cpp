@@ -0,0 +1,214 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mc_att_control_bench.cpp
+ *
+ * Host benchmark of the per-cycle cost of the multicopter attitude
+ * controller error computation, rotation matrix vs. quaternion
+ * formulation, including the conversion of the estimator output.
+ *
+ * Also checks that both formulations agree and that large errors are
+ * corrected the shortest way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mathlib/mathlib.h>
+#include <systemlib/err.h>
+#include <mc_att_control/attitude_error.h>
+
+#include "bench.h"
+
+using namespace math;
+
+/**
+ * Compare both formulations over random attitudes and setpoints.
+ *
+ * @return		the largest difference of the error vectors
+ */
+static float
+check_agreement(unsigned n)
+{
+	float max_diff = 0.0f;
+	srand(0);
+
+	for (unsigned i = 0; i < n; i++) {
+		float a[6];
+
+		for (unsigned j = 0; j < 6; j++) {
+			a[j] = M_PI_F * (2.0f * rand() / RAND_MAX - 1.0f);
+		}
+
+		Matrix<3, 3> R;
+		Matrix<3, 3> R_sp;
+		R.from_euler(a[0], 0.5f * a[1], a[2]);
+		R_sp.from_euler(a[3], 0.5f * a[4], a[5]);
+
+		Quaternion q;
+		Quaternion q_sp;
+		q.from_dcm(R);
+		q_sp.from_dcm(R_sp);
+
+		Vector<3> e_dcm;
+		Vector<3> e_quat;
+		float yaw_w_dcm;
+		float yaw_w_quat;
+		mc_att_control::attitude_error_dcm(R, R_sp, e_dcm, yaw_w_dcm);
+		mc_att_control::attitude_error_quat(q, q_sp, e_quat, yaw_w_quat);
+
+		float diff = (e_dcm - e_quat).length() + fabsf(yaw_w_dcm - yaw_w_quat);
+
+		if (diff > max_diff) {
+			max_diff = diff;
+		}
+	}
+
+	return max_diff;
+}
+
+/**
+ * Check that the direct rotation used for large thrust vector errors
+ * takes the shortest way, for a pure roll error of the given angle
+ * from level flight.
+ *
+ * @return		the largest deviation from the expected roll error
+ */
+static float
+check_shortest_rotation(float roll_sp)
+{
+	Matrix<3, 3> R;
+	Matrix<3, 3> R_sp;
+	R.identity();
+	R_sp.from_euler(roll_sp, 0.0f, 0.0f);
+
+	Quaternion q;
+	Quaternion q_sp;
+	q.from_dcm(R);
+	q_sp.from_dcm(R_sp);
+
+	Vector<3> e_dcm;
+	Vector<3> e_quat;
+	Vector<3> e_quat_neg;
+	float yaw_w;
+	mc_att_control::attitude_error_dcm(R, R_sp, e_dcm, yaw_w);
+	mc_att_control::attitude_error_quat(q, q_sp, e_quat, yaw_w);
+
+	/* the negated quaternion is the same rotation */
+	Quaternion q_sp_neg(-q_sp(0), -q_sp(1), -q_sp(2), -q_sp(3));
+	mc_att_control::attitude_error_quat(q, q_sp_neg, e_quat_neg, yaw_w);
+
+	Vector<3> expected(roll_sp, 0.0f, 0.0f);
+	float diff = (e_dcm - expected).length();
+	diff = fmaxf(diff, (e_quat - expected).length());
+	diff = fmaxf(diff, (e_quat_neg - expected).length());
+	return diff;
+}
+
+static void
+bench_case(const char *name, float roll, float pitch, float yaw, float roll_sp, float pitch_sp, float yaw_sp)
+{
+	/* inputs as they arrive in the controller */
+	float R_att[3][3];
+	float q_att[4];
+	float R_sp_body[3][3];
+
+	Matrix<3, 3> m;
+	m.from_euler(roll, pitch, yaw);
+	memcpy(R_att, m.data, sizeof(R_att));
+	Quaternion qm;
+	qm.from_dcm(m);
+	memcpy(q_att, qm.data, sizeof(q_att));
+	m.from_euler(roll_sp, pitch_sp, yaw_sp);
+	memcpy(R_sp_body, m.data, sizeof(R_sp_body));
+
+	Vector<3> e_R;
+	float yaw_w;
+	char title[80];
+
+	snprintf(title, sizeof(title), "attitude error dcm, %s", name);
+	BENCH_STMT(title, {
+		Matrix<3, 3> R;
+		R.set(R_att);
+		Matrix<3, 3> R_sp;
+		R_sp.set(R_sp_body);
+		mc_att_control::attitude_error_dcm(R, R_sp, e_R, yaw_w);
+	});
+
+	snprintf(title, sizeof(title), "attitude error quat, %s", name);
+	BENCH_STMT(title, {
+		Quaternion q;
+		q.set(q_att);
+		Matrix<3, 3> R_sp;
+		R_sp.set(R_sp_body);
+		Quaternion q_sp;
+		q_sp.from_dcm(R_sp);
+		mc_att_control::attitude_error_quat(q, q_sp, e_R, yaw_w);
+	});
+}
+
+int main(int argc, char *argv[])
+{
+	if (bench_init(argc, argv) != 0) {
+		return 1;
+	}
+
+	bench_case("small error", 0.1f, -0.05f, 1.0f, 0.15f, 0.0f, 1.1f);
+	bench_case("large error", 0.1f, -0.05f, 1.0f, 2.8f, 0.3f, -2.0f);
+
+	int ret = bench_finish();
+
+	float max_diff = check_agreement(100000);
+	warnx("max difference dcm vs. quat: %.3g", (double)max_diff);
+
+	if (max_diff > 1e-3f) {
+		warnx("FAIL: formulations disagree");
+		ret = 1;
+	}
+
+	const float roll_sp[] = { 2.97f, -2.97f, 2.0f, -2.0f };
+
+	for (unsigned i = 0; i < sizeof(roll_sp) / sizeof(roll_sp[0]); i++) {
+		float diff = check_shortest_rotation(roll_sp[i]);
+
+		if (diff > 1e-3f) {
+			warnx("FAIL: roll error %.2f rad not corrected the shortest way (off by %.3g)",
+			      (double)roll_sp[i], (double)diff);
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
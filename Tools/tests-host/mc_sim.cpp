@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mc_sim.cpp
+ *
+ * Simple multirotor flight dynamics model for host simulation.
+ */
+
+#include "mc_sim.h"
+
+#include <math.h>
+
+static const float	g = 9.80665f;
+
+/* roll, pitch and yaw scale of each rotor, as _config_quad_x of the multirotor mixer */
+static const float	rotor_scales[MulticopterSim::num_rotors][3] = {
+	{ -0.707107f,  0.707107f,  1.0f },
+	{  0.707107f, -0.707107f,  1.0f },
+	{  0.707107f,  0.707107f, -1.0f },
+	{ -0.707107f, -0.707107f, -1.0f },
+};
+
+MulticopterSim::MulticopterSim() :
+	_landed(true)
+{
+	_af.mass = 1.5f;
+	_af.inertia[0] = 0.03f;
+	_af.inertia[1] = 0.03f;
+	_af.inertia[2] = 0.05f;
+	_af.arm = 0.25f;
+	_af.thrust_max = 7.5f;
+	_af.torque_ratio = 0.05f;
+	_af.rotor_tau = 0.02f;
+	_af.drag = 0.25f;
+
+	reset(0.0f, 0.0f, 0.0f);
+}
+
+void
+MulticopterSim::reset(float north, float east, float heading)
+{
+	_pos = math::Vector<3>(north, east, 0.0f);
+	_vel.zero();
+	_q.from_euler(0.0f, 0.0f, heading);
+	_rates.zero();
+
+	for (unsigned i = 0; i < num_rotors; i++) {
+		_rotor[i] = 0.0f;
+	}
+
+	_landed = true;
+	_update_outputs();
+}
+
+void
+MulticopterSim::update(const float commands[num_rotors], float dt)
+{
+	float thrust = 0.0f;
+	math::Vector<3> torque;
+	torque.zero();
+
+	for (unsigned i = 0; i < num_rotors; i++) {
+		float cmd = math::constrain(commands[i], 0.0f, 1.0f);
+		_rotor[i] += (cmd - _rotor[i]) * math::min(dt / _af.rotor_tau, 1.0f);
+
+		float t = _rotor[i] * _af.thrust_max;
+		thrust += t;
+
+		/* roll and pitch scales are the rotor position relative to the arm */
+		torque(0) += rotor_scales[i][0] * _af.arm * t;
+		torque(1) += rotor_scales[i][1] * _af.arm * t;
+		torque(2) += rotor_scales[i][2] * _af.torque_ratio * t;
+	}
+
+	math::Vector<3> force(0.0f, 0.0f, -thrust);
+	math::Vector<3> accel = _R * force / _af.mass - _vel * (_af.drag / _af.mass);
+	accel(2) += g;
+
+	/* Euler's rotation equation with diagonal inertia */
+	math::Vector<3> rates_dot;
+
+	for (unsigned i = 0; i < 3; i++) {
+		unsigned j = (i + 1) % 3;
+		unsigned k = (i + 2) % 3;
+		rates_dot(i) = (torque(i) - (_af.inertia[k] - _af.inertia[j]) * _rates(j) * _rates(k)) / _af.inertia[i];
+	}
+
+	/* on the ground until the rotors lift more than the weight */
+	if (_landed && accel(2) >= 0.0f) {
+		_vel.zero();
+		_rates.zero();
+		_accel_body = _R.transposed() * math::Vector<3>(0.0f, 0.0f, -g);
+		return;
+	}
+
+	_landed = false;
+
+	/* explicit Euler, the simulation steps at 1 kHz or faster */
+	_pos += _vel * dt;
+	_vel += accel * dt;
+	_q += _q.derivative(_rates) * dt;
+	_q.normalize();
+	_rates += rates_dot * dt;
+
+	/* touch down */
+	if (_pos(2) > 0.0f) {
+		math::Vector<3> euler = _q.to_dcm().to_euler();
+		_pos(2) = 0.0f;
+		_vel.zero();
+		_rates.zero();
+		_q.from_euler(0.0f, 0.0f, euler(2));
+		_landed = true;
+	}
+
+	_update_outputs();
+
+	_accel_body = _R.transposed() * (accel - math::Vector<3>(0.0f, 0.0f, g));
+
+	if (_landed) {
+		_accel_body = _R.transposed() * math::Vector<3>(0.0f, 0.0f, -g);
+	}
+}
+
+void
+MulticopterSim::_update_outputs()
+{
+	_R = _q.to_dcm();
+	_euler = _R.to_euler();
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mc_sim.h
+ *
+ * Simple multirotor flight dynamics model for host simulation.
+ *
+ * Rigid body driven by four rotors in the quad X layout of the multirotor
+ * mixer, each with a first order speed lag and thrust linear in its
+ * normalized command, plus linear drag. The rotor torques use the mixer's
+ * roll, pitch and yaw scales, so that a mixed control moves the vehicle
+ * the way the controllers expect. The ground is a plane at zero altitude
+ * the vehicle rests on until the rotors lift it off.
+ *
+ * Conventions follow the estimator outputs: NED earth frame, FRD body
+ * frame, body rates in rad/s.
+ */
+
+#pragma once
+
+#include <mathlib/mathlib.h>
+
+class MulticopterSim
+{
+public:
+	static const unsigned num_rotors = 4;
+
+	/** airframe constants, default is a 1.5 kg quad */
+	struct Airframe {
+		float	mass;		/**< kg */
+		float	inertia[3];	/**< principal moments of inertia, kg m^2 */
+		float	arm;		/**< rotor distance from the center, m */
+		float	thrust_max;	/**< thrust of one rotor at full command, N */
+		float	torque_ratio;	/**< rotor drag torque per thrust, m */
+		float	rotor_tau;	/**< rotor speed time constant, s */
+		float	drag;		/**< linear drag, N per m/s */
+	};
+
+	MulticopterSim();
+
+	/**
+	 * Rest on the ground.
+	 *
+	 * @param north		position, m
+	 * @param east		position, m
+	 * @param heading	rad
+	 */
+	void	reset(float north, float east, float heading);
+
+	/**
+	 * Integrate the model over one step.
+	 *
+	 * @param commands	rotor commands 0..1, in mixer output order
+	 * @param dt		step in seconds
+	 */
+	void	update(const float commands[num_rotors], float dt);
+
+	Airframe &airframe() { return _af; }
+
+	const math::Vector<3> &position() const { return _pos; }
+	const math::Vector<3> &velocity() const { return _vel; }
+	const math::Matrix<3, 3> &R() const { return _R; }
+	const math::Vector<3> &rates() const { return _rates; }
+	const math::Vector<3> &euler() const { return _euler; }
+
+	/** specific force in the body frame, as measured by an accelerometer */
+	const math::Vector<3> &accel_body() const { return _accel_body; }
+
+	float	altitude() const { return -_pos(2); }
+	bool	landed() const { return _landed; }
+
+private:
+	Airframe		_af;
+
+	math::Vector<3>		_pos;
+	math::Vector<3>		_vel;
+	math::Quaternion	_q;
+	math::Vector<3>		_rates;
+	float			_rotor[num_rotors];	/**< rotor speeds as normalized thrust */
+	bool			_landed;
+
+	/* outputs derived from the state */
+	math::Matrix<3, 3>	_R;
+	math::Vector<3>		_euler;
+	math::Vector<3>		_accel_body;
+
+	void	_update_outputs();
+};
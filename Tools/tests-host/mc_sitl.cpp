@@ -0,0 +1,1082 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mc_sitl.cpp
+ *
+ * Software in the loop simulation of the multirotor flight stack.
+ *
+ * Runs the unmodified sensors, attitude_estimator_ekf, mc_att_control and
+ * mc_pos_control modules as tasks of one Linux process (sitl_posix.cpp),
+ * talking over an in-process uORB (uorb_sim.cpp), against the
+ * MulticopterSim dynamics model. The actuator controls are mixed with the
+ * quad X mixer file and limited like the FMU outputs before they drive
+ * the model.
+ *
+ * The harness publishes the raw sensor topics the drivers would and takes
+ * the place of the modules that are not run: the local position estimate
+ * is the true position of the model, and the vehicle_control_mode,
+ * actuator_armed and position_setpoint_triplet topics are published as
+ * commander and navigator would for the flight below.
+ *
+ * Simulated time (hrt_sim) advances in lockstep with the stack: every
+ * 4 ms the harness publishes the sensor samples, waits until the
+ * actuator controls computed from exactly these samples arrive and only
+ * then integrates the model and advances the clock. Runs therefore do not
+ * depend on host load, are deterministic and as fast as the host allows,
+ * or paced to real time with -R.
+ *
+ * The flight is given as a sequence, built in or read from a file (-s),
+ * one item per line:
+ *
+ *   start <north> <east> <heading_deg>
+ *   param <NAME> <value>			set a flight parameter
+ *   takeoff <alt>
+ *   wp <north> <east> <alt> [yaw_deg]
+ *   hold <seconds>
+ *   att <seconds> <roll_deg> <pitch_deg> <yaw_deg> <thrust>
+ *   land
+ *
+ * Reported are the latency from the gyro sample to the actuator controls
+ * computed from it, the CPU time of every task per control cycle and the
+ * tracking errors. The trace of states, setpoints and outputs can be
+ * written (-o) and compared against an earlier trace (-c).
+ *
+ * Module state is static, so a process flies one sequence; run one
+ * process per scenario.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <poll.h>
+#include <time.h>
+#include <systemlib/err.h>
+#include <systemlib/param/param.h>
+#include <systemlib/mixer/mixer.h>
+#include <systemlib/mixer/mixer_load.h>
+#include <systemlib/pwm_limit/pwm_limit.h>
+#include <mathlib/mathlib.h>
+#include <geo/geo.h>
+#include <drivers/drv_accel.h>
+#include <drivers/drv_gyro.h>
+#include <drivers/drv_mag.h>
+#include <drivers/drv_baro.h>
+#include <drivers/drv_adc.h>
+#include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/vehicle_attitude_setpoint.h>
+#include <uORB/topics/vehicle_local_position.h>
+#include <uORB/topics/vehicle_control_mode.h>
+#include <uORB/topics/actuator_armed.h>
+#include <uORB/topics/actuator_controls.h>
+#include <uORB/topics/position_setpoint_triplet.h>
+#include <uORB/topics/parameter_update.h>
+
+#include "bench.h"
+#include "hrt_sim.h"
+#include "sim_trace.h"
+#include "sitl_posix.h"
+#include "uorb_sim.h"
+#include "mc_sim.h"
+
+extern "C" int sensors_main(int argc, char *argv[]);
+extern "C" int attitude_estimator_ekf_main(int argc, char *argv[]);
+extern "C" int mc_att_control_main(int argc, char *argv[]);
+extern "C" int mc_pos_control_main(int argc, char *argv[]);
+
+/* control cycle as the gyro rate of the sensors module, dynamics at 1 kHz, position estimate at 50 Hz */
+static const hrt_abstime	cycle_us = 4000;
+static const unsigned		substeps = 4;
+static const unsigned		pos_divider = 5;
+static const unsigned		trace_divider = 25;
+
+/* time on the ground for the estimator to settle before the first item */
+static const float		preflight_time = 2.0f;
+
+/* items that do not finish in this time fail the run */
+static const float		item_timeout = 60.0f;
+
+/* waypoint acceptance, horizontal and vertical */
+static const float		acceptance_radius = 1.0f;
+static const float		acceptance_alt = 0.5f;
+
+/* local frame origin, as set by the position estimator */
+static const double		ref_lat = 47.397742;
+static const double		ref_lon = 8.545594;
+static const float		ref_alt = 488.0f;
+
+/* earth magnetic field in NED, gauss */
+static const float		mag_earth[3] = { 0.21f, 0.0f, 0.42f };
+
+/* sensor noise, standard deviation */
+static const float		gyro_noise = 0.005f;
+static const float		accel_noise = 0.05f;
+static const float		mag_noise = 0.005f;
+static const float		baro_noise = 0.1f;
+
+/* outputs as configured for the FMU: disarmed, min and max pulse */
+static const uint16_t		pwm_disarmed = 900;
+static const uint16_t		pwm_min = 1000;
+static const uint16_t		pwm_max = 2000;
+
+enum item_type {
+	ITEM_PARAM,
+	ITEM_TAKEOFF,
+	ITEM_WP,
+	ITEM_HOLD,
+	ITEM_ATT,
+	ITEM_LAND
+};
+
+struct item {
+	item_type	type;
+	float		north;
+	float		east;
+	float		alt;
+	float		yaw;		/**< NaN to keep the current yaw */
+	float		duration;
+	float		roll;
+	float		pitch;
+	float		thrust;
+	char		name[17];
+	float		value;
+};
+
+#define MAX_ITEMS	64
+
+static item	items[MAX_ITEMS];
+static unsigned	num_items;
+static float	start[3] = { 0.0f, 0.0f, 0.0f };
+
+/* takeoff, a box with a yaw turn, attitude steps, return and land */
+static const char *default_sequence[] = {
+	"takeoff 5",
+	"hold 2",
+	"wp 10 0 5",
+	"wp 10 10 8 90",
+	"hold 2",
+	"att 1.5 15 0 90 0.5",
+	"att 1.5 0 -15 90 0.5",
+	"wp 0 0 5 0",
+	"hold 2",
+	"land",
+};
+
+/**
+ * Parse one sequence line.
+ *
+ * @return		0 on success, -1 on a syntax error
+ */
+static int
+parse_line(const char *line)
+{
+	char cmd[16];
+	float v[5];
+	int n;
+
+	while (*line == ' ' || *line == '\t') {
+		line++;
+	}
+
+	if (*line == '\0' || *line == '\n' || *line == '#') {
+		return 0;
+	}
+
+	if (sscanf(line, "%15s", cmd) != 1) {
+		return -1;
+	}
+
+	if (num_items >= MAX_ITEMS) {
+		warnx("more than %u items", MAX_ITEMS);
+		return -1;
+	}
+
+	item &it = items[num_items];
+	memset(&it, 0, sizeof(it));
+	it.yaw = NAN;
+
+	if (strcmp(cmd, "param") == 0) {
+		if (sscanf(line, "%*s %16s %f", it.name, &it.value) != 2) {
+			return -1;
+		}
+
+		it.type = ITEM_PARAM;
+		num_items++;
+		return 0;
+	}
+
+	n = sscanf(line, "%*s %f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4]);
+
+	if (strcmp(cmd, "start") == 0 && n == 3) {
+		start[0] = v[0];
+		start[1] = v[1];
+		start[2] = math::radians(v[2]);
+		return 0;
+	}
+
+	if (strcmp(cmd, "takeoff") == 0 && n == 1) {
+		it.type = ITEM_TAKEOFF;
+		it.alt = v[0];
+
+	} else if (strcmp(cmd, "wp") == 0 && (n == 3 || n == 4)) {
+		it.type = ITEM_WP;
+		it.north = v[0];
+		it.east = v[1];
+		it.alt = v[2];
+		it.yaw = (n == 4) ? _wrap_pi(math::radians(v[3])) : NAN;
+
+	} else if (strcmp(cmd, "hold") == 0 && n == 1) {
+		it.type = ITEM_HOLD;
+		it.duration = v[0];
+
+	} else if (strcmp(cmd, "att") == 0 && n == 5) {
+		it.type = ITEM_ATT;
+		it.duration = v[0];
+		it.roll = math::radians(v[1]);
+		it.pitch = math::radians(v[2]);
+		it.yaw = _wrap_pi(math::radians(v[3]));
+		it.thrust = v[4];
+
+	} else if (strcmp(cmd, "land") == 0 && n <= 0) {
+		it.type = ITEM_LAND;
+
+	} else {
+		return -1;
+	}
+
+	num_items++;
+	return 0;
+}
+
+static int
+load_sequence(const char *path)
+{
+	if (path == nullptr) {
+		for (unsigned i = 0; i < sizeof(default_sequence) / sizeof(default_sequence[0]); i++) {
+			if (parse_line(default_sequence[i]) != 0) {
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	FILE *fp = fopen(path, "r");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return -1;
+	}
+
+	char line[128];
+	unsigned lineno = 0;
+	int ret = 0;
+
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		lineno++;
+		line[strcspn(line, "\r\n")] = '\0';
+
+		if (parse_line(line) != 0) {
+			warnx("%s:%u: invalid line: %s", path, lineno, line);
+			ret = -1;
+			break;
+		}
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+/**
+ * Set a parameter by name, as the param command does.
+ */
+static int
+set_param(const char *name, float value)
+{
+	param_t p = param_find(name);
+
+	if (p == PARAM_INVALID) {
+		warnx("unknown parameter %s", name);
+		return -1;
+	}
+
+	if (param_type(p) == PARAM_TYPE_INT32) {
+		int32_t i = (int32_t)value;
+		return param_set(p, &i);
+	}
+
+	return param_set(p, &value);
+}
+
+/*
+ * Deterministic sensor noise: a linear congruential generator, uniform
+ * with the given standard deviation.
+ */
+static uint32_t	noise_state = 12345;
+
+static float
+noise(float stddev)
+{
+	noise_state = noise_state * 1664525u + 1013904223u;
+	return ((float)(noise_state >> 8) / (float)(1u << 24) * 2.0f - 1.0f) * 1.7320508f * stddev;
+}
+
+/*
+ * Wall clock latency samples, in microseconds.
+ */
+static float	*latency;
+static unsigned	latency_len;
+static unsigned	latency_size;
+
+static void
+latency_add(float us)
+{
+	if (latency_len == latency_size) {
+		latency_size = (latency_size == 0) ? 4096 : latency_size * 2;
+		latency = (float *)realloc(latency, latency_size * sizeof(float));
+
+		if (latency == nullptr) {
+			errx(1, "out of memory");
+		}
+	}
+
+	latency[latency_len++] = us;
+}
+
+static int
+float_cmp(const void *a, const void *b)
+{
+	float fa = *(const float *)a;
+	float fb = *(const float *)b;
+	return (fa < fb) ? -1 : (fa > fb) ? 1 : 0;
+}
+
+static uint64_t
+cpu_ns(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Wait for a publication carrying a timestamp.
+ *
+ * @param sub		subscription
+ * @param meta		topic
+ * @param buf		topic buffer
+ * @param stamp		timestamp field in buf
+ * @param expected	timestamp to wait for
+ * @param timeout_ms	wall clock timeout
+ * @return		true if the publication arrived in time
+ */
+static bool
+wait_for(int sub, const struct orb_metadata *meta, void *buf, const uint64_t *stamp, hrt_abstime expected, int timeout_ms)
+{
+	uint64_t deadline = bench_time_ns() + timeout_ms * 1000000ULL;
+
+	for (;;) {
+		uint64_t now = bench_time_ns();
+
+		if (now >= deadline) {
+			return false;
+		}
+
+		struct pollfd fds;
+		fds.fd = sub;
+		fds.events = POLLIN;
+
+		if (poll(&fds, 1, (int)((deadline - now + 999999) / 1000000)) > 0) {
+			orb_copy(meta, sub, buf);
+
+			if (*stamp == expected) {
+				return true;
+			}
+		}
+	}
+}
+
+/*
+ * Mixer input, the controls of group 0.
+ */
+static actuator_controls_s	actuators;
+
+static int
+control_callback(uintptr_t handle, uint8_t control_group, uint8_t control_index, float &input)
+{
+	if (control_group != 0 || control_index >= NUM_ACTUATOR_CONTROLS) {
+		return -1;
+	}
+
+	input = actuators.control[control_index];
+	return 0;
+}
+
+/**
+ * Start a module the way the startup script does and check it came up.
+ */
+static void
+start_module(main_t entry, const char *name)
+{
+	const char *argv[] = { name, "start", nullptr };
+
+	if (sitl_command(entry, argv) != 0) {
+		errx(1, "%s failed to start", name);
+	}
+}
+
+/**
+ * Wait until the modules have subscribed to a topic.
+ */
+static void
+wait_subscribers(const struct orb_metadata *meta, unsigned count)
+{
+	for (unsigned i = 0; orb_sim_subscribers(meta) < count; i++) {
+		if (i > 2000) {
+			errx(1, "%s: %u subscribers, expected %u", meta->o_name, orb_sim_subscribers(meta), count);
+		}
+
+		usleep(1000);
+	}
+}
+
+/*
+ * Trace, one row every trace_divider cycles.
+ */
+#define TRACE_COLUMNS	17
+
+static const char *const trace_columns[TRACE_COLUMNS] = {
+	"t", "north", "east", "alt", "roll", "pitch", "yaw", "est_roll", "est_pitch", "est_yaw",
+	"sp_north", "sp_east", "sp_alt", "m0", "m1", "m2", "m3"
+};
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "usage: %s [-s sequence] [-o trace_out] [-c trace_in] [-t tolerance] [-T time_limit] [-R]\n", progname);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *sequence_file = nullptr;
+	const char *trace_out = nullptr;
+	const char *trace_in = nullptr;
+	float tolerance = 1e-3f;
+	float time_limit = 300.0f;
+	bool realtime = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "s:o:c:t:T:Rh")) != EOF) {
+		switch (ch) {
+		case 's':
+			sequence_file = optarg;
+			break;
+
+		case 'o':
+			trace_out = optarg;
+			break;
+
+		case 'c':
+			trace_in = optarg;
+			break;
+
+		case 't':
+			tolerance = strtof(optarg, nullptr);
+			break;
+
+		case 'T':
+			time_limit = strtof(optarg, nullptr);
+			break;
+
+		case 'R':
+			realtime = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (load_sequence(sequence_file) != 0 || num_items == 0) {
+		errx(1, "no valid sequence");
+	}
+
+	/* start the simulated clock away from zero, the modules treat zero as never */
+	hrt_sim_set_time(1000000);
+
+	/* parameters at the start of the sequence apply from boot */
+	unsigned current = 0;
+
+	while (current < num_items && items[current].type == ITEM_PARAM) {
+		if (set_param(items[current].name, items[current].value) != 0) {
+			errx(1, "invalid sequence");
+		}
+
+		current++;
+	}
+
+	/* the sensor drivers, their data flows over uORB */
+	sitl_device_register(ACCEL_DEVICE_PATH);
+	sitl_device_register(GYRO_DEVICE_PATH);
+	sitl_device_register(MAG_DEVICE_PATH);
+	sitl_device_register(BARO_DEVICE_PATH);
+	sitl_device_register(ADC_DEVICE_PATH);
+
+	/* the outputs: quad X mixer and PWM limits of the FMU driver */
+	char buf[2048];
+
+	if (load_mixer_file("../../ROMFS/px4fmu_common/mixers/FMU_quad_x.mix", &buf[0], sizeof(buf)) < 0) {
+		errx(1, "failed loading the mixer");
+	}
+
+	MixerGroup mixer(control_callback, 0);
+	unsigned mixer_len = strlen(buf);
+	mixer.load_from_buf(&buf[0], mixer_len);
+
+	if (mixer.count() == 0) {
+		errx(1, "no mixer");
+	}
+
+	pwm_limit_t pwm_limit;
+	pwm_limit_init(&pwm_limit);
+
+	uint16_t disarmed_pwm[MulticopterSim::num_rotors];
+	uint16_t min_pwm[MulticopterSim::num_rotors];
+	uint16_t max_pwm[MulticopterSim::num_rotors];
+
+	for (unsigned i = 0; i < MulticopterSim::num_rotors; i++) {
+		disarmed_pwm[i] = pwm_disarmed;
+		min_pwm[i] = pwm_min;
+		max_pwm[i] = pwm_max;
+	}
+
+	/* the flight stack, in the order of rc.mc_apps */
+	start_module(sensors_main, "sensors");
+	start_module(attitude_estimator_ekf_main, "attitude_estimator_ekf");
+	start_module(mc_att_control_main, "mc_att_control");
+	start_module(mc_pos_control_main, "mc_pos_control");
+
+	/* like on NuttX, a subscriber only sees publications made after it subscribed */
+	wait_subscribers(ORB_ID(sensor_gyro), 1);
+	wait_subscribers(ORB_ID(sensor_accel), 1);
+	wait_subscribers(ORB_ID(sensor_mag), 1);
+	wait_subscribers(ORB_ID(sensor_baro), 1);
+	wait_subscribers(ORB_ID(sensor_combined), 1);
+	wait_subscribers(ORB_ID(vehicle_attitude), 2);
+	wait_subscribers(ORB_ID(vehicle_attitude_setpoint), 2);
+	wait_subscribers(ORB_ID(vehicle_local_position), 1);
+	wait_subscribers(ORB_ID(vehicle_control_mode), 4);
+	wait_subscribers(ORB_ID(actuator_armed), 2);
+	wait_subscribers(ORB_ID(position_setpoint_triplet), 1);
+	wait_subscribers(ORB_ID(parameter_update), 4);
+
+	int actuators_sub = orb_subscribe(ORB_ID(actuator_controls_0));
+	int att_sp_sub = orb_subscribe(ORB_ID(vehicle_attitude_setpoint));
+	int att_sub = orb_subscribe(ORB_ID(vehicle_attitude));
+
+	MulticopterSim sim;
+	sim.reset(start[0], start[1], start[2]);
+
+	struct map_projection_reference_s ref;
+	map_projection_init(&ref, ref_lat, ref_lon);
+
+	/* topics of the drivers, the position estimator, commander and navigator */
+	struct accel_report accel;
+	struct gyro_report gyro;
+	struct mag_report mag;
+	struct baro_report baro;
+	struct vehicle_local_position_s local_pos;
+	struct vehicle_control_mode_s control_mode;
+	struct actuator_armed_s armed;
+	struct position_setpoint_triplet_s triplet;
+	struct vehicle_attitude_setpoint_s att_sp;
+	struct vehicle_attitude_s att;
+	memset(&accel, 0, sizeof(accel));
+	memset(&gyro, 0, sizeof(gyro));
+	memset(&mag, 0, sizeof(mag));
+	memset(&baro, 0, sizeof(baro));
+	memset(&local_pos, 0, sizeof(local_pos));
+	memset(&control_mode, 0, sizeof(control_mode));
+	memset(&armed, 0, sizeof(armed));
+	memset(&triplet, 0, sizeof(triplet));
+	memset(&att_sp, 0, sizeof(att_sp));
+	memset(&att, 0, sizeof(att));
+
+	local_pos.ref_lat = ref_lat;
+	local_pos.ref_lon = ref_lon;
+	local_pos.ref_alt = ref_alt;
+	local_pos.ref_timestamp = hrt_absolute_time();
+
+	/* on the ground and disarmed, in attitude mode until the first item */
+	control_mode.flag_control_attitude_enabled = true;
+	control_mode.flag_control_rates_enabled = true;
+	armed.ready_to_arm = true;
+	att_sp.R_valid = false;
+
+	orb_advert_t accel_pub = -1;
+	orb_advert_t gyro_pub = -1;
+	orb_advert_t mag_pub = -1;
+	orb_advert_t baro_pub = -1;
+	orb_advert_t local_pos_pub = -1;
+	orb_advert_t control_mode_pub = -1;
+	orb_advert_t armed_pub = -1;
+	orb_advert_t triplet_pub = -1;
+	orb_advert_t att_sp_pub = -1;
+
+	bool mode_changed = true;
+	bool pos_control = false;
+	bool warmed_up = false;
+	unsigned missed = 0;
+	unsigned cycles = 0;
+
+	float motors[MulticopterSim::num_rotors] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	math::Vector<3> pos_sp(start[0], start[1], 0.0f);
+
+	float t = 0.0f;
+	float item_start = preflight_time;
+	float landed_time = 0.0f;
+	bool item_started = false;
+	bool failed = false;
+
+	/* tracking errors */
+	float att_err_sq = 0.0f;
+	unsigned att_err_n = 0;
+	float est_err_sq = 0.0f;
+	unsigned est_err_n = 0;
+	float pos_err_sq = 0.0f;
+	unsigned pos_err_n = 0;
+	float max_tilt = 0.0f;
+
+	sim_trace_init(trace_columns, TRACE_COLUMNS);
+
+	uint64_t wall_start = bench_time_ns();
+	uint64_t harness_cpu_start = cpu_ns(CLOCK_THREAD_CPUTIME_ID);
+
+	while (current < num_items) {
+		hrt_abstime now = hrt_absolute_time();
+
+		if (t > time_limit) {
+			warnx("FAIL: time limit of %.0f s reached in item %u", (double)time_limit, current + 1);
+			failed = true;
+			break;
+		}
+
+		/* commander and navigator: the current item, after the preflight time */
+		if (t >= preflight_time) {
+			item &it = items[current];
+
+			if (!item_started) {
+				item_started = true;
+				item_start = t;
+				mode_changed = true;
+
+				switch (it.type) {
+				case ITEM_PARAM:
+					if (set_param(it.name, it.value) != 0) {
+						failed = true;
+					}
+
+					break;
+
+				case ITEM_TAKEOFF:
+					pos_sp = math::Vector<3>(sim.position()(0), sim.position()(1), -it.alt);
+					break;
+
+				case ITEM_WP:
+					pos_sp = math::Vector<3>(it.north, it.east, -it.alt);
+					break;
+
+				case ITEM_LAND:
+					pos_sp(2) = 0.0f;
+					landed_time = 0.0f;
+					break;
+
+				default:
+					break;
+				}
+
+				armed.armed = true;
+				pos_control = (it.type != ITEM_ATT);
+
+				control_mode.flag_armed = true;
+				control_mode.flag_control_auto_enabled = pos_control;
+				control_mode.flag_control_position_enabled = pos_control;
+				control_mode.flag_control_velocity_enabled = pos_control;
+				control_mode.flag_control_altitude_enabled = pos_control;
+				control_mode.flag_control_climb_rate_enabled = pos_control;
+
+				if (it.type == ITEM_TAKEOFF || it.type == ITEM_WP || it.type == ITEM_LAND) {
+					triplet.current.valid = true;
+					triplet.current.type = (it.type == ITEM_TAKEOFF) ? SETPOINT_TYPE_TAKEOFF :
+							       (it.type == ITEM_LAND) ? SETPOINT_TYPE_LAND : SETPOINT_TYPE_NORMAL;
+					map_projection_reproject(&ref, pos_sp(0), pos_sp(1), &triplet.current.lat, &triplet.current.lon);
+					triplet.current.alt = ref_alt - pos_sp(2);
+					triplet.current.yaw = it.yaw;
+				}
+
+				if (it.type == ITEM_ATT) {
+					math::Matrix<3, 3> R_sp;
+					R_sp.from_euler(it.roll, it.pitch, it.yaw);
+					memcpy(&att_sp.R_body[0][0], R_sp.data, sizeof(att_sp.R_body));
+					att_sp.R_valid = true;
+					att_sp.roll_body = it.roll;
+					att_sp.pitch_body = it.pitch;
+					att_sp.yaw_body = it.yaw;
+					att_sp.thrust = it.thrust;
+				}
+			}
+
+			/* advance the sequence */
+			float elapsed = t - item_start;
+			math::Vector<3> pos_err = pos_sp - sim.position();
+			bool done = false;
+
+			switch (it.type) {
+			case ITEM_PARAM:
+				done = true;
+				break;
+
+			case ITEM_TAKEOFF:
+			case ITEM_WP:
+				done = math::Vector<2>(pos_err(0), pos_err(1)).length() < acceptance_radius &&
+				       fabsf(pos_err(2)) < acceptance_alt;
+				break;
+
+			case ITEM_HOLD:
+				if (elapsed > 1.0f) {
+					pos_err_sq += pos_err * pos_err;
+					pos_err_n++;
+				}
+
+				done = (elapsed >= it.duration);
+				break;
+
+			case ITEM_ATT:
+				if (elapsed > it.duration - 0.5f) {
+					float e_roll = sim.euler()(0) - it.roll;
+					float e_pitch = sim.euler()(1) - it.pitch;
+					att_err_sq += e_roll * e_roll + e_pitch * e_pitch;
+					att_err_n += 2;
+				}
+
+				done = (elapsed >= it.duration);
+				break;
+
+			case ITEM_LAND:
+				landed_time = sim.landed() ? landed_time + cycle_us * 1e-6f : 0.0f;
+
+				if (landed_time >= 1.0f) {
+					/* disarm like commander after the land detector triggers */
+					armed.armed = false;
+					control_mode.flag_armed = false;
+					mode_changed = true;
+					done = true;
+				}
+
+				break;
+			}
+
+			if (!done && elapsed > item_timeout) {
+				warnx("FAIL: item %u did not complete in %.0f s", current + 1, (double)item_timeout);
+				failed = true;
+				break;
+			}
+
+			if (done) {
+				current++;
+				item_started = false;
+			}
+		}
+
+		if (mode_changed) {
+			mode_changed = false;
+			control_mode.timestamp = now;
+			armed.timestamp = now;
+
+			if (control_mode_pub > 0) {
+				orb_publish(ORB_ID(vehicle_control_mode), control_mode_pub, &control_mode);
+				orb_publish(ORB_ID(actuator_armed), armed_pub, &armed);
+				orb_publish(ORB_ID(position_setpoint_triplet), triplet_pub, &triplet);
+
+			} else {
+				control_mode_pub = orb_advertise(ORB_ID(vehicle_control_mode), &control_mode);
+				armed_pub = orb_advertise(ORB_ID(actuator_armed), &armed);
+				triplet_pub = orb_advertise(ORB_ID(position_setpoint_triplet), &triplet);
+			}
+		}
+
+		/* in attitude mode the harness is the source of the attitude setpoint */
+		if (!pos_control && cycles % pos_divider == 0) {
+			att_sp.timestamp = now;
+
+			if (att_sp_pub > 0) {
+				orb_publish(ORB_ID(vehicle_attitude_setpoint), att_sp_pub, &att_sp);
+
+			} else {
+				att_sp_pub = orb_advertise(ORB_ID(vehicle_attitude_setpoint), &att_sp);
+			}
+		}
+
+		const math::Vector<3> &pos = sim.position();
+		const math::Vector<3> &vel = sim.velocity();
+		const math::Matrix<3, 3> &R = sim.R();
+
+		/* position estimate, magnetometer and barometer at 50 Hz */
+		if (cycles % pos_divider == 0) {
+			local_pos.timestamp = now;
+			local_pos.xy_valid = true;
+			local_pos.z_valid = true;
+			local_pos.v_xy_valid = true;
+			local_pos.v_z_valid = true;
+			local_pos.x = pos(0);
+			local_pos.y = pos(1);
+			local_pos.z = pos(2);
+			local_pos.vx = vel(0);
+			local_pos.vy = vel(1);
+			local_pos.vz = vel(2);
+			local_pos.yaw = sim.euler()(2);
+			local_pos.xy_global = true;
+			local_pos.z_global = true;
+			local_pos.landed = sim.landed();
+			local_pos.dist_bottom = sim.altitude();
+			local_pos.dist_bottom_valid = true;
+
+			math::Vector<3> field = R.transposed() * math::Vector<3>(mag_earth[0], mag_earth[1], mag_earth[2]);
+			mag.timestamp = now;
+			mag.x = field(0) + noise(mag_noise);
+			mag.y = field(1) + noise(mag_noise);
+			mag.z = field(2) + noise(mag_noise);
+
+			float alt_amsl = ref_alt + sim.altitude() + noise(baro_noise);
+			baro.timestamp = now;
+			baro.altitude = alt_amsl;
+			baro.pressure = 1013.25f * powf(1.0f - alt_amsl / 44330.8f, 5.2559f);
+			baro.temperature = 20.0f;
+
+			if (mag_pub > 0) {
+				orb_publish(ORB_ID(sensor_mag), mag_pub, &mag);
+				orb_publish(ORB_ID(sensor_baro), baro_pub, &baro);
+				orb_publish(ORB_ID(vehicle_local_position), local_pos_pub, &local_pos);
+
+			} else {
+				mag_pub = orb_advertise(ORB_ID(sensor_mag), &mag);
+				baro_pub = orb_advertise(ORB_ID(sensor_baro), &baro);
+				local_pos_pub = orb_advertise(ORB_ID(vehicle_local_position), &local_pos);
+			}
+
+			/* mc_pos_control runs on the position estimate, its setpoint must be in before the attitude controller runs */
+			if (pos_control && !wait_for(att_sp_sub, ORB_ID(vehicle_attitude_setpoint), &att_sp,
+						     &att_sp.timestamp, now, 1000)) {
+				warnx("FAIL: no attitude setpoint from mc_pos_control at t=%.3f s", (double)t);
+				failed = true;
+				break;
+			}
+		}
+
+		/* IMU at 250 Hz, the gyro paces the sensors module */
+		const math::Vector<3> &specific_force = sim.accel_body();
+		const math::Vector<3> &rates = sim.rates();
+
+		accel.timestamp = now;
+		accel.x = specific_force(0) + noise(accel_noise);
+		accel.y = specific_force(1) + noise(accel_noise);
+		accel.z = specific_force(2) + noise(accel_noise);
+		accel.temperature = 20.0f;
+
+		gyro.timestamp = now;
+		gyro.x = rates(0) + noise(gyro_noise);
+		gyro.y = rates(1) + noise(gyro_noise);
+		gyro.z = rates(2) + noise(gyro_noise);
+		gyro.temperature = 20.0f;
+
+		if (accel_pub > 0) {
+			orb_publish(ORB_ID(sensor_accel), accel_pub, &accel);
+
+		} else {
+			accel_pub = orb_advertise(ORB_ID(sensor_accel), &accel);
+		}
+
+		uint64_t sample_time = bench_time_ns();
+
+		if (gyro_pub > 0) {
+			orb_publish(ORB_ID(sensor_gyro), gyro_pub, &gyro);
+
+		} else {
+			gyro_pub = orb_advertise(ORB_ID(sensor_gyro), &gyro);
+		}
+
+		/* wait for the controls computed from this sample; the estimator skips its first samples */
+		if (wait_for(actuators_sub, ORB_ID(actuator_controls_0), &actuators, &actuators.timestamp_sample,
+			     now, warmed_up ? 1000 : 20)) {
+			latency_add((bench_time_ns() - sample_time) * 1e-3f);
+			warmed_up = true;
+
+		} else if (warmed_up) {
+			missed++;
+		}
+
+		bool att_updated;
+		orb_check(att_sub, &att_updated);
+
+		if (att_updated) {
+			orb_copy(ORB_ID(vehicle_attitude), att_sub, &att);
+		}
+
+		/* mix and limit like the FMU output driver */
+		float outputs[MulticopterSim::num_rotors];
+		uint16_t pwm[MulticopterSim::num_rotors];
+		unsigned mixed = mixer.mix(&outputs[0], MulticopterSim::num_rotors);
+
+		for (unsigned i = mixed; i < MulticopterSim::num_rotors; i++) {
+			outputs[i] = -1.0f;
+		}
+
+		for (unsigned i = 0; i < MulticopterSim::num_rotors; i++) {
+			if (!isfinite(outputs[i])) {
+				outputs[i] = -1.0f;
+			}
+		}
+
+		pwm_limit_calc(armed.armed, MulticopterSim::num_rotors, disarmed_pwm, min_pwm, max_pwm, outputs, pwm, &pwm_limit);
+
+		for (unsigned i = 0; i < MulticopterSim::num_rotors; i++) {
+			motors[i] = math::constrain((pwm[i] - pwm_min) / (float)(pwm_max - pwm_min), 0.0f, 1.0f);
+		}
+
+		/* errors and trace */
+		const math::Vector<3> &euler = sim.euler();
+
+		if (att_updated && t > preflight_time) {
+			float e_roll = att.roll - euler(0);
+			float e_pitch = att.pitch - euler(1);
+			est_err_sq += e_roll * e_roll + e_pitch * e_pitch;
+			est_err_n += 2;
+		}
+
+		float tilt = acosf(math::constrain(R(2, 2), -1.0f, 1.0f));
+
+		if (tilt > max_tilt) {
+			max_tilt = tilt;
+		}
+
+		if (!isfinite(pos(0)) || !isfinite(pos(2)) || tilt > math::radians(80.0f)) {
+			warnx("FAIL: vehicle lost at t=%.2f s in item %u", (double)t, current + 1);
+			failed = true;
+			break;
+		}
+
+		if (cycles % trace_divider == 0) {
+			float row[TRACE_COLUMNS] = {
+				t, pos(0), pos(1), sim.altitude(), euler(0), euler(1), euler(2), att.roll, att.pitch, att.yaw,
+				pos_sp(0), pos_sp(1), -pos_sp(2), motors[0], motors[1], motors[2], motors[3]
+			};
+			sim_trace_add(row);
+		}
+
+		/* integrate the model and advance the clock */
+		for (unsigned i = 0; i < substeps; i++) {
+			sim.update(motors, cycle_us * 1e-6f / substeps);
+		}
+
+		hrt_sim_advance(cycle_us);
+		cycles++;
+		t = cycles * cycle_us * 1e-6f;
+
+		if (realtime) {
+			int64_t ahead_us = (int64_t)(t * 1e6f) - (int64_t)((bench_time_ns() - wall_start) / 1000);
+
+			if (ahead_us > 0) {
+				usleep(ahead_us);
+			}
+		}
+	}
+
+	double wall_s = (bench_time_ns() - wall_start) * 1e-9;
+	uint64_t harness_cpu = cpu_ns(CLOCK_THREAD_CPUTIME_ID) - harness_cpu_start;
+
+	if (missed > 0) {
+		warnx("FAIL: %u control cycles without actuator controls", missed);
+		failed = true;
+	}
+
+	if (latency_len > 0) {
+		double sum = 0.0;
+
+		for (unsigned i = 0; i < latency_len; i++) {
+			sum += latency[i];
+		}
+
+		qsort(latency, latency_len, sizeof(latency[0]), float_cmp);
+		printf("%-40s %10s %10s %10s %10s\n", "sensor to actuator latency", "mean us", "p50 us", "p99 us", "max us");
+		printf("%-40s %10.1f %10.1f %10.1f %10.1f\n\n", "gyro -> actuator_controls_0", sum / latency_len,
+		       (double)latency[latency_len / 2], (double)latency[(latency_len * 99) / 100], (double)latency[latency_len - 1]);
+	}
+
+	printf("%-40s %14s\n", "task", "CPU us/cycle");
+
+	for (unsigned i = 0; i < sitl_task_count(); i++) {
+		printf("%-40s %14.1f\n", sitl_task_name(i), (cycles > 0) ? sitl_task_cpu_ns(i) * 1e-3 / cycles : 0.0);
+	}
+
+	printf("%-40s %14.1f\n", "harness (model, mixer, topics)", (cycles > 0) ? harness_cpu * 1e-3 / cycles : 0.0);
+	printf("%-40s %14.1f\n", "process", (cycles > 0) ? cpu_ns(CLOCK_PROCESS_CPUTIME_ID) * 1e-3 / cycles : 0.0);
+
+	float att_rms = (att_err_n > 0) ? math::degrees(sqrtf(att_err_sq / att_err_n)) : 0.0f;
+	float est_rms = (est_err_n > 0) ? math::degrees(sqrtf(est_err_sq / est_err_n)) : 0.0f;
+	float pos_rms = (pos_err_n > 0) ? sqrtf(pos_err_sq / pos_err_n) : 0.0f;
+
+	printf("\nflew %u of %u items in %.1f s simulated, %u cycles, %.3f s wall clock (%.1fx real time)\n",
+	       current, num_items, (double)t, cycles, wall_s, (double)t / wall_s);
+	printf("attitude error RMS %.2f deg (settled), estimator error RMS %.2f deg, hold position error RMS %.2f m, max tilt %.1f deg\n",
+	       (double)att_rms, (double)est_rms, (double)pos_rms, (double)math::degrees(max_tilt));
+
+	int ret = failed ? 1 : 0;
+
+	if (trace_out != nullptr && sim_trace_write(trace_out) != 0) {
+		ret = 1;
+	}
+
+	if (trace_in != nullptr && sim_trace_compare(trace_in, tolerance) != 0) {
+		ret = 1;
+	}
+
+	sim_trace_free();
+	free(latency);
+	return ret;
+}
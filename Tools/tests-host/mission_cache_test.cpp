@@ -0,0 +1,354 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mission_cache_test.cpp
+ *
+ * Host test of the navigator mission item look-ahead cache.
+ *
+ * Runs Mission against an in-memory dataman and checks that stepping
+ * through a mission is served from the prefetched window, that items
+ * outside of the window are read on demand, and that a changed mission
+ * is never served from the cache after the mission update.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <systemlib/err.h>
+#include <systemlib/perf_counter.h>
+#include <dataman/dataman.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/mission_result.h>
+
+#include "../../src/modules/navigator/navigator_mission.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+#define MISSION_ITEMS	10
+
+/*
+ * In-memory dataman. An item is identified by its altitude,
+ * generation * 1000 + index, so a stale item is told apart from the
+ * current one.
+ */
+static struct mission_item_s	store[DM_KEY_NUM_KEYS][MISSION_ITEMS];
+static unsigned			dm_reads;
+
+extern "C" ssize_t
+dm_read(dm_item_t item, unsigned char index, void *buffer, size_t buflen)
+{
+	if (index >= MISSION_ITEMS || buflen != sizeof(struct mission_item_s)) {
+		return -1;
+	}
+
+	dm_reads++;
+	memcpy(buffer, &store[item][index], buflen);
+	return buflen;
+}
+
+static void
+write_mission(dm_item_t item, unsigned generation)
+{
+	for (unsigned i = 0; i < MISSION_ITEMS; i++) {
+		memset(&store[item][i], 0, sizeof(store[item][i]));
+		store[item][i].altitude = generation * 1000 + i;
+		store[item][i].nav_cmd = NAV_CMD_WAYPOINT;
+	}
+}
+
+static float
+expected(unsigned generation, unsigned index)
+{
+	return generation * 1000 + index;
+}
+
+/*
+ * Counting perf counters, the test reads the cache hits and stalls.
+ */
+struct perf_ctr_header {
+	const char	*name;
+	unsigned	count;
+};
+
+static struct perf_ctr_header	counters[8];
+static unsigned			num_counters;
+
+extern "C" perf_counter_t
+perf_alloc(enum perf_counter_type type, const char *name)
+{
+	if (num_counters >= sizeof(counters) / sizeof(counters[0])) {
+		return nullptr;
+	}
+
+	counters[num_counters].name = name;
+	counters[num_counters].count = 0;
+	return &counters[num_counters++];
+}
+
+extern "C" void
+perf_free(perf_counter_t handle)
+{
+}
+
+extern "C" void
+perf_count(perf_counter_t handle)
+{
+	if (handle != nullptr) {
+		handle->count++;
+	}
+}
+
+static unsigned
+counter(const char *name)
+{
+	for (unsigned i = 0; i < num_counters; i++) {
+		if (strcmp(counters[i].name, name) == 0) {
+			return counters[i].count;
+		}
+	}
+
+	return 0;
+}
+
+/* the mission result publication */
+ORB_DEFINE(mission_result, struct mission_result_s);
+
+orb_advert_t
+orb_advertise(const struct orb_metadata *meta, const void *data)
+{
+	return 1;
+}
+
+int
+orb_publish(const struct orb_metadata *meta, orb_advert_t handle, const void *data)
+{
+	return 0;
+}
+
+/* the navigator loop: prefetch until the window is complete */
+static void
+prefetch_all(Mission &mission)
+{
+	for (unsigned i = 0; i < 3; i++) {
+		mission.prefetch();
+	}
+}
+
+static bool
+current_is(Mission &mission, float altitude)
+{
+	struct mission_item_s item;
+	bool onboard;
+	unsigned index;
+
+	return mission.get_current_mission_item(&item, &onboard, &index) == 0 && item.altitude == altitude;
+}
+
+static bool
+next_is(Mission &mission, float altitude)
+{
+	struct mission_item_s item;
+
+	return mission.get_next_mission_item(&item) == 0 && item.altitude == altitude;
+}
+
+static void
+test_step_through()
+{
+	Mission mission;
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 1);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+
+	dm_reads = 0;
+	prefetch_all(mission);
+	CHECK(dm_reads == 3);
+
+	/* one loop iteration per transition, every lookup is a hit */
+	for (unsigned i = 0; i < MISSION_ITEMS; i++) {
+		CHECK(current_is(mission, expected(1, i)));
+
+		if (i + 1 < MISSION_ITEMS) {
+			CHECK(next_is(mission, expected(1, i + 1)));
+		}
+
+		mission.move_to_next();
+		mission.prefetch();
+	}
+
+	CHECK(counter("mission cache stall") == 0);
+	CHECK(counter("mission cache hit") == 2 * MISSION_ITEMS - 1);
+	CHECK(dm_reads == MISSION_ITEMS);
+	CHECK(!mission.current_mission_available());
+}
+
+static void
+test_miss()
+{
+	Mission mission;
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 1);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+	prefetch_all(mission);
+
+	/* a jump out of the window reads on demand, then prefetches around the new index */
+	mission.set_current_offboard_mission_index(7);
+	CHECK(current_is(mission, expected(1, 7)));
+	CHECK(counter("mission cache stall") == 1);
+
+	prefetch_all(mission);
+	CHECK(next_is(mission, expected(1, 8)));
+	CHECK(counter("mission cache stall") == 1);
+
+	/* back into items that were evicted */
+	mission.set_current_offboard_mission_index(1);
+	CHECK(current_is(mission, expected(1, 1)));
+	CHECK(next_is(mission, expected(1, 2)));
+	CHECK(counter("mission cache stall") == 3);
+}
+
+static void
+test_mission_update()
+{
+	Mission mission;
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 1);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+	prefetch_all(mission);
+	CHECK(current_is(mission, expected(1, 0)));
+
+	/* rewritten in place with the same count, as a re-upload into the same slot */
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 2);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+	CHECK(current_is(mission, expected(2, 0)));
+	CHECK(next_is(mission, expected(2, 1)));
+
+	prefetch_all(mission);
+	CHECK(current_is(mission, expected(2, 0)));
+	CHECK(next_is(mission, expected(2, 1)));
+
+	/* upload into the other slot, as mavlink alternates them */
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_1, 3);
+	mission.set_offboard_dataman_id(1);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+	CHECK(current_is(mission, expected(3, 0)));
+	prefetch_all(mission);
+	CHECK(next_is(mission, expected(3, 1)));
+
+	/* and back into the first slot, none of its earlier items may survive */
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 4);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_current_offboard_mission_index(0);
+	CHECK(current_is(mission, expected(4, 0)));
+	CHECK(next_is(mission, expected(4, 1)));
+
+	/* a shorter mission resets the index to its first item */
+	mission.move_to_next();
+	mission.move_to_next();
+	prefetch_all(mission);
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 5);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(2);
+	mission.set_current_offboard_mission_index(-1);
+	CHECK(current_is(mission, expected(5, 0)));
+	CHECK(next_is(mission, expected(5, 1)));
+}
+
+static void
+test_onboard_update()
+{
+	Mission mission;
+	write_mission(DM_KEY_WAYPOINTS_OFFBOARD_0, 1);
+	write_mission(DM_KEY_WAYPOINTS_ONBOARD, 6);
+	mission.set_onboard_mission_allowed(true);
+	mission.set_offboard_dataman_id(0);
+	mission.set_offboard_mission_count(MISSION_ITEMS);
+	mission.set_onboard_mission_count(MISSION_ITEMS);
+	mission.set_current_onboard_mission_index(0);
+	prefetch_all(mission);
+
+	/* the onboard mission takes precedence */
+	CHECK(current_is(mission, expected(6, 0)));
+	CHECK(next_is(mission, expected(6, 1)));
+
+	write_mission(DM_KEY_WAYPOINTS_ONBOARD, 7);
+	mission.set_onboard_mission_count(MISSION_ITEMS);
+	mission.set_current_onboard_mission_index(0);
+	CHECK(current_is(mission, expected(7, 0)));
+	prefetch_all(mission);
+	CHECK(next_is(mission, expected(7, 1)));
+
+	/* onboard mission cleared: the offboard one, not a cached onboard item */
+	mission.set_onboard_mission_count(0);
+	mission.set_current_onboard_mission_index(0);
+	CHECK(current_is(mission, expected(1, 0)));
+}
+
+int
+main(int argc, char *argv[])
+{
+	test_step_through();
+
+	/* counters are per test */
+	num_counters = 0;
+	test_miss();
+
+	num_counters = 0;
+	test_mission_update();
+
+	num_counters = 0;
+	test_onboard_update();
+
+	if (failures > 0) {
+		warnx("%u checks FAILED", failures);
+		return 1;
+	}
+
+	warnx("all checks passed");
+	return 0;
+}
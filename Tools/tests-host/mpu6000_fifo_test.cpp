@@ -0,0 +1,280 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mpu6000_fifo_test.cpp
+ *
+ * Host test of the MPU6000 FIFO reader against a mocked sensor.
+ *
+ * The mock implements the FIFO count and data registers of the SPI
+ * register file: samples are pushed into a 1024 byte FIFO that
+ * overflows like the real one, and bursts are served from it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <systemlib/err.h>
+#include <drivers/drv_hrt.h>
+#include <mpu6000/mpu6000_fifo.h>
+
+#include "bench.h"
+
+#define DIR_READ	0x80
+
+struct MockMPU6000 {
+	uint8_t		fifo[MPU6000_FIFO_SIZE];
+	unsigned	count;
+	bool		overflowed;
+	unsigned	transfers;
+	unsigned	fail_after;	/**< fail transfers after this many, 0 never */
+
+	MockMPU6000() { reset(); }
+
+	void reset()
+	{
+		count = 0;
+		overflowed = false;
+		transfers = 0;
+		fail_after = 0;
+	}
+
+	/* push one sample, derived from its sequence number, into the FIFO */
+	void push(int16_t seq)
+	{
+		if (count + MPU6000_FIFO_SAMPLE_SIZE > MPU6000_FIFO_SIZE) {
+			/* the sensor keeps writing, overwriting the oldest bytes */
+			overflowed = true;
+			count = MPU6000_FIFO_SIZE;
+			return;
+		}
+
+		for (unsigned v = 0; v < 7; v++) {
+			int16_t value = seq * 7 + v - 300;
+			fifo[count++] = (uint8_t)((uint16_t)value >> 8);
+			fifo[count++] = (uint8_t)(value & 0xff);
+		}
+	}
+
+	static int transfer(void *arg, uint8_t *send, uint8_t *recv, unsigned len)
+	{
+		MockMPU6000 *mock = reinterpret_cast<MockMPU6000 *>(arg);
+
+		mock->transfers++;
+
+		if (mock->fail_after != 0 && mock->transfers > mock->fail_after)
+			return -EIO;
+
+		if (len < 2 || !(send[0] & DIR_READ))
+			return -EINVAL;
+
+		unsigned reg = send[0] & ~DIR_READ;
+
+		if (reg == MPUREG_FIFO_COUNTH) {
+			recv[1] = mock->count >> 8;
+
+			if (len > 2)
+				recv[2] = mock->count & 0xff;
+
+			return 0;
+		}
+
+		if (reg == MPUREG_FIFO_R_W) {
+			unsigned n = len - 1;
+
+			if (n > mock->count)
+				return -EIO;
+
+			memcpy(&recv[1], mock->fifo, n);
+			memmove(mock->fifo, &mock->fifo[n], mock->count - n);
+			mock->count -= n;
+			return 0;
+		}
+
+		return -EINVAL;
+	}
+};
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static bool
+sample_matches(const mpu6000_fifo_sample &s, int16_t seq)
+{
+	const int16_t *values = &s.accel_x;
+
+	for (unsigned v = 0; v < 7; v++) {
+		if (values[v] != (int16_t)(seq * 7 + v - 300))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+test_burst()
+{
+	MockMPU6000 mock;
+	MPU6000_FIFO fifo(&MockMPU6000::transfer, &mock);
+	mpu6000_fifo_sample samples[MPU6000_FIFO_MAX_SAMPLES];
+	hrt_abstime timestamps[MPU6000_FIFO_MAX_SAMPLES];
+
+	fifo.set_sample_interval(1000);
+
+	/* empty FIFO */
+	CHECK(fifo.read(10000, samples, timestamps) == 0);
+
+	for (int16_t i = 0; i < 4; i++)
+		mock.push(i);
+
+	mock.transfers = 0;
+	CHECK(fifo.read(10000, samples, timestamps) == 4);
+	CHECK(mock.transfers == 2);
+
+	for (int16_t i = 0; i < 4; i++) {
+		CHECK(sample_matches(samples[i], i));
+	}
+
+	/* the newest sample is stamped with the read time, older ones back by the interval */
+	CHECK(timestamps[3] == 10000);
+	CHECK(timestamps[2] == 9000);
+	CHECK(timestamps[0] == 7000);
+	CHECK(mock.count == 0);
+	CHECK(fifo.samples() == 4);
+}
+
+static void
+test_partial()
+{
+	MockMPU6000 mock;
+	MPU6000_FIFO fifo(&MockMPU6000::transfer, &mock);
+	mpu6000_fifo_sample samples[MPU6000_FIFO_MAX_SAMPLES];
+	hrt_abstime timestamps[MPU6000_FIFO_MAX_SAMPLES];
+
+	fifo.set_sample_interval(500);
+
+	/* more than one burst, the rest stays queued and keeps its age */
+	unsigned queued = MPU6000_FIFO_MAX_SAMPLES + 5;
+
+	for (unsigned i = 0; i < queued; i++)
+		mock.push(i);
+
+	CHECK(fifo.read(100000, samples, timestamps) == MPU6000_FIFO_MAX_SAMPLES);
+	CHECK(sample_matches(samples[0], 0));
+	CHECK(sample_matches(samples[MPU6000_FIFO_MAX_SAMPLES - 1], MPU6000_FIFO_MAX_SAMPLES - 1));
+	CHECK(timestamps[0] == 100000 - (queued - 1) * 500);
+	CHECK(timestamps[MPU6000_FIFO_MAX_SAMPLES - 1] == 100000 - 5 * 500);
+
+	CHECK(fifo.read(100000, samples, timestamps) == 5);
+	CHECK(sample_matches(samples[0], MPU6000_FIFO_MAX_SAMPLES));
+	CHECK(timestamps[4] == 100000);
+	CHECK(fifo.overruns() == 0);
+}
+
+static void
+test_overflow()
+{
+	MockMPU6000 mock;
+	MPU6000_FIFO fifo(&MockMPU6000::transfer, &mock);
+	mpu6000_fifo_sample samples[MPU6000_FIFO_MAX_SAMPLES];
+	hrt_abstime timestamps[MPU6000_FIFO_MAX_SAMPLES];
+
+	/* a full FIFO has lost samples */
+	for (unsigned i = 0; i < 100; i++)
+		mock.push(i);
+
+	CHECK(mock.overflowed);
+	CHECK(fifo.read(0, samples, timestamps) == -EOVERFLOW);
+	CHECK(fifo.overruns() == 1);
+
+	/* a misaligned count means a torn sample */
+	mock.reset();
+	mock.push(1);
+	mock.count -= 2;
+	CHECK(fifo.read(0, samples, timestamps) == -EOVERFLOW);
+	CHECK(fifo.overruns() == 2);
+
+	/* after the driver reset the FIFO, reads work again */
+	mock.reset();
+	mock.push(42);
+	CHECK(fifo.read(0, samples, timestamps) == 1);
+	CHECK(sample_matches(samples[0], 42));
+
+	/* bus errors are reported, not counted as overruns */
+	mock.reset();
+	mock.push(1);
+	mock.fail_after = 1;
+	CHECK(fifo.read(0, samples, timestamps) == -EIO);
+	CHECK(fifo.overruns() == 2);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("MPU6000 FIFO test started");
+
+	test_burst();
+	test_partial();
+	test_overflow();
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	/* cost of parsing a burst, excluding the mocked bus */
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	MockMPU6000 mock;
+	MPU6000_FIFO fifo(&MockMPU6000::transfer, &mock);
+	mpu6000_fifo_sample samples[MPU6000_FIFO_MAX_SAMPLES];
+	hrt_abstime timestamps[MPU6000_FIFO_MAX_SAMPLES];
+	const unsigned bursts[] = { 1, 4, MPU6000_FIFO_MAX_SAMPLES };
+
+	for (unsigned b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+		char title[40];
+		snprintf(title, sizeof(title), "MPU6000_FIFO::read %u samples", bursts[b]);
+
+		BENCH_OP(title, (mock.count = bursts[b] * MPU6000_FIFO_SAMPLE_SIZE,
+				 fifo.read(0, samples, timestamps)));
+	}
+
+	return bench_finish();
+}
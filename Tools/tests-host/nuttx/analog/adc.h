@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the NuttX ADC driver interface.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct adc_msg_s {
+	uint8_t		am_channel;
+	int32_t		am_data;
+} __attribute__((packed));
@@ -0,0 +1,5 @@
+/*
+ * Host stand-in for the NuttX architecture header, see px4io_sim_compat.h.
+ */
+
+#pragma once
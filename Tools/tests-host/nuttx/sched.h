@@ -0,0 +1,5 @@
+/*
+ * Host stand-in for the NuttX scheduler header, see sitl_compat.h.
+ */
+
+#pragma once
@@ -0,0 +1,313 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file param_test.cpp
+ *
+ * Host test and benchmark of parameter export and import.
+ *
+ * The parameter store is built with the parameter definitions of the
+ * flight control modules, all values are modified, and the set is
+ * saved to and loaded from a temporary file. File read/write calls are
+ * counted to show the effect of the BSON I/O window.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <systemlib/err.h>
+#include <systemlib/param/param.h>
+/* tinybson.h is a C header using a C++ keyword as a parameter name */
+#define private bson_private
+__BEGIN_DECLS
+#include <systemlib/bson/tinybson.h>
+__END_DECLS
+#undef private
+#include <uORB/uORB.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* file calls made by the parameter and BSON code, see the --wrap options in the Makefile */
+static unsigned	write_calls;
+static unsigned	read_calls;
+
+/* parameter_update notifications */
+static unsigned	notifications;
+
+extern "C" {
+	ssize_t __real_write(int fd, const void *buf, size_t count);
+	ssize_t __real_read(int fd, void *buf, size_t count);
+
+	ssize_t __wrap_write(int fd, const void *buf, size_t count)
+	{
+		write_calls++;
+		return __real_write(fd, buf, count);
+	}
+
+	ssize_t __wrap_read(int fd, void *buf, size_t count)
+	{
+		read_calls++;
+		return __real_read(fd, buf, count);
+	}
+
+	orb_advert_t orb_advertise(const struct orb_metadata *meta, const void *data)
+	{
+		notifications++;
+		return 1;
+	}
+
+	int orb_publish(const struct orb_metadata *meta, orb_advert_t handle, const void *data)
+	{
+		notifications++;
+		return 0;
+	}
+}
+
+/*
+ * Give every parameter a value that differs from its default and identifies it.
+ */
+static void
+set_all(unsigned seed)
+{
+	for (unsigned i = 0; i < param_count(); i++) {
+		param_t p = param_for_index(i);
+
+		if (param_type(p) == PARAM_TYPE_INT32) {
+			int32_t v = seed + i;
+			param_set(p, &v);
+
+		} else if (param_type(p) == PARAM_TYPE_FLOAT) {
+			float v = seed + i * 0.5f;
+			param_set(p, &v);
+		}
+	}
+}
+
+static bool
+check_all(unsigned seed)
+{
+	for (unsigned i = 0; i < param_count(); i++) {
+		param_t p = param_for_index(i);
+
+		if (param_type(p) == PARAM_TYPE_INT32) {
+			int32_t v;
+			param_get(p, &v);
+
+			if (v != (int32_t)(seed + i))
+				return false;
+
+		} else if (param_type(p) == PARAM_TYPE_FLOAT) {
+			float v;
+			param_get(p, &v);
+
+			if (v != seed + i * 0.5f)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+rewind_fd(int fd)
+{
+	return (int)lseek(fd, 0, SEEK_SET);
+}
+
+static void
+test_save_load(int fd)
+{
+	set_all(1000);
+
+	/* save the full set */
+	CHECK(ftruncate(fd, 0) == 0);
+	write_calls = 0;
+	CHECK(param_export(fd, false) == 0);
+	off_t size = lseek(fd, 0, SEEK_CUR);
+	warnx("%u parameters, %u bytes saved in %u write calls", param_count(), (unsigned)size, write_calls);
+	CHECK(write_calls <= size / BSON_FILE_WINDOW + 1);
+
+	/* load it back, notifying once */
+	param_reset_all();
+	CHECK(!check_all(1000));
+	CHECK(rewind_fd(fd) == 0);
+	notifications = 0;
+	read_calls = 0;
+	CHECK(param_load(fd) == 0);
+	warnx("loaded in %u read calls", read_calls);
+	CHECK(notifications == 1);
+	CHECK(check_all(1000));
+
+	/* loaded values are saved */
+	bool unsaved = false;
+
+	for (unsigned i = 0; i < param_count(); i++)
+		unsaved |= param_value_unsaved(param_for_index(i));
+
+	CHECK(!unsaved);
+
+	/* import over other values, they become unsaved */
+	set_all(2000);
+	CHECK(rewind_fd(fd) == 0);
+	notifications = 0;
+	CHECK(param_import(fd) == 0);
+	CHECK(notifications == 1);
+	CHECK(check_all(1000));
+	CHECK(param_value_unsaved(param_for_index(0)));
+
+	/* only unsaved values are exported */
+	int32_t sys_autostart = 4001;
+	param_t p = param_find("SYS_AUTOSTART");
+	CHECK(p != PARAM_INVALID);
+	CHECK(rewind_fd(fd) == 0);
+	CHECK(ftruncate(fd, 0) == 0);
+	CHECK(param_export(fd, false) == 0);
+	CHECK(param_set(p, &sys_autostart) == 0);
+	CHECK(rewind_fd(fd) == 0);
+	CHECK(ftruncate(fd, 0) == 0);
+	CHECK(param_export(fd, true) == 0);
+	CHECK(lseek(fd, 0, SEEK_CUR) < 64);
+}
+
+static int
+count_nodes(bson_decoder_t decoder, void *priv, bson_node_t node)
+{
+	if (node->type == BSON_EOO)
+		return 0;
+
+	(*(unsigned *)priv)++;
+	return 1;
+}
+
+static void
+test_window(int fd)
+{
+	struct bson_encoder_s encoder;
+	struct bson_decoder_s decoder;
+	char name[16];
+	unsigned nodes = 0;
+
+	/* a document that records its length, followed by other data */
+	CHECK(bson_encoder_init_buf(&encoder, NULL, 0) == 0);
+
+	for (unsigned i = 0; i < 40; i++) {
+		snprintf(name, sizeof(name), "N%u", i);
+		CHECK(bson_encoder_append_int(&encoder, name, i) == 0);
+	}
+
+	CHECK(bson_encoder_fini(&encoder) == 0);
+	int len = bson_encoder_buf_size(&encoder);
+	void *doc = bson_encoder_buf_data(&encoder);
+
+	CHECK(rewind_fd(fd) == 0);
+	CHECK(ftruncate(fd, 0) == 0);
+	CHECK(write(fd, doc, len) == len);
+	CHECK(write(fd, "trailer", 8) == 8);
+	free(doc);
+
+	/* the decoder does not read past the document */
+	CHECK(rewind_fd(fd) == 0);
+	CHECK(bson_decoder_init_file(&decoder, fd, count_nodes, &nodes) == 0);
+
+	while (bson_decoder_next(&decoder) > 0)
+		;
+
+	CHECK(nodes == 40);
+	CHECK(lseek(fd, 0, SEEK_CUR) == len);
+
+	/* a truncated file is an error, not an endless read */
+	CHECK(rewind_fd(fd) == 0);
+	CHECK(ftruncate(fd, len / 2) == 0);
+	nodes = 0;
+	CHECK(bson_decoder_init_file(&decoder, fd, count_nodes, &nodes) == 0);
+
+	int result;
+
+	while ((result = bson_decoder_next(&decoder)) > 0)
+		;
+
+	CHECK(result < 0);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("parameter export/import test started");
+
+	char path[] = "/tmp/param_test_XXXXXX";
+	int fd = mkstemp(path);
+
+	if (fd < 0)
+		err(1, "creating temporary file");
+
+	unlink(path);
+
+	test_save_load(fd);
+	test_window(fd);
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	param_reset_all();
+	set_all(1000);
+
+	BENCH_STMT("param export all parameters", {
+		rewind_fd(fd);
+		ftruncate(fd, 0);
+		param_export(fd, false);
+	});
+
+	BENCH_STMT("param load all parameters", {
+		rewind_fd(fd);
+		param_load(fd);
+	});
+
+	close(fd);
+	return bench_finish();
+}
@@ -0,0 +1,303 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file perf_counter_test.cpp
+ *
+ * Host test and benchmark of the histogram performance counters.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <systemlib/err.h>
+#include <systemlib/perf_counter.h>
+#include <drivers/drv_hrt.h>
+
+#include "bench.h"
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* simulated time, see hrt_absolute_time below */
+static hrt_abstime	sim_time;
+
+extern "C" {
+	hrt_abstime hrt_absolute_time()
+	{
+		return sim_time;
+	}
+
+	/* the NuttX singly linked queue used by the counter list */
+	void sq_addfirst(sq_entry_t *node, sq_queue_t *queue)
+	{
+		node->flink = queue->head;
+
+		if (queue->head == NULL)
+			queue->tail = node;
+
+		queue->head = node;
+	}
+
+	void sq_rem(sq_entry_t *node, sq_queue_t *queue)
+	{
+		sq_entry_t **p = &queue->head;
+		sq_entry_t *prev = NULL;
+
+		while (*p != NULL && *p != node) {
+			prev = *p;
+			p = &(*p)->flink;
+		}
+
+		if (*p == NULL)
+			return;
+
+		*p = node->flink;
+
+		if (queue->tail == node)
+			queue->tail = prev;
+	}
+}
+
+/*
+ * Record one elapsed time of the given length.
+ */
+static void
+elapsed(perf_counter_t pc, hrt_abstime us)
+{
+	sim_time += 1000;
+	perf_begin(pc);
+	sim_time += us;
+	perf_end(pc);
+}
+
+static void
+test_elapsed_percentiles()
+{
+	perf_counter_t pc = perf_alloc(PC_ELAPSED_HIST, "test_elapsed");
+	CHECK(pc != NULL);
+
+	/* no samples yet */
+	CHECK(perf_percentile(pc, 500) == 0);
+
+	/* 980 fast loops, 19 slow ones and one outlier */
+	for (unsigned i = 0; i < 980; i++)
+		elapsed(pc, 100 + (i % 10));
+
+	for (unsigned i = 0; i < 19; i++)
+		elapsed(pc, 2000);
+
+	elapsed(pc, 50000);
+
+	CHECK(perf_event_count(pc) == 1000);
+
+	/* percentiles are bucket upper bounds, within a quarter of the value */
+	uint64_t p50 = perf_percentile(pc, 500);
+	uint64_t p99 = perf_percentile(pc, 990);
+	uint64_t p999 = perf_percentile(pc, 999);
+	uint64_t p100 = perf_percentile(pc, 1000);
+
+	CHECK(p50 >= 100 && p50 < 125);
+	CHECK(p99 >= 2000 && p99 < 2500);
+	CHECK(p999 >= 2000 && p999 < 2500);
+	CHECK(p100 == 50000);
+
+	perf_print_counter(pc);
+
+	/* reset clears the histogram */
+	perf_reset(pc);
+	CHECK(perf_percentile(pc, 500) == 0);
+
+	/* cancelled events are not recorded */
+	perf_begin(pc);
+	sim_time += 10;
+	perf_cancel(pc);
+	perf_end(pc);
+	CHECK(perf_percentile(pc, 500) == 0);
+
+	/* externally measured times are recorded like begin/end pairs, negative ones ignored */
+	perf_set(pc, 300);
+	perf_set(pc, 3000);
+	perf_set(pc, -5);
+	CHECK(perf_event_count(pc) == 2);
+	CHECK(perf_time_total(pc) == 3300);
+	CHECK(perf_percentile(pc, 500) >= 300 && perf_percentile(pc, 500) < 375);
+	CHECK(perf_percentile(pc, 1000) >= 3000 && perf_percentile(pc, 1000) < 3750);
+
+	perf_free(pc);
+}
+
+static void
+test_interval_percentiles()
+{
+	perf_counter_t pc = perf_alloc(PC_INTERVAL_HIST, "test_interval");
+
+	/* a 250Hz loop with occasional jitter */
+	for (unsigned i = 0; i < 1000; i++) {
+		sim_time += (i % 100 == 99) ? 8000 : 4000;
+		perf_count(pc);
+	}
+
+	CHECK(perf_event_count(pc) == 1000);
+	CHECK(perf_time_total(pc) == 999 * 4000 + 10 * 4000);
+	CHECK(perf_find("test_interval") == pc);
+	CHECK(perf_find("test_missing") == NULL);
+	CHECK(perf_percentile(pc, 500) >= 4000 && perf_percentile(pc, 500) < 5000);
+	CHECK(perf_percentile(pc, 999) == 8000);
+
+	/* plain counters don't keep a histogram */
+	perf_counter_t plain = perf_alloc(PC_ELAPSED, "test_plain");
+	elapsed(plain, 100);
+	CHECK(perf_percentile(plain, 500) == 0);
+
+	perf_free(plain);
+	perf_free(pc);
+}
+
+static void
+test_bucket_edges()
+{
+	perf_counter_t pc = perf_alloc(PC_ELAPSED_HIST, "test_edges");
+
+	/* every value lands in a bucket whose upper bound is within 25% above it */
+	for (hrt_abstime v = 0; v < (1 << 20); v += 1 + v / 7) {
+		perf_reset(pc);
+		elapsed(pc, v);
+		elapsed(pc, 1 << 30);
+
+		uint64_t p = perf_percentile(pc, 500);
+		CHECK(p >= v && p <= v + v / 4 + 1);
+	}
+
+	/* values beyond the histogram range report the largest recorded value */
+	perf_reset(pc);
+	elapsed(pc, 100000000);
+	CHECK(perf_percentile(pc, 500) == 100000000);
+
+	perf_free(pc);
+}
+
+static void
+test_dump()
+{
+	perf_counter_t pc = perf_alloc(PC_ELAPSED_HIST, "test_dump");
+
+	for (unsigned i = 0; i < 200; i++)
+		elapsed(pc, (i + 1) * 37);
+
+	char path[] = "/tmp/perf_test_XXXXXX";
+	int fd = mkstemp(path);
+	CHECK(fd >= 0);
+	unlink(path);
+
+	CHECK(perf_dump_counter(pc, fd) == 0);
+
+	char line[4096];
+	lseek(fd, 0, SEEK_SET);
+	ssize_t len = read(fd, line, sizeof(line) - 1);
+	CHECK(len > 0);
+	line[len > 0 ? len : 0] = '\0';
+	close(fd);
+
+	/* one line, with the header fields and a bucket list adding up to the event count */
+	CHECK(strchr(line, '\n') == &line[len - 1]);
+
+	unsigned type;
+	unsigned long long events, least, most, avg;
+	int offset = 0;
+	CHECK(sscanf(line, "test_dump,%u,%llu,%llu,%llu,%llu,%*u,%*u,%*u,%*u%n",
+		     &type, &events, &least, &most, &avg, &offset) == 5);
+	CHECK(type == PC_ELAPSED_HIST);
+	CHECK(events == 200);
+	CHECK(least == 37 && most == 200 * 37);
+
+	unsigned long long total = 0;
+	char *p = &line[offset];
+	unsigned long long upper, count;
+	int n;
+
+	while (sscanf(p, ",%llu:%llu%n", &upper, &count, &n) == 2) {
+		total += count;
+		p += n;
+	}
+
+	CHECK(total == 200);
+	CHECK(*p == '\n');
+
+	perf_free(pc);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("perf counter test started");
+
+	test_elapsed_percentiles();
+	test_interval_percentiles();
+	test_bucket_edges();
+	test_dump();
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	perf_counter_t plain = perf_alloc(PC_ELAPSED, "bench_plain");
+	perf_counter_t hist = perf_alloc(PC_ELAPSED_HIST, "bench_hist");
+
+	BENCH_STMT("perf begin/end PC_ELAPSED", {
+		perf_begin(plain);
+		sim_time += 1 + (_j & 1023);
+		perf_end(plain);
+	});
+
+	BENCH_STMT("perf begin/end PC_ELAPSED_HIST", {
+		perf_begin(hist);
+		sim_time += 1 + (_j & 1023);
+		perf_end(hist);
+	});
+
+	BENCH_OP("perf_percentile p99", perf_percentile(hist, 990));
+
+	return bench_finish();
+}
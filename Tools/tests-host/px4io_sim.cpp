@@ -0,0 +1,435 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file px4io_sim.cpp
+ *
+ * Host simulator for the PX4IO register protocol.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+
+#include <drivers/drv_pwm_output.h>
+
+#include "px4io_sim.h"
+
+/* serial link as configured on FMUv2: 1.5Mbps, 8N1 */
+#define SIM_BITRATE		1500000
+#define SIM_BITS_PER_BYTE	10
+
+/* assumed time for the IO to turn a request around */
+#define SIM_TURNAROUND_US	35
+
+/*
+ * IO firmware globals normally defined in px4io.c
+ */
+struct sys_state_s	system_state;
+pwm_limit_t		pwm_limit;
+volatile uint8_t	debug_level = 0;
+
+static hrt_abstime	sim_time;
+static uint16_t		sim_pwm[PX4IO_SERVO_COUNT];
+static bool		sim_pwm_armed;
+
+/*
+ * Simulated time
+ */
+hrt_abstime
+hrt_absolute_time()
+{
+	return sim_time;
+}
+
+hrt_abstime
+hrt_elapsed_time(const volatile hrt_abstime *then)
+{
+	return sim_time - *then;
+}
+
+void
+px4io_sim_advance(hrt_abstime interval)
+{
+	sim_time += interval;
+}
+
+/*
+ * Hardware stubs for the IO firmware
+ */
+extern "C" {
+
+void
+stm32_gpiowrite(uint32_t pinset, bool value)
+{
+}
+
+bool
+stm32_gpioread(uint32_t pinset)
+{
+	return false;
+}
+
+uint16_t
+adc_measure(unsigned channel)
+{
+	/* 5V servo rail, 0V RSSI */
+	return (channel == ADC_VSERVO) ? 2069 : 0;
+}
+
+void
+isr_debug(uint8_t level, const char *fmt, ...)
+{
+	if (level > debug_level)
+		return;
+
+	va_list ap;
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	printf("\n");
+}
+
+void
+schedule_reboot(uint32_t time_delta_usec)
+{
+}
+
+void
+dsm_bind(uint16_t cmd, int pulses)
+{
+}
+
+bool
+sbus1_output(uint16_t *values, uint16_t num_values)
+{
+	return true;
+}
+
+bool
+sbus2_output(uint16_t *values, uint16_t num_values)
+{
+	return true;
+}
+
+int
+up_pwm_servo_set(unsigned channel, servo_position_t value)
+{
+	if (channel >= PX4IO_SERVO_COUNT)
+		return -1;
+
+	sim_pwm[channel] = value;
+	return 0;
+}
+
+servo_position_t
+up_pwm_servo_get(unsigned channel)
+{
+	return (channel < PX4IO_SERVO_COUNT) ? sim_pwm[channel] : 0;
+}
+
+void
+up_pwm_servo_arm(bool armed)
+{
+	sim_pwm_armed = armed;
+}
+
+uint32_t
+up_pwm_servo_get_rate_group(unsigned group)
+{
+	/* two outputs per timer channel group, as on IOv2 */
+	return (group < PX4IO_SERVO_COUNT / 2) ? (3 << (group * 2)) : 0;
+}
+
+int
+up_pwm_servo_set_rate_group_update(unsigned group, unsigned rate)
+{
+	return 0;
+}
+
+}
+
+/*
+ * IO side
+ */
+void
+px4io_sim_init()
+{
+	memset(&system_state, 0, sizeof(system_state));
+	memset(sim_pwm, 0, sizeof(sim_pwm));
+	sim_pwm_armed = false;
+
+	/* back to the power-on register state that matters for arming */
+	r_status_flags = 0;
+	r_status_alarms = 0;
+	r_setup_arming = 0;
+	memset((void *)r_page_controls, 0, PX4IO_CONTROL_GROUPS * PX4IO_CONTROL_CHANNELS * sizeof(uint16_t));
+
+	/* start away from zero, pwm_limit treats a zero arming time as unset */
+	sim_time = 1000000;
+
+	pwm_limit_init(&pwm_limit);
+}
+
+void
+px4io_sim_mixer_tick()
+{
+	mixer_tick();
+}
+
+uint16_t
+px4io_sim_pwm(unsigned channel)
+{
+	return up_pwm_servo_get(channel);
+}
+
+bool
+px4io_sim_pwm_armed()
+{
+	return sim_pwm_armed;
+}
+
+void
+px4io_sim_set_rc(const uint16_t *values, unsigned count)
+{
+	if (count > PX4IO_RC_INPUT_CHANNELS)
+		count = PX4IO_RC_INPUT_CHANNELS;
+
+	memcpy(r_raw_rc_values, values, count * sizeof(values[0]));
+	r_raw_rc_count = count;
+	r_raw_rc_flags = PX4IO_P_RAW_RC_FLAGS_RC_OK;
+	r_page_raw_rc_input[PX4IO_P_RAW_FRAME_COUNT]++;
+	r_status_flags |= PX4IO_P_STATUS_FLAGS_RC_OK | PX4IO_P_STATUS_FLAGS_RC_SBUS;
+	system_state.rc_channels_timestamp_received = sim_time;
+}
+
+/*
+ * FMU side
+ */
+PX4IOLoopback::PX4IOLoopback() :
+	_corrupt(0),
+	_wire_time(0)
+{
+	reset_counters();
+}
+
+void
+PX4IOLoopback::reset_counters()
+{
+	_wire_time = 0;
+	_txns = 0;
+	_retries = 0;
+	_crcerrs = 0;
+	_protoerrs = 0;
+}
+
+int
+PX4IOLoopback::_transact()
+{
+	IOPacket io_packet;
+
+	_buffer.crc = 0;
+	_buffer.crc = crc_packet(&_buffer);
+
+	/* the request goes over the wire */
+	unsigned request_size = PKT_SIZE(_buffer);
+	memcpy(&io_packet, &_buffer, request_size);
+
+	if (_corrupt > 0) {
+		_corrupt--;
+		reinterpret_cast<uint8_t *>(&io_packet)[request_size - 1] ^= 0x10;
+	}
+
+	/* IO checks the CRC, handles it and replies, see px4iofirmware/serial.c */
+	uint8_t io_crc = io_packet.crc;
+	io_packet.crc = 0;
+
+	if (io_crc != crc_packet(&io_packet)) {
+		io_packet.count_code = PKT_CODE_CORRUPT;
+		io_packet.page = 0xff;
+		io_packet.offset = 0xff;
+
+	} else {
+		registers_handle_packet(&io_packet);
+	}
+
+	io_packet.crc = 0;
+	io_packet.crc = crc_packet(&io_packet);
+
+	unsigned reply_size = PKT_SIZE(io_packet);
+	memcpy(&_buffer, &io_packet, reply_size);
+
+	hrt_abstime elapsed = ((request_size + reply_size) * SIM_BITS_PER_BYTE * 1000000ULL) / SIM_BITRATE +
+			      SIM_TURNAROUND_US;
+	_wire_time += elapsed;
+	sim_time += elapsed;
+	_txns++;
+
+	/* check packet CRC - corrupt packet errors mean IO receive CRC error */
+	uint8_t crc = _buffer.crc;
+	_buffer.crc = 0;
+
+	if ((crc != crc_packet(&_buffer)) | (PKT_CODE(_buffer) == PKT_CODE_CORRUPT)) {
+		_crcerrs++;
+		return -EIO;
+	}
+
+	return OK;
+}
+
+int
+PX4IOLoopback::write(unsigned address, void *data, unsigned count)
+{
+	const uint16_t *values = reinterpret_cast<const uint16_t *>(data);
+
+	if (count > PKT_MAX_REGS)
+		return -EINVAL;
+
+	int result;
+
+	for (unsigned retries = 0; retries < 3; retries++) {
+
+		_buffer.count_code = count | PKT_CODE_WRITE;
+		_buffer.page = address >> 8;
+		_buffer.offset = address & 0xff;
+		memcpy((void *)&_buffer.regs[0], (void *)values, (2 * count));
+
+		for (unsigned i = count; i < PKT_MAX_REGS; i++)
+			_buffer.regs[i] = 0x55aa;
+
+		result = _transact();
+
+		if (result == OK) {
+			if (PKT_CODE(_buffer) == PKT_CODE_ERROR) {
+				result = -EINVAL;
+				_protoerrs++;
+			}
+
+			break;
+		}
+
+		_retries++;
+	}
+
+	if (result == OK)
+		result = count;
+
+	return result;
+}
+
+int
+PX4IOLoopback::read(unsigned address, void *data, unsigned count)
+{
+	uint16_t *values = reinterpret_cast<uint16_t *>(data);
+
+	if (count > PKT_MAX_REGS)
+		return -EINVAL;
+
+	int result;
+
+	for (unsigned retries = 0; retries < 3; retries++) {
+
+		_buffer.count_code = count | PKT_CODE_READ;
+		_buffer.page = address >> 8;
+		_buffer.offset = address & 0xff;
+
+		result = _transact();
+
+		if (result == OK) {
+			if (PKT_CODE(_buffer) == PKT_CODE_ERROR) {
+				result = -EINVAL;
+				_protoerrs++;
+
+			} else if (PKT_COUNT(_buffer) != count) {
+				result = -EIO;
+				_protoerrs++;
+
+			} else {
+				memcpy(values, &_buffer.regs[0], (2 * count));
+			}
+
+			break;
+		}
+
+		_retries++;
+	}
+
+	if (result == OK)
+		result = count;
+
+	return result;
+}
+
+int
+PX4IOLoopback::exchange(unsigned address, const uint16_t *values, unsigned count, uint16_t *reply)
+{
+	if (count > PKT_MAX_REGS)
+		return -EINVAL;
+
+	int result;
+
+	for (unsigned retries = 0; retries < 3; retries++) {
+
+		_buffer.count_code = count | PKT_CODE_EXCHANGE;
+		_buffer.page = address >> 8;
+		_buffer.offset = address & 0xff;
+		memcpy((void *)&_buffer.regs[0], (void *)values, (2 * count));
+
+		for (unsigned i = count; i < PKT_MAX_REGS; i++)
+			_buffer.regs[i] = 0x55aa;
+
+		result = _transact();
+
+		if (result == OK) {
+			if (PKT_CODE(_buffer) == PKT_CODE_ERROR) {
+				result = -EINVAL;
+				_protoerrs++;
+
+			} else if (PKT_COUNT(_buffer) != PX4IO_P_EXCHANGE_SIZE) {
+				result = -EIO;
+				_protoerrs++;
+
+			} else {
+				memcpy(reply, &_buffer.regs[0], (2 * PX4IO_P_EXCHANGE_SIZE));
+			}
+
+			break;
+		}
+
+		_retries++;
+	}
+
+	return result;
+}
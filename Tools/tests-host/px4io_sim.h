@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file px4io_sim.h
+ *
+ * Host simulator for the PX4IO register protocol.
+ *
+ * The IO side is the unmodified firmware register map and mixer
+ * (px4iofirmware/registers.c and mixer.cpp) with the hardware stubbed
+ * out. The FMU side is a loopback transport that frames requests into
+ * IOPackets exactly like the PX4IO_serial interface, including CRC
+ * checks and retries, and hands them to the IO packet handler.
+ *
+ * Time is simulated: hrt_absolute_time() only advances with the modelled
+ * wire time of each transaction and with px4io_sim_advance(), so that
+ * runs are deterministic and the link cost of a transaction sequence can
+ * be compared without hardware.
+ */
+
+#pragma once
+
+#include "px4io_sim_compat.h"
+
+#include <drivers/drv_hrt.h>
+
+extern "C" {
+#include <modules/px4iofirmware/px4io.h>
+}
+
+/**
+ * Reset the IO side to its power-on state.
+ */
+void	px4io_sim_init();
+
+/**
+ * Run one iteration of the IO main loop mixer.
+ */
+void	px4io_sim_mixer_tick();
+
+/**
+ * Advance the simulated time.
+ */
+void	px4io_sim_advance(hrt_abstime interval);
+
+/**
+ * PWM value last written to an output by the IO mixer.
+ */
+uint16_t px4io_sim_pwm(unsigned channel);
+
+/**
+ * True if the IO has armed its PWM outputs.
+ */
+bool	px4io_sim_pwm_armed();
+
+/**
+ * Set the raw RC input seen by the IO.
+ */
+void	px4io_sim_set_rc(const uint16_t *values, unsigned count);
+
+/**
+ * FMU side of the link.
+ *
+ * Mirrors the PX4IO_serial read/write/exchange framing on a loopback.
+ */
+class PX4IOLoopback
+{
+public:
+	PX4IOLoopback();
+
+	int	read(unsigned address, void *data, unsigned count = 1);
+	int	write(unsigned address, void *data, unsigned count = 1);
+	int	exchange(unsigned address, const uint16_t *values, unsigned count, uint16_t *reply);
+
+	/**
+	 * Corrupt a byte of the next requests on the wire.
+	 */
+	void	corrupt_next(unsigned count) { _corrupt = count; }
+
+	/**
+	 * Modelled time on the wire for all transactions so far.
+	 */
+	hrt_abstime wire_time() const { return _wire_time; }
+
+	unsigned txns() const { return _txns; }
+	unsigned retries() const { return _retries; }
+	unsigned crcerrs() const { return _crcerrs; }
+	unsigned protoerrs() const { return _protoerrs; }
+
+	void	reset_counters();
+
+private:
+	IOPacket	_buffer;
+	unsigned	_corrupt;
+	hrt_abstime	_wire_time;
+	unsigned	_txns;
+	unsigned	_retries;
+	unsigned	_crcerrs;
+	unsigned	_protoerrs;
+
+	/**
+	 * Send the request in _buffer and receive the reply into it.
+	 */
+	int	_transact();
+};
@@ -0,0 +1,82 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file px4io_sim_compat.h
+ *
+ * NuttX and STM32 definitions needed to build the PX4IO firmware
+ * register, mixer and R/C input code on the host. Force-included into those
+ * sources by the Makefile.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/cdefs.h>
+#include <malloc.h>
+
+#define noreturn_function	__attribute__((noreturn))
+
+typedef int (*main_t)(int argc, char *argv[]);
+
+/* simulate a PX4IOv2 */
+#define CONFIG_ARCH_BOARD_PX4IO_V2
+
+/* GPIOs are ignored by the simulator */
+#define GPIO_LED1		0
+#define GPIO_LED2		0
+#define GPIO_LED3		0
+#define GPIO_SPEKTRUM_PWR_EN	0
+#define GPIO_SBUS_OENABLE	0
+#define GPIO_SERVO_FAULT_DETECT	0
+#define GPIO_BTN_SAFETY		0
+
+/* pins and modes used for DSM binding */
+#define GPIO_OUTPUT		0
+#define GPIO_CNF_OUTPP		0
+#define GPIO_MODE_50MHz		0
+#define GPIO_OUTPUT_SET		0
+#define GPIO_PORTA		0
+#define GPIO_PIN10		0
+#define GPIO_USART1_RX		0
+
+__BEGIN_DECLS
+
+void	stm32_gpiowrite(uint32_t pinset, bool value);
+bool	stm32_gpioread(uint32_t pinset);
+int	stm32_configgpio(uint32_t cfgset);
+void	up_udelay(unsigned int microseconds);
+
+__END_DECLS
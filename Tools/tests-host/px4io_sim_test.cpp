@@ -0,0 +1,418 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file px4io_sim_test.cpp
+ *
+ * Exercise the PX4IO register protocol against the host simulator.
+ *
+ * Checks the FMU-side transactions (configuration, mixer upload, arming,
+ * controls, status readback and the combined exchange) end to end through
+ * the firmware register map and mixer, then benchmarks the host cost of
+ * the transactions and of the IO mixer, and reports the modelled wire
+ * time of one FMU poll cycle with and without the combined exchange.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <systemlib/err.h>
+#include <drivers/drv_pwm_output.h>
+
+#include "px4io_sim.h"
+#include "bench.h"
+
+#define MIXER_PASSTHROUGH	"../../ROMFS/px4fmu_common/mixers/IO_pass.mix"
+#define MIXER_QUAD_X		"R: 4x 10000 10000 10000 0\n"
+
+#define ADDR(_page, _offset)	(((_page) << 8) | (_offset))
+
+/* maximum transfer as reported by the IO, less the page/offset header */
+#define MAX_TRANSFER		62
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static PX4IOLoopback io;
+
+static uint16_t
+reg_get(uint8_t page, uint8_t offset)
+{
+	uint16_t value = 0xffff;
+
+	if (io.read(ADDR(page, offset), &value, 1) != 1)
+		warnx("read %u/%u failed", page, offset);
+
+	return value;
+}
+
+static int
+reg_set(uint8_t page, uint8_t offset, uint16_t value)
+{
+	return (io.write(ADDR(page, offset), &value, 1) == 1) ? OK : -1;
+}
+
+/*
+ * Upload mixer text in chunks, as PX4IO::mixer_send does.
+ */
+static int
+mixer_send(const char *buf, unsigned buflen)
+{
+	uint8_t frame[MAX_TRANSFER + 2];
+	px4io_mixdata *msg = (px4io_mixdata *)&frame[0];
+	const unsigned max_len = MAX_TRANSFER - sizeof(px4io_mixdata);
+
+	msg->f2i_mixer_magic = F2I_MIXER_MAGIC;
+	msg->action = F2I_MIXER_ACTION_RESET;
+
+	while (buflen > 0) {
+		unsigned count = (buflen > max_len) ? max_len : buflen;
+
+		memcpy(&msg->text[0], buf, count);
+		buf += count;
+		buflen -= count;
+
+		/* we have to send an even number of bytes */
+		unsigned total_len = sizeof(px4io_mixdata) + count;
+
+		if (total_len % 2) {
+			frame[total_len] = 0;
+			total_len++;
+		}
+
+		if (io.write(ADDR(PX4IO_PAGE_MIXERLOAD, 0), frame, total_len / 2) != (int)(total_len / 2))
+			return -1;
+
+		msg->action = F2I_MIXER_ACTION_APPEND;
+	}
+
+	/* ensure a closing newline */
+	msg->text[0] = '\n';
+	msg->text[1] = '\0';
+
+	if (io.write(ADDR(PX4IO_PAGE_MIXERLOAD, 0), frame, (sizeof(px4io_mixdata) + 2) / 2) < 0)
+		return -1;
+
+	return (reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS) & PX4IO_P_STATUS_FLAGS_MIXER_OK) ? OK : -1;
+}
+
+static int
+mixer_load_file(const char *path)
+{
+	char buf[2048];
+	FILE *fp = fopen(path, "r");
+
+	if (fp == nullptr) {
+		warn("can't open %s", path);
+		return -1;
+	}
+
+	size_t len = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+
+	return mixer_send(buf, len);
+}
+
+static void
+controls_to_regs(const float *controls, uint16_t *regs)
+{
+	for (unsigned i = 0; i < PX4IO_PROTOCOL_MAX_CONTROL_COUNT; i++)
+		regs[i] = FLOAT_TO_REG(controls[i]);
+}
+
+/*
+ * Bring the IO up the way the FMU driver does and arm it.
+ */
+static void
+setup_armed(const char *mixer_path, const char *mixer_text)
+{
+	px4io_sim_init();
+
+	if (mixer_path != nullptr) {
+		CHECK(mixer_load_file(mixer_path) == OK);
+
+	} else {
+		CHECK(mixer_send(mixer_text, strlen(mixer_text)) == OK);
+	}
+
+	/* FMU handles RC, which also marks the IO initialised */
+	CHECK(reg_set(PX4IO_PAGE_SETUP, PX4IO_P_SETUP_ARMING,
+		      PX4IO_P_SETUP_ARMING_IO_ARM_OK |
+		      PX4IO_P_SETUP_ARMING_FMU_ARMED |
+		      PX4IO_P_SETUP_ARMING_RC_HANDLING_DISABLED) == OK);
+	CHECK(reg_set(PX4IO_PAGE_SETUP, PX4IO_P_SETUP_FORCE_SAFETY_OFF, PX4IO_FORCE_SAFETY_MAGIC) == OK);
+}
+
+static void
+test_config()
+{
+	px4io_sim_init();
+
+	CHECK(reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_PROTOCOL_VERSION) == PX4IO_PROTOCOL_VERSION);
+	CHECK(reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_ACTUATOR_COUNT) == PX4IO_SERVO_COUNT);
+	CHECK(reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_MAX_TRANSFER) == MAX_TRANSFER + 2);
+	CHECK(reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_RC_INPUT_COUNT) == PX4IO_RC_INPUT_CHANNELS);
+
+	/* unknown pages are rejected without retries */
+	uint16_t value;
+	io.reset_counters();
+	CHECK(io.read(ADDR(99, 0), &value, 1) == -EINVAL);
+	CHECK(io.protoerrs() == 1);
+	CHECK(io.retries() == 0);
+
+	/* read beyond the end of a page */
+	uint16_t regs[PKT_MAX_REGS];
+	CHECK(io.read(ADDR(PX4IO_PAGE_SERVOS, 0), regs, PX4IO_SERVO_COUNT + 1) == -EIO);
+}
+
+static void
+test_corruption()
+{
+	px4io_sim_init();
+
+	/* a corrupted request is NAKed by the IO and retried */
+	io.reset_counters();
+	io.corrupt_next(1);
+	CHECK(reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_PROTOCOL_VERSION) == PX4IO_PROTOCOL_VERSION);
+	CHECK(io.crcerrs() == 1);
+	CHECK(io.retries() == 1);
+	CHECK(io.txns() == 2);
+
+	/* three in a row exhaust the retries */
+	uint16_t value = 1;
+	io.reset_counters();
+	io.corrupt_next(3);
+	CHECK(io.write(ADDR(PX4IO_PAGE_SETUP, PX4IO_P_SETUP_PWM_DEFAULTRATE), &value, 1) == -EIO);
+	CHECK(io.retries() == 3);
+}
+
+static void
+test_mixing()
+{
+	setup_armed(MIXER_PASSTHROUGH, nullptr);
+
+	const float controls[PX4IO_PROTOCOL_MAX_CONTROL_COUNT] = { 0.5f, -0.5f, 0.0f, 1.0f, -1.0f, 0.25f, 0.0f, 0.0f };
+	uint16_t regs[PX4IO_PROTOCOL_MAX_CONTROL_COUNT];
+	controls_to_regs(controls, regs);
+
+	/* run the 50Hz loop through the PWM limit arming ramp */
+	for (unsigned i = 0; i < 200; i++) {
+		CHECK(io.write(ADDR(PX4IO_PAGE_CONTROLS, 0), regs, PX4IO_PROTOCOL_MAX_CONTROL_COUNT) ==
+		      PX4IO_PROTOCOL_MAX_CONTROL_COUNT);
+		px4io_sim_mixer_tick();
+		px4io_sim_advance(20000);
+	}
+
+	uint16_t flags = reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS);
+	CHECK(flags & PX4IO_P_STATUS_FLAGS_FMU_OK);
+	CHECK(flags & PX4IO_P_STATUS_FLAGS_MIXER_OK);
+	CHECK(flags & PX4IO_P_STATUS_FLAGS_OUTPUTS_ARMED);
+	CHECK(!(flags & PX4IO_P_STATUS_FLAGS_FAILSAFE));
+	CHECK(px4io_sim_pwm_armed());
+
+	/* pass-through mixer: actuators mirror the controls, PWM is scaled into min..max */
+	uint16_t actuators[PX4IO_SERVO_COUNT];
+	uint16_t servos[PX4IO_SERVO_COUNT];
+	CHECK(io.read(ADDR(PX4IO_PAGE_ACTUATORS, 0), actuators, PX4IO_SERVO_COUNT) == PX4IO_SERVO_COUNT);
+	CHECK(io.read(ADDR(PX4IO_PAGE_SERVOS, 0), servos, PX4IO_SERVO_COUNT) == PX4IO_SERVO_COUNT);
+
+	for (unsigned i = 0; i < PX4IO_SERVO_COUNT; i++) {
+		int expected = (PWM_DEFAULT_MAX + PWM_DEFAULT_MIN) / 2 +
+			       (int)(controls[i] * (PWM_DEFAULT_MAX - PWM_DEFAULT_MIN) / 2);
+
+		CHECK(abs(REG_TO_SIGNED(actuators[i]) - REG_TO_SIGNED(regs[i])) <= 1);
+		CHECK(abs((int)servos[i] - expected) <= 1);
+		CHECK(px4io_sim_pwm(i) == servos[i]);
+	}
+
+	/* FMU goes quiet: IO drops to failsafe */
+	px4io_sim_advance(300000);
+	px4io_sim_mixer_tick();
+	flags = reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS);
+	CHECK(!(flags & PX4IO_P_STATUS_FLAGS_FMU_OK));
+	CHECK(flags & PX4IO_P_STATUS_FLAGS_FAILSAFE);
+	CHECK(reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_ALARMS) & PX4IO_P_STATUS_ALARMS_FMU_LOST);
+}
+
+static void
+test_exchange()
+{
+	setup_armed(MIXER_PASSTHROUGH, nullptr);
+
+	uint16_t rc[12];
+
+	for (unsigned i = 0; i < 12; i++)
+		rc[i] = 1000 + i * 50;
+
+	px4io_sim_set_rc(rc, 12);
+
+	const float controls[PX4IO_PROTOCOL_MAX_CONTROL_COUNT] = { 0.1f, 0.2f, 0.3f, 0.4f, -0.1f, -0.2f, -0.3f, -0.4f };
+	uint16_t regs[PX4IO_PROTOCOL_MAX_CONTROL_COUNT];
+	uint16_t reply[PX4IO_P_EXCHANGE_SIZE];
+	controls_to_regs(controls, regs);
+
+	io.reset_counters();
+	CHECK(io.exchange(ADDR(PX4IO_PAGE_CONTROLS, 0), regs, PX4IO_PROTOCOL_MAX_CONTROL_COUNT, reply) == OK);
+	CHECK(io.txns() == 1);
+	px4io_sim_mixer_tick();
+
+	/* the controls were written */
+	uint16_t readback[PX4IO_PROTOCOL_MAX_CONTROL_COUNT];
+	CHECK(io.read(ADDR(PX4IO_PAGE_CONTROLS, 0), readback, PX4IO_PROTOCOL_MAX_CONTROL_COUNT) ==
+	      PX4IO_PROTOCOL_MAX_CONTROL_COUNT);
+	CHECK(memcmp(readback, regs, sizeof(regs)) == 0);
+
+	/* the summary matches the individual pages */
+	CHECK(io.exchange(ADDR(PX4IO_PAGE_CONTROLS, 0), regs, PX4IO_PROTOCOL_MAX_CONTROL_COUNT, reply) == OK);
+
+	uint16_t status[PX4IO_P_EXCHANGE_STATUS_COUNT];
+	uint16_t servos[PX4IO_P_EXCHANGE_SERVO_COUNT];
+	uint16_t raw_rc[PX4IO_P_RAW_RC_BASE + PX4IO_P_EXCHANGE_RC_COUNT];
+	CHECK(io.read(ADDR(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS), status, PX4IO_P_EXCHANGE_STATUS_COUNT) ==
+	      PX4IO_P_EXCHANGE_STATUS_COUNT);
+	CHECK(io.read(ADDR(PX4IO_PAGE_SERVOS, 0), servos, PX4IO_P_EXCHANGE_SERVO_COUNT) == PX4IO_P_EXCHANGE_SERVO_COUNT);
+	CHECK(io.read(ADDR(PX4IO_PAGE_RAW_RC_INPUT, 0), raw_rc, sizeof(raw_rc) / sizeof(raw_rc[0])) ==
+	      (int)(sizeof(raw_rc) / sizeof(raw_rc[0])));
+
+	CHECK(memcmp(&reply[PX4IO_P_EXCHANGE_STATUS], status, sizeof(status)) == 0);
+	CHECK(memcmp(&reply[PX4IO_P_EXCHANGE_SERVOS], servos, sizeof(servos)) == 0);
+	CHECK(memcmp(&reply[PX4IO_P_EXCHANGE_RAW_RC], raw_rc, sizeof(raw_rc)) == 0);
+	CHECK(reply[PX4IO_P_EXCHANGE_RAW_RC + PX4IO_P_RAW_RC_COUNT] == 12);
+	CHECK(reply[PX4IO_P_EXCHANGE_STATUS] & PX4IO_P_STATUS_FLAGS_FMU_OK);
+
+	/* the page can also be read on its own */
+	uint16_t page[PX4IO_P_EXCHANGE_SIZE];
+	CHECK(io.read(ADDR(PX4IO_PAGE_EXCHANGE, 0), page, PX4IO_P_EXCHANGE_SIZE) == PX4IO_P_EXCHANGE_SIZE);
+	CHECK(memcmp(page, reply, sizeof(page)) == 0);
+
+	/* register errors are reported, not retried */
+	io.reset_counters();
+	CHECK(io.exchange(ADDR(99, 0), regs, 1, reply) == -EINVAL);
+	CHECK(io.retries() == 0);
+}
+
+/*
+ * One 50Hz FMU poll cycle as done by PX4IO::task_main.
+ */
+static void
+cycle_separate(const uint16_t *controls)
+{
+	uint16_t regs[PKT_MAX_REGS];
+
+	io.write(ADDR(PX4IO_PAGE_CONTROLS, 0), (void *)controls, PX4IO_PROTOCOL_MAX_CONTROL_COUNT);
+	io.read(ADDR(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS), regs, 6);
+	io.read(ADDR(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT), regs, PX4IO_P_RAW_RC_BASE + 9);
+	io.read(ADDR(PX4IO_PAGE_SERVOS, 0), regs, PX4IO_SERVO_COUNT);
+}
+
+static void
+cycle_exchange(const uint16_t *controls)
+{
+	uint16_t reply[PX4IO_P_EXCHANGE_SIZE];
+
+	io.exchange(ADDR(PX4IO_PAGE_CONTROLS, 0), controls, PX4IO_PROTOCOL_MAX_CONTROL_COUNT, reply);
+}
+
+static void
+report_wire_time()
+{
+	setup_armed(MIXER_PASSTHROUGH, nullptr);
+
+	uint16_t controls[PX4IO_PROTOCOL_MAX_CONTROL_COUNT] = {};
+
+	io.reset_counters();
+	cycle_separate(controls);
+	hrt_abstime separate = io.wire_time();
+	unsigned separate_txns = io.txns();
+
+	io.reset_counters();
+	cycle_exchange(controls);
+	hrt_abstime exchange = io.wire_time();
+	unsigned exchange_txns = io.txns();
+
+	printf("poll cycle on the link: separate %u txns %lluus, exchange %u txns %lluus\n",
+	       separate_txns, (unsigned long long)separate, exchange_txns, (unsigned long long)exchange);
+
+	CHECK(exchange < separate);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("PX4IO simulator test started");
+
+	test_config();
+	test_corruption();
+	test_mixing();
+	test_exchange();
+	report_wire_time();
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	/* host cost of the protocol handling and of the IO mixer */
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	setup_armed(MIXER_PASSTHROUGH, nullptr);
+
+	uint16_t controls[PX4IO_PROTOCOL_MAX_CONTROL_COUNT] = {};
+	uint16_t regs[PKT_MAX_REGS];
+
+	BENCH_OP("px4io read status (6 regs)", io.read(ADDR(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS), regs, 6));
+	BENCH_OP("px4io write controls (8 regs)", io.write(ADDR(PX4IO_PAGE_CONTROLS, 0), controls, 8));
+	BENCH_OP("px4io exchange", io.exchange(ADDR(PX4IO_PAGE_CONTROLS, 0), controls, 8, regs));
+	BENCH_STMT("px4io poll cycle separate", cycle_separate(controls));
+	BENCH_STMT("px4io poll cycle exchange", cycle_exchange(controls));
+	BENCH_STMT("px4io mixer_tick pass-through", px4io_sim_mixer_tick());
+
+	setup_armed(nullptr, MIXER_QUAD_X);
+
+	/* controls from the FMU select it as the mixer source */
+	io.write(ADDR(PX4IO_PAGE_CONTROLS, 0), controls, 8);
+	BENCH_STMT("px4io mixer_tick quad x", px4io_sim_mixer_tick());
+
+	BENCH_STMT("px4io controls to PWM quad x", (io.write(ADDR(PX4IO_PAGE_CONTROLS, 0), controls, 8),
+			px4io_sim_mixer_tick()));
+
+	return bench_finish();
+}
@@ -0,0 +1,357 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rc_decode_test.cpp
+ *
+ * Host test and benchmark of the PX4IO S.Bus and DSM frame decoders.
+ *
+ * The S.Bus decoder is checked against the former per-bit decoder
+ * matrix and float scaling for every raw value on every channel, the
+ * DSM decoder against the Spektrum scaling for both 10 and 11 bit
+ * formats after the format detector has locked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <systemlib/err.h>
+#include <drivers/drv_hrt.h>
+
+extern "C" {
+#include <px4iofirmware/px4io.h>
+}
+
+#include "bench.h"
+
+#define SBUS_FRAME_SIZE		25
+#define SBUS_FLAGS_BYTE		23
+#define DSM_FRAME_SIZE		16
+#define DSM_FRAME_CHANNELS	7
+
+extern "C" unsigned sbus_frame_drops;
+
+static unsigned	failures;
+
+#define CHECK(_cond) do { \
+		if (!(_cond)) { \
+			warnx("FAIL line %d: %s", __LINE__, #_cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* IO hardware used by the DSM power and bind code */
+extern "C" {
+	void stm32_gpiowrite(uint32_t pinset, bool value) {}
+	bool stm32_gpioread(uint32_t pinset) { return false; }
+	int stm32_configgpio(uint32_t cfgset) { return 0; }
+	void up_udelay(unsigned int microseconds) {}
+}
+
+/*
+ * The S.Bus decoder the word-level decoder replaced: a matrix of
+ * byte/shift/mask picks applied bit group by bit group, float scaling.
+ */
+struct sbus_bit_pick {
+	uint8_t byte;
+	uint8_t rshift;
+	uint8_t mask;
+	uint8_t lshift;
+};
+static const struct sbus_bit_pick sbus_decoder[16][3] = {
+	/*  0 */ { { 0, 0, 0xff, 0}, { 1, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+	/*  1 */ { { 1, 3, 0x1f, 0}, { 2, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
+	/*  2 */ { { 2, 6, 0x03, 0}, { 3, 0, 0xff, 2}, { 4, 0, 0x01, 10} },
+	/*  3 */ { { 4, 1, 0x7f, 0}, { 5, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
+	/*  4 */ { { 5, 4, 0x0f, 0}, { 6, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
+	/*  5 */ { { 6, 7, 0x01, 0}, { 7, 0, 0xff, 1}, { 8, 0, 0x03,  9} },
+	/*  6 */ { { 8, 2, 0x3f, 0}, { 9, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
+	/*  7 */ { { 9, 5, 0x07, 0}, {10, 0, 0xff, 3}, { 0, 0, 0x00,  0} },
+	/*  8 */ { {11, 0, 0xff, 0}, {12, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+	/*  9 */ { {12, 3, 0x1f, 0}, {13, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
+	/* 10 */ { {13, 6, 0x03, 0}, {14, 0, 0xff, 2}, {15, 0, 0x01, 10} },
+	/* 11 */ { {15, 1, 0x7f, 0}, {16, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
+	/* 12 */ { {16, 4, 0x0f, 0}, {17, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
+	/* 13 */ { {17, 7, 0x01, 0}, {18, 0, 0xff, 1}, {19, 0, 0x03,  9} },
+	/* 14 */ { {19, 2, 0x3f, 0}, {20, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
+	/* 15 */ { {20, 5, 0x07, 0}, {21, 0, 0xff, 3}, { 0, 0, 0x00,  0} }
+};
+
+#define SBUS_SCALE_FACTOR ((2000.0f - 1000.0f) / (1800.0f - 200.0f))
+#define SBUS_SCALE_OFFSET (int)(1000.0f - (SBUS_SCALE_FACTOR * 200.0f + 0.5f))
+
+static void
+sbus_reference_decode(const uint8_t *frame, uint16_t *values)
+{
+	for (unsigned channel = 0; channel < 16; channel++) {
+		unsigned value = 0;
+
+		for (unsigned pick = 0; pick < 3; pick++) {
+			const struct sbus_bit_pick *decode = &sbus_decoder[channel][pick];
+
+			if (decode->mask != 0) {
+				unsigned piece = frame[1 + decode->byte];
+				piece >>= decode->rshift;
+				piece &= decode->mask;
+				piece <<= decode->lshift;
+
+				value |= piece;
+			}
+		}
+
+		values[channel] = (uint16_t)(value * SBUS_SCALE_FACTOR + .5f) + SBUS_SCALE_OFFSET;
+	}
+
+	values[16] = (frame[SBUS_FLAGS_BYTE] & (1 << 0)) * 1000 + 998;
+	values[17] = (frame[SBUS_FLAGS_BYTE] & (1 << 1)) * 1000 + 998;
+}
+
+/*
+ * Pack 16 11-bit channel values into an S.Bus frame.
+ */
+static void
+sbus_encode(const unsigned *raw, uint8_t flags, uint8_t *frame)
+{
+	memset(frame, 0, SBUS_FRAME_SIZE);
+	frame[0] = 0x0f;
+
+	for (unsigned bit = 0; bit < 16 * 11; bit++) {
+		if (raw[bit / 11] & (1 << (bit % 11)))
+			frame[1 + bit / 8] |= 1 << (bit % 8);
+	}
+
+	frame[SBUS_FLAGS_BYTE] = flags;
+}
+
+static void
+test_sbus_values()
+{
+	uint8_t frame[SBUS_FRAME_SIZE];
+	unsigned raw[16];
+	uint16_t values[18];
+	uint16_t expected[18];
+	uint16_t num_values;
+	bool failsafe, frame_drop;
+
+	srand(1);
+
+	/* every raw value on every channel, with random neighbours */
+	for (unsigned value = 0; value < 2048; value++) {
+		for (unsigned c = 0; c < 16; c++)
+			raw[c] = rand() & 0x7ff;
+
+		raw[value % 16] = value;
+		raw[(value + 7) % 16] = 2047 - value;
+
+		sbus_encode(raw, value & 0x03, frame);
+		sbus_reference_decode(frame, expected);
+
+		CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+		CHECK(num_values == 18);
+		CHECK(memcmp(values, expected, sizeof(values)) == 0);
+	}
+
+	/* extremes of the scaling */
+	for (unsigned c = 0; c < 16; c++)
+		raw[c] = (c & 1) ? 2047 : 0;
+
+	sbus_encode(raw, 0, frame);
+	CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+	CHECK(values[0] == 874);
+	CHECK(values[1] == 2153);
+
+	/* a short channel buffer only gets the channels it can hold */
+	memset(values, 0, sizeof(values));
+	CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 8));
+	CHECK(num_values == 8);
+	CHECK(values[7] == 2153);
+	CHECK(values[8] == 0);
+}
+
+static void
+test_sbus_flags()
+{
+	uint8_t frame[SBUS_FRAME_SIZE];
+	unsigned raw[16] = {};
+	uint16_t values[18];
+	uint16_t num_values;
+	bool failsafe, frame_drop;
+
+	sbus_encode(raw, 0, frame);
+	CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+	CHECK(!failsafe && !frame_drop);
+
+	sbus_encode(raw, 1 << 2, frame);
+	CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+	CHECK(!failsafe && frame_drop);
+
+	sbus_encode(raw, 1 << 3, frame);
+	CHECK(sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+	CHECK(failsafe && frame_drop);
+
+	/* out of sync */
+	unsigned drops = sbus_frame_drops;
+	frame[0] = 0x00;
+	CHECK(!sbus_decode(0, frame, values, &num_values, &failsafe, &frame_drop, 18));
+	CHECK(sbus_frame_drops == drops + 1);
+}
+
+/*
+ * Build a DSM frame of 7 channels starting at first_channel.
+ */
+static void
+dsm_encode(unsigned shift, unsigned first_channel, const unsigned *value, uint8_t *frame)
+{
+	frame[0] = 0;
+	frame[1] = 0x12;
+
+	for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++) {
+		unsigned raw = ((first_channel + i) << shift) | value[i];
+		frame[2 + 2 * i] = raw >> 8;
+		frame[3 + 2 * i] = raw & 0xff;
+	}
+}
+
+static const unsigned dsm_channel_map[] = { 2, 0, 1, 3, 4, 5, 6 };
+
+static hrt_abstime	dsm_time = 10000000;
+
+/*
+ * Feed frames until the format detector locks, return the decoded channel count.
+ */
+static unsigned
+dsm_lock(unsigned shift)
+{
+	uint8_t frame[DSM_FRAME_SIZE];
+	unsigned value[DSM_FRAME_CHANNELS] = { 1, 2, 3, 4, 5, 6, 7 };
+	uint16_t values[PX4IO_RC_INPUT_CHANNELS];
+	uint16_t num_values = 0;
+
+	/* a gap of more than a second resets the detector */
+	dsm_time += 2000000;
+
+	for (unsigned frames = 0; frames < 20; frames++) {
+		dsm_encode(shift, 0, value, frame);
+		dsm_time += 11000;
+
+		if (dsm_decode(dsm_time, frame, values, &num_values))
+			return frames;
+	}
+
+	return 0;
+}
+
+static void
+test_dsm(unsigned shift)
+{
+	uint8_t frame[DSM_FRAME_SIZE];
+	unsigned value[DSM_FRAME_CHANNELS];
+	uint16_t values[PX4IO_RC_INPUT_CHANNELS];
+	uint16_t num_values;
+
+	/* the detector needs six frames of a recognised channel set, decoding starts with the seventh */
+	CHECK(dsm_lock(shift) == 6);
+
+	for (unsigned v = 0; v < (1u << shift); v++) {
+		for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++)
+			value[i] = (v + 97 * i) & ((1 << shift) - 1);
+
+		dsm_encode(shift, 0, value, frame);
+		dsm_time += 11000;
+		num_values = 0;
+		CHECK(dsm_decode(dsm_time, frame, values, &num_values));
+		CHECK(num_values == (DSM_FRAME_CHANNELS | ((shift == 11) ? 0x8000 : 0)));
+
+		for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++) {
+			int scaled = (shift == 10) ? value[i] * 2 : value[i];
+			CHECK(values[dsm_channel_map[i]] == (((scaled - 1024) * 1000) / 1700) + 1500);
+		}
+	}
+
+	/* unused slots are skipped */
+	for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++)
+		value[i] = 512;
+
+	dsm_encode(shift, 0, value, frame);
+	frame[14] = frame[15] = 0xff;
+	dsm_time += 11000;
+	num_values = 0;
+	CHECK(dsm_decode(dsm_time, frame, values, &num_values));
+	CHECK((num_values & 0x7fff) == 6);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("R/C decoder test started");
+
+	test_sbus_values();
+	test_sbus_flags();
+	test_dsm(10);
+	test_dsm(11);
+
+	if (failures > 0)
+		errx(1, "%u checks failed", failures);
+
+	warnx("all checks passed");
+
+	/* host cost of decoding one frame */
+	if (bench_init(argc, argv) != 0)
+		return 1;
+
+	uint8_t sbus_frame[SBUS_FRAME_SIZE];
+	unsigned raw[16];
+	uint16_t values[18];
+	uint16_t num_values;
+	bool failsafe, frame_drop;
+
+	for (unsigned c = 0; c < 16; c++)
+		raw[c] = 172 + 100 * c;
+
+	sbus_encode(raw, 0, sbus_frame);
+
+	BENCH_OP("sbus_decode frame, 18 channels",
+		 sbus_decode(0, sbus_frame, values, &num_values, &failsafe, &frame_drop, 18));
+	BENCH_STMT("sbus reference decode frame (bit picks, float)", sbus_reference_decode(sbus_frame, values));
+
+	uint8_t dsm_frame[DSM_FRAME_SIZE];
+	unsigned value[DSM_FRAME_CHANNELS] = { 100, 400, 800, 1024, 1300, 1700, 2000 };
+
+	dsm_lock(11);
+	dsm_encode(11, 0, value, dsm_frame);
+
+	BENCH_OP("dsm_decode frame, 11 bit locked",
+		 (num_values = 0, dsm_decode(dsm_time, dsm_frame, values, &num_values)));
+
+	return bench_finish();
+}
@@ -3,4 +3,18 @@
 make clean
 make all
 ./mixer_test
-./sbus2_test ../../../../data/sbus2/sbus2_r7008SB_gps_baro_tx_off.txt
\ No newline at end of file
+./sbus2_test ../../../../data/sbus2/sbus2_r7008SB_gps_baro_tx_off.txt
+./mpu6000_fifo_test
+./px4io_sim_test -n 2000 -r 3
+./hrt_queue_test -n 20000 -r 5
+./rc_decode_test -n 20000 -r 5
+./param_test -n 200 -r 5
+./perf_counter_test -n 100000 -r 5
+./mavlink_logqueue_test -n 100000 -r 5
+./geo_test -n 100000 -r 5
+./commander_tests
+./mission_cache_test
+./mag_fit_test -n 20000 -r 5
+./imu_cal_test -n 100000 -r 5
+./fw_ctrl_harness
+./mc_sitl
@@ -5,7 +5,9 @@
 #include <systemlib/mixer/mixer.h>
 #include <systemlib/err.h>
 #include <drivers/drv_hrt.h>
+extern "C" {
 #include <px4iofirmware/px4io.h>
+}
 #include "../../src/systemcmds/tests/tests.h"
 
 int main(int argc, char *argv[]) {
@@ -33,8 +35,10 @@ int main(int argc, char *argv[]) {
 	}
 
 	// Init the parser
-	uint8_t frame[30];
+	uint8_t frame[25];
 	unsigned partial_frame_count = 0;
+	unsigned frames = 0;
+	unsigned decoded = 0;
 	uint16_t rc_values[18];
 	uint16_t num_values;
 	bool sbus_failsafe;
@@ -54,18 +58,28 @@ int main(int argc, char *argv[]) {
 
 		//warnx("%f: 0x%02x, first: 0x%02x, last: 0x%02x, pcount: %u", (double)f, x, frame[0], frame[24], partial_frame_count);
 
-		if (partial_frame_count == sizeof(frame))
-			partial_frame_count = 0;
-
 		last_time = f;
 
+		if (partial_frame_count < sizeof(frame))
+			continue;
+
+		partial_frame_count = 0;
+		frames++;
+
 		// Pipe the data into the parser
 		hrt_abstime now = hrt_absolute_time();
 
-		//if (partial_frame_count % 25 == 0)
-			//sbus_parse(now, frame, &partial_frame_count, rc_values, &num_values, &sbus_failsafe, &sbus_frame_drop, max_channels);
+		if (sbus_decode(now, frame, rc_values, &num_values, &sbus_failsafe, &sbus_frame_drop, max_channels)) {
+			decoded++;
+			warnx("%u channels: %u %u %u %u %u %u %u %u%s%s", num_values,
+			      rc_values[0], rc_values[1], rc_values[2], rc_values[3],
+			      rc_values[4], rc_values[5], rc_values[6], rc_values[7],
+			      sbus_failsafe ? " FAILSAFE" : "", sbus_frame_drop ? " FRAME DROP" : "");
+		}
 	}
 
+	warnx("%u frames, %u decoded", frames, decoded);
+
 	if (ret == EOF) {
 		warnx("Test finished, reached end of file");
 	} else {
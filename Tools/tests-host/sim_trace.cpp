@@ -0,0 +1,182 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sim_trace.cpp
+ *
+ * Trace of a host simulation run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include "sim_trace.h"
+
+static const char *const *trace_columns;
+static unsigned		trace_width;
+static float		*trace;
+static unsigned		trace_len;
+static unsigned		trace_size;
+
+void
+sim_trace_init(const char *const columns[], unsigned count)
+{
+	sim_trace_free();
+	trace_columns = columns;
+	trace_width = count;
+}
+
+void
+sim_trace_add(const float row[])
+{
+	if (trace_len == trace_size) {
+		trace_size = (trace_size == 0) ? 1024 : trace_size * 2;
+		trace = (float *)realloc(trace, trace_size * trace_width * sizeof(float));
+
+		if (trace == nullptr) {
+			errx(1, "out of memory");
+		}
+	}
+
+	memcpy(&trace[trace_len * trace_width], row, trace_width * sizeof(float));
+	trace_len++;
+}
+
+int
+sim_trace_write(const char *path)
+{
+	FILE *fp = fopen(path, "w");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return -1;
+	}
+
+	for (unsigned c = 0; c < trace_width; c++) {
+		fprintf(fp, "%s%s", trace_columns[c], (c < trace_width - 1) ? "," : "\n");
+	}
+
+	for (unsigned i = 0; i < trace_len; i++) {
+		for (unsigned c = 0; c < trace_width; c++) {
+			fprintf(fp, "%.6g%s", (double)trace[i * trace_width + c], (c < trace_width - 1) ? "," : "\n");
+		}
+	}
+
+	fclose(fp);
+	warnx("trace written to %s (%u rows)", path, trace_len);
+	return 0;
+}
+
+int
+sim_trace_compare(const char *path, float tolerance)
+{
+	FILE *fp = fopen(path, "r");
+
+	if (fp == nullptr) {
+		warn("failed opening %s", path);
+		return 1;
+	}
+
+	char line[1024];
+	unsigned row = 0;
+	unsigned mismatches = 0;
+	float worst = 0.0f;
+	unsigned worst_row = 0;
+	unsigned worst_col = 0;
+
+	/* header */
+	if (fgets(line, sizeof(line), fp) == nullptr) {
+		fclose(fp);
+		warnx("%s: empty", path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), fp) != nullptr && row < trace_len) {
+		char *p = line;
+
+		for (unsigned c = 0; c < trace_width; c++) {
+			char *end;
+			float ref = strtof(p, &end);
+
+			if (end == p) {
+				break;
+			}
+
+			p = (*end == ',') ? end + 1 : end;
+
+			float err = fabsf(trace[row * trace_width + c] - ref) / fmaxf(fabsf(ref), 1.0f);
+
+			if (!(err <= tolerance)) {
+				mismatches++;
+			}
+
+			if (!(err <= worst)) {
+				worst = err;
+				worst_row = row;
+				worst_col = c;
+			}
+		}
+
+		row++;
+	}
+
+	/* remaining rows on either side */
+	bool length_differs = (row != trace_len) || (fgets(line, sizeof(line), fp) != nullptr);
+	fclose(fp);
+
+	if (worst > 0.0f && worst_row < trace_len) {
+		warnx("largest difference %.3g at t=%.2f s in %s", (double)worst,
+		      (double)trace[worst_row * trace_width], trace_columns[worst_col]);
+	}
+
+	if (length_differs) {
+		warnx("trace length differs from %s", path);
+	}
+
+	warnx("compared %u rows against %s, %u values differ by more than %g", row, path, mismatches, (double)tolerance);
+
+	return (mismatches > 0 || length_differs) ? 1 : 0;
+}
+
+void
+sim_trace_free()
+{
+	free(trace);
+	trace = nullptr;
+	trace_len = 0;
+	trace_size = 0;
+}
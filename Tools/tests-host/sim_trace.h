@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sim_trace.h
+ *
+ * Trace of a host simulation run.
+ *
+ * A trace is a table of float columns, one row per sample, written as CSV.
+ * Comparing a run against the trace of an earlier one shows the effect of
+ * a change before it is flown.
+ */
+
+#pragma once
+
+/**
+ * Start a trace.
+ *
+ * @param columns	column names, the first column is the time in seconds
+ * @param count		number of columns
+ */
+void	sim_trace_init(const char *const columns[], unsigned count);
+
+/**
+ * Append a row of as many values as there are columns.
+ */
+void	sim_trace_add(const float row[]);
+
+/**
+ * Write the trace as CSV with a header line.
+ *
+ * @return		0 on success, -1 on error
+ */
+int	sim_trace_write(const char *path);
+
+/**
+ * Compare the trace against a reference trace.
+ *
+ * A value differs if it is off by more than tolerance, relative to the
+ * reference value but at least absolute.
+ *
+ * @return		0 if the traces match, 1 otherwise
+ */
+int	sim_trace_compare(const char *path, float tolerance);
+
+/**
+ * Release the trace.
+ */
+void	sim_trace_free();
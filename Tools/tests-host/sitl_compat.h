@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sitl_compat.h
+ *
+ * NuttX definitions needed to run flight control modules as threads of one
+ * Linux process. Force-included into the module sources by the Makefile.
+ *
+ * Tasks are POSIX threads (sitl_posix.cpp). exit() in a module ends the
+ * calling task, not the process, and device nodes the modules open are
+ * looked up in a table of simulated devices before the host file system.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/cdefs.h>
+#include <sys/ioctl.h>
+
+/* NuttX encodes ioctl commands from a base and a number only */
+#undef _IOC
+#define _IOC(_type, _nr)	((_type) | (_nr))
+
+#define noreturn_function	__attribute__((noreturn))
+
+typedef int (*main_t)(int argc, char *argv[]);
+
+#define ASSERT(_x)		assert(_x)
+
+/* the board the sensor setup follows */
+#define CONFIG_ARCH_BOARD_PX4FMU_V2	1
+
+/* priorities are accepted and ignored, all tasks run at the host default */
+#define SCHED_PRIORITY_MAX	255
+#define SCHED_PRIORITY_DEFAULT	100
+
+__BEGIN_DECLS
+
+/**
+ * End the calling task with a status, or the process if called
+ * outside of a task.
+ */
+void	sitl_task_exit(int status) noreturn_function;
+
+int	task_delete(int pid);
+
+int	sitl_open(const char *path, int flags, ...);
+int	sitl_close(int fd);
+int	sitl_ioctl(int fd, int cmd, unsigned long arg);
+ssize_t	sitl_read(int fd, void *buf, size_t count);
+
+__END_DECLS
+
+#define exit(_status)		sitl_task_exit(_status)
+#define _exit(_status)		sitl_task_exit(_status)
+#define open(...)		sitl_open(__VA_ARGS__)
+#define close(_fd)		sitl_close(_fd)
+#define ioctl(_fd, _cmd, _arg)	sitl_ioctl(_fd, _cmd, (unsigned long)(_arg))
+#define read(_fd, _buf, _count)	sitl_read(_fd, _buf, _count)
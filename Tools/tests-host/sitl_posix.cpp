@@ -0,0 +1,492 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sitl_posix.cpp
+ *
+ * NuttX task and device services for flight control modules running as
+ * threads of one Linux process.
+ *
+ * Tasks are detached POSIX threads. Like on NuttX, a task ends when its
+ * main returns or it calls exit(), which sitl_compat.h maps onto
+ * sitl_task_exit(). The err() family is replaced here for the same reason:
+ * a fatal error in a module ends the module, not the simulation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <queue.h>
+#include <systemlib/err.h>
+
+#include "sitl_posix.h"
+
+#define SITL_MAX_TASKS		16
+#define SITL_MAX_ARGS		8
+#define SITL_MAX_DEVICES	16
+#define SITL_MAX_FDS		1024
+#define SITL_PID_BASE		100
+
+struct sitl_task {
+	char		name[32];
+	main_t		entry;
+	int		argc;
+	char		*argv[SITL_MAX_ARGS + 1];
+	char		args[SITL_MAX_ARGS][32];
+	pthread_t	thread;
+	bool		detached;
+	bool		running;
+	int		status;
+	uint64_t	cpu_ns;		/**< CPU time used, valid once the task has ended */
+};
+
+static sitl_task	tasks[SITL_MAX_TASKS];
+static unsigned		num_tasks;
+static unsigned		spawned[SITL_MAX_TASKS];	/**< tasks started with task_spawn_cmd() */
+static unsigned		num_spawned;
+static pthread_mutex_t	task_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread sitl_task *current_task;
+
+static pthread_mutex_t	queue_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char		devices[SITL_MAX_DEVICES][32];
+static unsigned		num_devices;
+static bool		device_fds[SITL_MAX_FDS];
+static pthread_mutex_t	device_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t
+thread_cpu_ns(clockid_t clock)
+{
+	struct timespec ts;
+
+	if (clock_gettime(clock, &ts) != 0) {
+		return 0;
+	}
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+task_ended(sitl_task *task, int status)
+{
+	pthread_mutex_lock(&task_lock);
+	task->cpu_ns = thread_cpu_ns(CLOCK_THREAD_CPUTIME_ID);
+	task->status = status;
+	task->running = false;
+	pthread_mutex_unlock(&task_lock);
+}
+
+static void *
+task_trampoline(void *arg)
+{
+	sitl_task *task = (sitl_task *)arg;
+	current_task = task;
+
+	int status = task->entry(task->argc, task->argv);
+
+	task_ended(task, status);
+	return (void *)(intptr_t)status;
+}
+
+static int
+task_create(const char *name, main_t entry, const char *const argv[], bool detached)
+{
+	pthread_mutex_lock(&task_lock);
+
+	if (num_tasks >= SITL_MAX_TASKS) {
+		pthread_mutex_unlock(&task_lock);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	unsigned index = num_tasks++;
+	sitl_task *task = &tasks[index];
+	memset(task, 0, sizeof(*task));
+
+	strncpy(task->name, name, sizeof(task->name) - 1);
+	task->entry = entry;
+	task->argv[task->argc++] = task->name;
+
+	for (unsigned i = 0; argv != nullptr && argv[i] != nullptr && task->argc < SITL_MAX_ARGS; i++) {
+		strncpy(task->args[i], argv[i], sizeof(task->args[i]) - 1);
+		task->argv[task->argc++] = task->args[i];
+	}
+
+	task->detached = detached;
+	task->running = true;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, detached ? PTHREAD_CREATE_DETACHED : PTHREAD_CREATE_JOINABLE);
+
+	int ret = pthread_create(&task->thread, &attr, task_trampoline, task);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		task->running = false;
+		pthread_mutex_unlock(&task_lock);
+		errno = ret;
+		return -1;
+	}
+
+	pthread_mutex_unlock(&task_lock);
+	return SITL_PID_BASE + index;
+}
+
+extern "C" int
+task_spawn_cmd(const char *name, int priority, int scheduler, int stack_size, main_t entry, const char *argv[])
+{
+	(void)priority;
+	(void)scheduler;
+	(void)stack_size;
+
+	int pid = task_create(name, entry, argv, true);
+
+	if (pid >= 0) {
+		pthread_mutex_lock(&task_lock);
+		spawned[num_spawned++] = pid - SITL_PID_BASE;
+		pthread_mutex_unlock(&task_lock);
+	}
+
+	return pid;
+}
+
+extern "C" int
+task_delete(int pid)
+{
+	unsigned index = pid - SITL_PID_BASE;
+
+	if (index >= num_tasks || !tasks[index].running) {
+		errno = ESRCH;
+		return -1;
+	}
+
+	return (pthread_cancel(tasks[index].thread) == 0) ? 0 : -1;
+}
+
+extern "C" void
+sitl_task_exit(int status)
+{
+	if (current_task == nullptr) {
+		fflush(stdout);
+		exit(status);
+	}
+
+	task_ended(current_task, status);
+	pthread_exit((void *)(intptr_t)status);
+}
+
+int
+sitl_command(main_t entry, const char *argv[])
+{
+	int pid = task_create(argv[0], entry, &argv[1], false);
+
+	if (pid < 0) {
+		warn("%s", argv[0]);
+		return 1;
+	}
+
+	pthread_join(tasks[pid - SITL_PID_BASE].thread, nullptr);
+	return tasks[pid - SITL_PID_BASE].status;
+}
+
+unsigned
+sitl_task_count()
+{
+	return num_spawned;
+}
+
+const char *
+sitl_task_name(unsigned index)
+{
+	return (index < num_spawned) ? tasks[spawned[index]].name : nullptr;
+}
+
+uint64_t
+sitl_task_cpu_ns(unsigned index)
+{
+	if (index >= num_spawned) {
+		return 0;
+	}
+
+	sitl_task *task = &tasks[spawned[index]];
+
+	pthread_mutex_lock(&task_lock);
+	uint64_t ns = task->cpu_ns;
+
+	if (task->running) {
+		clockid_t clock;
+
+		if (pthread_getcpuclockid(task->thread, &clock) == 0) {
+			ns = thread_cpu_ns(clock);
+		}
+	}
+
+	pthread_mutex_unlock(&task_lock);
+	return ns;
+}
+
+/*
+ * err() and warn() families: report like BSD err(3) with the task name,
+ * err() then ends the calling task.
+ */
+static void
+report(const char *fmt, va_list args, int code)
+{
+	fprintf(stderr, "%s: ", (current_task != nullptr) ? current_task->name : program_invocation_short_name);
+
+	if (fmt != nullptr) {
+		vfprintf(stderr, fmt, args);
+	}
+
+	if (code >= 0) {
+		fprintf(stderr, "%s%s", (fmt != nullptr) ? ": " : "", strerror(code));
+	}
+
+	fprintf(stderr, "\n");
+}
+
+void
+vwarn(const char *fmt, va_list args)
+{
+	report(fmt, args, errno);
+}
+
+void
+warn(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vwarn(fmt, args);
+	va_end(args);
+}
+
+void
+vwarnx(const char *fmt, va_list args)
+{
+	report(fmt, args, -1);
+}
+
+void
+warnx(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vwarnx(fmt, args);
+	va_end(args);
+}
+
+void
+verrc(int eval, int code, const char *fmt, va_list args)
+{
+	report(fmt, args, code);
+	sitl_task_exit(eval);
+}
+
+void
+errc(int eval, int code, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	report(fmt, args, code);
+	va_end(args);
+	sitl_task_exit(eval);
+}
+
+void
+verr(int eval, const char *fmt, va_list args)
+{
+	verrc(eval, errno, fmt, args);
+}
+
+void
+err(int eval, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	report(fmt, args, errno);
+	va_end(args);
+	sitl_task_exit(eval);
+}
+
+void
+verrx(int eval, const char *fmt, va_list args)
+{
+	report(fmt, args, -1);
+	sitl_task_exit(eval);
+}
+
+void
+errx(int eval, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	report(fmt, args, -1);
+	va_end(args);
+	sitl_task_exit(eval);
+}
+
+/*
+ * Simulated device nodes.
+ */
+void
+sitl_device_register(const char *path)
+{
+	pthread_mutex_lock(&device_lock);
+
+	if (num_devices < SITL_MAX_DEVICES) {
+		strncpy(devices[num_devices], path, sizeof(devices[0]) - 1);
+		num_devices++;
+	}
+
+	pthread_mutex_unlock(&device_lock);
+}
+
+static bool
+is_device(int fd)
+{
+	return fd >= 0 && fd < SITL_MAX_FDS && device_fds[fd];
+}
+
+extern "C" int
+sitl_open(const char *path, int flags, ...)
+{
+	va_list args;
+	va_start(args, flags);
+	mode_t mode = va_arg(args, int);
+	va_end(args);
+
+	pthread_mutex_lock(&device_lock);
+
+	for (unsigned i = 0; i < num_devices; i++) {
+		if (strcmp(devices[i], path) == 0) {
+			/* back the node with a real descriptor so that it cannot clash with others */
+			int fd = open("/dev/null", O_RDWR);
+
+			if (fd >= 0 && fd < SITL_MAX_FDS) {
+				device_fds[fd] = true;
+			}
+
+			pthread_mutex_unlock(&device_lock);
+			return fd;
+		}
+	}
+
+	pthread_mutex_unlock(&device_lock);
+
+	return open(path, flags, mode);
+}
+
+extern "C" int
+sitl_close(int fd)
+{
+	if (is_device(fd)) {
+		pthread_mutex_lock(&device_lock);
+		device_fds[fd] = false;
+		pthread_mutex_unlock(&device_lock);
+	}
+
+	return close(fd);
+}
+
+extern "C" int
+sitl_ioctl(int fd, int cmd, unsigned long arg)
+{
+	if (is_device(fd)) {
+		return 0;
+	}
+
+	return ioctl(fd, cmd, arg);
+}
+
+extern "C" ssize_t
+sitl_read(int fd, void *buf, size_t count)
+{
+	if (is_device(fd)) {
+		return 0;
+	}
+
+	return read(fd, buf, count);
+}
+
+/*
+ * The NuttX singly linked queue, as used by the perf counter list. Tasks
+ * allocate their counters concurrently here, so the operations are locked.
+ */
+extern "C" void
+sq_addfirst(sq_entry_t *node, sq_queue_t *queue)
+{
+	pthread_mutex_lock(&queue_lock);
+
+	node->flink = queue->head;
+
+	if (queue->head == nullptr) {
+		queue->tail = node;
+	}
+
+	queue->head = node;
+
+	pthread_mutex_unlock(&queue_lock);
+}
+
+extern "C" void
+sq_rem(sq_entry_t *node, sq_queue_t *queue)
+{
+	pthread_mutex_lock(&queue_lock);
+
+	sq_entry_t **p = &queue->head;
+	sq_entry_t *prev = nullptr;
+
+	while (*p != nullptr && *p != node) {
+		prev = *p;
+		p = &(*p)->flink;
+	}
+
+	if (*p != nullptr) {
+		*p = node->flink;
+
+		if (queue->tail == node) {
+			queue->tail = prev;
+		}
+	}
+
+	pthread_mutex_unlock(&queue_lock);
+}
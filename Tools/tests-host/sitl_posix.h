@@ -0,0 +1,90 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sitl_posix.h
+ *
+ * NuttX task and device services for flight control modules running as
+ * threads of one Linux process.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+typedef int (*main_t)(int argc, char *argv[]);
+
+__BEGIN_DECLS
+
+/**
+ * End the calling task with a status, or the process if called
+ * outside of a task.
+ */
+void	sitl_task_exit(int status) __attribute__((noreturn));
+
+__END_DECLS
+
+/**
+ * Run a command the way the NuttX shell runs a builtin: in a task of its
+ * own, so that exit() or errx() in the command only ends that task.
+ *
+ * @param entry		The command main, e.g. sensors_main.
+ * @param argv		Command line, argv[0] is the command name, nullptr terminated.
+ * @return		The exit status of the command.
+ */
+int	sitl_command(main_t entry, const char *argv[]);
+
+/**
+ * Register a simulated device node.
+ *
+ * Opening the node succeeds and ioctl() on it returns OK, so that drivers'
+ * clients configure and calibrate without hardware. The data flows over uORB.
+ */
+void	sitl_device_register(const char *path);
+
+/**
+ * Number of tasks started with task_spawn_cmd().
+ */
+unsigned sitl_task_count();
+
+/**
+ * Name of a task.
+ */
+const char *sitl_task_name(unsigned index);
+
+/**
+ * CPU time a task has used so far, in nanoseconds.
+ */
+uint64_t sitl_task_cpu_ns(unsigned index);
@@ -0,0 +1,5 @@
+/*
+ * Host stand-in for the STM32 power control header, nothing is needed from it.
+ */
+
+#pragma once
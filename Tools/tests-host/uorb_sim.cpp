@@ -0,0 +1,396 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file uorb_sim.cpp
+ *
+ * In-process uORB for host simulation.
+ *
+ * Every topic is a node holding the last published data and a generation
+ * count. A subscriber remembers the generation it has seen; its eventfd
+ * is signalled when the topic appears updated and drained by orb_copy().
+ * The update semantics follow the NuttX implementation, with one
+ * simplification for rate limited subscribers: an update suppressed by the
+ * interval is reported with the next publication after the interval, not
+ * by a timer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <drivers/drv_hrt.h>
+
+#include "uorb_sim.h"
+
+#define ORB_SIM_MAX_NODES	64
+#define ORB_SIM_MAX_FDS		1024
+
+struct orb_sim_node {
+	const struct orb_metadata *meta;
+	void		*data;		/**< last publication, nullptr until published */
+	unsigned	generation;
+	hrt_abstime	last_update;
+	unsigned	subscribers;
+	struct orb_sim_sub *first_sub;
+};
+
+struct orb_sim_sub {
+	orb_sim_node	*node;
+	orb_sim_sub	*next;		/**< next subscriber of the node */
+	int		fd;
+	unsigned	generation;	/**< last generation seen */
+	unsigned	interval;	/**< minimum interval between updates in ms, 0 for none */
+	hrt_abstime	last_report;
+	bool		update_reported;
+	bool		signalled;	/**< the eventfd is readable */
+};
+
+static orb_sim_node	nodes[ORB_SIM_MAX_NODES];
+static unsigned		num_nodes;
+static orb_sim_sub	*subs[ORB_SIM_MAX_FDS];
+static pthread_mutex_t	orb_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static orb_sim_node *
+node_get(const struct orb_metadata *meta)
+{
+	for (unsigned i = 0; i < num_nodes; i++) {
+		if (nodes[i].meta == meta) {
+			return &nodes[i];
+		}
+	}
+
+	if (num_nodes >= ORB_SIM_MAX_NODES) {
+		return nullptr;
+	}
+
+	orb_sim_node *node = &nodes[num_nodes++];
+	memset(node, 0, sizeof(*node));
+	node->meta = meta;
+	return node;
+}
+
+static orb_sim_sub *
+sub_get(int handle)
+{
+	if (handle < 0 || handle >= ORB_SIM_MAX_FDS) {
+		return nullptr;
+	}
+
+	return subs[handle];
+}
+
+/*
+ * Decide whether the topic appears updated to a subscriber, see
+ * ORBDevNode::appears_updated().
+ */
+static bool
+appears_updated(orb_sim_sub *sub)
+{
+	orb_sim_node *node = sub->node;
+
+	if (node->data == nullptr || sub->generation == node->generation) {
+		return false;
+	}
+
+	if (sub->interval == 0 || sub->update_reported) {
+		return true;
+	}
+
+	hrt_abstime now = hrt_absolute_time();
+
+	if (sub->last_report != 0 && now - sub->last_report < sub->interval * 1000ULL) {
+		return false;
+	}
+
+	sub->last_report = now;
+	sub->update_reported = true;
+	return true;
+}
+
+static void
+signal_sub(orb_sim_sub *sub)
+{
+	if (!sub->signalled && appears_updated(sub)) {
+		uint64_t one = 1;
+
+		if (write(sub->fd, &one, sizeof(one)) == sizeof(one)) {
+			sub->signalled = true;
+		}
+	}
+}
+
+static int
+publish_locked(orb_sim_node *node, const void *data)
+{
+	if (node->data == nullptr) {
+		node->data = malloc(node->meta->o_size);
+
+		if (node->data == nullptr) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	memcpy(node->data, data, node->meta->o_size);
+	node->generation++;
+	node->last_update = hrt_absolute_time();
+
+	for (orb_sim_sub *sub = node->first_sub; sub != nullptr; sub = sub->next) {
+		signal_sub(sub);
+	}
+
+	return 0;
+}
+
+orb_advert_t
+orb_advertise(const struct orb_metadata *meta, const void *data)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_node *node = node_get(meta);
+	int ret = (node != nullptr) ? publish_locked(node, data) : -1;
+
+	pthread_mutex_unlock(&orb_lock);
+
+	if (ret != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* the handle only has to be positive and identify the node */
+	return (orb_advert_t)node;
+}
+
+int
+orb_publish(const struct orb_metadata *meta, orb_advert_t handle, const void *data)
+{
+	orb_sim_node *node = (orb_sim_node *)handle;
+
+	if (handle <= 0 || node->meta != meta) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pthread_mutex_lock(&orb_lock);
+	int ret = publish_locked(node, data);
+	pthread_mutex_unlock(&orb_lock);
+
+	return ret;
+}
+
+int
+orb_subscribe(const struct orb_metadata *meta)
+{
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	if (fd >= ORB_SIM_MAX_FDS) {
+		close(fd);
+		errno = EMFILE;
+		return -1;
+	}
+
+	orb_sim_sub *sub = (orb_sim_sub *)calloc(1, sizeof(orb_sim_sub));
+
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_node *node = node_get(meta);
+
+	if (sub == nullptr || node == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		free(sub);
+		close(fd);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* like on NuttX, earlier publications do not appear as an update */
+	sub->node = node;
+	sub->fd = fd;
+	sub->generation = node->generation;
+	sub->next = node->first_sub;
+	node->first_sub = sub;
+	node->subscribers++;
+	subs[fd] = sub;
+
+	pthread_mutex_unlock(&orb_lock);
+
+	return fd;
+}
+
+int
+orb_unsubscribe(int handle)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_sub *sub = sub_get(handle);
+
+	if (sub == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EBADF;
+		return -1;
+	}
+
+	orb_sim_sub **link = &sub->node->first_sub;
+
+	while (*link != sub) {
+		link = &(*link)->next;
+	}
+
+	*link = sub->next;
+	sub->node->subscribers--;
+	subs[handle] = nullptr;
+
+	pthread_mutex_unlock(&orb_lock);
+
+	free(sub);
+	return close(handle);
+}
+
+int
+orb_copy(const struct orb_metadata *meta, int handle, void *buffer)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_sub *sub = sub_get(handle);
+
+	if (sub == nullptr || sub->node->meta != meta) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EBADF;
+		return -1;
+	}
+
+	orb_sim_node *node = sub->node;
+
+	if (node->data == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EIO;
+		return -1;
+	}
+
+	memcpy(buffer, node->data, meta->o_size);
+	sub->generation = node->generation;
+	sub->update_reported = false;
+
+	if (sub->signalled) {
+		uint64_t count;
+
+		if (read(handle, &count, sizeof(count)) == sizeof(count)) {
+			sub->signalled = false;
+		}
+	}
+
+	pthread_mutex_unlock(&orb_lock);
+	return 0;
+}
+
+int
+orb_check(int handle, bool *updated)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_sub *sub = sub_get(handle);
+
+	if (sub == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EBADF;
+		return -1;
+	}
+
+	*updated = appears_updated(sub);
+
+	pthread_mutex_unlock(&orb_lock);
+	return 0;
+}
+
+int
+orb_stat(int handle, uint64_t *time)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_sub *sub = sub_get(handle);
+
+	if (sub == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EBADF;
+		return -1;
+	}
+
+	*time = sub->node->last_update;
+
+	pthread_mutex_unlock(&orb_lock);
+	return 0;
+}
+
+int
+orb_set_interval(int handle, unsigned interval)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	orb_sim_sub *sub = sub_get(handle);
+
+	if (sub == nullptr) {
+		pthread_mutex_unlock(&orb_lock);
+		errno = EBADF;
+		return -1;
+	}
+
+	sub->interval = interval;
+
+	pthread_mutex_unlock(&orb_lock);
+	return 0;
+}
+
+unsigned
+orb_sim_subscribers(const struct orb_metadata *meta)
+{
+	pthread_mutex_lock(&orb_lock);
+
+	unsigned count = 0;
+
+	for (unsigned i = 0; i < num_nodes; i++) {
+		if (nodes[i].meta == meta) {
+			count = nodes[i].subscribers;
+		}
+	}
+
+	pthread_mutex_unlock(&orb_lock);
+	return count;
+}
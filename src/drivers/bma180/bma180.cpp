@@ -63,7 +63,7 @@
 
 #include <drivers/device/spi.h>
 #include <drivers/drv_accel.h>
-#include <drivers/device/ringbuffer.h>
+#include <drivers/device/sampler.h>
 
 
 /* oddly, ERROR is not defined for c++ */
@@ -121,9 +121,12 @@ static const int ERROR = -1;
 #define ADDR_OFFSET_T			0x37
 #define OFFSET_T_READOUT_12BIT			(1<<0)
 
+/* with internal low pass filters enabled, 250 Hz is sufficient */
+#define BMA180_DEFAULT_RATE		250
+
 extern "C" { __EXPORT int bma180_main(int argc, char *argv[]); }
 
-class BMA180 : public device::SPI
+class BMA180 : public device::SPI, public device::Sampler
 {
 public:
 	BMA180(int bus, spi_dev_e device);
@@ -142,12 +145,10 @@ public:
 protected:
 	virtual int		probe();
 
-private:
-
-	struct hrt_call		_call;
-	unsigned		_call_interval;
+	virtual int		sample(void *report, hrt_abstime timestamp);
+	virtual void		sample_ready(const void *report);
 
-	RingBuffer		*_reports;
+private:
 
 	struct accel_scale	_accel_scale;
 	float			_accel_range_scale;
@@ -158,34 +159,6 @@ private:
 	unsigned		_current_lowpass;
 	unsigned		_current_range;
 
-	perf_counter_t		_sample_perf;
-
-	/**
-	 * Start automatic measurement.
-	 */
-	void			start();
-
-	/**
-	 * Stop automatic measurement.
-	 */
-	void			stop();
-
-	/**
-	 * Static trampoline from the hrt_call context; because we don't have a
-	 * generic hrt wrapper yet.
-	 *
-	 * Called by the HRT in interrupt context at the specified rate if
-	 * automatic polling is enabled.
-	 *
-	 * @param arg		Instance pointer for the driver that is polling.
-	 */
-	static void		measure_trampoline(void *arg);
-
-	/**
-	 * Fetch measurements from the sensor and update the report ring.
-	 */
-	void			measure();
-
 	/**
 	 * Read a register from the BMA180
 	 *
@@ -234,15 +207,13 @@ private:
 
 BMA180::BMA180(int bus, spi_dev_e device) :
 	SPI("BMA180", ACCEL_DEVICE_PATH, bus, device, SPIDEV_MODE3, 8000000),
-	_call_interval(0),
-	_reports(nullptr),
+	Sampler("bma180", sizeof(accel_report), BMA180_DEFAULT_RATE, BMA180_DEFAULT_RATE),
 	_accel_range_scale(0.0f),
 	_accel_range_m_s2(0.0f),
 	_accel_topic(-1),
 	_class_instance(-1),
 	_current_lowpass(0),
-	_current_range(0),
-	_sample_perf(perf_alloc(PC_ELAPSED, "bma180_read"))
+	_current_range(0)
 {
 	// enable debug() calls
 	_debug_enabled = true;
@@ -259,14 +230,7 @@ BMA180::BMA180(int bus, spi_dev_e device) :
 BMA180::~BMA180()
 {
 	/* make sure we are truly inactive */
-	stop();
-
-	/* free any existing reports */
-	if (_reports != nullptr)
-		delete _reports;
-
-	/* delete the perf counter */
-	perf_free(_sample_perf);
+	sampler_stop();
 }
 
 int
@@ -278,10 +242,8 @@ BMA180::init()
 	if (SPI::init() != OK)
 		goto out;
 
-	/* allocate basic report buffers */
-	_reports = new RingBuffer(2, sizeof(accel_report));
-
-	if (_reports == nullptr)
+	/* allocate basic report buffers, keep at least two queued reports */
+	if (sampler_init(2, 2) != OK)
 		goto out;
 
 	/* perform soft reset (p48) */
@@ -322,11 +284,11 @@ BMA180::init()
 	_class_instance = register_class_devname(ACCEL_DEVICE_PATH);
 
 	/* advertise sensor topic, measure manually to initialize valid report */
-	measure();
+	sampler_measure();
 
 	if (_class_instance == CLASS_DEVICE_PRIMARY) {
 		struct accel_report arp;
-		_reports->get(&arp);
+		sampler_get(&arp);
 
 		/* measurement will have generated a report, publish */
 		_accel_topic = orb_advertise(ORB_ID(sensor_accel), &arp);
@@ -351,120 +313,18 @@ BMA180::probe()
 ssize_t
 BMA180::read(struct file *filp, char *buffer, size_t buflen)
 {
-	unsigned count = buflen / sizeof(struct accel_report);
-	struct accel_report *arp = reinterpret_cast<struct accel_report *>(buffer);
-	int ret = 0;
-
-	/* buffer must be large enough */
-	if (count < 1)
-		return -ENOSPC;
-
-	/* if automatic measurement is enabled */
-	if (_call_interval > 0) {
-
-		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
-		 * Note that we may be pre-empted by the measurement code while we are doing this;
-		 * we are careful to avoid racing with it.
-		 */
-		while (count--) {
-			if (_reports->get(arp)) {
-				ret += sizeof(*arp);
-				arp++;
-			}
-		}
-
-		/* if there was no data, warn the caller */
-		return ret ? ret : -EAGAIN;
-	}
-
-	/* manual measurement */
-	_reports->flush();
-	measure();
-
-	/* measurement will have generated a report, copy it out */
-	if (_reports->get(arp))
-		ret = sizeof(*arp);
-
-	return ret;
+	return sampler_read(buffer, buflen);
 }
 
 int
 BMA180::ioctl(struct file *filp, int cmd, unsigned long arg)
 {
-	switch (cmd) {
+	int ret = sampler_ioctl(cmd, arg);
 
-	case SENSORIOCSPOLLRATE: {
-			switch (arg) {
-
-				/* switching to manual polling */
-			case SENSOR_POLLRATE_MANUAL:
-				stop();
-				_call_interval = 0;
-				return OK;
-
-				/* external signalling not supported */
-			case SENSOR_POLLRATE_EXTERNAL:
-
-				/* zero would be bad */
-			case 0:
-				return -EINVAL;
-
-
-				/* set default/max polling rate */
-			case SENSOR_POLLRATE_MAX:
-			case SENSOR_POLLRATE_DEFAULT:
-				/* With internal low pass filters enabled, 250 Hz is sufficient */
-				return ioctl(filp, SENSORIOCSPOLLRATE, 250);
-
-				/* adjust to a legal polling interval in Hz */
-			default: {
-					/* do we need to start internal polling? */
-					bool want_start = (_call_interval == 0);
-
-					/* convert hz to hrt interval via microseconds */
-					unsigned ticks = 1000000 / arg;
-
-					/* check against maximum sane rate */
-					if (ticks < 1000)
-						return -EINVAL;
-
-					/* update interval for next measurement */
-					/* XXX this is a bit shady, but no other way to adjust... */
-					_call.period = _call_interval = ticks;
-
-					/* if we need to start the poll state machine, do it */
-					if (want_start)
-						start();
-
-					return OK;
-				}
-			}
-		}
-
-	case SENSORIOCGPOLLRATE:
-		if (_call_interval == 0)
-			return SENSOR_POLLRATE_MANUAL;
-
-		return 1000000 / _call_interval;
-
-	case SENSORIOCSQUEUEDEPTH: {
-		/* lower bound is mandatory, upper bound is a sanity check */
-		if ((arg < 2) || (arg > 100))
-			return -EINVAL;
-		
-		irqstate_t flags = irqsave();
-		if (!_reports->resize(arg)) {
-			irqrestore(flags);
-			return -ENOMEM;
-		}
-		irqrestore(flags);
-		
-		return OK;
-	}
+	if (ret != -ENOTTY)
+		return ret;
 
-	case SENSORIOCGQUEUEDEPTH:
-		return _reports->size();
+	switch (cmd) {
 
 	case SENSORIOCRESET:
 		/* XXX implement */
@@ -638,36 +498,8 @@ BMA180::set_lowpass(unsigned frequency)
 		 (BW_TCS_BW_MASK & bwbits));
 }
 
-void
-BMA180::start()
-{
-	/* make sure we are stopped first */
-	stop();
-
-	/* reset the report ring */
-	_reports->flush();
-
-	/* start polling at the specified rate */
-	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&BMA180::measure_trampoline, this);
-}
-
-void
-BMA180::stop()
-{
-	hrt_cancel(&_call);
-}
-
-void
-BMA180::measure_trampoline(void *arg)
-{
-	BMA180 *dev = (BMA180 *)arg;
-
-	/* make another measurement */
-	dev->measure();
-}
-
-void
-BMA180::measure()
+int
+BMA180::sample(void *report_buf, hrt_abstime timestamp)
 {
 	/* BMA180 measurement registers */
 // #pragma pack(push, 1)
@@ -679,10 +511,7 @@ BMA180::measure()
 // 	} raw_report;
 // #pragma pack(pop)
 
-	struct accel_report report;
-
-	/* start the performance counter */
-	perf_begin(_sample_perf);
+	struct accel_report &report = *reinterpret_cast<struct accel_report *>(report_buf);
 
 	/*
 	 * Fetch the full set of measurements from the BMA180 in one pass;
@@ -699,8 +528,8 @@ BMA180::measure()
 	 * them before.  There is no good way to synchronise with the internal
 	 * measurement flow without using the external interrupt.
 	 */
-	report.timestamp = hrt_absolute_time();
-        report.error_count = 0;
+	report.timestamp = timestamp;
+	report.error_count = sampler_errors();
 	/*
 	 * y of board is x of sensor and x of board is -y of sensor
 	 * perform only the axis assignment here.
@@ -727,24 +556,24 @@ BMA180::measure()
 	report.scaling = _accel_range_scale;
 	report.range_m_s2 = _accel_range_m_s2;
 
-	_reports->force(&report);
+	return OK;
+}
 
+void
+BMA180::sample_ready(const void *report)
+{
 	/* notify anyone waiting for data */
 	poll_notify(POLLIN);
 
 	/* publish for subscribers */
 	if (_accel_topic > 0 && !(_pub_blocked))
-		orb_publish(ORB_ID(sensor_accel), _accel_topic, &report);
-
-	/* stop the perf counter */
-	perf_end(_sample_perf);
+		orb_publish(ORB_ID(sensor_accel), _accel_topic, report);
 }
 
 void
 BMA180::print_info()
 {
-	perf_print_counter(_sample_perf);
-	_reports->print_info("report queue");
+	sampler_print_info();
 }
 
 /**
@@ -122,6 +122,7 @@
 #define HRT_TIMER		1	/* use timer1 for the HRT */
 #define HRT_TIMER_CHANNEL	2	/* use capture/compare channel 2 */
 #define HRT_PPM_CHANNEL		1	/* use capture/compare channel 1 */
+#define HRT_CALLOUT_MAX		8	/* few callouts on IO, keep the queue small */
 #define GPIO_PPM_IN		(GPIO_ALT|GPIO_CNF_INPULLUP|GPIO_PORTE|GPIO_PIN9)
 
 /* LED definitions ******************************************************************/
@@ -0,0 +1,347 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sampler.cpp
+ *
+ * Common sampling logic for polled sensor drivers.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <drivers/drv_sensor.h>
+#include <drivers/device/ringbuffer.h>
+
+#include "sampler.h"
+
+/* retry delay in microseconds when the sensor had no new data */
+#define SAMPLER_RESCHEDULE_DELAY	100
+
+/* minimum poll interval in microseconds */
+#define SAMPLER_MIN_INTERVAL		1000
+
+namespace device
+{
+
+Sampler::Sampler(const char *name, size_t report_size, unsigned default_rate, unsigned max_rate) :
+	_call_interval(0),
+	_report_size(report_size),
+	_default_rate(default_rate),
+	_max_rate(max_rate),
+	_min_queue_depth(1),
+	_reports(nullptr),
+	_report(nullptr),
+	_error_count(0)
+{
+	static const char *suffixes[] = { "read", "interval", "errors", "overruns", "reschedules" };
+
+	for (unsigned i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+		snprintf(_perf_names[i], sizeof(_perf_names[i]), "%s_%s", name, suffixes[i]);
+	}
+
+	_sample_perf = perf_alloc(PC_ELAPSED, _perf_names[0]);
+	_interval_perf = perf_alloc(PC_INTERVAL, _perf_names[1]);
+	_errors = perf_alloc(PC_COUNT, _perf_names[2]);
+	_overruns = perf_alloc(PC_COUNT, _perf_names[3]);
+	_reschedules = perf_alloc(PC_COUNT, _perf_names[4]);
+
+	memset(&_call, 0, sizeof(_call));
+}
+
+Sampler::~Sampler()
+{
+	/* make sure we are truly inactive */
+	sampler_stop();
+
+	if (_reports != nullptr)
+		delete _reports;
+
+	if (_report != nullptr)
+		delete[] _report;
+
+	perf_free(_sample_perf);
+	perf_free(_interval_perf);
+	perf_free(_errors);
+	perf_free(_overruns);
+	perf_free(_reschedules);
+}
+
+int
+Sampler::sampler_init(unsigned queue_depth, unsigned min_queue_depth)
+{
+	_min_queue_depth = min_queue_depth;
+	_reports = new RingBuffer(queue_depth, _report_size);
+	_report = new uint8_t[_report_size];
+
+	if (_reports == nullptr || _report == nullptr)
+		return -ENOMEM;
+
+	return OK;
+}
+
+void
+Sampler::sampler_set_rates(unsigned default_rate, unsigned max_rate)
+{
+	_default_rate = default_rate;
+	_max_rate = max_rate;
+}
+
+void
+Sampler::sampler_start()
+{
+	/* make sure we are stopped first */
+	sampler_stop();
+
+	/* discard any stale data in the queue */
+	_reports->flush();
+
+	/* start polling at the specified rate */
+	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&Sampler::sample_trampoline, this);
+}
+
+void
+Sampler::sampler_stop()
+{
+	hrt_cancel(&_call);
+}
+
+void
+Sampler::sample_trampoline(void *arg)
+{
+	Sampler *dev = reinterpret_cast<Sampler *>(arg);
+
+	int ret = dev->sampler_measure();
+
+	if (ret == -EAGAIN) {
+		/*
+		 * The sensor has no new data yet; try again shortly rather
+		 * than reading the same value twice and missing the next.
+		 */
+		perf_count(dev->_reschedules);
+		hrt_call_delay(&dev->_call, SAMPLER_RESCHEDULE_DELAY);
+	}
+}
+
+int
+Sampler::sampler_measure()
+{
+	/* take the timestamp before any bus traffic */
+	hrt_abstime timestamp = hrt_absolute_time();
+
+	perf_begin(_sample_perf);
+
+	int ret = sample(_report, timestamp);
+
+	if (ret == -EAGAIN) {
+		perf_cancel(_sample_perf);
+		return ret;
+	}
+
+	if (ret != OK) {
+		_error_count++;
+		perf_count(_errors);
+		perf_end(_sample_perf);
+		return ret;
+	}
+
+	perf_count(_interval_perf);
+
+	if (_reports->force(_report))
+		perf_count(_overruns);
+
+	sample_ready(_report);
+
+	perf_end(_sample_perf);
+
+	return OK;
+}
+
+ssize_t
+Sampler::sampler_read(char *buffer, size_t buflen)
+{
+	unsigned count = buflen / _report_size;
+	ssize_t ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1)
+		return -ENOSPC;
+
+	/* if automatic measurement is enabled */
+	if (_call_interval > 0) {
+
+		/*
+		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Note that we may be pre-empted by the measurement code while we are doing this;
+		 * we are careful to avoid racing with it.
+		 */
+		while (count--) {
+			if (!_reports->get(buffer, _report_size))
+				break;
+
+			ret += _report_size;
+			buffer += _report_size;
+		}
+
+		/* if there was no data, warn the caller */
+		return ret ? ret : -EAGAIN;
+	}
+
+	/* manual measurement */
+	_reports->flush();
+	sampler_measure();
+
+	/* measurement will have generated a report, copy it out */
+	if (_reports->get(buffer, _report_size))
+		ret = _report_size;
+
+	return ret;
+}
+
+bool
+Sampler::sampler_get(void *report)
+{
+	return _reports->get(report, _report_size);
+}
+
+int
+Sampler::sampler_ioctl(int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case SENSORIOCSPOLLRATE: {
+			switch (arg) {
+
+				/* switching to manual polling */
+			case SENSOR_POLLRATE_MANUAL:
+				sampler_stop();
+				_call_interval = 0;
+				return OK;
+
+				/* external signalling not supported */
+			case SENSOR_POLLRATE_EXTERNAL:
+
+				/* zero would be bad */
+			case 0:
+				return -EINVAL;
+
+				/* set default/max polling rate */
+			case SENSOR_POLLRATE_MAX:
+				return sampler_ioctl(SENSORIOCSPOLLRATE, _max_rate);
+
+			case SENSOR_POLLRATE_DEFAULT:
+				return sampler_ioctl(SENSORIOCSPOLLRATE, _default_rate);
+
+				/* adjust to a legal polling interval in Hz */
+			default: {
+					/* do we need to start internal polling? */
+					bool want_start = (_call_interval == 0);
+
+					/* convert hz to hrt interval via microseconds */
+					unsigned ticks = 1000000 / arg;
+
+					/* check against maximum sane rate */
+					if (ticks < SAMPLER_MIN_INTERVAL)
+						return -EINVAL;
+
+					/* update interval for next measurement */
+					/* XXX this is a bit shady, but no other way to adjust... */
+					_call.period = _call_interval = ticks;
+
+					sample_rate_changed(arg);
+
+					/* if we need to start the poll state machine, do it */
+					if (want_start)
+						sampler_start();
+
+					return OK;
+				}
+			}
+		}
+
+	case SENSORIOCGPOLLRATE:
+		if (_call_interval == 0)
+			return SENSOR_POLLRATE_MANUAL;
+
+		return 1000000 / _call_interval;
+
+	case SENSORIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < _min_queue_depth) || (arg > 100))
+				return -EINVAL;
+
+			irqstate_t flags = irqsave();
+
+			if (!_reports->resize(arg)) {
+				irqrestore(flags);
+				return -ENOMEM;
+			}
+
+			irqrestore(flags);
+
+			return OK;
+		}
+
+	case SENSORIOCGQUEUEDEPTH:
+		return _reports->size();
+
+	default:
+		return -ENOTTY;
+	}
+}
+
+void
+Sampler::sampler_print_info()
+{
+	perf_print_counter(_sample_perf);
+	perf_print_counter(_interval_perf);
+	perf_print_counter(_errors);
+	perf_print_counter(_overruns);
+	perf_print_counter(_reschedules);
+
+	if (_call_interval > 0) {
+		printf("poll interval: %u us\n", _call_interval);
+
+	} else {
+		printf("polled manually\n");
+	}
+
+	_reports->print_info("report queue");
+}
+
+} // namespace device
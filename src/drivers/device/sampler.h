@@ -0,0 +1,229 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sampler.h
+ *
+ * Common sampling logic for polled sensor drivers.
+ */
+
+#ifndef _DEVICE_SAMPLER_H
+#define _DEVICE_SAMPLER_H
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
+
+class RingBuffer;
+
+namespace device __EXPORT
+{
+
+/**
+ * Mix-in base for sensor drivers that are polled from the HRT.
+ *
+ * The sampler owns the polling schedule, the report queue and the
+ * statistics of a driver. A driver derives from its bus class and from
+ * Sampler, implements sample() to read the sensor and convert the data
+ * into a report and sample_ready() to notify pollers and publish, and
+ * forwards read() and the common sensor ioctls to sampler_read() and
+ * sampler_ioctl():
+ *
+ *   SENSORIOCSPOLLRATE / SENSORIOCGPOLLRATE
+ *   SENSORIOCSQUEUEDEPTH / SENSORIOCGQUEUEDEPTH
+ *
+ * The following perf counters are kept, prefixed with the driver name:
+ *
+ *   <name>_read		time spent in sample() (PC_ELAPSED)
+ *   <name>_interval	interval between samples (PC_INTERVAL)
+ *   <name>_errors	failed samples (PC_COUNT)
+ *   <name>_overruns	reports dropped because the queue was full (PC_COUNT)
+ *   <name>_reschedules	samples retried because data was not ready (PC_COUNT)
+ */
+class __EXPORT Sampler
+{
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param name		Driver name, used as the perf counter prefix
+	 * @param report_size	Size of one report
+	 * @param default_rate	Poll rate in Hz for SENSOR_POLLRATE_DEFAULT
+	 * @param max_rate	Poll rate in Hz for SENSOR_POLLRATE_MAX; explicit
+	 *			rates are accepted up to 1 kHz
+	 */
+	Sampler(const char *name, size_t report_size, unsigned default_rate, unsigned max_rate);
+
+	virtual ~Sampler();
+
+protected:
+	/**
+	 * Allocate the report queue.
+	 *
+	 * @param queue_depth	Initial number of queued reports
+	 * @param min_queue_depth Smallest depth accepted by SENSORIOCSQUEUEDEPTH
+	 * @return		OK on success, -ENOMEM otherwise
+	 */
+	int			sampler_init(unsigned queue_depth = 2, unsigned min_queue_depth = 1);
+
+	/**
+	 * Change the default and maximum poll rates, e.g. once the exact
+	 * sensor variant has been probed.
+	 */
+	void			sampler_set_rates(unsigned default_rate, unsigned max_rate);
+
+	/**
+	 * Start polling at the configured interval, discarding queued reports.
+	 */
+	void			sampler_start();
+
+	/**
+	 * Stop polling.
+	 */
+	void			sampler_stop();
+
+	/**
+	 * Take one sample now and queue it, as done by the poll schedule.
+	 *
+	 * @return		OK if a report was queued
+	 */
+	int			sampler_measure();
+
+	/**
+	 * Copy queued reports out, or take a fresh sample in manual mode.
+	 *
+	 * @return		bytes copied, -ENOSPC if buflen is too short for
+	 *			one report, -EAGAIN if no report is queued
+	 */
+	ssize_t			sampler_read(char *buffer, size_t buflen);
+
+	/**
+	 * Handle the ioctls common to all sensors.
+	 *
+	 * @return		the ioctl result, or -ENOTTY if cmd is not a
+	 *			sampler ioctl
+	 */
+	int			sampler_ioctl(int cmd, unsigned long arg);
+
+	/**
+	 * Get the oldest queued report.
+	 *
+	 * @return		true if a report was copied out
+	 */
+	bool			sampler_get(void *report);
+
+	/**
+	 * Print the sampler statistics and queue state.
+	 */
+	void			sampler_print_info();
+
+	/**
+	 * Current poll interval in microseconds, 0 when polled manually.
+	 */
+	unsigned		sampler_interval() const { return _call_interval; }
+
+	/**
+	 * Number of failed samples so far, for the error_count field of
+	 * reports.
+	 */
+	uint64_t		sampler_errors() const { return _error_count; }
+
+	/**
+	 * Read the sensor and convert the data into a report.
+	 *
+	 * Called from the HRT callout, i.e. in interrupt context, or from
+	 * read() in manual mode.
+	 *
+	 * @param report	report to fill in
+	 * @param timestamp	time the sample was started, taken before any
+	 *			bus traffic so that transfer time does not age
+	 *			the report
+	 * @return		OK if the report is valid, -EAGAIN if the
+	 *			sensor has no new data yet and should be
+	 *			polled again shortly, -errno on errors
+	 */
+	virtual int		sample(void *report, hrt_abstime timestamp) = 0;
+
+	/**
+	 * Called after a report was queued; notify pollers and publish.
+	 */
+	virtual void		sample_ready(const void *report) = 0;
+
+	/**
+	 * Called when the poll rate changes, e.g. to retune driver filters.
+	 *
+	 * @param rate		new poll rate in Hz
+	 */
+	virtual void		sample_rate_changed(unsigned rate) {}
+
+private:
+	struct hrt_call		_call;
+	unsigned		_call_interval;
+
+	size_t			_report_size;
+	unsigned		_default_rate;
+	unsigned		_max_rate;
+	unsigned		_min_queue_depth;
+
+	RingBuffer		*_reports;
+	uint8_t			*_report;	/**< report being sampled */
+	uint64_t		_error_count;
+
+	char			_perf_names[5][24];
+	perf_counter_t		_sample_perf;
+	perf_counter_t		_interval_perf;
+	perf_counter_t		_errors;
+	perf_counter_t		_overruns;
+	perf_counter_t		_reschedules;
+
+	/**
+	 * Static trampoline from the hrt_call context.
+	 */
+	static void		sample_trampoline(void *arg);
+
+	/** disable copy construction */
+	Sampler(const Sampler &);
+
+	/** disable assignment */
+	Sampler &operator = (const Sampler &);
+};
+
+} // namespace device
+
+#endif /* _DEVICE_SAMPLER_H */
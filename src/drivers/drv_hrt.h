@@ -69,7 +69,7 @@ typedef void	(* hrt_callout)(void *arg);
  * Callout record.
  */
 typedef struct hrt_call {
-	struct sq_entry_s	link;
+	unsigned		queue_index;	/* position in the callout queue, owned by the HRT */
 
 	hrt_abstime		deadline;
 	hrt_abstime		period;
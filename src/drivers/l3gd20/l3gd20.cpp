@@ -64,7 +64,7 @@
 #include <drivers/drv_hrt.h>
 #include <drivers/device/spi.h>
 #include <drivers/drv_gyro.h>
-#include <drivers/device/ringbuffer.h>
+#include <drivers/device/sampler.h>
 
 #include <board_config.h>
 #include <mathlib/math/filter/LowPassFilter2p.hpp>
@@ -181,7 +181,7 @@ static const int ERROR = -1;
 
 extern "C" { __EXPORT int l3gd20_main(int argc, char *argv[]); }
 
-class L3GD20 : public device::SPI
+class L3GD20 : public device::SPI, public device::Sampler
 {
 public:
 	L3GD20(int bus, const char* path, spi_dev_e device);
@@ -200,12 +200,11 @@ public:
 protected:
 	virtual int		probe();
 
-private:
+	virtual int		sample(void *report, hrt_abstime timestamp);
+	virtual void		sample_ready(const void *report);
+	virtual void		sample_rate_changed(unsigned rate);
 
-	struct hrt_call		_call;
-	unsigned		_call_interval;
-	
-	RingBuffer		*_reports;
+private:
 
 	struct gyro_scale	_gyro_scale;
 	float			_gyro_range_scale;
@@ -218,10 +217,6 @@ private:
 
 	unsigned		_read;
 
-	perf_counter_t		_sample_perf;
-	perf_counter_t		_reschedules;
-	perf_counter_t		_errors;
-
 	math::LowPassFilter2p	_gyro_filter_x;
 	math::LowPassFilter2p	_gyro_filter_y;
 	math::LowPassFilter2p	_gyro_filter_z;
@@ -229,16 +224,6 @@ private:
 	/* true if an L3G4200D is detected */
 	bool	_is_l3g4200d;
 
-	/**
-	 * Start automatic measurement.
-	 */
-	void			start();
-
-	/**
-	 * Stop automatic measurement.
-	 */
-	void			stop();
-
 	/**
 	 * Reset the driver
 	 */
@@ -249,22 +234,6 @@ private:
 	 */
 	void			disable_i2c();
 
-	/**
-	 * Static trampoline from the hrt_call context; because we don't have a
-	 * generic hrt wrapper yet.
-	 *
-	 * Called by the HRT in interrupt context at the specified rate if
-	 * automatic polling is enabled.
-	 *
-	 * @param arg		Instance pointer for the driver that is polling.
-	 */
-	static void		measure_trampoline(void *arg);
-
-	/**
-	 * Fetch measurements from the sensor and update the report ring.
-	 */
-	void			measure();
-
 	/**
 	 * Read a register from the L3GD20
 	 *
@@ -330,8 +299,7 @@ private:
 
 L3GD20::L3GD20(int bus, const char* path, spi_dev_e device) :
 	SPI("L3GD20", path, bus, device, SPIDEV_MODE3, 11*1000*1000 /* will be rounded to 10.4 MHz, within margins for L3GD20 */),
-	_call_interval(0),
-	_reports(nullptr),
+	Sampler("l3gd20", sizeof(gyro_report), L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_RATE),
 	_gyro_range_scale(0.0f),
 	_gyro_range_rad_s(0.0f),
 	_gyro_topic(-1),
@@ -339,9 +307,6 @@ L3GD20::L3GD20(int bus, const char* path, spi_dev_e device) :
 	_current_rate(0),
 	_orientation(SENSOR_BOARD_ROTATION_DEFAULT),
 	_read(0),
-	_sample_perf(perf_alloc(PC_ELAPSED, "l3gd20_read")),
-	_reschedules(perf_alloc(PC_COUNT, "l3gd20_reschedules")),
-	_errors(perf_alloc(PC_COUNT, "l3gd20_errors")),
 	_gyro_filter_x(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
 	_gyro_filter_y(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
 	_gyro_filter_z(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
@@ -362,19 +327,10 @@ L3GD20::L3GD20(int bus, const char* path, spi_dev_e device) :
 L3GD20::~L3GD20()
 {
 	/* make sure we are truly inactive */
-	stop();
-
-	/* free any existing reports */
-	if (_reports != nullptr)
-		delete _reports;
+	sampler_stop();
 
 	if (_class_instance != -1)
 		unregister_class_devname(GYRO_DEVICE_PATH, _class_instance);
-
-	/* delete the perf counter */
-	perf_free(_sample_perf);
-	perf_free(_reschedules);
-	perf_free(_errors);
 }
 
 int
@@ -387,22 +343,24 @@ L3GD20::init()
 		goto out;
 
 	/* allocate basic report buffers */
-	_reports = new RingBuffer(2, sizeof(gyro_report));
-
-	if (_reports == nullptr)
+	if (sampler_init() != OK)
 		goto out;
 
+	/* polling faster than the sensor output rate only yields duplicates */
+	if (_is_l3g4200d)
+		sampler_set_rates(L3G4200D_DEFAULT_RATE, L3G4200D_DEFAULT_RATE);
+
 	_class_instance = register_class_devname(GYRO_DEVICE_PATH);
 
 	reset();
 
-	measure();
+	sampler_measure();
 
 	if (_class_instance == CLASS_DEVICE_PRIMARY) {
 
 		/* advertise sensor topic, measure manually to initialize valid report */
 		struct gyro_report grp;
-		_reports->get(&grp);
+		sampler_get(&grp);
 
 		_gyro_topic = orb_advertise(ORB_ID(sensor_gyro), &grp);
 
@@ -453,127 +411,18 @@ L3GD20::probe()
 ssize_t
 L3GD20::read(struct file *filp, char *buffer, size_t buflen)
 {
-	unsigned count = buflen / sizeof(struct gyro_report);
-	struct gyro_report *gbuf = reinterpret_cast<struct gyro_report *>(buffer);
-	int ret = 0;
-
-	/* buffer must be large enough */
-	if (count < 1)
-		return -ENOSPC;
-
-	/* if automatic measurement is enabled */
-	if (_call_interval > 0) {
-
-		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
-		 * Note that we may be pre-empted by the measurement code while we are doing this;
-		 * we are careful to avoid racing with it.
-		 */
-		while (count--) {
-			if (_reports->get(gbuf)) {
-				ret += sizeof(*gbuf);
-				gbuf++;
-			}
-		}
-
-		/* if there was no data, warn the caller */
-		return ret ? ret : -EAGAIN;
-	}
-
-	/* manual measurement */
-	_reports->flush();
-	measure();
-
-	/* measurement will have generated a report, copy it out */
-	if (_reports->get(gbuf)) {
-		ret = sizeof(*gbuf);
-	}
-
-	return ret;
+	return sampler_read(buffer, buflen);
 }
 
 int
 L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
 {
-	switch (cmd) {
+	int ret = sampler_ioctl(cmd, arg);
 
-	case SENSORIOCSPOLLRATE: {
-			switch (arg) {
-
-				/* switching to manual polling */
-			case SENSOR_POLLRATE_MANUAL:
-				stop();
-				_call_interval = 0;
-				return OK;
-
-				/* external signalling not supported */
-			case SENSOR_POLLRATE_EXTERNAL:
-
-				/* zero would be bad */
-			case 0:
-				return -EINVAL;
-
-				/* set default/max polling rate */
-			case SENSOR_POLLRATE_MAX:
-			case SENSOR_POLLRATE_DEFAULT:
-				if (_is_l3g4200d) {
-					return ioctl(filp, SENSORIOCSPOLLRATE, L3G4200D_DEFAULT_RATE);
-				}
-				return ioctl(filp, SENSORIOCSPOLLRATE, L3GD20_DEFAULT_RATE);
-
-				/* adjust to a legal polling interval in Hz */
-			default: {
-					/* do we need to start internal polling? */
-					bool want_start = (_call_interval == 0);
-
-					/* convert hz to hrt interval via microseconds */
-					unsigned ticks = 1000000 / arg;
-
-					/* check against maximum sane rate */
-					if (ticks < 1000)
-						return -EINVAL;
-
-					/* update interval for next measurement */
-					/* XXX this is a bit shady, but no other way to adjust... */
-					_call.period = _call_interval = ticks;
-
-					/* adjust filters */
-					float cutoff_freq_hz = _gyro_filter_x.get_cutoff_freq();
-					float sample_rate = 1.0e6f/ticks;
-					set_driver_lowpass_filter(sample_rate, cutoff_freq_hz);
-
-					/* if we need to start the poll state machine, do it */
-					if (want_start)
-						start();
-
-					return OK;
-				}
-			}
-		}
+	if (ret != -ENOTTY)
+		return ret;
 
-	case SENSORIOCGPOLLRATE:
-		if (_call_interval == 0)
-			return SENSOR_POLLRATE_MANUAL;
-
-		return 1000000 / _call_interval;
-
-	case SENSORIOCSQUEUEDEPTH: {
-		/* lower bound is mandatory, upper bound is a sanity check */
-		if ((arg < 1) || (arg > 100))
-			return -EINVAL;
-
-		irqstate_t flags = irqsave();
-		if (!_reports->resize(arg)) {
-			irqrestore(flags);
-			return -ENOMEM;
-		}
-		irqrestore(flags);
-		
-		return OK;
-	}
-
-	case SENSORIOCGQUEUEDEPTH:
-		return _reports->size();
+	switch (cmd) {
 
 	case SENSORIOCRESET:
 		reset();
@@ -587,7 +436,7 @@ L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
 
 	case GYROIOCSLOWPASS: {
 		float cutoff_freq_hz = arg;
-		float sample_rate = 1.0e6f / _call_interval;
+		float sample_rate = (sampler_interval() > 0) ? 1.0e6f / sampler_interval() : L3GD20_DEFAULT_RATE;
 		set_driver_lowpass_filter(sample_rate, cutoff_freq_hz);
 
 		return OK;
@@ -739,22 +588,10 @@ L3GD20::set_driver_lowpass_filter(float samplerate, float bandwidth)
 }
 
 void
-L3GD20::start()
+L3GD20::sample_rate_changed(unsigned rate)
 {
-	/* make sure we are stopped first */
-	stop();
-
-	/* reset the report ring */
-	_reports->flush();
-
-	/* start polling at the specified rate */
-	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&L3GD20::measure_trampoline, this);
-}
-
-void
-L3GD20::stop()
-{
-	hrt_cancel(&_call);
+	/* adjust filters */
+	set_driver_lowpass_filter(rate, _gyro_filter_x.get_cutoff_freq());
 }
 
 void
@@ -799,32 +636,21 @@ L3GD20::reset()
 	_read = 0;
 }
 
-void
-L3GD20::measure_trampoline(void *arg)
-{
-	L3GD20 *dev = (L3GD20 *)arg;
-
-	/* make another measurement */
-	dev->measure();
-}
-
 #ifdef GPIO_EXTI_GYRO_DRDY
 # define L3GD20_USE_DRDY 1
 #else
 # define L3GD20_USE_DRDY 0
 #endif
 
-void
-L3GD20::measure()
+int
+L3GD20::sample(void *report_buf, hrt_abstime timestamp)
 {
 #if L3GD20_USE_DRDY
 	// if the gyro doesn't have any data ready then re-schedule
 	// for 100 microseconds later. This ensures we don't double
 	// read a value and then miss the next value
-	if (stm32_gpioread(GPIO_EXTI_GYRO_DRDY) == 0) {
-		perf_count(_reschedules);
-		hrt_call_delay(&_call, 100);
-		return;
+	if (sampler_interval() > 0 && stm32_gpioread(GPIO_EXTI_GYRO_DRDY) == 0) {
+		return -EAGAIN;
 	}
 #endif
 
@@ -840,10 +666,7 @@ L3GD20::measure()
 	} raw_report;
 #pragma pack(pop)
 
-	gyro_report report;
-
-	/* start the performance counter */
-	perf_begin(_sample_perf);
+	gyro_report &report = *reinterpret_cast<gyro_report *>(report_buf);
 
 	/* fetch data from the sensor */
 	memset(&raw_report, 0, sizeof(raw_report));
@@ -856,8 +679,7 @@ L3GD20::measure()
               we waited for DRDY, but did not see DRDY on all axes
               when we captured. That means a transfer error of some sort
              */
-            perf_count(_errors);            
-            return;
+            return -EIO;
         }
 #endif
 	/*
@@ -874,8 +696,8 @@ L3GD20::measure()
 	 *	 	  the offset is 74 from the origin and subtracting
 	 *		  74 from all measurements centers them around zero.
 	 */
-	report.timestamp = hrt_absolute_time();
-        report.error_count = 0; // not recorded
+	report.timestamp = timestamp;
+	report.error_count = sampler_errors();
 	
 	switch (_orientation) {
 
@@ -917,31 +739,29 @@ L3GD20::measure()
 	report.scaling = _gyro_range_scale;
 	report.range_rad_s = _gyro_range_rad_s;
 
-	_reports->force(&report);
+	_read++;
 
+	return OK;
+}
+
+void
+L3GD20::sample_ready(const void *report)
+{
 	/* notify anyone waiting for data */
 	poll_notify(POLLIN);
 
 	/* publish for subscribers */
 	if (_gyro_topic > 0 && !(_pub_blocked)) {
 		/* publish it */
-		orb_publish(ORB_ID(sensor_gyro), _gyro_topic, &report);
+		orb_publish(ORB_ID(sensor_gyro), _gyro_topic, report);
 	}
-
-	_read++;
-
-	/* stop the perf counter */
-	perf_end(_sample_perf);
 }
 
 void
 L3GD20::print_info()
 {
 	printf("gyro reads:          %u\n", _read);
-	perf_print_counter(_sample_perf);
-	perf_print_counter(_reschedules);
-	perf_print_counter(_errors);
-	_reports->print_info("report queue");
+	sampler_print_info();
 }
 
 int
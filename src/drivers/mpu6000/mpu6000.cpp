@@ -70,7 +70,9 @@
 #include <drivers/device/ringbuffer.h>
 #include <drivers/drv_accel.h>
 #include <drivers/drv_gyro.h>
-#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <mathlib/math/filter/LowPassFilter2pVector.hpp>
+
+#include "mpu6000_fifo.h"
 
 #define DIR_READ			0x80
 #define DIR_WRITE			0x00
@@ -84,7 +86,6 @@
 #define MPUREG_CONFIG			0x1A
 #define MPUREG_GYRO_CONFIG		0x1B
 #define MPUREG_ACCEL_CONFIG		0x1C
-#define MPUREG_FIFO_EN			0x23
 #define MPUREG_INT_PIN_CFG		0x37
 #define MPUREG_INT_ENABLE		0x38
 #define MPUREG_INT_STATUS		0x3A
@@ -105,9 +106,6 @@
 #define MPUREG_USER_CTRL		0x6A
 #define MPUREG_PWR_MGMT_1		0x6B
 #define MPUREG_PWR_MGMT_2		0x6C
-#define MPUREG_FIFO_COUNTH		0x72
-#define MPUREG_FIFO_COUNTL		0x73
-#define MPUREG_FIFO_R_W			0x74
 #define MPUREG_PRODUCT_ID		0x0C
 
 // Configuration bits MPU 3000 and MPU 6000 (not revised)?
@@ -164,6 +162,9 @@
 
 #define MPU6000_ONE_G					9.80665f
 
+/* report queue depth in FIFO mode, enough for a full FIFO burst */
+#define MPU6000_FIFO_QUEUE_DEPTH			MPU6000_FIFO_MAX_SAMPLES
+
 /*
   the MPU6000 can only handle high SPI bus speeds on the sensor and
   interrupt status registers. All other registers have a maximum 1MHz
@@ -177,7 +178,12 @@ class MPU6000_gyro;
 class MPU6000 : public device::SPI
 {
 public:
-	MPU6000(int bus, spi_dev_e device);
+	/**
+	 * @param fifo		read samples through the on-chip FIFO
+	 * @param publish_all	in FIFO mode, publish every sample instead of
+	 *			only the newest one of each burst
+	 */
+	MPU6000(int bus, spi_dev_e device, bool fifo = false, bool publish_all = false);
 	virtual ~MPU6000();
 
 	virtual int		init();
@@ -224,13 +230,19 @@ private:
 	perf_counter_t		_gyro_reads;
 	perf_counter_t		_sample_perf;
 	perf_counter_t		_bad_transfers;
+	perf_counter_t		_fifo_overruns;
+	perf_counter_t		_queue_overruns;
 
-	math::LowPassFilter2p	_accel_filter_x;
-	math::LowPassFilter2p	_accel_filter_y;
-	math::LowPassFilter2p	_accel_filter_z;
-	math::LowPassFilter2p	_gyro_filter_x;
-	math::LowPassFilter2p	_gyro_filter_y;
-	math::LowPassFilter2p	_gyro_filter_z;
+	math::LowPassFilter2pVector<3>	_accel_filter;
+	math::LowPassFilter2pVector<3>	_gyro_filter;
+
+	bool			_fifo_enabled;
+	bool			_publish_all;
+	MPU6000_FIFO		_fifo;
+	mpu6000_fifo_sample	_samples[MPU6000_FIFO_MAX_SAMPLES];
+	hrt_abstime		_timestamps[MPU6000_FIFO_MAX_SAMPLES];
+	float			_accel_block[MPU6000_FIFO_MAX_SAMPLES * 3];
+	float			_gyro_block[MPU6000_FIFO_MAX_SAMPLES * 3];
 
 	/**
 	 * Start automatic measurement.
@@ -265,6 +277,37 @@ private:
 	 */
 	void			measure();
 
+	/**
+	 * Fetch all samples queued in the on-chip FIFO.
+	 *
+	 * @return		number of samples fetched into _samples
+	 */
+	int			measure_fifo();
+
+	/**
+	 * Scale, filter and queue a number of raw samples in _samples and
+	 * publish them.
+	 */
+	void			process_samples(unsigned count);
+
+	/**
+	 * Discard the contents of the on-chip FIFO and restart it.
+	 */
+	void			fifo_reset();
+
+	/**
+	 * SPI transfer for the FIFO reader.
+	 */
+	static int		fifo_transfer(void *arg, uint8_t *send, uint8_t *recv, unsigned len);
+
+	/**
+	 * Rate in Hz at which samples reach the driver filters.
+	 *
+	 * In FIFO mode this is the sensor sample rate, otherwise the
+	 * rate the sensor is polled at.
+	 */
+	float			filter_sample_rate();
+
 	/**
 	 * Read a register from the MPU6000
 	 *
@@ -368,7 +411,7 @@ private:
 /** driver 'main' command */
 extern "C" { __EXPORT int mpu6000_main(int argc, char *argv[]); }
 
-MPU6000::MPU6000(int bus, spi_dev_e device) :
+MPU6000::MPU6000(int bus, spi_dev_e device, bool fifo, bool publish_all) :
 	SPI("MPU6000", MPU_DEVICE_PATH_ACCEL, bus, device, SPIDEV_MODE3, MPU6000_LOW_BUS_SPEED),
 	_gyro(new MPU6000_gyro(this)),
 	_product(0),
@@ -386,12 +429,13 @@ MPU6000::MPU6000(int bus, spi_dev_e device) :
 	_gyro_reads(perf_alloc(PC_COUNT, "mpu6000_gyro_read")),
 	_sample_perf(perf_alloc(PC_ELAPSED, "mpu6000_read")),
 	_bad_transfers(perf_alloc(PC_COUNT, "mpu6000_bad_transfers")),
-	_accel_filter_x(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_y(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_z(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_x(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_y(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_z(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ)
+	_fifo_overruns(perf_alloc(PC_COUNT, "mpu6000_fifo_overruns")),
+	_queue_overruns(perf_alloc(PC_COUNT, "mpu6000_queue_overruns")),
+	_accel_filter(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
+	_gyro_filter(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
+	_fifo_enabled(fifo),
+	_publish_all(publish_all),
+	_fifo(&MPU6000::fifo_transfer, this)
 {
 	// disable debug() calls
 	_debug_enabled = false;
@@ -437,6 +481,8 @@ MPU6000::~MPU6000()
 	perf_free(_accel_reads);
 	perf_free(_gyro_reads);
 	perf_free(_bad_transfers);
+	perf_free(_fifo_overruns);
+	perf_free(_queue_overruns);
 }
 
 int
@@ -453,12 +499,12 @@ MPU6000::init()
 		return ret;
 	}
 
-	/* allocate basic report buffers */
-	_accel_reports = new RingBuffer(2, sizeof(accel_report));
+	/* allocate basic report buffers, deep enough for a FIFO burst in FIFO mode */
+	_accel_reports = new RingBuffer(_fifo_enabled ? MPU6000_FIFO_QUEUE_DEPTH : 2, sizeof(accel_report));
 	if (_accel_reports == nullptr)
 		goto out;
 
-	_gyro_reports = new RingBuffer(2, sizeof(gyro_report));
+	_gyro_reports = new RingBuffer(_fifo_enabled ? MPU6000_FIFO_QUEUE_DEPTH : 2, sizeof(gyro_report));
 	if (_gyro_reports == nullptr)
 		goto out;
 
@@ -550,6 +596,13 @@ void MPU6000::reset()
 	_set_sample_rate(_sample_rate);
 	usleep(1000);
 
+	// FIFO: queue accel, temperature and gyro samples
+	if (_fifo_enabled) {
+		write_reg(MPUREG_FIFO_EN, BITS_FIFO_EN_ALL);
+		fifo_reset();
+		usleep(1000);
+	}
+
 	// FS & DLPF   FS=2000 deg/s, DLPF = 20Hz (low pass filter)
 	// was 90 Hz, but this ruins quality and does not improve the
 	// system response
@@ -653,6 +706,41 @@ MPU6000::_set_sample_rate(uint16_t desired_sample_rate_hz)
   if(div<1) div=1;
   write_reg(MPUREG_SMPLRT_DIV, div-1);
   _sample_rate = 1000 / div;
+  _fifo.set_sample_interval(1000000 / _sample_rate);
+
+  // in FIFO mode the driver filters run at the sensor rate
+  if (_fifo_enabled) {
+    _accel_filter.set_cutoff_frequency(_sample_rate, _accel_filter.get_cutoff_freq());
+    _gyro_filter.set_cutoff_frequency(_sample_rate, _gyro_filter.get_cutoff_freq());
+  }
+}
+
+/*
+  restart the FIFO, discarding its contents
+*/
+void
+MPU6000::fifo_reset()
+{
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS);
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_RESET);
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_EN);
+}
+
+int
+MPU6000::fifo_transfer(void *arg, uint8_t *send, uint8_t *recv, unsigned len)
+{
+	MPU6000 *dev = reinterpret_cast<MPU6000 *>(arg);
+
+	return dev->transfer(send, recv, len);
+}
+
+float
+MPU6000::filter_sample_rate()
+{
+	if (_fifo_enabled || _call_interval == 0)
+		return _sample_rate;
+
+	return 1.0e6f / _call_interval;
 }
 
 /*
@@ -861,23 +949,18 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 					if (ticks < 1000)
 						return -EINVAL;
 
-					// adjust filters
-					float cutoff_freq_hz = _accel_filter_x.get_cutoff_freq();
-					float sample_rate = 1.0e6f/ticks;
-					_accel_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-
-
-					float cutoff_freq_hz_gyro = _gyro_filter_x.get_cutoff_freq();
-					_gyro_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-
 					/* update interval for next measurement */
 					/* XXX this is a bit shady, but no other way to adjust... */
 					_call.period = _call_interval = ticks;
 
+					// adjust filters
+					float cutoff_freq_hz = _accel_filter.get_cutoff_freq();
+					float sample_rate = filter_sample_rate();
+					_accel_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
+
+					float cutoff_freq_hz_gyro = _gyro_filter.get_cutoff_freq();
+					_gyro_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
+
 					/* if we need to start the poll state machine, do it */
 					if (want_start)
 						start();
@@ -919,16 +1002,14 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case ACCELIOCGLOWPASS:
-		return _accel_filter_x.get_cutoff_freq();
+		return _accel_filter.get_cutoff_freq();
 
 	case ACCELIOCSLOWPASS:
 		
 		// XXX decide on relationship of both filters
 		// i.e. disable the on-chip filter
 		//_set_dlpf_filter((uint16_t)arg);
-		_accel_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_accel_filter.set_cutoff_frequency(filter_sample_rate(), arg);
 		return OK;
 
 	case ACCELIOCSSCALE:
@@ -1004,11 +1085,9 @@ MPU6000::gyro_ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case GYROIOCGLOWPASS:
-		return _gyro_filter_x.get_cutoff_freq();
+		return _gyro_filter.get_cutoff_freq();
 	case GYROIOCSLOWPASS:
-		_gyro_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_gyro_filter.set_cutoff_frequency(filter_sample_rate(), arg);
 		// XXX check relation to the internal lowpass
 		//_set_dlpf_filter((uint16_t)arg);
 		return OK;
@@ -1144,6 +1223,9 @@ MPU6000::start()
 	_accel_reports->flush();
 	_gyro_reports->flush();
 
+	if (_fifo_enabled)
+		fifo_reset();
+
 	/* start polling at the specified rate */
 	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&MPU6000::measure_trampoline, this);
 }
@@ -1184,33 +1266,34 @@ MPU6000::measure()
 	} mpu_report;
 #pragma pack(pop)
 
-	struct Report {
-		int16_t		accel_x;
-		int16_t		accel_y;
-		int16_t		accel_z;
-		int16_t		temp;
-		int16_t		gyro_x;
-		int16_t		gyro_y;
-		int16_t		gyro_z;
-	} report;
-
 	/* start measuring */
 	perf_begin(_sample_perf);
 
+        // sensor transfer at high clock speed
+        set_frequency(MPU6000_HIGH_BUS_SPEED);
+
+	if (_fifo_enabled) {
+		int count = measure_fifo();
+
+		if (count > 0)
+			process_samples(count);
+
+		perf_end(_sample_perf);
+		return;
+	}
+
 	/*
 	 * Fetch the full set of measurements from the MPU6000 in one pass.
 	 */
 	mpu_report.cmd = DIR_READ | MPUREG_INT_STATUS;
 
-        // sensor transfer at high clock speed
-        set_frequency(MPU6000_HIGH_BUS_SPEED);
-
 	if (OK != transfer((uint8_t *)&mpu_report, ((uint8_t *)&mpu_report), sizeof(mpu_report)))
 		return;
 
 	/*
 	 * Convert from big to little endian
 	 */
+	mpu6000_fifo_sample &report = _samples[0];
 
 	report.accel_x = int16_t_from_bytes(mpu_report.accel_x);
 	report.accel_y = int16_t_from_bytes(mpu_report.accel_y);
@@ -1234,36 +1317,50 @@ MPU6000::measure()
 		perf_end(_sample_perf);
 		return;
 	}
-	    
 
-	/*
-	 * Swap axes and negate y
-	 */
-	int16_t accel_xt = report.accel_y;
-	int16_t accel_yt = ((report.accel_x == -32768) ? 32767 : -report.accel_x);
+	_timestamps[0] = hrt_absolute_time();
 
-	int16_t gyro_xt = report.gyro_y;
-	int16_t gyro_yt = ((report.gyro_x == -32768) ? 32767 : -report.gyro_x);
+	process_samples(1);
 
-	/*
-	 * Apply the swap
-	 */
-	report.accel_x = accel_xt;
-	report.accel_y = accel_yt;
-	report.gyro_x = gyro_xt;
-	report.gyro_y = gyro_yt;
+	/* stop measuring */
+	perf_end(_sample_perf);
+}
 
+int
+MPU6000::measure_fifo()
+{
+	int ret = _fifo.read(hrt_absolute_time(), _samples, _timestamps);
+
+	if (ret == -EOVERFLOW) {
+		/*
+		 * Samples were lost or the stream is misaligned, restart the
+		 * FIFO. The samples queued since are picked up next time.
+		 */
+		perf_count(_fifo_overruns);
+		fifo_reset();
+		return 0;
+	}
+
+	if (ret < 0) {
+		perf_count(_bad_transfers);
+		return 0;
+	}
+
+	return ret;
+}
+
+void
+MPU6000::process_samples(unsigned count)
+{
 	/*
 	 * Report buffers.
 	 */
 	accel_report		arb;
 	gyro_report		grb;
 
-	/*
-	 * Adjust and scale results to m/s^2.
-	 */
-	grb.timestamp = arb.timestamp = hrt_absolute_time();
-        grb.error_count = arb.error_count = 0; // not reported
+	/* kept off the stack, this runs in interrupt context */
+	float			*accel = _accel_block;
+	float			*gyro = _gyro_block;
 
 	/*
 	 * 1) Scale raw value to SI units using scaling from datasheet.
@@ -1279,65 +1376,99 @@ MPU6000::measure()
 	 *	 	  the offset is 74 from the origin and subtracting
 	 *		  74 from all measurements centers them around zero.
 	 */
+	for (unsigned i = 0; i < count; i++) {
+		mpu6000_fifo_sample &report = _samples[i];
+
+		/*
+		 * Swap axes and negate y
+		 */
+		int16_t accel_xt = report.accel_y;
+		int16_t accel_yt = ((report.accel_x == -32768) ? 32767 : -report.accel_x);
+
+		int16_t gyro_xt = report.gyro_y;
+		int16_t gyro_yt = ((report.gyro_x == -32768) ? 32767 : -report.gyro_x);
+
+		/*
+		 * Apply the swap
+		 */
+		report.accel_x = accel_xt;
+		report.accel_y = accel_yt;
+		report.gyro_x = gyro_xt;
+		report.gyro_y = gyro_yt;
+
+		accel[i * 3 + 0] = ((report.accel_x * _accel_range_scale) - _accel_scale.x_offset) * _accel_scale.x_scale;
+		accel[i * 3 + 1] = ((report.accel_y * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
+		accel[i * 3 + 2] = ((report.accel_z * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
+
+		gyro[i * 3 + 0] = ((report.gyro_x * _gyro_range_scale) - _gyro_scale.x_offset) * _gyro_scale.x_scale;
+		gyro[i * 3 + 1] = ((report.gyro_y * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
+		gyro[i * 3 + 2] = ((report.gyro_z * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
+	}
 
+	/* filter the whole burst in one pass */
+	_accel_filter.apply_block(accel, accel, count);
+	_gyro_filter.apply_block(gyro, gyro, count);
 
-	/* NOTE: Axes have been swapped to match the board a few lines above. */
+	for (unsigned i = 0; i < count; i++) {
+		const mpu6000_fifo_sample &report = _samples[i];
 
-	arb.x_raw = report.accel_x;
-	arb.y_raw = report.accel_y;
-	arb.z_raw = report.accel_z;
+		grb.timestamp = arb.timestamp = _timestamps[i];
+		grb.error_count = arb.error_count = 0; // not reported
 
-	float x_in_new = ((report.accel_x * _accel_range_scale) - _accel_scale.x_offset) * _accel_scale.x_scale;
-	float y_in_new = ((report.accel_y * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
-	float z_in_new = ((report.accel_z * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
-	
-	arb.x = _accel_filter_x.apply(x_in_new);
-	arb.y = _accel_filter_y.apply(y_in_new);
-	arb.z = _accel_filter_z.apply(z_in_new);
+		/* NOTE: Axes have been swapped to match the board above. */
 
-	arb.scaling = _accel_range_scale;
-	arb.range_m_s2 = _accel_range_m_s2;
+		arb.x_raw = report.accel_x;
+		arb.y_raw = report.accel_y;
+		arb.z_raw = report.accel_z;
 
-	arb.temperature_raw = report.temp;
-	arb.temperature = (report.temp) / 361.0f + 35.0f;
+		arb.x = accel[i * 3 + 0];
+		arb.y = accel[i * 3 + 1];
+		arb.z = accel[i * 3 + 2];
 
-	grb.x_raw = report.gyro_x;
-	grb.y_raw = report.gyro_y;
-	grb.z_raw = report.gyro_z;
+		arb.scaling = _accel_range_scale;
+		arb.range_m_s2 = _accel_range_m_s2;
 
-	float x_gyro_in_new = ((report.gyro_x * _gyro_range_scale) - _gyro_scale.x_offset) * _gyro_scale.x_scale;
-	float y_gyro_in_new = ((report.gyro_y * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
-	float z_gyro_in_new = ((report.gyro_z * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
-	
-	grb.x = _gyro_filter_x.apply(x_gyro_in_new);
-	grb.y = _gyro_filter_y.apply(y_gyro_in_new);
-	grb.z = _gyro_filter_z.apply(z_gyro_in_new);
+		arb.temperature_raw = report.temp;
+		arb.temperature = (report.temp) / 361.0f + 35.0f;
 
-	grb.scaling = _gyro_range_scale;
-	grb.range_rad_s = _gyro_range_rad_s;
+		grb.x_raw = report.gyro_x;
+		grb.y_raw = report.gyro_y;
+		grb.z_raw = report.gyro_z;
 
-	grb.temperature_raw = report.temp;
-	grb.temperature = (report.temp) / 361.0f + 35.0f;
+		grb.x = gyro[i * 3 + 0];
+		grb.y = gyro[i * 3 + 1];
+		grb.z = gyro[i * 3 + 2];
 
-	_accel_reports->force(&arb);
-	_gyro_reports->force(&grb);
+		grb.scaling = _gyro_range_scale;
+		grb.range_rad_s = _gyro_range_rad_s;
 
-	/* notify anyone waiting for data */
-	poll_notify(POLLIN);
-	_gyro->parent_poll_notify();
+		grb.temperature_raw = report.temp;
+		grb.temperature = (report.temp) / 361.0f + 35.0f;
 
-	if (_accel_topic > 0 && !(_pub_blocked)) {
-		/* publish it */
-		orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
-	}
+		if (_accel_reports->force(&arb))
+			perf_count(_queue_overruns);
+
+		if (_gyro_reports->force(&grb))
+			perf_count(_queue_overruns);
 
-	if (_gyro->_gyro_topic > 0 && !(_pub_blocked)) {
-		/* publish it */
-		orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+		/* publish every sample on request, otherwise only the newest */
+		if (!_publish_all && i + 1 < count)
+			continue;
+
+		if (_accel_topic > 0 && !(_pub_blocked)) {
+			/* publish it */
+			orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
+		}
+
+		if (_gyro->_gyro_topic > 0 && !(_pub_blocked)) {
+			/* publish it */
+			orb_publish(ORB_ID(sensor_gyro), _gyro->_gyro_topic, &grb);
+		}
 	}
 
-	/* stop measuring */
-	perf_end(_sample_perf);
+	/* notify anyone waiting for data */
+	poll_notify(POLLIN);
+	_gyro->parent_poll_notify();
 }
 
 void
@@ -1346,6 +1477,15 @@ MPU6000::print_info()
 	perf_print_counter(_sample_perf);
 	perf_print_counter(_accel_reads);
 	perf_print_counter(_gyro_reads);
+	perf_print_counter(_bad_transfers);
+	perf_print_counter(_queue_overruns);
+
+	if (_fifo_enabled) {
+		printf("fifo: %u Hz, %llu samples, %s\n", _sample_rate, (unsigned long long)_fifo.samples(),
+		       _publish_all ? "publishing all" : "publishing newest");
+		perf_print_counter(_fifo_overruns);
+	}
+
 	_accel_reports->print_info("accel queue");
 	_gyro_reports->print_info("gyro queue");
 }
@@ -1410,7 +1550,7 @@ namespace mpu6000
 
 MPU6000	*g_dev;
 
-void	start();
+void	start(bool fifo, bool publish_all);
 void	test();
 void	reset();
 void	info();
@@ -1419,7 +1559,7 @@ void	info();
  * Start the driver.
  */
 void
-start()
+start(bool fifo, bool publish_all)
 {
 	int fd;
 
@@ -1428,7 +1568,7 @@ start()
 		errx(0, "already started");
 
 	/* create the driver */
-	g_dev = new MPU6000(1 /* XXX magic number */, (spi_dev_e)PX4_SPIDEV_MPU);
+	g_dev = new MPU6000(1 /* XXX magic number */, (spi_dev_e)PX4_SPIDEV_MPU, fifo, publish_all);
 
 	if (g_dev == nullptr)
 		goto fail;
@@ -1576,29 +1716,61 @@ info()
 int
 mpu6000_main(int argc, char *argv[])
 {
+	bool fifo = false;
+	bool publish_all = false;
+	int ch;
+
+	if (argc < 2)
+		errx(1, "unrecognized command, try 'start', 'test', 'reset' or 'info'");
+
+	const char *verb = argv[1];
+
+	/*
+	 * Options follow the verb. NuttX getopt does not permute argv and
+	 * would stop at the verb, so parse the arguments after it, with the
+	 * verb in the place of the program name.
+	 */
+	optind = 1;
+
+	while ((ch = getopt(argc - 1, argv + 1, "fF")) != EOF) {
+		switch (ch) {
+		case 'f':
+			fifo = true;
+			break;
+
+		case 'F':
+			fifo = true;
+			publish_all = true;
+			break;
+
+		default:
+			errx(1, "usage: mpu6000 {start|test|reset|info} [-f (FIFO)] [-F (FIFO, publish all samples)]");
+		}
+	}
+
 	/*
 	 * Start/load the driver.
 
 	 */
-	if (!strcmp(argv[1], "start"))
-		mpu6000::start();
+	if (!strcmp(verb, "start"))
+		mpu6000::start(fifo, publish_all);
 
 	/*
 	 * Test the driver/device.
 	 */
-	if (!strcmp(argv[1], "test"))
+	if (!strcmp(verb, "test"))
 		mpu6000::test();
 
 	/*
 	 * Reset the driver.
 	 */
-	if (!strcmp(argv[1], "reset"))
+	if (!strcmp(verb, "reset"))
 		mpu6000::reset();
 
 	/*
 	 * Print driver information.
 	 */
-	if (!strcmp(argv[1], "info"))
+	if (!strcmp(verb, "info"))
 		mpu6000::info();
 
 	errx(1, "unrecognized command, try 'start', 'test', 'reset' or 'info'");
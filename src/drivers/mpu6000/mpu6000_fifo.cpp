@@ -0,0 +1,116 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mpu6000_fifo.cpp
+ *
+ * Burst reader for the MPU6000 on-chip FIFO.
+ */
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include <systemlib/conversions.h>
+
+#include "mpu6000_fifo.h"
+
+#define DIR_READ			0x80
+
+MPU6000_FIFO::MPU6000_FIFO(transfer_t transfer, void *arg) :
+	_transfer(transfer),
+	_arg(arg),
+	_sample_interval(1000),
+	_overruns(0),
+	_samples(0)
+{
+	memset(_buffer, 0, sizeof(_buffer));
+}
+
+int
+MPU6000_FIFO::read(hrt_abstime now, mpu6000_fifo_sample *samples, hrt_abstime *timestamps)
+{
+	uint8_t cmd[3] = { (uint8_t)(MPUREG_FIFO_COUNTH | DIR_READ), 0, 0 };
+
+	if (_transfer(_arg, cmd, cmd, sizeof(cmd)) != OK) {
+		return -EIO;
+	}
+
+	unsigned count = (cmd[1] << 8) | cmd[2];
+
+	/*
+	 * A full FIFO has dropped samples, and a count that is not a
+	 * multiple of the sample size means we lost alignment. Either
+	 * way the FIFO contents cannot be trusted any more.
+	 */
+	if (count >= MPU6000_FIFO_SIZE || (count % MPU6000_FIFO_SAMPLE_SIZE) != 0) {
+		_overruns++;
+		return -EOVERFLOW;
+	}
+
+	unsigned available = count / MPU6000_FIFO_SAMPLE_SIZE;
+	unsigned n = (available > MPU6000_FIFO_MAX_SAMPLES) ? MPU6000_FIFO_MAX_SAMPLES : available;
+
+	if (n == 0) {
+		return 0;
+	}
+
+	/* read all samples in one burst */
+	memset(_buffer, 0, 1 + n * MPU6000_FIFO_SAMPLE_SIZE);
+	_buffer[0] = MPUREG_FIFO_R_W | DIR_READ;
+
+	if (_transfer(_arg, _buffer, _buffer, 1 + n * MPU6000_FIFO_SAMPLE_SIZE) != OK) {
+		return -EIO;
+	}
+
+	for (unsigned i = 0; i < n; i++) {
+		uint8_t *p = &_buffer[1 + i * MPU6000_FIFO_SAMPLE_SIZE];
+
+		samples[i].accel_x = int16_t_from_bytes(&p[0]);
+		samples[i].accel_y = int16_t_from_bytes(&p[2]);
+		samples[i].accel_z = int16_t_from_bytes(&p[4]);
+		samples[i].temp    = int16_t_from_bytes(&p[6]);
+		samples[i].gyro_x  = int16_t_from_bytes(&p[8]);
+		samples[i].gyro_y  = int16_t_from_bytes(&p[10]);
+		samples[i].gyro_z  = int16_t_from_bytes(&p[12]);
+
+		/* the newest sample in the FIFO was taken just before now */
+		timestamps[i] = now - (hrt_abstime)(available - 1 - i) * _sample_interval;
+	}
+
+	_samples += n;
+
+	return n;
+}
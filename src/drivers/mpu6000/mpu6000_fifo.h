@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mpu6000_fifo.h
+ *
+ * Burst reader for the MPU6000 on-chip FIFO.
+ *
+ * The FIFO is configured to hold accel, temperature and gyro samples,
+ * 14 bytes per sample in register order. All samples available are read
+ * in one SPI transfer and time stamped by their index in the FIFO, the
+ * newest sample being the one completed just before the read.
+ *
+ * The SPI transfer is passed in as a function, so that the reader can be
+ * exercised against a mocked sensor on the host.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <drivers/drv_hrt.h>
+
+// FIFO registers
+#define MPUREG_FIFO_EN			0x23
+#define MPUREG_FIFO_COUNTH		0x72
+#define MPUREG_FIFO_COUNTL		0x73
+#define MPUREG_FIFO_R_W			0x74
+
+// FIFO_EN bits
+#define BIT_TEMP_FIFO_EN		0x80
+#define BIT_XG_FIFO_EN			0x40
+#define BIT_YG_FIFO_EN			0x20
+#define BIT_ZG_FIFO_EN			0x10
+#define BIT_ACCEL_FIFO_EN		0x08
+#define BITS_FIFO_EN_ALL		(BIT_TEMP_FIFO_EN | BIT_XG_FIFO_EN | BIT_YG_FIFO_EN | BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN)
+
+// USER_CTRL bits
+#define BIT_USER_CTRL_FIFO_EN		0x40
+#define BIT_USER_CTRL_FIFO_RESET	0x04
+
+#define MPU6000_FIFO_SIZE		1024	/**< size of the on-chip FIFO in bytes */
+#define MPU6000_FIFO_SAMPLE_SIZE	14	/**< accel xyz, temp, gyro xyz */
+#define MPU6000_FIFO_MAX_SAMPLES	16	/**< maximum samples read in one burst */
+
+/**
+ * One raw sample as read from the FIFO, converted to native byte order.
+ */
+struct mpu6000_fifo_sample {
+	int16_t		accel_x;
+	int16_t		accel_y;
+	int16_t		accel_z;
+	int16_t		temp;
+	int16_t		gyro_x;
+	int16_t		gyro_y;
+	int16_t		gyro_z;
+};
+
+class MPU6000_FIFO
+{
+public:
+	/**
+	 * Full duplex SPI transfer, as device::SPI::transfer().
+	 *
+	 * @return		OK on success
+	 */
+	typedef int (*transfer_t)(void *arg, uint8_t *send, uint8_t *recv, unsigned len);
+
+	MPU6000_FIFO(transfer_t transfer, void *arg);
+
+	/**
+	 * Set the interval between two samples entering the FIFO, i.e. the
+	 * sensor sample rate.
+	 */
+	void			set_sample_interval(unsigned interval_us) { _sample_interval = interval_us; }
+	unsigned		get_sample_interval() const { return _sample_interval; }
+
+	/**
+	 * Read a burst of samples from the FIFO.
+	 *
+	 * At most MPU6000_FIFO_MAX_SAMPLES samples are read, the oldest
+	 * first. Samples left in the FIFO are collected by the next read.
+	 *
+	 * @param now		time of the read
+	 * @param samples	buffer for MPU6000_FIFO_MAX_SAMPLES samples
+	 * @param timestamps	buffer for MPU6000_FIFO_MAX_SAMPLES timestamps
+	 * @return		number of samples read, -EOVERFLOW if the FIFO
+	 *			overflowed and has to be reset, -EIO on
+	 *			transfer errors
+	 */
+	int			read(hrt_abstime now, mpu6000_fifo_sample *samples, hrt_abstime *timestamps);
+
+	/**
+	 * Number of FIFO overflows seen so far.
+	 */
+	unsigned		overruns() const { return _overruns; }
+
+	/**
+	 * Number of samples read so far.
+	 */
+	uint64_t		samples() const { return _samples; }
+
+private:
+	transfer_t		_transfer;
+	void			*_arg;
+	unsigned		_sample_interval;
+	unsigned		_overruns;
+	uint64_t		_samples;
+
+	/** command byte and sample data of a burst */
+	uint8_t			_buffer[1 + MPU6000_FIFO_MAX_SAMPLES * MPU6000_FIFO_SAMPLE_SIZE];
+
+	/* do not allow copying */
+	MPU6000_FIFO(const MPU6000_FIFO &);
+	MPU6000_FIFO &operator=(const MPU6000_FIFO &);
+};
@@ -645,6 +645,8 @@ PX4FMU::task_main()
 				/* do mixing */
 				outputs.noutputs = _mixers->mix(&outputs.output[0], num_outputs);
 				outputs.timestamp = hrt_absolute_time();
+				/* trace the latency back to the attitude controls' sensor sample */
+				outputs.timestamp_sample = _controls[0].timestamp_sample;
 
 				/* iterate actuators */
 				for (unsigned i = 0; i < num_outputs; i++) {
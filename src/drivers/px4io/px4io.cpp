@@ -90,6 +90,7 @@
 #include <modules/px4iofirmware/protocol.h>
 
 #include "uploader.h"
+#include "px4io_driver.h"
 
 #include "modules/dataman/dataman.h"
 
@@ -237,6 +238,7 @@ private:
 	unsigned		_max_rc_input;		///< Maximum receiver channels supported by PX4IO
 	unsigned		_max_relays;		///< Maximum relays supported by PX4IO
 	unsigned		_max_transfer;		///< Maximum number of I2C transfers supported by PX4IO
+	bool			_exchange_page;		///< IO provides PX4IO_PAGE_EXCHANGE (protocol version 5 and later)
 
 	unsigned 		_update_interval;	///< Subscription interval limiting send rate
 	bool			_rc_handling_disabled;	///< If set, IO does not evaluate, but only forward the RC values
@@ -251,6 +253,9 @@ private:
 	perf_counter_t		_perf_update;		///<local performance counter for status updates
 	perf_counter_t		_perf_write;		///<local performance counter for PWM control writes
 	perf_counter_t		_perf_chan_count;	///<local performance counter for channel number changes
+	perf_counter_t		_perf_exchange;		///<local performance counter for combined control/status transactions
+	perf_counter_t		_perf_controls;		///<local performance counter for control group writes
+	perf_counter_t		_perf_readback;		///<local performance counter for status/RC/servo reads
 
 	/* cached IO state */
 	uint16_t		_status;		///< Various IO status flags
@@ -283,6 +288,7 @@ private:
 	float			_battery_amp_bias;	///< current sensor bias
 	float			_battery_mamphour_total;///< amp hours consumed so far
 	uint64_t		_battery_last_timestamp;///< last amp hour calculation timestamp
+	uint64_t		_controls_timestamp_sample;///< sensor sample of the last group 0 controls sent to IO
 
 #ifdef CONFIG_ARCH_BOARD_PX4FMU_V1
 	bool			_dsm_vcc_ctl;		///< true if relay 1 controls DSM satellite RX power
@@ -300,13 +306,22 @@ private:
 
 	/**
 	 * Send controls for one group to IO
+	 *
+	 * @param group		Control group to send.
+	 * @param exchange	If not nullptr, send the controls in a combined
+	 *			transaction and store PX4IO_PAGE_EXCHANGE here.
+	 * @return		OK if the controls were sent.
 	 */
-	int			io_set_control_state(unsigned group);
+	int			io_set_control_state(unsigned group, uint16_t *exchange = nullptr);
 
 	/**
 	 * Send all controls to IO
+	 *
+	 * @param exchange	If not nullptr, the group 0 controls are sent in a
+	 *			combined transaction that returns PX4IO_PAGE_EXCHANGE.
+	 * @return		OK if the group 0 controls were sent.
 	 */
-	int			io_set_control_groups();
+	int			io_set_control_groups(uint16_t *exchange = nullptr);
 
 	/**
 	 * Update IO's arming-related state
@@ -325,6 +340,19 @@ private:
 	 */
 	int			io_get_status();
 
+	/**
+	 * Handle a block of status registers
+	 *
+	 * @param regs		STATUS_FLAGS, STATUS_ALARMS, STATUS_VBATT, STATUS_IBATT,
+	 *			STATUS_VSERVO, STATUS_VRSSI in that order.
+	 */
+	void			io_handle_status_block(const uint16_t *regs);
+
+	/**
+	 * Handle the status, RC input and servo outputs in a PX4IO_PAGE_EXCHANGE snapshot
+	 */
+	void			io_handle_exchange(const uint16_t *regs);
+
 	/**
 	 * Disable RC input handling
 	 */
@@ -334,19 +362,42 @@ private:
 	 * Fetch RC inputs from IO.
 	 *
 	 * @param input_rc	Input structure to populate.
+	 * @param prefetched	If not nullptr, raw RC registers from PX4IO_P_RAW_RC_COUNT
+	 *			onwards that have already been read from IO.
+	 * @param num_channels	Number of channels present in prefetched.
 	 * @return		OK if data was returned.
 	 */
-	int			io_get_raw_rc_input(rc_input_values &input_rc);
+	int			io_get_raw_rc_input(rc_input_values &input_rc, const uint16_t *prefetched = nullptr, unsigned num_channels = 0);
 
 	/**
 	 * Fetch and publish raw RC input data.
+	 *
+	 * @param regs		Optional raw RC registers already read, see io_get_raw_rc_input.
+	 * @param num_channels	Number of channels present in regs.
 	 */
-	int			io_publish_raw_rc();
+	int			io_publish_raw_rc(const uint16_t *regs = nullptr, unsigned num_channels = 0);
 
 	/**
 	 * Fetch and publish the PWM servo outputs.
+	 *
+	 * @param servos	If not nullptr, servo values already read from IO.
+	 * @param num_servos	Number of values in servos; the remaining outputs are read.
 	 */
-	int			io_publish_pwm_outputs();
+	int			io_publish_pwm_outputs(const uint16_t *servos = nullptr, unsigned num_servos = 0);
+
+	/**
+	 * write register(s) and read back PX4IO_PAGE_EXCHANGE
+	 *
+	 * Uses a single combined transaction if the interface supports it.
+	 *
+	 * @param page		Register page to write to.
+	 * @param offset	Register offset to start writing at.
+	 * @param values	Pointer to array of values to write.
+	 * @param num_values	The number of values to write.
+	 * @param reply		PX4IO_P_EXCHANGE_SIZE registers read back.
+	 * @return		OK if the values were written and the reply read.
+	 */
+	int			io_exchange(uint8_t page, uint8_t offset, const uint16_t *values, unsigned num_values, uint16_t *reply);
 
 	/**
 	 * write register(s)
@@ -468,6 +519,7 @@ PX4IO::PX4IO(device::Device *interface) :
 	_max_rc_input(0),
 	_max_relays(0),
 	_max_transfer(16),	/* sensible default */
+	_exchange_page(false),
 	_update_interval(0),
 	_rc_handling_disabled(false),
 	_rc_chan_count(0),
@@ -478,6 +530,9 @@ PX4IO::PX4IO(device::Device *interface) :
 	_perf_update(perf_alloc(PC_ELAPSED, "io update")),
 	_perf_write(perf_alloc(PC_ELAPSED, "io write")),
 	_perf_chan_count(perf_alloc(PC_COUNT, "io rc #")),
+	_perf_exchange(perf_alloc(PC_ELAPSED, "io exchange")),
+	_perf_controls(perf_alloc(PC_ELAPSED, "io controls")),
+	_perf_readback(perf_alloc(PC_ELAPSED, "io readback")),
 	_status(0),
 	_alarms(0),
 	_t_actuator_controls_0(-1),
@@ -498,7 +553,8 @@ PX4IO::PX4IO(device::Device *interface) :
 	_battery_amp_per_volt(90.0f / 5.0f), // this matches the 3DR current sensor
 	_battery_amp_bias(0),
 	_battery_mamphour_total(0),
-	_battery_last_timestamp(0)
+	_battery_last_timestamp(0),
+	_controls_timestamp_sample(0)
 #ifdef CONFIG_ARCH_BOARD_PX4FMU_V1
 	, _dsm_vcc_ctl(false)
 #endif
@@ -533,6 +589,9 @@ PX4IO::~PX4IO()
 	perf_free(_perf_update);
 	perf_free(_perf_write);
 	perf_free(_perf_chan_count);
+	perf_free(_perf_exchange);
+	perf_free(_perf_controls);
+	perf_free(_perf_readback);
 
 	g_dev = nullptr;
 }
@@ -553,7 +612,7 @@ PX4IO::detect()
 		/* get some parameters */
 		unsigned protocol = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_PROTOCOL_VERSION);
 
-		if (protocol != PX4IO_PROTOCOL_VERSION) {
+		if ((protocol < PX4IO_PROTOCOL_VERSION_MIN) || (protocol > PX4IO_PROTOCOL_VERSION)) {
 			if (protocol == _io_reg_get_error) {
 				log("IO not installed");
 
@@ -599,12 +658,15 @@ PX4IO::init()
 		return -1;
 	}
 
-	if (protocol != PX4IO_PROTOCOL_VERSION) {
+	if ((protocol < PX4IO_PROTOCOL_VERSION_MIN) || (protocol > PX4IO_PROTOCOL_VERSION)) {
 		log("protocol/firmware mismatch");
 		mavlink_log_emergency(_mavlink_fd, "[IO] protocol/firmware mismatch, abort.");
 		return -1;
 	}
 
+	/* PX4IO_PAGE_EXCHANGE was added in protocol version 5 */
+	_exchange_page = (protocol >= 5);
+
 	_hardware      = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_HARDWARE_VERSION);
 	_max_actuators = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_ACTUATOR_COUNT);
 	_max_controls  = io_reg_get(PX4IO_PAGE_CONFIG, PX4IO_P_CONFIG_CONTROL_COUNT);
@@ -892,26 +954,53 @@ PX4IO::task_main()
 		perf_begin(_perf_update);
 		hrt_abstime now = hrt_absolute_time();
 
+		/* status, R/C and PWM outputs are pulled at 50Hz */
+		bool poll_due = (now >= poll_last + IO_POLL_INTERVAL);
+
+		uint16_t exchange[PX4IO_P_EXCHANGE_SIZE];
+		bool exchanged = false;
+
 		/* if we have new control data from the ORB, handle it */
 		if (fds[0].revents & POLLIN) {
 
+			/* when the status is due, it comes back with the group 0 controls */
+			uint16_t *reply = (poll_due && _exchange_page) ? &exchange[0] : nullptr;
+
 			/* we're not nice to the lower-priority control groups and only check them
 			   when the primary group updated (which is now). */
-			(void)io_set_control_groups();
+			if ((io_set_control_groups(reply) == OK) && (reply != nullptr))
+				exchanged = true;
 		}
 
-		if (now >= poll_last + IO_POLL_INTERVAL) {
-			/* run at 50Hz */
+		if (poll_due) {
 			poll_last = now;
 
-			/* pull status and alarms from IO */
-			io_get_status();
+			if (exchanged) {
+				io_handle_exchange(exchange);
+
+			} else if (_exchange_page) {
+				/* no controls went out, fetch the summary in a single read */
+				perf_begin(_perf_readback);
+				ret = io_reg_get(PX4IO_PAGE_EXCHANGE, 0, exchange, PX4IO_P_EXCHANGE_SIZE);
+				perf_end(_perf_readback);
+
+				if (ret == OK)
+					io_handle_exchange(exchange);
+
+			} else {
+				perf_begin(_perf_readback);
 
-			/* get raw R/C input from IO */
-			io_publish_raw_rc();
+				/* pull status and alarms from IO */
+				io_get_status();
 
-			/* fetch PWM outputs from IO */
-			io_publish_pwm_outputs();
+				/* get raw R/C input from IO */
+				io_publish_raw_rc();
+
+				/* fetch PWM outputs from IO */
+				io_publish_pwm_outputs();
+
+				perf_end(_perf_readback);
+			}
 		}
 
 		if (now >= orb_check_last + ORB_CHECK_INTERVAL) {
@@ -1030,9 +1119,9 @@ out:
 }
 
 int
-PX4IO::io_set_control_groups()
+PX4IO::io_set_control_groups(uint16_t *exchange)
 {
-	int ret = io_set_control_state(0);
+	int ret = io_set_control_state(0, exchange);
 
 	/* send auxiliary control groups */
 	(void)io_set_control_state(1);
@@ -1043,7 +1132,7 @@ PX4IO::io_set_control_groups()
 }
 
 int
-PX4IO::io_set_control_state(unsigned group)
+PX4IO::io_set_control_state(unsigned group, uint16_t *exchange)
 {
 	actuator_controls_s	controls;	///< actuator outputs
 	uint16_t 		regs[_max_actuators];
@@ -1058,6 +1147,7 @@ PX4IO::io_set_control_state(unsigned group)
 
 			if (changed) {
 				orb_copy(ORB_ID(actuator_controls_0), _t_actuator_controls_0, &controls);
+				_controls_timestamp_sample = controls.timestamp_sample;
 			}
 		}
 		break;
@@ -1096,8 +1186,15 @@ PX4IO::io_set_control_state(unsigned group)
 	for (unsigned i = 0; i < _max_controls; i++)
 		regs[i] = FLOAT_TO_REG(controls.control[i]);
 
-	/* copy values to registers in IO */
-	return io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, _max_controls);
+	/* copy values to registers in IO, picking up the status summary on the way back if asked to */
+	if (exchange != nullptr)
+		return io_exchange(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, _max_controls, exchange);
+
+	perf_begin(_perf_controls);
+	int ret = io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, _max_controls);
+	perf_end(_perf_controls);
+
+	return ret;
 }
 
 
@@ -1439,6 +1536,14 @@ PX4IO::io_get_status()
 	if (ret != OK)
 		return ret;
 
+	io_handle_status_block(regs);
+
+	return ret;
+}
+
+void
+PX4IO::io_handle_status_block(const uint16_t *regs)
+{
 	io_handle_status(regs[0]);
 	io_handle_alarms(regs[1]);
 
@@ -1449,12 +1554,21 @@ PX4IO::io_get_status()
 #ifdef CONFIG_ARCH_BOARD_PX4FMU_V2
 	io_handle_vservo(regs[4], regs[5]);
 #endif
+}
 
-	return ret;
+void
+PX4IO::io_handle_exchange(const uint16_t *regs)
+{
+	/* status first, RC and servo publication depend on the flags */
+	io_handle_status_block(&regs[PX4IO_P_EXCHANGE_STATUS]);
+
+	io_publish_raw_rc(&regs[PX4IO_P_EXCHANGE_RAW_RC], PX4IO_P_EXCHANGE_RC_COUNT);
+
+	io_publish_pwm_outputs(&regs[PX4IO_P_EXCHANGE_SERVOS], PX4IO_P_EXCHANGE_SERVO_COUNT);
 }
 
 int
-PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
+PX4IO::io_get_raw_rc_input(rc_input_values &input_rc, const uint16_t *prefetched, unsigned num_channels)
 {
 	uint32_t channel_count;
 	int	ret;
@@ -1465,15 +1579,26 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 	const unsigned prolog = (PX4IO_P_RAW_RC_BASE - PX4IO_P_RAW_RC_COUNT);
 	uint16_t regs[RC_INPUT_MAX_CHANNELS + prolog];
 
-	/*
-	 * Read the channel count and the first 9 channels.
-	 *
-	 * This should be the common case (9 channel R/C control being a reasonable upper bound).
-	 */
-	ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT, &regs[0], prolog + 9);
+	if (prefetched != nullptr) {
+		/* the channel count and the first channels came with the status summary */
+		if (num_channels > RC_INPUT_MAX_CHANNELS)
+			num_channels = RC_INPUT_MAX_CHANNELS;
 
-	if (ret != OK)
-		return ret;
+		memcpy(&regs[0], prefetched, (prolog + num_channels) * sizeof(regs[0]));
+		ret = OK;
+
+	} else {
+		/*
+		 * Read the channel count and the first 9 channels.
+		 *
+		 * This should be the common case (9 channel R/C control being a reasonable upper bound).
+		 */
+		num_channels = 9;
+		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT, &regs[0], prolog + num_channels);
+
+		if (ret != OK)
+			return ret;
+	}
 
 	/*
 	 * Get the channel count any any extra channels. This is no more expensive than reading the
@@ -1513,8 +1638,9 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 	/* FIELDS NOT SET HERE */
 	/* input_rc.input_source is set after this call XXX we might want to mirror the flags in the RC struct */
 
-	if (channel_count > 9) {
-		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + 9, &regs[prolog + 9], channel_count - 9);
+	if (channel_count > num_channels) {
+		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + num_channels, &regs[prolog + num_channels],
+				 channel_count - num_channels);
 
 		if (ret != OK)
 			return ret;
@@ -1529,7 +1655,7 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 }
 
 int
-PX4IO::io_publish_raw_rc()
+PX4IO::io_publish_raw_rc(const uint16_t *regs, unsigned num_channels)
 {
 
 	/* fetch values from IO */
@@ -1538,7 +1664,7 @@ PX4IO::io_publish_raw_rc()
 	/* set the RC status flag ORDER MATTERS! */
 	rc_val.rc_lost = !(_status & PX4IO_P_STATUS_FLAGS_RC_OK);
 
-	int ret = io_get_raw_rc_input(rc_val);
+	int ret = io_get_raw_rc_input(rc_val, regs, num_channels);
 
 	if (ret != OK)
 		return ret;
@@ -1575,7 +1701,7 @@ PX4IO::io_publish_raw_rc()
 }
 
 int
-PX4IO::io_publish_pwm_outputs()
+PX4IO::io_publish_pwm_outputs(const uint16_t *servos, unsigned num_servos)
 {
 	/* if no FMU comms(!) just don't publish */
 	if (!(_status & PX4IO_P_STATUS_FLAGS_FMU_OK))
@@ -1584,17 +1710,23 @@ PX4IO::io_publish_pwm_outputs()
 	/* data we are going to fetch */
 	actuator_outputs_s outputs;
 	outputs.timestamp = hrt_absolute_time();
+	outputs.timestamp_sample = _controls_timestamp_sample;
 
-	/* get servo values from IO */
+	/* get servo values from IO, unless they have all been read already */
 	uint16_t ctl[_max_actuators];
-	int ret = io_reg_get(PX4IO_PAGE_SERVOS, 0, ctl, _max_actuators);
 
-	if (ret != OK)
-		return ret;
+	if ((servos == nullptr) || (num_servos < _max_actuators)) {
+		int ret = io_reg_get(PX4IO_PAGE_SERVOS, 0, ctl, _max_actuators);
+
+		if (ret != OK)
+			return ret;
+
+		servos = ctl;
+	}
 
 	/* convert from register format to float */
 	for (unsigned i = 0; i < _max_actuators; i++)
-		outputs.output[i] = ctl[i];
+		outputs.output[i] = servos[i];
 
 	outputs.noutputs = _max_actuators;
 
@@ -1660,6 +1792,46 @@ PX4IO::io_reg_get(uint8_t page, uint8_t offset, uint16_t *values, unsigned num_v
 	return OK;
 }
 
+int
+PX4IO::io_exchange(uint8_t page, uint8_t offset, const uint16_t *values, unsigned num_values, uint16_t *reply)
+{
+	px4io_exchange exchange;
+	exchange.address = (page << 8) | offset;
+	exchange.values = values;
+	exchange.num_values = num_values;
+	exchange.reply = reply;
+
+	unsigned arg = reinterpret_cast<unsigned>(&exchange);
+
+	perf_begin(_perf_exchange);
+	int ret = _interface->ioctl(PX4IO_INTERFACE_EXCHANGE, arg);
+
+	if (ret != -ENOTTY) {
+		perf_end(_perf_exchange);
+
+		if (ret != OK)
+			debug("io_exchange(%u,%u,%u): error %d", page, offset, num_values, ret);
+
+		return ret;
+	}
+
+	/* the interface can't combine transfers, write and read separately */
+	perf_cancel(_perf_exchange);
+
+	perf_begin(_perf_controls);
+	ret = io_reg_set(page, offset, values, num_values);
+	perf_end(_perf_controls);
+
+	if (ret != OK)
+		return ret;
+
+	perf_begin(_perf_readback);
+	ret = io_reg_get(PX4IO_PAGE_EXCHANGE, 0, reply, PX4IO_P_EXCHANGE_SIZE);
+	perf_end(_perf_readback);
+
+	return ret;
+}
+
 uint32_t
 PX4IO::io_reg_get(uint8_t page, uint8_t offset)
 {
@@ -53,6 +53,8 @@
 
 #include <drivers/device/i2c.h>
 
+#include "px4io_driver.h"
+
 #ifdef PX4_I2C_OBDEV_PX4IO
 
 device::Device	*PX4IO_i2c_interface();
@@ -106,6 +108,10 @@ out:
 int
 PX4IO_I2C::ioctl(unsigned operation, unsigned &arg)
 {
+	/* I2C has no combined write/read, the driver falls back to separate transfers */
+	if (operation == PX4IO_INTERFACE_EXCHANGE)
+		return -ENOTTY;
+
 	return 0;
 }
 
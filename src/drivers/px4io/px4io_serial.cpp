@@ -68,6 +68,8 @@
 
 #include <modules/px4iofirmware/protocol.h>
 
+#include "px4io_driver.h"
+
 #ifdef PX4IO_SERIAL_BASE
 
 device::Device	*PX4IO_serial_interface();
@@ -126,6 +128,11 @@ private:
 	 */
 	int			_wait_complete();
 
+	/**
+	 * Write registers and read back the exchange page in one transaction.
+	 */
+	int			_exchange(const px4io_exchange *exchange);
+
 	/**
 	 * DMA completion handler.
 	 */
@@ -330,6 +337,11 @@ PX4IO_serial::ioctl(unsigned operation, unsigned &arg)
 			lowsyslog("test 2\n");
 			return 0;
 		}
+		break;
+
+	case PX4IO_INTERFACE_EXCHANGE:
+		return _exchange(reinterpret_cast<const px4io_exchange *>(arg));
+
 	default:
 		break;
 	}
@@ -337,6 +349,59 @@ PX4IO_serial::ioctl(unsigned operation, unsigned &arg)
 	return -1;
 }
 
+int
+PX4IO_serial::_exchange(const px4io_exchange *exchange)
+{
+	if (exchange->num_values > PKT_MAX_REGS)
+		return -EINVAL;
+
+	sem_wait(&_bus_semaphore);
+
+	int result;
+	for (unsigned retries = 0; retries < 3; retries++) {
+
+		_dma_buffer.count_code = exchange->num_values | PKT_CODE_EXCHANGE;
+		_dma_buffer.page = exchange->address >> 8;
+		_dma_buffer.offset = exchange->address & 0xff;
+		memcpy((void *)&_dma_buffer.regs[0], (void *)exchange->values, (2 * exchange->num_values));
+		for (unsigned i = exchange->num_values; i < PKT_MAX_REGS; i++)
+			_dma_buffer.regs[i] = 0x55aa;
+
+		/* start the transaction and wait for it to complete */
+		result = _wait_complete();
+
+		/* successful transaction? */
+		if (result == OK) {
+
+			/* check result in packet */
+			if (PKT_CODE(_dma_buffer) == PKT_CODE_ERROR) {
+
+				/* IO didn't like it - no point retrying */
+				result = -EINVAL;
+				perf_count(_pc_protoerrs);
+
+			/* IO must reply with the complete exchange page */
+			} else if (PKT_COUNT(_dma_buffer) != PX4IO_P_EXCHANGE_SIZE) {
+
+				result = -EIO;
+				perf_count(_pc_protoerrs);
+
+			} else {
+
+				/* copy back the result */
+				memcpy(exchange->reply, &_dma_buffer.regs[0], (2 * PX4IO_P_EXCHANGE_SIZE));
+			}
+
+			break;
+		}
+		perf_count(_pc_retries);
+	}
+
+	sem_post(&_bus_semaphore);
+
+	return result;
+}
+
 int
 PX4IO_serial::write(unsigned address, void *data, unsigned count)
 {
@@ -70,6 +70,8 @@
 #include "stm32_gpio.h"
 #include "stm32_tim.h"
 
+#include "hrt_queue.h"
+
 #ifdef HRT_TIMER
 
 /* HRT configuration */
@@ -242,9 +244,9 @@
 #endif
 
 /*
- * Queue of callout entries.
+ * Queue of callout entries, ordered by deadline.
  */
-static struct sq_queue_s	callout_queue;
+static struct hrt_queue		callout_queue;
 
 /* latency baseline (last compare value applied) */
 static uint16_t			latency_baseline;
@@ -741,7 +743,7 @@ hrt_store_absolute_time(volatile hrt_abstime *now)
 void
 hrt_init(void)
 {
-	sq_init(&callout_queue);
+	hrt_queue_init(&callout_queue);
 	hrt_tim_init();
 
 #ifdef HRT_PPM_CHANNEL
@@ -791,15 +793,11 @@ hrt_call_internal(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime inte
 	irqstate_t flags = irqsave();
 
 	/* if the entry is currently queued, remove it */
-	/* note that we are using a potentially uninitialised
-	   entry->link here, but it is safe as sq_rem() doesn't
-	   dereference the passed node unless it is found in the
-	   list. So we potentially waste a bit of time searching the
-	   queue for the uninitialised entry->link but we don't do
-	   anything actually unsafe.
+	/* note that entry->queue_index may be uninitialised here,
+	   but it is safe as hrt_queue_remove() only acts on the entry
+	   if the queue slot it names actually holds it.
 	*/
-	if (entry->deadline != 0)
-		sq_rem(&entry->link, &callout_queue);
+	hrt_queue_remove(&callout_queue, entry);
 
 	entry->deadline = deadline;
 	entry->period = interval;
@@ -830,7 +828,7 @@ hrt_cancel(struct hrt_call *entry)
 {
 	irqstate_t flags = irqsave();
 
-	sq_rem(&entry->link, &callout_queue);
+	hrt_queue_remove(&callout_queue, entry);
 	entry->deadline = 0;
 
 	/* if this is a periodic call being removed by the callout, prevent it from
@@ -844,29 +842,18 @@ hrt_cancel(struct hrt_call *entry)
 static void
 hrt_call_enter(struct hrt_call *entry)
 {
-	struct hrt_call	*call, *next;
-
-	call = (struct hrt_call *)sq_peek(&callout_queue);
+	if (hrt_queue_insert(&callout_queue, entry) != 0) {
+		/* out of queue slots; the call will never fire, so report it as called */
+		lldbg("hrt: callout queue full\n");
+		entry->deadline = 0;
+		entry->period = 0;
+		return;
+	}
 
-	if ((call == NULL) || (entry->deadline < call->deadline)) {
-		sq_addfirst(&entry->link, &callout_queue);
-		//lldbg("call enter at head, reschedule\n");
+	if (hrt_queue_peek(&callout_queue) == entry) {
 		/* we changed the next deadline, reschedule the timer event */
 		hrt_call_reschedule();
-
-	} else {
-		do {
-			next = (struct hrt_call *)sq_next(&call->link);
-
-			if ((next == NULL) || (entry->deadline < next->deadline)) {
-				//lldbg("call enter after head\n");
-				sq_addafter(&call->link, &entry->link, &callout_queue);
-				break;
-			}
-		} while ((call = next) != NULL);
 	}
-
-	//lldbg("scheduled\n");
 }
 
 static void
@@ -879,7 +866,7 @@ hrt_call_invoke(void)
 		/* get the current time */
 		hrt_abstime now = hrt_absolute_time();
 
-		call = (struct hrt_call *)sq_peek(&callout_queue);
+		call = hrt_queue_peek(&callout_queue);
 
 		if (call == NULL)
 			break;
@@ -887,7 +874,7 @@ hrt_call_invoke(void)
 		if (call->deadline > now)
 			break;
 
-		sq_rem(&call->link, &callout_queue);
+		hrt_queue_pop(&callout_queue);
 		//lldbg("call pop\n");
 
 		/* save the intended deadline for periodic calls */
@@ -925,7 +912,7 @@ static void
 hrt_call_reschedule()
 {
 	hrt_abstime	now = hrt_absolute_time();
-	struct hrt_call	*next = (struct hrt_call *)sq_peek(&callout_queue);
+	struct hrt_call	*next = hrt_queue_peek(&callout_queue);
 	hrt_abstime	deadline = now + HRT_INTERVAL_MAX;
 
 	/*
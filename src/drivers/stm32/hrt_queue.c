@@ -0,0 +1,159 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file hrt_queue.c
+ *
+ * Deadline ordered queue of HRT callouts.
+ */
+
+#include <stddef.h>
+#include <errno.h>
+
+#include "hrt_queue.h"
+
+static inline void
+hrt_queue_place(struct hrt_queue *queue, unsigned index, struct hrt_call *entry)
+{
+	queue->calls[index] = entry;
+	entry->queue_index = index;
+}
+
+/*
+ * Move the entry from index towards the root until its parent is due no later.
+ */
+static void
+hrt_queue_sift_up(struct hrt_queue *queue, unsigned index, struct hrt_call *entry)
+{
+	while (index > 0) {
+		unsigned parent = (index - 1) / 2;
+
+		if (queue->calls[parent]->deadline <= entry->deadline)
+			break;
+
+		hrt_queue_place(queue, index, queue->calls[parent]);
+		index = parent;
+	}
+
+	hrt_queue_place(queue, index, entry);
+}
+
+/*
+ * Move the entry from index towards the leaves until no child is due earlier.
+ */
+static void
+hrt_queue_sift_down(struct hrt_queue *queue, unsigned index, struct hrt_call *entry)
+{
+	for (;;) {
+		unsigned child = 2 * index + 1;
+
+		if (child >= queue->count)
+			break;
+
+		/* pick the earlier of the two children */
+		if ((child + 1 < queue->count) &&
+		    (queue->calls[child + 1]->deadline < queue->calls[child]->deadline))
+			child++;
+
+		if (entry->deadline <= queue->calls[child]->deadline)
+			break;
+
+		hrt_queue_place(queue, index, queue->calls[child]);
+		index = child;
+	}
+
+	hrt_queue_place(queue, index, entry);
+}
+
+void
+hrt_queue_init(struct hrt_queue *queue)
+{
+	queue->count = 0;
+	queue->overflows = 0;
+}
+
+bool
+hrt_queue_contains(const struct hrt_queue *queue, const struct hrt_call *entry)
+{
+	unsigned index = entry->queue_index;
+
+	return (index < queue->count) && (queue->calls[index] == entry);
+}
+
+int
+hrt_queue_insert(struct hrt_queue *queue, struct hrt_call *entry)
+{
+	if (queue->count >= HRT_QUEUE_MAX) {
+		queue->overflows++;
+		return -ENOSPC;
+	}
+
+	hrt_queue_sift_up(queue, queue->count++, entry);
+	return 0;
+}
+
+void
+hrt_queue_remove(struct hrt_queue *queue, struct hrt_call *entry)
+{
+	if (!hrt_queue_contains(queue, entry))
+		return;
+
+	unsigned index = entry->queue_index;
+	struct hrt_call *last = queue->calls[--queue->count];
+
+	if (last != entry) {
+		/* fill the hole with the last entry, which may belong above or below it */
+		if ((index > 0) && (last->deadline < queue->calls[(index - 1) / 2]->deadline)) {
+			hrt_queue_sift_up(queue, index, last);
+
+		} else {
+			hrt_queue_sift_down(queue, index, last);
+		}
+	}
+}
+
+struct hrt_call *
+hrt_queue_pop(struct hrt_queue *queue)
+{
+	if (queue->count == 0)
+		return NULL;
+
+	struct hrt_call *first = queue->calls[0];
+	struct hrt_call *last = queue->calls[--queue->count];
+
+	if (queue->count > 0)
+		hrt_queue_sift_down(queue, 0, last);
+
+	return first;
+}
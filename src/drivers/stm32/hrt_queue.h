@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file hrt_queue.h
+ *
+ * Deadline ordered queue of HRT callouts.
+ *
+ * The queue is a binary min-heap of hrt_call pointers in a fixed array.
+ * Each entry records its position in the heap, so that insert, cancel
+ * and pop are O(log n) and the earliest deadline is found in O(1),
+ * independent of how many drivers have callouts registered.
+ *
+ * The queue does no locking; the caller serialises access (the HRT
+ * driver does so by disabling interrupts). It has no hardware
+ * dependencies and is built for the host in Tools/tests-host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <board_config.h>
+#include <drivers/drv_hrt.h>
+
+/**
+ * Maximum number of callouts that can be queued at the same time,
+ * boards with little RAM can lower it with HRT_CALLOUT_MAX.
+ */
+#ifdef HRT_CALLOUT_MAX
+# define HRT_QUEUE_MAX		HRT_CALLOUT_MAX
+#else
+# define HRT_QUEUE_MAX		64
+#endif
+
+struct hrt_queue {
+	struct hrt_call		*calls[HRT_QUEUE_MAX];	/**< heap ordered by deadline */
+	unsigned		count;			/**< number of queued calls */
+	unsigned		overflows;		/**< inserts refused because the queue was full */
+};
+
+__BEGIN_DECLS
+
+/**
+ * Initialise an empty queue.
+ */
+__EXPORT extern void	hrt_queue_init(struct hrt_queue *queue);
+
+/**
+ * Test whether an entry is queued.
+ *
+ * This only compares the entry against the heap slot it claims to be in,
+ * so it is safe for entries whose contents have never been initialised.
+ */
+__EXPORT extern bool	hrt_queue_contains(const struct hrt_queue *queue, const struct hrt_call *entry);
+
+/**
+ * Add an entry ordered by its deadline.
+ *
+ * The entry must not be queued already.
+ *
+ * @return		0 on success, -ENOSPC if the queue is full
+ */
+__EXPORT extern int	hrt_queue_insert(struct hrt_queue *queue, struct hrt_call *entry);
+
+/**
+ * Remove an entry, if it is queued.
+ */
+__EXPORT extern void	hrt_queue_remove(struct hrt_queue *queue, struct hrt_call *entry);
+
+/**
+ * Return the entry with the earliest deadline, or NULL if the queue is empty.
+ */
+static inline struct hrt_call *
+hrt_queue_peek(const struct hrt_queue *queue)
+{
+	return (queue->count > 0) ? queue->calls[0] : NULL;
+}
+
+/**
+ * Remove and return the entry with the earliest deadline, or NULL if the queue is empty.
+ */
+__EXPORT extern struct hrt_call *hrt_queue_pop(struct hrt_queue *queue);
+
+__END_DECLS
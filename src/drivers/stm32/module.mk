@@ -38,6 +38,7 @@
 #
 
 SRCS		= drv_hrt.c \
+		  hrt_queue.c \
 		  drv_pwm_servo.c
 
 INCLUDE_DIRS	+= $(NUTTX_SRC)/arch/arm/src/stm32 $(NUTTX_SRC)/arch/arm/src/common
@@ -46,6 +46,7 @@
  * IOCTL interface for sending log messages.
  */
 #include <sys/ioctl.h>
+#include <stdint.h>
 
 /**
  * The mavlink log device node; must be opened before messages
@@ -103,30 +104,100 @@ __EXPORT void mavlink_vasprintf(int _fd, int severity, const char *fmt, ...);
 
 struct mavlink_logmessage {
 	char text[MAVLINK_LOG_MAXLEN + 1];
-	unsigned char severity;
+	unsigned char severity;		/**< MAV_SEVERITY, lower values are more severe */
 };
 
-struct mavlink_logbuffer {
-	unsigned int start;
-	unsigned int size;
-	int count;
-	struct mavlink_logmessage *elems;
-};
+/**
+ * Number of messages held by the log queue, a power of two.
+ */
+#define MAVLINK_LOGQUEUE_SIZE		16
 
-__BEGIN_DECLS
-void mavlink_logbuffer_init(struct mavlink_logbuffer *lb, int size);
+/**
+ * Number of readers (MAVLink instances) the log queue supports.
+ */
+#define MAVLINK_LOGQUEUE_READERS	6
 
-void mavlink_logbuffer_destroy(struct mavlink_logbuffer *lb);
+/**
+ * Queue slots kept for severe messages.
+ *
+ * Once the slowest reader is this close to losing messages, messages
+ * less severe than MAVLINK_LOGQUEUE_KEEP_SEVERITY are dropped on write.
+ */
+#define MAVLINK_LOGQUEUE_RESERVE	4
+#define MAVLINK_LOGQUEUE_KEEP_SEVERITY	2	/**< MAV_SEVERITY_CRITICAL */
 
-int mavlink_logbuffer_is_full(struct mavlink_logbuffer *lb);
+struct mavlink_logslot {
+	volatile uint32_t seq;		/**< sequence number + 1 once published, 0 while written */
+	struct mavlink_logmessage msg;
+};
 
-int mavlink_logbuffer_is_empty(struct mavlink_logbuffer *lb);
+struct mavlink_logqueue_reader {
+	volatile uint32_t in_use;
+	volatile uint32_t next;		/**< sequence number of the next message to read */
+	uint32_t lost;			/**< messages overwritten before they were read */
+	uint32_t read;			/**< messages read */
+};
 
-void mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem);
+/**
+ * Bounded multi-producer, multi-reader queue of log messages.
+ *
+ * Writers take turns, claim the next sequence number and publish the
+ * message in the slot it maps to; they never wait for readers. Writing is
+ * serialized so that a writer lapping the queue cannot meet another one
+ * still filling the same slot. Every reader has its own cursor, so each one sees every
+ * message unless it falls more than MAVLINK_LOGQUEUE_SIZE messages behind,
+ * in which case the oldest messages are overwritten and counted as lost
+ * for that reader.
+ *
+ * A zero initialised queue is empty and ready for use.
+ */
+struct mavlink_logqueue {
+	volatile uint32_t head;		/**< sequence number of the next message written */
+	volatile uint32_t dropped;	/**< messages dropped on write to keep room for severe ones */
+	volatile uint32_t write_lock;	/**< held while a writer fills a slot */
+	struct mavlink_logqueue_reader readers[MAVLINK_LOGQUEUE_READERS];
+	struct mavlink_logslot slots[MAVLINK_LOGQUEUE_SIZE];
+};
 
-int mavlink_logbuffer_read(struct mavlink_logbuffer *lb, struct mavlink_logmessage *elem);
+__BEGIN_DECLS
+/**
+ * Write a message to the queue.
+ *
+ * Safe to call from any number of tasks concurrently, but not from
+ * interrupt context.
+ *
+ * @param q		The queue.
+ * @param severity	MAV_SEVERITY of the message.
+ * @param text		Message text, truncated to MAVLINK_LOG_MAXLEN.
+ * @return		0 if queued, -1 if dropped.
+ */
+__EXPORT int mavlink_logqueue_write(struct mavlink_logqueue *q, int severity, const char *text);
+
+/**
+ * Attach a reader to the queue.
+ *
+ * The reader receives the messages written from now on.
+ *
+ * @return		The reader index, or -1 if all readers are in use.
+ */
+__EXPORT int mavlink_logqueue_attach(struct mavlink_logqueue *q);
+
+/**
+ * Detach a reader from the queue.
+ */
+__EXPORT void mavlink_logqueue_detach(struct mavlink_logqueue *q, int reader);
 
-void mavlink_logbuffer_vasprintf(struct mavlink_logbuffer *lb, int severity, const char *fmt, ...);
+/**
+ * Read the next message for a reader.
+ *
+ * Each reader must only be read from one task.
+ *
+ * @param q		The queue.
+ * @param reader	Index returned by mavlink_logqueue_attach.
+ * @param msg		Receives the message.
+ * @return		0 if a message was read, 1 if there is none.
+ */
+__EXPORT int mavlink_logqueue_read(struct mavlink_logqueue *q, int reader, struct mavlink_logmessage *msg);
 __END_DECLS
 
 #endif
@@ -88,22 +88,9 @@ float ECL_L1_Pos_Controller::crosstrack_error(void)
 void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A, const math::Vector<2> &vector_B, const math::Vector<2> &vector_curr_position,
 				       const math::Vector<2> &ground_speed_vector)
 {
-
-	/* this follows the logic presented in [1] */
-
-	float eta;
-	float xtrack_vel;
-	float ltrack_vel;
-
 	/* get the direction between the last (visited) and next waypoint */
 	_target_bearing = get_bearing_to_next_waypoint(vector_curr_position(0), vector_curr_position(1), vector_B(0), vector_B(1));
 
-	/* enforce a minimum ground speed of 0.1 m/s to avoid singularities */
-	float ground_speed = math::max(ground_speed_vector.length(), 0.1f);
-
-	/* calculate the L1 length required for the desired period */
-	_L1_distance = _L1_ratio * ground_speed;
-
 	/* calculate vector from A to B */
 	math::Vector<2> vector_AB = get_local_planar_vector(vector_A, vector_B);
 
@@ -115,11 +102,50 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 		vector_AB = get_local_planar_vector(vector_curr_position, vector_B);
 	}
 
-	vector_AB.normalize();
-
 	/* calculate the vector from waypoint A to the aircraft */
 	math::Vector<2> vector_A_to_airplane = get_local_planar_vector(vector_A, vector_curr_position);
 
+	/* estimate airplane position WRT to B */
+	math::Vector<2> vector_B_to_airplane = get_local_planar_vector(vector_B, vector_curr_position);
+
+	navigate_waypoints_planar(vector_AB, vector_A_to_airplane, vector_B_to_airplane, ground_speed_vector);
+}
+
+void ECL_L1_Pos_Controller::navigate_waypoints_local(const math::Vector<2> &vector_A, const math::Vector<2> &vector_B, const math::Vector<2> &vector_curr_position,
+				       const math::Vector<2> &ground_speed_vector)
+{
+	math::Vector<2> vector_B_to_airplane = vector_curr_position - vector_B;
+
+	_target_bearing = atan2f(-vector_B_to_airplane(1), -vector_B_to_airplane(0));
+
+	math::Vector<2> vector_AB = vector_B - vector_A;
+
+	/* waypoints on top of each other, skip A and directly continue to B */
+	if (vector_AB.length() < 1.0e-6f) {
+		vector_AB = -vector_B_to_airplane;
+	}
+
+	navigate_waypoints_planar(vector_AB, vector_curr_position - vector_A, vector_B_to_airplane, ground_speed_vector);
+}
+
+void ECL_L1_Pos_Controller::navigate_waypoints_planar(const math::Vector<2> &vector_A_to_B, const math::Vector<2> &vector_A_to_airplane,
+				       const math::Vector<2> &vector_B_to_airplane, const math::Vector<2> &ground_speed_vector)
+{
+
+	/* this follows the logic presented in [1] */
+
+	float eta;
+	float xtrack_vel;
+	float ltrack_vel;
+
+	/* enforce a minimum ground speed of 0.1 m/s to avoid singularities */
+	float ground_speed = math::max(ground_speed_vector.length(), 0.1f);
+
+	/* calculate the L1 length required for the desired period */
+	_L1_distance = _L1_ratio * ground_speed;
+
+	math::Vector<2> vector_AB = vector_A_to_B.normalized();
+
 	/* calculate crosstrack error (output only) */
 	_crosstrack_error = vector_AB % vector_A_to_airplane;
 
@@ -132,7 +158,7 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 	float alongTrackDist = vector_A_to_airplane * vector_AB;
 
 	/* estimate airplane position WRT to B */
-	math::Vector<2> vector_B_to_P_unit = get_local_planar_vector(vector_B, vector_curr_position).normalized();
+	math::Vector<2> vector_B_to_P_unit = vector_B_to_airplane.normalized();
 	
 	/* calculate angle of airplane position vector relative to line) */
 
@@ -213,6 +239,26 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 
 void ECL_L1_Pos_Controller::navigate_loiter(const math::Vector<2> &vector_A, const math::Vector<2> &vector_curr_position, float radius, int8_t loiter_direction,
 				       const math::Vector<2> &ground_speed_vector)
+{
+	/* update bearing to next waypoint */
+	_target_bearing = get_bearing_to_next_waypoint(vector_curr_position(0), vector_curr_position(1), vector_A(0), vector_A(1));
+
+	/* calculate the vector from waypoint A to current position */
+	navigate_loiter_planar(get_local_planar_vector(vector_A, vector_curr_position), radius, loiter_direction, ground_speed_vector);
+}
+
+void ECL_L1_Pos_Controller::navigate_loiter_local(const math::Vector<2> &vector_A, const math::Vector<2> &vector_curr_position, float radius, int8_t loiter_direction,
+				       const math::Vector<2> &ground_speed_vector)
+{
+	math::Vector<2> vector_A_to_airplane = vector_curr_position - vector_A;
+
+	_target_bearing = atan2f(-vector_A_to_airplane(1), -vector_A_to_airplane(0));
+
+	navigate_loiter_planar(vector_A_to_airplane, radius, loiter_direction, ground_speed_vector);
+}
+
+void ECL_L1_Pos_Controller::navigate_loiter_planar(const math::Vector<2> &vector_A_to_airplane, float radius, int8_t loiter_direction,
+				       const math::Vector<2> &ground_speed_vector)
 {
 	/* the complete guidance logic in this section was proposed by [2] */
 
@@ -221,18 +267,12 @@ void ECL_L1_Pos_Controller::navigate_loiter(const math::Vector<2> &vector_A, con
 	float K_crosstrack = omega * omega;
 	float K_velocity = 2.0f * _L1_damping * omega;
 
-	/* update bearing to next waypoint */
-	_target_bearing = get_bearing_to_next_waypoint(vector_curr_position(0), vector_curr_position(1), vector_A(0), vector_A(1));
-
 	/* ground speed, enforce minimum of 0.1 m/s to avoid singularities */
 	float ground_speed = math::max(ground_speed_vector.length() , 0.1f);
 
 	/* calculate the L1 length required for the desired period */
 	_L1_distance = _L1_ratio * ground_speed;
 
-	/* calculate the vector from waypoint A to current position */
-	math::Vector<2> vector_A_to_airplane = get_local_planar_vector(vector_A, vector_curr_position);
-
 	math::Vector<2> vector_A_to_airplane_unit;
 
 	/* prevent NaN when normalizing */
@@ -176,6 +176,31 @@ public:
 			   const math::Vector<2> &ground_speed_vector);
 
 
+	/**
+	 * Navigate between two waypoints given in a local frame
+	 *
+	 * Same as navigate_waypoints(), but all positions are north / east
+	 * in meters relative to a common origin, e.g. projected once with
+	 * map_projection_project() when the waypoints change. This avoids
+	 * the great circle computations on every call.
+	 *
+	 * @return sets _lateral_accel setpoint
+	 */
+	void navigate_waypoints_local(const math::Vector<2> &vector_A, const math::Vector<2> &vector_B, const math::Vector<2> &vector_curr_position,
+			   const math::Vector<2> &ground_speed);
+
+
+	/**
+	 * Navigate on an orbit around a loiter waypoint given in a local frame
+	 *
+	 * Same as navigate_loiter(), positions are north / east in meters.
+	 *
+	 * @return sets _lateral_accel setpoint
+	 */
+	void navigate_loiter_local(const math::Vector<2> &vector_A, const math::Vector<2> &vector_curr_position, float radius, int8_t loiter_direction,
+			   const math::Vector<2> &ground_speed_vector);
+
+
 	/**
 	 * Navigate on a fixed bearing.
 	 *
@@ -249,6 +274,20 @@ private:
 
 	float _roll_lim_rad;  ///<maximum roll angle
 
+	/**
+	 * Waypoint navigation on planar vectors in meters, shared by the
+	 * global and the local frame variant. _target_bearing is set by the caller.
+	 */
+	void navigate_waypoints_planar(const math::Vector<2> &vector_A_to_B, const math::Vector<2> &vector_A_to_airplane,
+				       const math::Vector<2> &vector_B_to_airplane, const math::Vector<2> &ground_speed_vector);
+
+	/**
+	 * Loiter navigation on the planar vector from the loiter center
+	 * to the aircraft in meters. _target_bearing is set by the caller.
+	 */
+	void navigate_loiter_planar(const math::Vector<2> &vector_A_to_airplane, float radius, int8_t loiter_direction,
+				    const math::Vector<2> &ground_speed_vector);
+
 	/**
 	 * Convert a 2D vector from WGS84 to planar coordinates.
 	 *
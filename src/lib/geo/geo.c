@@ -50,6 +50,104 @@
 #include <math.h>
 #include <stdbool.h>
 
+/*
+ * Single precision evaluation of the great circle quantities.
+ *
+ * The Cortex-M4 FPU only executes single precision; double sin/cos/acos/atan2
+ * are emulated and cost several microseconds each. The functions below
+ * therefore only form the latitude / longitude differences in double, where
+ * the subtraction is exact, and do all trigonometry in float:
+ *
+ * - the differences are small angles, so their float rounding is relative
+ *   (about 1e-7 of the distance, i.e. below a millimeter at 10 km)
+ * - the absolute latitudes are only needed as sine / cosine factors, which
+ *   tolerate the float rounding of the latitude; they are taken from the
+ *   colatitude so that the cosine stays accurate close to the poles
+ * - the formulas are rearranged so that no quantity close to one has to be
+ *   differenced: cos(c) close to one is never passed to acos, and
+ *   cos(lat_0) sin(lat) - sin(lat_0) cos(lat) cos(d_lon) is evaluated as
+ *   sin(d_lat) + 2 sin(lat_0) cos(lat) sin^2(d_lon / 2)
+ *
+ * The formulas are exact, not approximations, and are valid for any
+ * distance short of antipodal points. Errors against the double precision
+ * evaluation are verified by Tools/tests-host/geo_test.
+ */
+struct geo_delta {
+	float d_lat;		/**< latitude difference in radians */
+	float d_lon;		/**< longitude difference in radians, wrapped to +-pi */
+	float sin_lat_now;
+	float cos_lat_now;
+	float cos_lat_next;
+	float sin2_half_d_lon;	/**< sin^2(d_lon / 2) */
+};
+
+/*
+ * Sine and cosine of a latitude in degrees.
+ *
+ * Evaluated from the colatitude to the nearer pole, formed in double, so
+ * that the cosine keeps its relative accuracy close to the poles.
+ */
+static void geo_sincos_lat(double lat, float *sin_lat, float *cos_lat)
+{
+	float colat = (float)(90.0 - fabs(lat)) * M_DEG_TO_RAD_F;
+
+	*cos_lat = sinf(colat);
+	*sin_lat = (lat < 0.0) ? -cosf(colat) : cosf(colat);
+}
+
+static void geo_delta(double lat_now, double lon_now, double lat_next, double lon_next, struct geo_delta *d)
+{
+	double d_lon_deg = lon_next - lon_now;
+
+	if (d_lon_deg > 180.0) {
+		d_lon_deg -= 360.0;
+
+	} else if (d_lon_deg < -180.0) {
+		d_lon_deg += 360.0;
+	}
+
+	d->d_lat = (float)(lat_next - lat_now) * M_DEG_TO_RAD_F;
+	d->d_lon = (float)d_lon_deg * M_DEG_TO_RAD_F;
+
+	float sin_lat_next;
+	geo_sincos_lat(lat_now, &d->sin_lat_now, &d->cos_lat_now);
+	geo_sincos_lat(lat_next, &sin_lat_next, &d->cos_lat_next);
+
+	float sin_half_d_lon = sinf(0.5f * d->d_lon);
+	d->sin2_half_d_lon = sin_half_d_lon * sin_half_d_lon;
+}
+
+/*
+ * Central angle between the two positions (haversine).
+ */
+static float geo_central_angle(const struct geo_delta *d)
+{
+	float sin_half_d_lat = sinf(0.5f * d->d_lat);
+	float a = sin_half_d_lat * sin_half_d_lat + d->sin2_half_d_lon * d->cos_lat_now * d->cos_lat_next;
+
+	if (a > 1.0f) {
+		a = 1.0f;
+	}
+
+	return 2.0f * atan2f(sqrtf(a), sqrtf(1.0f - a));
+}
+
+/*
+ * North component of the initial great circle direction, unscaled.
+ */
+static float geo_north(const struct geo_delta *d)
+{
+	return sinf(d->d_lat) + 2.0f * d->sin_lat_now * d->cos_lat_next * d->sin2_half_d_lon;
+}
+
+/*
+ * East component of the initial great circle direction, unscaled.
+ */
+static float geo_east(const struct geo_delta *d)
+{
+	return sinf(d->d_lon) * d->cos_lat_next;
+}
+
 /*
  * Azimuthal Equidistant Projection
  * formulas according to: http://mathworld.wolfram.com/AzimuthalEquidistantProjection.html
@@ -66,18 +164,15 @@ __EXPORT void map_projection_init(struct map_projection_reference_s *ref, double
 
 __EXPORT void map_projection_project(struct map_projection_reference_s *ref, double lat, double lon, float *x, float *y)
 {
-	double lat_rad = lat / 180.0 * M_PI;
-	double lon_rad = lon / 180.0 * M_PI;
+	struct geo_delta d;
 
-	double sin_lat = sin(lat_rad);
-	double cos_lat = cos(lat_rad);
-	double cos_d_lon = cos(lon_rad - ref->lon);
+	geo_delta(ref->lat * M_RAD_TO_DEG, ref->lon * M_RAD_TO_DEG, lat, lon, &d);
 
-	double c = acos(ref->sin_lat * sin_lat + ref->cos_lat * cos_lat * cos_d_lon);
-	double k = (c == 0.0) ? 1.0 : (c / sin(c));
+	float c = geo_central_angle(&d);
+	float k = (c == 0.0f) ? 1.0f : (c / sinf(c));
 
-	*x = k * (ref->cos_lat * sin_lat - ref->sin_lat * cos_lat * cos_d_lon) * CONSTANTS_RADIUS_OF_EARTH;
-	*y = k * cos_lat * sin(lon_rad - ref->lon) * CONSTANTS_RADIUS_OF_EARTH;
+	*x = k * geo_north(&d) * CONSTANTS_RADIUS_OF_EARTH;
+	*y = k * geo_east(&d) * CONSTANTS_RADIUS_OF_EARTH;
 }
 
 __EXPORT void map_projection_reproject(struct map_projection_reference_s *ref, float x, float y, double *lat, double *lon)
@@ -107,32 +202,20 @@ __EXPORT void map_projection_reproject(struct map_projection_reference_s *ref, f
 
 __EXPORT float get_distance_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next)
 {
-	double lat_now_rad = lat_now / 180.0d * M_PI;
-	double lon_now_rad = lon_now / 180.0d * M_PI;
-	double lat_next_rad = lat_next / 180.0d * M_PI;
-	double lon_next_rad = lon_next / 180.0d * M_PI;
+	struct geo_delta d;
 
+	geo_delta(lat_now, lon_now, lat_next, lon_next, &d);
 
-	double d_lat = lat_next_rad - lat_now_rad;
-	double d_lon = lon_next_rad - lon_now_rad;
-
-	double a = sin(d_lat / 2.0d) * sin(d_lat / 2.0d) + sin(d_lon / 2.0d) * sin(d_lon / 2.0d) * cos(lat_now_rad) * cos(lat_next_rad);
-	double c = 2.0d * atan2(sqrt(a), sqrt(1.0d - a));
-
-	return CONSTANTS_RADIUS_OF_EARTH * c;
+	return CONSTANTS_RADIUS_OF_EARTH * geo_central_angle(&d);
 }
 
 __EXPORT float get_bearing_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next)
 {
-	double lat_now_rad = lat_now * M_DEG_TO_RAD;
-	double lon_now_rad = lon_now * M_DEG_TO_RAD;
-	double lat_next_rad = lat_next * M_DEG_TO_RAD;
-	double lon_next_rad = lon_next * M_DEG_TO_RAD;
+	struct geo_delta d;
 
-	double d_lon = lon_next_rad - lon_now_rad;
+	geo_delta(lat_now, lon_now, lat_next, lon_next, &d);
 
-	/* conscious mix of double and float trig function to maximize speed and efficiency */
-	float theta = atan2f(sin(d_lon) * cos(lat_next_rad) , cos(lat_now_rad) * sin(lat_next_rad) - sin(lat_now_rad) * cos(lat_next_rad) * cos(d_lon));
+	float theta = atan2f(geo_east(&d), geo_north(&d));
 
 	theta = _wrap_pi(theta);
 
@@ -141,17 +224,12 @@ __EXPORT float get_bearing_to_next_waypoint(double lat_now, double lon_now, doub
 
 __EXPORT void get_vector_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next, float *v_n, float *v_e)
 {
-	double lat_now_rad = lat_now * M_DEG_TO_RAD;
-	double lon_now_rad = lon_now * M_DEG_TO_RAD;
-	double lat_next_rad = lat_next * M_DEG_TO_RAD;
-	double lon_next_rad = lon_next * M_DEG_TO_RAD;
+	struct geo_delta d;
 
-	double d_lat = lat_next_rad - lat_now_rad;
-	double d_lon = lon_next_rad - lon_now_rad;
+	geo_delta(lat_now, lon_now, lat_next, lon_next, &d);
 
-	/* conscious mix of double and float trig function to maximize speed and efficiency */
-	*v_n = CONSTANTS_RADIUS_OF_EARTH * (cos(lat_now_rad) * sin(lat_next_rad) - sin(lat_now_rad) * cos(lat_next_rad) * cos(d_lon));
-	*v_e = CONSTANTS_RADIUS_OF_EARTH * sin(d_lon) * cos(lat_next_rad);
+	*v_n = CONSTANTS_RADIUS_OF_EARTH * geo_north(&d);
+	*v_e = CONSTANTS_RADIUS_OF_EARTH * geo_east(&d);
 }
 
 __EXPORT void get_vector_to_next_waypoint_fast(double lat_now, double lon_now, double lat_next, double lon_next, float *v_n, float *v_e)
@@ -212,9 +290,10 @@ __EXPORT int get_distance_to_line(struct crosstrack_error_s *crosstrack_error, d
 	}
 
 	dist_to_end = get_distance_to_next_waypoint(lat_now, lon_now, lat_end, lon_end);
-	crosstrack_error->distance = (dist_to_end) * sin(bearing_diff);
+	float sin_bearing_diff = sinf(bearing_diff);
+	crosstrack_error->distance = (dist_to_end) * sin_bearing_diff;
 
-	if (sin(bearing_diff) >= 0) {
+	if (sin_bearing_diff >= 0) {
 		crosstrack_error->bearing = _wrap_pi(bearing_track - M_PI_2_F);
 
 	} else {
@@ -298,8 +377,8 @@ __EXPORT int get_distance_to_arc(struct crosstrack_error_s *crosstrack_error, do
 		// TO DO - this is messed up and won't compile
 		float start_disp_x = radius * sin(arc_start_bearing);
 		float start_disp_y = radius * cos(arc_start_bearing);
-		float end_disp_x = radius * sin(_wrapPI(arc_start_bearing + arc_sweep));
-		float end_disp_y = radius * cos(_wrapPI(arc_start_bearing + arc_sweep));
+		float end_disp_x = radius * sin(_wrap_pi(arc_start_bearing + arc_sweep));
+		float end_disp_y = radius * cos(_wrap_pi(arc_start_bearing + arc_sweep));
 		float lon_start = lon_now + start_disp_x / 111111.0d;
 		float lat_start = lat_now + start_disp_y * cos(lat_now) / 111111.0d;
 		float lon_end = lon_now + end_disp_x / 111111.0d;
@@ -320,7 +399,7 @@ __EXPORT int get_distance_to_arc(struct crosstrack_error_s *crosstrack_error, do
 
 	}
 
-	crosstrack_error->bearing = _wrapPI(crosstrack_error->bearing);
+	crosstrack_error->bearing = _wrap_pi(crosstrack_error->bearing);
 	return_value = OK;
 	return return_value;
 }
@@ -329,18 +408,7 @@ __EXPORT float get_distance_to_point_global_wgs84(double lat_now, double lon_now
 		double lat_next, double lon_next, float alt_next,
 		float *dist_xy, float *dist_z)
 {
-	double current_x_rad = lat_next / 180.0 * M_PI;
-	double current_y_rad = lon_next / 180.0 * M_PI;
-	double x_rad = lat_now / 180.0 * M_PI;
-	double y_rad = lon_now / 180.0 * M_PI;
-
-	double d_lat = x_rad - current_x_rad;
-	double d_lon = y_rad - current_y_rad;
-
-	double a = sin(d_lat / 2.0) * sin(d_lat / 2.0) + sin(d_lon / 2.0) * sin(d_lon / 2.0f) * cos(current_x_rad) * cos(x_rad);
-	double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-
-	float dxy = CONSTANTS_RADIUS_OF_EARTH * c;
+	float dxy = get_distance_to_next_waypoint(lat_now, lon_now, lat_next, lon_next);
 	float dz = alt_now - alt_next;
 
 	*dist_xy = fabsf(dxy);
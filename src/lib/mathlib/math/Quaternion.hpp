@@ -130,12 +130,51 @@ public:
 		data[3] = cosPhi_2 * cosTheta_2 * sinPsi_2 - sinPhi_2 * sinTheta_2 * cosPsi_2;
 	}
 
+	/**
+	 * set quaternion to rotation by given rotation matrix
+	 *
+	 * the largest component is taken from the diagonal to avoid
+	 * singularities, the others (with their signs) from the
+	 * off-diagonal elements
+	 */
 	void from_dcm(const Matrix<3, 3> &m) {
-		// avoiding singularities by not using division equations
-		data[0] = 0.5f * sqrtf(1.0f + m.data[0][0] + m.data[1][1] + m.data[2][2]);
-		data[1] = 0.5f * sqrtf(1.0f + m.data[0][0] - m.data[1][1] - m.data[2][2]);
-		data[2] = 0.5f * sqrtf(1.0f - m.data[0][0] + m.data[1][1] - m.data[2][2]);
-		data[3] = 0.5f * sqrtf(1.0f - m.data[0][0] - m.data[1][1] + m.data[2][2]);
+		float tr = m.data[0][0] + m.data[1][1] + m.data[2][2];
+
+		if (tr > 0.0f) {
+			float s = sqrtf(tr + 1.0f) * 2.0f;
+			data[0] = 0.25f * s;
+			data[1] = (m.data[2][1] - m.data[1][2]) / s;
+			data[2] = (m.data[0][2] - m.data[2][0]) / s;
+			data[3] = (m.data[1][0] - m.data[0][1]) / s;
+
+		} else if (m.data[0][0] > m.data[1][1] && m.data[0][0] > m.data[2][2]) {
+			float s = sqrtf(1.0f + m.data[0][0] - m.data[1][1] - m.data[2][2]) * 2.0f;
+			data[0] = (m.data[2][1] - m.data[1][2]) / s;
+			data[1] = 0.25f * s;
+			data[2] = (m.data[0][1] + m.data[1][0]) / s;
+			data[3] = (m.data[0][2] + m.data[2][0]) / s;
+
+		} else if (m.data[1][1] > m.data[2][2]) {
+			float s = sqrtf(1.0f + m.data[1][1] - m.data[0][0] - m.data[2][2]) * 2.0f;
+			data[0] = (m.data[0][2] - m.data[2][0]) / s;
+			data[1] = (m.data[0][1] + m.data[1][0]) / s;
+			data[2] = 0.25f * s;
+			data[3] = (m.data[1][2] + m.data[2][1]) / s;
+
+		} else {
+			float s = sqrtf(1.0f + m.data[2][2] - m.data[0][0] - m.data[1][1]) * 2.0f;
+			data[0] = (m.data[1][0] - m.data[0][1]) / s;
+			data[1] = (m.data[0][2] + m.data[2][0]) / s;
+			data[2] = (m.data[1][2] + m.data[2][1]) / s;
+			data[3] = 0.25f * s;
+		}
+	}
+
+	/**
+	 * conjugate, i.e. the inverse rotation for a unit quaternion
+	 */
+	const Quaternion conjugated(void) const {
+		return Quaternion(data[0], -data[1], -data[2], -data[3]);
 	}
 
 	/**
@@ -57,6 +57,13 @@ public:
      */
     void set_cutoff_frequency(float sample_freq, float cutoff_freq);
 
+    /**
+     * Compute the filter coefficients for a cutoff frequency above zero,
+     * shared with LowPassFilter2pVector
+     */
+    static void compute_coefficients(float sample_freq, float cutoff_freq,
+                                     float &b0, float &b1, float &b2, float &a1, float &a2);
+
     /**
      * Add a new raw value to the filter
      *
@@ -0,0 +1,169 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/// @file	LowPassFilter2pVector.hpp
+/// @brief	Second order low pass filter over N channels sharing one cutoff
+///
+/// Same filter as LowPassFilter2p, but the coefficients are stored once
+/// and the delay elements of all channels are kept in structure-of-arrays
+/// form, so that one call filters a complete sample (e.g. the three axes
+/// of a sensor) and the inner loops are plain per-channel arithmetic the
+/// compiler can unroll or vectorize.
+
+#pragma once
+
+#include <string.h>
+#include <math.h>
+
+#include "LowPassFilter2p.hpp"
+
+namespace math
+{
+template <unsigned N>
+class __EXPORT LowPassFilter2pVector
+{
+public:
+    // constructor
+    LowPassFilter2pVector(float sample_freq, float cutoff_freq) {
+        // set initial parameters
+        set_cutoff_frequency(sample_freq, cutoff_freq);
+        memset(_delay_element_1, 0, sizeof(_delay_element_1));
+        memset(_delay_element_2, 0, sizeof(_delay_element_2));
+    }
+
+    /**
+     * Change filter parameters, the coefficients are those of LowPassFilter2p
+     */
+    void set_cutoff_frequency(float sample_freq, float cutoff_freq) {
+        _cutoff_freq = cutoff_freq;
+        if (_cutoff_freq <= 0.0f) {
+            // no filtering
+            return;
+        }
+        LowPassFilter2p::compute_coefficients(sample_freq, _cutoff_freq, _b0, _b1, _b2, _a1, _a2);
+    }
+
+    /**
+     * Add a new raw sample of all channels to the filter
+     *
+     * @param sample    N raw values
+     * @param output    N filtered values, may alias sample
+     */
+    void apply(const float sample[N], float output[N]) {
+        if (_cutoff_freq <= 0.0f) {
+            // no filtering
+            if (output != sample) {
+                memcpy(output, sample, sizeof(float) * N);
+            }
+            return;
+        }
+        filter(sample, output);
+    }
+
+    /**
+     * Filter a burst of samples, e.g. read from a sensor FIFO
+     *
+     * The samples are interleaved by channel, i.e. samples[i * N + c]
+     * is channel c of sample i.
+     *
+     * @param samples   count * N raw values
+     * @param output    count * N filtered values, may alias samples
+     * @param count     number of samples per channel
+     */
+    void apply_block(const float *samples, float *output, unsigned count) {
+        if (_cutoff_freq <= 0.0f) {
+            if (output != samples) {
+                memcpy(output, samples, sizeof(float) * N * count);
+            }
+            return;
+        }
+        for (unsigned i = 0; i < count; i++) {
+            filter(&samples[i * N], &output[i * N]);
+        }
+    }
+
+    /**
+     * Return the cutoff frequency
+     */
+    float get_cutoff_freq(void) const {
+        return _cutoff_freq;
+    }
+
+    /**
+     * Reset the filter state of all channels to this sample
+     *
+     * @param sample    N values to settle the filter on
+     * @param output    N filtered values
+     */
+    void reset(const float sample[N], float output[N]) {
+        for (unsigned c = 0; c < N; c++) {
+            _delay_element_1[c] = _delay_element_2[c] = sample[c];
+        }
+        apply(sample, output);
+    }
+
+private:
+    float           _cutoff_freq;
+    float           _a1;
+    float           _a2;
+    float           _b0;
+    float           _b1;
+    float           _b2;
+    float           _delay_element_1[N];    // buffered sample -1, per channel
+    float           _delay_element_2[N];    // buffered sample -2, per channel
+
+    void filter(const float sample[N], float output[N]) {
+        // load the coefficients once for all channels
+        const float a1 = _a1;
+        const float a2 = _a2;
+        const float b0 = _b0;
+        const float b1 = _b1;
+        const float b2 = _b2;
+
+        for (unsigned c = 0; c < N; c++) {
+            float delay_element_0 = sample[c] - _delay_element_1[c] * a1 - _delay_element_2[c] * a2;
+            if (isnan(delay_element_0) || isinf(delay_element_0)) {
+                // don't allow bad values to propagate via the filter
+                delay_element_0 = sample[c];
+            }
+            output[c] = delay_element_0 * b0 + _delay_element_1[c] * b1 + _delay_element_2[c] * b2;
+
+            _delay_element_2[c] = _delay_element_1[c];
+            _delay_element_1[c] = delay_element_0;
+        }
+    }
+};
+
+} // namespace math
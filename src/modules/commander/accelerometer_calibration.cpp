@@ -63,42 +63,28 @@
  * 6 reference vectors * 3 axes = 18 equations
  * 9 (accel_T) + 3 (accel_offs) = 12 unknown constants
  *
- * Find accel_offs
+ * Find accel_offs and accel_T
  *
- * accel_offs[i] = (accel_raw_ref[i*2][i] + accel_raw_ref[i*2+1][i]) / 2
+ * Each pair of opposite orientations gives the offset and one column of A = g * accel_T^-1:
  *
- * Find accel_T
+ * accel_raw_ref[i*2]   =  A[i] + accel_offs
+ * accel_raw_ref[i*2+1] = -A[i] + accel_offs
  *
- * 9 unknown constants
- * need 9 equations -> use 3 of 6 measurements -> 3 * 3 = 9 equations
+ * accel_offs = sum(accel_raw_ref[i*2] + accel_raw_ref[i*2+1]) / 6, i = 0...2
+ * A[i] = (accel_raw_ref[i*2] - accel_raw_ref[i*2+1]) / 2
  *
- * accel_corr_ref[i*2] = accel_T * (accel_raw_ref[i*2] - accel_offs), i = 0...2
- *
- * Solve separate system for each row of accel_T:
- *
- * accel_corr_ref[j*2][i] = accel_T[i] * (accel_raw_ref[j*2] - accel_offs), j = 0...2
- *
- * A * x = b
- *
- * x = [ accel_T[0][i] ]
- *     | accel_T[1][i] |
- *     [ accel_T[2][i] ]
- *
- * b = [ accel_corr_ref[0][i] ]	// One measurement per axis is enough
- *     | accel_corr_ref[2][i] |
- *     [ accel_corr_ref[4][i] ]
- *
- * a[i][j] = accel_raw_ref[i][j] - accel_offs[j], i = 0;2;4, j = 0...2
+ * accel_T = A^-1 * g
+ * g = 9.80665
  *
- * Matrix A is common for all three systems:
- * A = [ a[0][0]  a[0][1]  a[0][2] ]
- *     | a[2][0]  a[2][1]  a[2][2] |
- *     [ a[4][0]  a[4][1]  a[4][2] ]
+ * All six measurements contribute to both, see accel_calibration_solve().
  *
- * x = A^-1 * b
+ * ===== Measurement =====
  *
- * accel_T = A^-1 * g
- * g = 9.80665
+ * All accelerometer instances are read at the full sensor rate from their
+ * device nodes. Rest is detected on the primary accelerometer from the
+ * variance over short windows, and the windows of all sensors taken at rest
+ * are accumulated until the orientation is complete, so the user only has
+ * to turn the vehicle and hold it still.
  *
  * ===== Rotation =====
  *
@@ -121,8 +107,10 @@
  * @author Anton Babushkin <anton.babushkin@me.com>
  */
 
+
 #include "accelerometer_calibration.h"
 #include "calibration_messages.h"
+#include "calibration_routines.h"
 #include "commander_helper.h"
 
 #include <unistd.h>
@@ -134,7 +122,6 @@
 #include <mathlib/mathlib.h>
 #include <string.h>
 #include <drivers/drv_hrt.h>
-#include <uORB/topics/sensor_combined.h>
 #include <drivers/drv_accel.h>
 #include <geo/geo.h>
 #include <conversion/rotation.h>
@@ -150,11 +137,23 @@ static const int ERROR = -1;
 
 static const char *sensor_name = "accel";
 
-int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float accel_T[3][3]);
-int detect_orientation(int mavlink_fd, int sub_sensor_combined);
-int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[3], int samples_num);
-int mat_invert3(float src[3][3], float dst[3][3]);
-int calculate_calibration_values(float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g);
+/* rest detection on the primary accelerometer: 0.25 m/s^2 standard deviation over 250 ms windows */
+static const unsigned still_window_us = 250000;
+static const float still_threshold = 0.25f * 0.25f;
+
+/* windows at rest before collecting, and windows collected per orientation */
+static const unsigned settle_windows = 2;
+static const unsigned collect_windows = 6;
+
+/* abort if no orientation was completed for 30 s */
+static const hrt_abstime orientation_timeout = 30000000;
+
+/* driver queue depth while calibrating, enough to not lose samples between polls */
+static const unsigned queue_depth = 20;
+
+int do_accel_calibration_measurements(int mavlink_fd, const int fds[], unsigned count,
+				      const math::Matrix<3, 3> &board_rotation, float accel_ref[][6][3]);
+int detect_orientation(const float accel[3]);
 
 int do_accel_calibration(int mavlink_fd)
 {
@@ -171,32 +170,73 @@ int do_accel_calibration(int mavlink_fd)
 
 	int res = OK;
 
-	/* reset all offsets to zero and all scales to one */
-	int fd = open(ACCEL_DEVICE_PATH, 0);
-	res = ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale);
-	close(fd);
+	/* open all instances, reset all offsets to zero and all scales to one */
+	int fds[CALIBRATION_MAX_SENSORS];
+	int queue_depths[CALIBRATION_MAX_SENSORS];
+	unsigned count = 0;
+
+	for (unsigned s = 0; s < CALIBRATION_MAX_SENSORS; s++) {
+		char path[20];
+
+		if (s == 0) {
+			snprintf(path, sizeof(path), "%s", ACCEL_DEVICE_PATH);
+
+		} else {
+			snprintf(path, sizeof(path), "%s%u", ACCEL_DEVICE_PATH, s);
+		}
 
-	if (res != OK) {
-		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
+		int fd = open(path, O_RDONLY);
+
+		/* instances are numbered without gaps */
+		if (fd < 0) {
+			break;
+		}
+
+		if (ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale) != OK) {
+			mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
+			close(fd);
+			res = ERROR;
+			break;
+		}
+
+		queue_depths[count] = ioctl(fd, SENSORIOCGQUEUEDEPTH, 0);
+		ioctl(fd, SENSORIOCSQUEUEDEPTH, queue_depth);
+		fds[count++] = fd;
+	}
+
+	if (res == OK && count == 0) {
+		mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+		res = ERROR;
 	}
 
-	float accel_offs[3];
-	float accel_T[3][3];
+	/* measurements are in the body frame, rotated by the board rotation */
+	param_t board_rotation_h = param_find("SENS_BOARD_ROT");
+	int32_t board_rotation_int;
+	param_get(board_rotation_h, &(board_rotation_int));
+	enum Rotation board_rotation_id = (enum Rotation)board_rotation_int;
+	math::Matrix<3, 3> board_rotation;
+	get_rot_matrix(board_rotation_id, &board_rotation);
+	math::Matrix<3, 3> board_rotation_t = board_rotation.transposed();
+
+	float accel_ref[CALIBRATION_MAX_SENSORS][6][3];
 
 	if (res == OK) {
-		/* measure and calculate offsets & scales */
-		res = do_accel_calibration_measurements(mavlink_fd, accel_offs, accel_T);
+		mavlink_log_info(mavlink_fd, "calibrating %u accelerometer%s", count, (count > 1) ? "s" : "");
+		res = do_accel_calibration_measurements(mavlink_fd, fds, count, board_rotation, accel_ref);
 	}
 
-	if (res == OK) {
-		/* measurements completed successfully, rotate calibration values */
-		param_t board_rotation_h = param_find("SENS_BOARD_ROT");
-		int32_t board_rotation_int;
-		param_get(board_rotation_h, &(board_rotation_int));
-		enum Rotation board_rotation_id = (enum Rotation)board_rotation_int;
-		math::Matrix<3, 3> board_rotation;
-		get_rot_matrix(board_rotation_id, &board_rotation);
-		math::Matrix<3, 3> board_rotation_t = board_rotation.transposed();
+	for (unsigned s = 0; s < count && res == OK; s++) {
+		/* calculate offsets and transform matrix, all sensors from the same orientations */
+		float accel_offs[3];
+		float accel_T[3][3];
+
+		if (accel_calibration_solve(accel_ref[s], accel_T, accel_offs, CONSTANTS_ONE_G) != OK) {
+			mavlink_log_critical(mavlink_fd, "ERROR: calibration values calculation error");
+			res = ERROR;
+			break;
+		}
+
+		/* rotate calibration values back to the sensor frame */
 		math::Vector<3> accel_offs_vec(&accel_offs[0]);
 		math::Vector<3> accel_offs_rotated = board_rotation_t *accel_offs_vec;
 		math::Matrix<3, 3> accel_T_mat(&accel_T[0][0]);
@@ -209,29 +249,48 @@ int do_accel_calibration(int mavlink_fd)
 		accel_scale.z_offset = accel_offs_rotated(2);
 		accel_scale.z_scale = accel_T_rotated(2, 2);
 
-		/* set parameters */
-		if (param_set(param_find("SENS_ACC_XOFF"), &(accel_scale.x_offset))
-		    || param_set(param_find("SENS_ACC_YOFF"), &(accel_scale.y_offset))
-		    || param_set(param_find("SENS_ACC_ZOFF"), &(accel_scale.z_offset))
-		    || param_set(param_find("SENS_ACC_XSCALE"), &(accel_scale.x_scale))
-		    || param_set(param_find("SENS_ACC_YSCALE"), &(accel_scale.y_scale))
-		    || param_set(param_find("SENS_ACC_ZSCALE"), &(accel_scale.z_scale))) {
-			mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
-			res = ERROR;
+		/* set parameters, SENS_ACC_* for the primary and SENS_ACC<n>_* for further instances */
+		const float values[6] = {
+			accel_scale.x_offset, accel_scale.y_offset, accel_scale.z_offset,
+			accel_scale.x_scale, accel_scale.y_scale, accel_scale.z_scale
+		};
+		const char *names[6] = { "XOFF", "YOFF", "ZOFF", "XSCALE", "YSCALE", "ZSCALE" };
+
+		for (unsigned i = 0; i < 6; i++) {
+			char name[20];
+
+			if (s == 0) {
+				snprintf(name, sizeof(name), "SENS_ACC_%s", names[i]);
+
+			} else {
+				snprintf(name, sizeof(name), "SENS_ACC%u_%s", s, names[i]);
+			}
+
+			if (param_set(param_find(name), &values[i])) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
+				res = ERROR;
+				break;
+			}
 		}
-	}
 
-	if (res == OK) {
-		/* apply new scaling and offsets */
-		int fd = open(ACCEL_DEVICE_PATH, 0);
-		res = ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale);
-		close(fd);
+		if (res == OK) {
+			/* apply new scaling and offsets */
+			res = ioctl(fds[s], ACCELIOCSSCALE, (long unsigned int)&accel_scale);
 
-		if (res != OK) {
-			mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+			if (res != OK) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+			}
 		}
 	}
 
+	for (unsigned s = 0; s < count; s++) {
+		if (queue_depths[s] > 0) {
+			ioctl(fds[s], SENSORIOCSQUEUEDEPTH, queue_depths[s]);
+		}
+
+		close(fds[s]);
+	}
+
 	if (res == OK) {
 		/* auto-save to EEPROM */
 		res = param_save_default();
@@ -251,328 +310,225 @@ int do_accel_calibration(int mavlink_fd)
 	return res;
 }
 
-int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float accel_T[3][3])
+/*
+ * Collect the mean acceleration of all sensors in the six orientations.
+ *
+ * Reports are read in bulk from the device queues. The primary sensor
+ * decides when the vehicle is at rest and in which orientation; the
+ * samples of all sensors in a window at rest are then added to that
+ * orientation, and the orientation is complete after collect_windows.
+ */
+int do_accel_calibration_measurements(int mavlink_fd, const int fds[], unsigned count,
+				      const math::Matrix<3, 3> &board_rotation, float accel_ref[][6][3])
 {
-	const int samples_num = 2500;
-	float accel_ref[6][3];
-	bool data_collected[6] = { false, false, false, false, false, false };
 	const char *orientation_strs[6] = { "x+", "x-", "y+", "y-", "z+", "z-" };
-
-	int sensor_combined_sub = orb_subscribe(ORB_ID(sensor_combined));
-
+	bool data_collected[6] = { false, false, false, false, false, false };
 	unsigned done_count = 0;
-	int res = OK;
 
-	while (true) {
-		bool done = true;
-		unsigned old_done_count = done_count;
-		done_count = 0;
+	struct still_detector_s detector;
+	still_detector_init(&detector, still_window_us, still_threshold);
 
-		for (int i = 0; i < 6; i++) {
-			if (data_collected[i]) {
-				done_count++;
+	/* samples of the current window, and the windows at rest of the current orientation */
+	struct calibration_stats_s window[CALIBRATION_MAX_SENSORS];
+	struct calibration_stats_s orient_stats[CALIBRATION_MAX_SENSORS];
 
-			} else {
-				done = false;
-			}
-		}
+	for (unsigned s = 0; s < count; s++) {
+		calibration_stats_reset(&window[s]);
+		calibration_stats_reset(&orient_stats[s]);
+	}
 
-		if (old_done_count != done_count) {
-			mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 17 * done_count);
-		}
+	/* orientation being collected, and the last one reported as done or invalid */
+	int orient = -1;
+	int orient_reported = -2;
+	unsigned collected = 0;
+	bool resting = false;
 
-		if (done) {
-			break;
-		}
+	struct pollfd pfds[CALIBRATION_MAX_SENSORS];
 
-		mavlink_log_info(mavlink_fd, "directions left: %s%s%s%s%s%s",
-				 (!data_collected[0]) ? "x+ " : "",
-				 (!data_collected[1]) ? "x- " : "",
-				 (!data_collected[2]) ? "y+ " : "",
-				 (!data_collected[3]) ? "y- " : "",
-				 (!data_collected[4]) ? "z+ " : "",
-				 (!data_collected[5]) ? "z- " : "");
+	for (unsigned s = 0; s < count; s++) {
+		pfds[s].fd = fds[s];
+		pfds[s].events = POLLIN;
+	}
 
-		int orient = detect_orientation(mavlink_fd, sensor_combined_sub);
+	hrt_abstime t_timeout = hrt_absolute_time() + orientation_timeout;
+	unsigned poll_errcount = 0;
+	int res = OK;
 
-		if (orient < 0) {
+	mavlink_log_info(mavlink_fd, "directions left: x+ x- y+ y- z+ z-");
+
+	while (done_count < 6) {
+		if (hrt_absolute_time() > t_timeout) {
+			mavlink_log_critical(mavlink_fd, "ERROR: no orientation completed in time");
 			res = ERROR;
 			break;
 		}
 
-		if (data_collected[orient]) {
-			mavlink_log_info(mavlink_fd, "%s done, rotate to a different axis", orientation_strs[orient]);
-			continue;
-		}
-
-		mavlink_log_info(mavlink_fd, "accel measurement started: %s axis", orientation_strs[orient]);
-		read_accelerometer_avg(sensor_combined_sub, &(accel_ref[orient][0]), samples_num);
-		mavlink_log_info(mavlink_fd, "result for %s axis: [ %.2f %.2f %.2f ]", orientation_strs[orient],
-				 (double)accel_ref[orient][0],
-				 (double)accel_ref[orient][1],
-				 (double)accel_ref[orient][2]);
-
-		data_collected[orient] = true;
-		tune_neutral(true);
-	}
+		int poll_ret = poll(pfds, count, 1000);
 
-	close(sensor_combined_sub);
-
-	if (res == OK) {
-		/* calculate offsets and transform matrix */
-		res = calculate_calibration_values(accel_ref, accel_T, accel_offs, CONSTANTS_ONE_G);
+		if (poll_ret <= 0) {
+			if (++poll_errcount > 10) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+				res = ERROR;
+				break;
+			}
 
-		if (res != OK) {
-			mavlink_log_info(mavlink_fd, "ERROR: calibration values calculation error");
+			continue;
 		}
-	}
 
-	return res;
-}
+		/*
+		 * Drain the further sensors before the primary, so that their windows
+		 * hold the samples up to the primary's when its window completes.
+		 */
+		for (unsigned n = 0; n < count; n++) {
+			unsigned s = (n + 1) % count;
+			struct accel_report reports[4];
+			ssize_t ret;
 
-/*
- * Wait for vehicle become still and detect it's orientation.
- *
- * @return 0..5 according to orientation when vehicle is still and ready for measurements,
- * ERROR if vehicle is not still after 30s or orientation error is more than 5m/s^2
- */
-int detect_orientation(int mavlink_fd, int sub_sensor_combined)
-{
-	struct sensor_combined_s sensor;
-	/* exponential moving average of accel */
-	float accel_ema[3] = { 0.0f, 0.0f, 0.0f };
-	/* max-hold dispersion of accel */
-	float accel_disp[3] = { 0.0f, 0.0f, 0.0f };
-	/* EMA time constant in seconds*/
-	float ema_len = 0.5f;
-	/* set "still" threshold to 0.25 m/s^2 */
-	float still_thr2 = pow(0.25f, 2);
-	/* set accel error threshold to 5m/s^2 */
-	float accel_err_thr = 5.0f;
-	/* still time required in us */
-	hrt_abstime still_time = 2000000;
-	struct pollfd fds[1];
-	fds[0].fd = sub_sensor_combined;
-	fds[0].events = POLLIN;
-
-	hrt_abstime t_start = hrt_absolute_time();
-	/* set timeout to 30s */
-	hrt_abstime timeout = 30000000;
-	hrt_abstime t_timeout = t_start + timeout;
-	hrt_abstime t = t_start;
-	hrt_abstime t_prev = t_start;
-	hrt_abstime t_still = 0;
+			do {
+				ret = read(fds[s], reports, sizeof(reports));
+				unsigned num = (ret > 0) ? ret / sizeof(reports[0]) : 0;
 
-	unsigned poll_errcount = 0;
+				for (unsigned i = 0; i < num; i++) {
+					calibration_stats_add(&window[s], reports[i].x, reports[i].y, reports[i].z);
 
-	while (true) {
-		/* wait blocking for new data */
-		int poll_ret = poll(fds, 1, 1000);
-
-		if (poll_ret) {
-			orb_copy(ORB_ID(sensor_combined), sub_sensor_combined, &sensor);
-			t = hrt_absolute_time();
-			float dt = (t - t_prev) / 1000000.0f;
-			t_prev = t;
-			float w = dt / ema_len;
-
-			for (int i = 0; i < 3; i++) {
-				float d = sensor.accelerometer_m_s2[i] - accel_ema[i];
-				accel_ema[i] += d * w;
-				d = d * d;
-				accel_disp[i] = accel_disp[i] * (1.0f - w);
-
-				if (d > still_thr2 * 8.0f) {
-					d = still_thr2 * 8.0f;
-				}
+					if (s != 0) {
+						continue;
+					}
 
-				if (d > accel_disp[i]) {
-					accel_disp[i] = d;
-				}
-			}
+					math::Vector<3> accel_body = board_rotation * math::Vector<3>(reports[i].x, reports[i].y, reports[i].z);
+					int still = still_detector_add(&detector, reports[i].timestamp, accel_body(0), accel_body(1), accel_body(2));
 
-			/* still detector with hysteresis */
-			if (accel_disp[0] < still_thr2 &&
-			    accel_disp[1] < still_thr2 &&
-			    accel_disp[2] < still_thr2) {
-				/* is still now */
-				if (t_still == 0) {
-					/* first time */
-					mavlink_log_info(mavlink_fd, "detected rest position, waiting...");
-					t_still = t;
-					t_timeout = t + timeout;
-
-				} else {
-					/* still since t_still */
-					if (t > t_still + still_time) {
-						/* vehicle is still, exit from the loop to detection of its orientation */
-						break;
+					if (still == 0) {
+						continue;
 					}
-				}
 
-			} else if (accel_disp[0] > still_thr2 * 4.0f ||
-				   accel_disp[1] > still_thr2 * 4.0f ||
-				   accel_disp[2] > still_thr2 * 4.0f) {
-				/* not still, reset still start time */
-				if (t_still != 0) {
-					mavlink_log_info(mavlink_fd, "detected motion, hold still...");
-					t_still = 0;
-				}
-			}
-
-		} else if (poll_ret == 0) {
-			poll_errcount++;
-		}
+					if (still == STILL_DETECTOR_UNDECIDED) {
+						/* still at rest, but too noisy to average, drop the window */
+
+					} else if (still < 0) {
+						if (resting) {
+							mavlink_log_info(mavlink_fd, "detected motion, hold still...");
+							resting = false;
+						}
+
+						orient = -1;
+						orient_reported = -2;
+						collected = 0;
+
+						for (unsigned k = 0; k < count; k++) {
+							calibration_stats_reset(&orient_stats[k]);
+						}
+
+					} else if (!resting) {
+						mavlink_log_info(mavlink_fd, "detected rest position, hold still...");
+						resting = true;
+
+					} else if ((unsigned)still > settle_windows) {
+						if (orient < 0) {
+							int o = detect_orientation(detector.mean);
+
+							if (o < 0 || data_collected[o]) {
+								if (o != orient_reported) {
+									if (o < 0) {
+										mavlink_log_info(mavlink_fd, "invalid orientation, rotate to an axis");
+
+									} else {
+										mavlink_log_info(mavlink_fd, "%s done, rotate to a different axis", orientation_strs[o]);
+									}
+
+									orient_reported = o;
+								}
+
+							} else {
+								orient = o;
+								mavlink_log_info(mavlink_fd, "accel measurement started: %s axis", orientation_strs[o]);
+							}
+						}
+
+						if (orient >= 0) {
+							for (unsigned k = 0; k < count; k++) {
+								calibration_stats_merge(&orient_stats[k], &window[k]);
+							}
+
+							collected++;
+						}
+
+						if (orient >= 0 && collected >= collect_windows) {
+							for (unsigned k = 0; k < count; k++) {
+								math::Vector<3> mean = board_rotation * math::Vector<3>(orient_stats[k].mean);
+
+								for (unsigned j = 0; j < 3; j++) {
+									accel_ref[k][orient][j] = mean(j);
+								}
+
+								calibration_stats_reset(&orient_stats[k]);
+							}
+
+							mavlink_log_info(mavlink_fd, "result for %s axis: [ %.2f %.2f %.2f ]", orientation_strs[orient],
+									 (double)accel_ref[0][orient][0],
+									 (double)accel_ref[0][orient][1],
+									 (double)accel_ref[0][orient][2]);
+
+							data_collected[orient] = true;
+							done_count++;
+							orient_reported = orient;
+							orient = -1;
+							collected = 0;
+							t_timeout = hrt_absolute_time() + orientation_timeout;
+
+							mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 17 * done_count);
+							mavlink_log_info(mavlink_fd, "directions left: %s%s%s%s%s%s",
+									 (!data_collected[0]) ? "x+ " : "",
+									 (!data_collected[1]) ? "x- " : "",
+									 (!data_collected[2]) ? "y+ " : "",
+									 (!data_collected[3]) ? "y- " : "",
+									 (!data_collected[4]) ? "z+ " : "",
+									 (!data_collected[5]) ? "z- " : "");
+							tune_neutral(true);
+						}
+					}
 
-		if (t > t_timeout) {
-			poll_errcount++;
-		}
+					/* a new window starts for all sensors */
+					for (unsigned k = 0; k < count; k++) {
+						calibration_stats_reset(&window[k]);
+					}
+				}
 
-		if (poll_errcount > 1000) {
-			mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
-			return ERROR;
+			} while (ret == sizeof(reports));
 		}
 	}
 
-	if (fabsf(accel_ema[0] - CONSTANTS_ONE_G) < accel_err_thr &&
-	    fabsf(accel_ema[1]) < accel_err_thr &&
-	    fabsf(accel_ema[2]) < accel_err_thr) {
-		return 0;        // [ g, 0, 0 ]
-	}
-
-	if (fabsf(accel_ema[0] + CONSTANTS_ONE_G) < accel_err_thr &&
-	    fabsf(accel_ema[1]) < accel_err_thr &&
-	    fabsf(accel_ema[2]) < accel_err_thr) {
-		return 1;        // [ -g, 0, 0 ]
-	}
-
-	if (fabsf(accel_ema[0]) < accel_err_thr &&
-	    fabsf(accel_ema[1] - CONSTANTS_ONE_G) < accel_err_thr &&
-	    fabsf(accel_ema[2]) < accel_err_thr) {
-		return 2;        // [ 0, g, 0 ]
-	}
-
-	if (fabsf(accel_ema[0]) < accel_err_thr &&
-	    fabsf(accel_ema[1] + CONSTANTS_ONE_G) < accel_err_thr &&
-	    fabsf(accel_ema[2]) < accel_err_thr) {
-		return 3;        // [ 0, -g, 0 ]
-	}
-
-	if (fabsf(accel_ema[0]) < accel_err_thr &&
-	    fabsf(accel_ema[1]) < accel_err_thr &&
-	    fabsf(accel_ema[2] - CONSTANTS_ONE_G) < accel_err_thr) {
-		return 4;        // [ 0, 0, g ]
-	}
-
-	if (fabsf(accel_ema[0]) < accel_err_thr &&
-	    fabsf(accel_ema[1]) < accel_err_thr &&
-	    fabsf(accel_ema[2] + CONSTANTS_ONE_G) < accel_err_thr) {
-		return 5;        // [ 0, 0, -g ]
-	}
-
-	mavlink_log_critical(mavlink_fd, "ERROR: invalid orientation");
-
-	return ERROR;	// Can't detect orientation
+	return res;
 }
 
 /*
- * Read specified number of accelerometer samples, calculate average and dispersion.
+ * Detect the orientation from the mean acceleration at rest, in the body frame.
+ *
+ * @return 0..5 according to orientation, ERROR if the acceleration is more
+ * than 5 m/s^2 from all of them
  */
-int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[3], int samples_num)
+int detect_orientation(const float accel[3])
 {
-	struct pollfd fds[1];
-	fds[0].fd = sensor_combined_sub;
-	fds[0].events = POLLIN;
-	int count = 0;
-	float accel_sum[3] = { 0.0f, 0.0f, 0.0f };
-
-	int errcount = 0;
+	/* set accel error threshold to 5m/s^2 */
+	const float accel_err_thr = 5.0f;
 
-	while (count < samples_num) {
-		int poll_ret = poll(fds, 1, 1000);
+	for (int i = 0; i < 6; i++) {
+		int axis = i / 2;
+		float g = (i % 2 == 0) ? CONSTANTS_ONE_G : -CONSTANTS_ONE_G;
+		bool match = true;
 
-		if (poll_ret == 1) {
-			struct sensor_combined_s sensor;
-			orb_copy(ORB_ID(sensor_combined), sensor_combined_sub, &sensor);
+		for (int j = 0; j < 3; j++) {
+			float expected = (j == axis) ? g : 0.0f;
 
-			for (int i = 0; i < 3; i++) {
-				accel_sum[i] += sensor.accelerometer_m_s2[i];
+			if (fabsf(accel[j] - expected) >= accel_err_thr) {
+				match = false;
 			}
-
-			count++;
-
-		} else {
-			errcount++;
-			continue;
-		}
-
-		if (errcount > samples_num / 10) {
-			return ERROR;
-		}
-	}
-
-	for (int i = 0; i < 3; i++) {
-		accel_avg[i] = accel_sum[i] / count;
-	}
-
-	return OK;
-}
-
-int mat_invert3(float src[3][3], float dst[3][3])
-{
-	float det = src[0][0] * (src[1][1] * src[2][2] - src[1][2] * src[2][1]) -
-		    src[0][1] * (src[1][0] * src[2][2] - src[1][2] * src[2][0]) +
-		    src[0][2] * (src[1][0] * src[2][1] - src[1][1] * src[2][0]);
-
-	if (det == 0.0f) {
-		return ERROR;        // Singular matrix
-	}
-
-	dst[0][0] = (src[1][1] * src[2][2] - src[1][2] * src[2][1]) / det;
-	dst[1][0] = (src[1][2] * src[2][0] - src[1][0] * src[2][2]) / det;
-	dst[2][0] = (src[1][0] * src[2][1] - src[1][1] * src[2][0]) / det;
-	dst[0][1] = (src[0][2] * src[2][1] - src[0][1] * src[2][2]) / det;
-	dst[1][1] = (src[0][0] * src[2][2] - src[0][2] * src[2][0]) / det;
-	dst[2][1] = (src[0][1] * src[2][0] - src[0][0] * src[2][1]) / det;
-	dst[0][2] = (src[0][1] * src[1][2] - src[0][2] * src[1][1]) / det;
-	dst[1][2] = (src[0][2] * src[1][0] - src[0][0] * src[1][2]) / det;
-	dst[2][2] = (src[0][0] * src[1][1] - src[0][1] * src[1][0]) / det;
-
-	return OK;
-}
-
-int calculate_calibration_values(float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g)
-{
-	/* calculate offsets */
-	for (int i = 0; i < 3; i++) {
-		accel_offs[i] = (accel_ref[i * 2][i] + accel_ref[i * 2 + 1][i]) / 2;
-	}
-
-	/* fill matrix A for linear equations system*/
-	float mat_A[3][3];
-	memset(mat_A, 0, sizeof(mat_A));
-
-	for (int i = 0; i < 3; i++) {
-		for (int j = 0; j < 3; j++) {
-			float a = accel_ref[i * 2][j] - accel_offs[j];
-			mat_A[i][j] = a;
 		}
-	}
-
-	/* calculate inverse matrix for A */
-	float mat_A_inv[3][3];
 
-	if (mat_invert3(mat_A, mat_A_inv) != OK) {
-		return ERROR;
-	}
-
-	/* copy results to accel_T */
-	for (int i = 0; i < 3; i++) {
-		for (int j = 0; j < 3; j++) {
-			/* simplify matrices mult because b has only one non-zero element == g at index i */
-			accel_T[j][i] = mat_A_inv[j][i] * g;
+		if (match) {
+			return i;
 		}
 	}
 
-	return OK;
+	return ERROR;	// Can't detect orientation
 }
@@ -40,6 +40,7 @@
  */
 
 #include <math.h>
+#include <string.h>
 
 #include "calibration_routines.h"
 
@@ -218,3 +219,389 @@ int sphere_fit_least_squares(const float x[], const float y[], const float z[],
 	return 0;
 }
 
+/**
+ * Solve a symmetric positive definite system by Cholesky decomposition.
+ *
+ * @param a	n x n matrix, row major, overwritten by the decomposition
+ * @param b	right hand side, overwritten by the solution
+ * @param n	dimension
+ *
+ * @return 0 on success, 1 if the matrix is not (numerically) positive definite
+ */
+static int cholesky_solve(double *a, double *b, unsigned n)
+{
+	for (unsigned j = 0; j < n; j++) {
+		double d = a[j * n + j];
+
+		for (unsigned k = 0; k < j; k++) {
+			d -= a[j * n + k] * a[j * n + k];
+		}
+
+		/* reject pivots lost in rounding, the system is then not determined */
+		if (!(d > a[j * n + j] * 1e-12)) {
+			return 1;
+		}
+
+		a[j * n + j] = sqrt(d);
+
+		for (unsigned i = j + 1; i < n; i++) {
+			double s = a[i * n + j];
+
+			for (unsigned k = 0; k < j; k++) {
+				s -= a[i * n + k] * a[j * n + k];
+			}
+
+			a[i * n + j] = s / a[j * n + j];
+		}
+	}
+
+	/* L y = b */
+	for (unsigned i = 0; i < n; i++) {
+		for (unsigned k = 0; k < i; k++) {
+			b[i] -= a[i * n + k] * b[k];
+		}
+
+		b[i] /= a[i * n + i];
+	}
+
+	/* L^T x = y */
+	for (unsigned i = n; i-- > 0;) {
+		for (unsigned k = i + 1; k < n; k++) {
+			b[i] -= a[k * n + i] * b[k];
+		}
+
+		b[i] /= a[i * n + i];
+	}
+
+	return 0;
+}
+
+void ellipsoid_fit_init(struct ellipsoid_fit_s *fit)
+{
+	memset(fit, 0, sizeof(*fit));
+}
+
+void ellipsoid_fit_add(struct ellipsoid_fit_s *fit, float x, float y, float z)
+{
+	const double j[9] = { (double)x * x, (double)y * y, (double)z * z,
+			      (double)x * y, (double)x * z, (double)y * z,
+			      x, y, z
+			    };
+
+	for (unsigned r = 0; r < 9; r++) {
+		for (unsigned c = r; c < 9; c++) {
+			fit->ata[r][c] += j[r] * j[c];
+		}
+
+		fit->atb[r] += j[r];
+	}
+
+	const float p[3] = { x, y, z };
+
+	for (unsigned i = 0; i < 3; i++) {
+		if (fit->count == 0 || p[i] < fit->min[i]) {
+			fit->min[i] = p[i];
+		}
+
+		if (fit->count == 0 || p[i] > fit->max[i]) {
+			fit->max[i] = p[i];
+		}
+	}
+
+	fit->count++;
+
+	/* classify the direction from the center, the middle of the range until a fit is known */
+	float d[3];
+	unsigned axis = 0;
+
+	for (unsigned i = 0; i < 3; i++) {
+		float center = fit->center_valid ? fit->center[i] : 0.5f * (fit->min[i] + fit->max[i]);
+		d[i] = p[i] - center;
+
+		if (fabsf(d[i]) > fabsf(d[axis])) {
+			axis = i;
+		}
+	}
+
+	if (d[axis] != 0.0f) {
+		unsigned octant = (d[0] > 0.0f ? 1 : 0) | (d[1] > 0.0f ? 2 : 0) | (d[2] > 0.0f ? 4 : 0);
+		fit->sectors |= 1u << (octant * 3 + axis);
+	}
+}
+
+unsigned ellipsoid_fit_coverage(const struct ellipsoid_fit_s *fit)
+{
+	unsigned n = 0;
+
+	for (uint32_t s = fit->sectors; s != 0; s &= s - 1) {
+		n++;
+	}
+
+	return n;
+}
+
+int ellipsoid_fit_solve(struct ellipsoid_fit_s *fit, bool sphere, float center[3], float scale[3],
+			float *radius, float *residual)
+{
+	const double (*ata)[9] = fit->ata;
+	const double *atb = fit->atb;
+	const double n = fit->count;
+
+	if (fit->count < 9) {
+		return 1;
+	}
+
+	double c[3];
+	double r[3];
+	double rss;
+	double norm;
+
+	if (!sphere) {
+		/* a v = b with the full normal matrix */
+		double v[9];
+
+		for (unsigned i = 0; i < 9; i++) {
+			for (unsigned k = 0; k < 9; k++) {
+				fit->chol[i][k] = (i <= k) ? ata[i][k] : ata[k][i];
+			}
+
+			v[i] = atb[i];
+		}
+
+		if (cholesky_solve(&fit->chol[0][0], v, 9) != 0) {
+			return 1;
+		}
+
+		/* p^T M p + 2 g^T p = 1 */
+		double m[3][3] = {
+			{ v[0],        0.5 * v[3], 0.5 * v[4] },
+			{ 0.5 * v[3], v[1],        0.5 * v[5] },
+			{ 0.5 * v[4], 0.5 * v[5], v[2]        }
+		};
+		double mc[3][3];
+		memcpy(mc, m, sizeof(mc));
+
+		for (unsigned i = 0; i < 3; i++) {
+			c[i] = -0.5 * v[6 + i];
+		}
+
+		/* center c = -M^-1 g, M must be positive definite for an ellipsoid */
+		if (cholesky_solve(&mc[0][0], c, 3) != 0) {
+			return 1;
+		}
+
+		/* (p - c)^T M (p - c) = k */
+		double k = 1.0;
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned l = 0; l < 3; l++) {
+				k += c[i] * m[i][l] * c[l];
+			}
+		}
+
+		for (unsigned i = 0; i < 3; i++) {
+			r[i] = sqrt(k / m[i][i]);
+		}
+
+		/* a v = b, so the residual sum of squares is n - v^T b */
+		rss = n;
+
+		for (unsigned i = 0; i < 9; i++) {
+			rss -= v[i] * atb[i];
+		}
+
+		/* the quadric is off by about 2 k dr / r at a radial error dr */
+		norm = 2.0 * k;
+
+	} else {
+		/* |p|^2 = 2 c^T p + q, from the sums of the quadric terms */
+		double u[4];
+		double (*a)[4] = reinterpret_cast<double (*)[4]>(&fit->chol[0][0]);
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned l = 0; l < 3; l++) {
+				a[i][l] = 4.0 * ((i <= l) ? ata[6 + i][6 + l] : ata[6 + l][6 + i]);
+			}
+
+			a[i][3] = a[3][i] = 2.0 * atb[6 + i];
+			u[i] = 2.0 * (ata[0][6 + i] + ata[1][6 + i] + ata[2][6 + i]);
+		}
+
+		a[3][3] = n;
+		u[3] = atb[0] + atb[1] + atb[2];
+
+		double uw[4];
+		memcpy(uw, u, sizeof(uw));
+
+		if (cholesky_solve(&a[0][0], u, 4) != 0) {
+			return 1;
+		}
+
+		double rsq = u[3];
+
+		for (unsigned i = 0; i < 3; i++) {
+			c[i] = u[i];
+			rsq += u[i] * u[i];
+		}
+
+		if (!(rsq > 0.0)) {
+			return 1;
+		}
+
+		r[0] = r[1] = r[2] = sqrt(rsq);
+
+		/* sum of |p|^4 minus the fitted part */
+		rss = ata[0][0] + ata[1][1] + ata[2][2] + 2.0 * (ata[0][1] + ata[0][2] + ata[1][2]);
+
+		for (unsigned i = 0; i < 4; i++) {
+			rss -= u[i] * uw[i];
+		}
+
+		/* |p|^2 is off by about 2 r^2 dr / r at a radial error dr */
+		norm = 2.0 * rsq;
+	}
+
+	/* scale every axis to the geometric mean radius */
+	double mean_radius = pow(r[0] * r[1] * r[2], 1.0 / 3.0);
+
+	for (unsigned i = 0; i < 3; i++) {
+		center[i] = c[i];
+		scale[i] = mean_radius / r[i];
+	}
+
+	*radius = mean_radius;
+	*residual = (rss > 0.0) ? sqrt(rss / n) / norm : 0.0f;
+
+	if (!isfinite(center[0]) || !isfinite(center[1]) || !isfinite(center[2]) || !isfinite(*radius)) {
+		return 1;
+	}
+
+	memcpy(fit->center, center, sizeof(fit->center));
+	fit->center_valid = true;
+
+	return 0;
+}
+
+void calibration_stats_reset(struct calibration_stats_s *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+
+void calibration_stats_add(struct calibration_stats_s *stats, float x, float y, float z)
+{
+	const float v[3] = { x, y, z };
+
+	stats->count++;
+
+	for (unsigned i = 0; i < 3; i++) {
+		float d = v[i] - stats->mean[i];
+		stats->mean[i] += d / stats->count;
+		stats->m2[i] += d * (v[i] - stats->mean[i]);
+	}
+}
+
+void calibration_stats_merge(struct calibration_stats_s *stats, const struct calibration_stats_s *other)
+{
+	if (other->count == 0) {
+		return;
+	}
+
+	unsigned count = stats->count + other->count;
+	float w = (float)other->count / count;
+
+	for (unsigned i = 0; i < 3; i++) {
+		float d = other->mean[i] - stats->mean[i];
+		stats->mean[i] += d * w;
+		stats->m2[i] += other->m2[i] + d * d * stats->count * w;
+	}
+
+	stats->count = count;
+}
+
+float calibration_stats_variance(const struct calibration_stats_s *stats)
+{
+	if (stats->count < 2) {
+		return 0.0f;
+	}
+
+	float m2 = fmaxf(stats->m2[0], fmaxf(stats->m2[1], stats->m2[2]));
+	return m2 / (stats->count - 1);
+}
+
+void still_detector_init(struct still_detector_s *det, unsigned window_us, float threshold)
+{
+	memset(det, 0, sizeof(*det));
+	det->window_us = window_us;
+	det->threshold = threshold;
+}
+
+int still_detector_add(struct still_detector_s *det, uint64_t timestamp, float x, float y, float z)
+{
+	if (det->window.count == 0) {
+		det->window_start = timestamp;
+	}
+
+	calibration_stats_add(&det->window, x, y, z);
+
+	if (timestamp - det->window_start < det->window_us) {
+		return 0;
+	}
+
+	float var = calibration_stats_variance(&det->window);
+	memcpy(det->mean, det->window.mean, sizeof(det->mean));
+	calibration_stats_reset(&det->window);
+
+	if (var < det->threshold) {
+		det->still_windows++;
+		return (int)det->still_windows;
+	}
+
+	if (var > det->threshold * 4.0f) {
+		det->still_windows = 0;
+		return -1;
+	}
+
+	/* undecided windows keep the state, but do not count as still */
+	return (det->still_windows > 0) ? STILL_DETECTOR_UNDECIDED : -1;
+}
+
+int accel_calibration_solve(const float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g)
+{
+	/*
+	 * Model: accel_ref[2i] = A e_i + offs, accel_ref[2i+1] = -A e_i + offs
+	 * with A = accel_T^-1 * g, so the half sum of each pair is the offset
+	 * and the half difference is column i of A.
+	 */
+	float a[3][3];
+
+	for (unsigned j = 0; j < 3; j++) {
+		accel_offs[j] = 0.0f;
+
+		for (unsigned i = 0; i < 3; i++) {
+			accel_offs[j] += (accel_ref[i * 2][j] + accel_ref[i * 2 + 1][j]) / 6.0f;
+			a[j][i] = (accel_ref[i * 2][j] - accel_ref[i * 2 + 1][j]) / 2.0f;
+		}
+	}
+
+	float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+		    a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+		    a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+
+	if (!(fabsf(det) > 0.0f) || !isfinite(det)) {
+		return 1;
+	}
+
+	float k = g / det;
+
+	accel_T[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) * k;
+	accel_T[1][0] = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * k;
+	accel_T[2][0] = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * k;
+	accel_T[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * k;
+	accel_T[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * k;
+	accel_T[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * k;
+	accel_T[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * k;
+	accel_T[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * k;
+	accel_T[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * k;
+
+	return 0;
+}
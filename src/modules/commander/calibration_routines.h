@@ -39,6 +39,11 @@
  * @author Lorenz Meier <lm@inf.ethz.ch>
  */
 
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
 /**
  * Least-squares fit of a sphere to a set of points.
  *
@@ -58,4 +63,162 @@
  * @return 0 on success, 1 on failure
  */
 int sphere_fit_least_squares(const float x[], const float y[], const float z[],
-			     unsigned int size, unsigned int max_iterations, float delta, float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius);
\ No newline at end of file
+			     unsigned int size, unsigned int max_iterations, float delta, float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius);
+
+/**
+ * Number of direction sectors tracked for coverage: the eight octants,
+ * each split by the dominant axis.
+ */
+#define ELLIPSOID_FIT_SECTORS	24
+
+/**
+ * Incremental least-squares fit of an ellipsoid to a stream of points.
+ *
+ * Fits the general quadric
+ *   a x^2 + b y^2 + c z^2 + d xy + e xz + f yz + g x + h y + i z = 1
+ * by accumulating its normal equations, so adding a point is O(1) and the
+ * memory does not depend on the number of points. The same sums also
+ * give a sphere fit, used when the ellipsoid is not well determined.
+ */
+struct ellipsoid_fit_s {
+	double		ata[9][9];	/**< normal matrix, upper triangle */
+	double		atb[9];		/**< normal vector */
+	double		chol[9][9];	/**< scratch for the solver */
+	unsigned	count;		/**< points added */
+	float		min[3];		/**< smallest point seen per axis */
+	float		max[3];		/**< largest point seen per axis */
+	float		center[3];	/**< center used to classify directions */
+	bool		center_valid;	/**< center was set from a fit */
+	uint32_t	sectors;	/**< bitmask of the direction sectors seen */
+};
+
+/**
+ * Reset the fit.
+ */
+void ellipsoid_fit_init(struct ellipsoid_fit_s *fit);
+
+/**
+ * Add a point to the fit.
+ */
+void ellipsoid_fit_add(struct ellipsoid_fit_s *fit, float x, float y, float z);
+
+/**
+ * Number of direction sectors, out of ELLIPSOID_FIT_SECTORS, in which
+ * points were seen, relative to the best known center.
+ */
+unsigned ellipsoid_fit_coverage(const struct ellipsoid_fit_s *fit);
+
+/**
+ * Solve the fit for the points added so far.
+ *
+ * The axis scales correct the ellipsoid to a sphere of the returned radius
+ * along the sensor axes, their product is one. The off-axis terms of the
+ * ellipsoid are used for the center but not returned. On success the center
+ * is also used to classify the directions of further points.
+ *
+ * @param fit		fit state
+ * @param sphere	fit a sphere only, the scales are then all one
+ * @param center	ellipsoid center
+ * @param scale		scale per axis
+ * @param radius	mean radius
+ * @param residual	RMS radial error of the points relative to the radius
+ *
+ * @return 0 on success, 1 if the model is not determined by the points
+ */
+int ellipsoid_fit_solve(struct ellipsoid_fit_s *fit, bool sphere, float center[3], float scale[3],
+			float *radius, float *residual);
+
+/**
+ * Maximum number of instances of one sensor type calibrated together,
+ * e.g. /dev/accel and /dev/accel1.
+ */
+#define CALIBRATION_MAX_SENSORS	2
+
+/**
+ * Running mean and variance of a three axis signal.
+ *
+ * Updated per sample with Welford's method, which stays accurate when the
+ * variance is small compared to the mean, as for an accelerometer at rest.
+ */
+struct calibration_stats_s {
+	unsigned	count;		/**< samples added */
+	float		mean[3];	/**< mean per axis */
+	float		m2[3];		/**< sum of squared deviations from the mean per axis */
+};
+
+/**
+ * Reset the statistics.
+ */
+void calibration_stats_reset(struct calibration_stats_s *stats);
+
+/**
+ * Add a sample to the statistics.
+ */
+void calibration_stats_add(struct calibration_stats_s *stats, float x, float y, float z);
+
+/**
+ * Merge the samples of other into stats.
+ */
+void calibration_stats_merge(struct calibration_stats_s *stats, const struct calibration_stats_s *other);
+
+/**
+ * Largest sample variance of the three axes, 0 for less than two samples.
+ */
+float calibration_stats_variance(const struct calibration_stats_s *stats);
+
+/**
+ * Detects rest from the variance over consecutive time windows.
+ *
+ * A window counts as still if the variance of all axes is below the
+ * threshold, and as motion if it is above four times the threshold. In
+ * between, the previous state is kept.
+ */
+struct still_detector_s {
+	struct calibration_stats_s window;	/**< samples of the current window */
+	uint64_t	window_start;		/**< timestamp of the first sample of the window */
+	unsigned	window_us;		/**< window length */
+	float		threshold;		/**< variance threshold */
+	unsigned	still_windows;		/**< consecutive still windows */
+	float		mean[3];		/**< mean of the last complete window */
+};
+
+/**
+ * Reset the detector.
+ *
+ * @param window_us	window length in microseconds
+ * @param threshold	variance threshold
+ */
+void still_detector_init(struct still_detector_s *det, unsigned window_us, float threshold);
+
+/** still_detector_add() result for a window that is neither still nor motion while at rest */
+#define STILL_DETECTOR_UNDECIDED	-2
+
+/**
+ * Add a sample to the detector.
+ *
+ * A window with a variance between the threshold and four times the
+ * threshold keeps the previous state, but is not still: while at rest
+ * it returns STILL_DETECTOR_UNDECIDED and callers must drop its samples.
+ *
+ * @return 0 if the window is not complete, otherwise the number of
+ *	consecutive still windows, STILL_DETECTOR_UNDECIDED, or -1 if
+ *	not at rest.
+ */
+int still_detector_add(struct still_detector_s *det, uint64_t timestamp, float x, float y, float z);
+
+/**
+ * Solve the six position accelerometer calibration.
+ *
+ * The reference measurements are the mean accelerations in the six
+ * orientations x+, x-, y+, y-, z+, z-, in the body frame. Both
+ * measurements of each axis are used, so the offsets and the transform
+ * are each averaged over two orientations.
+ *
+ * @param accel_ref	reference measurements
+ * @param accel_T	transform from offset corrected measurement to acceleration
+ * @param accel_offs	offsets
+ * @param g		gravity
+ *
+ * @return 0 on success, 1 if the measurements are singular
+ */
+int accel_calibration_solve(const float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g);
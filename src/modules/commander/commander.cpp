@@ -60,7 +60,6 @@
 #include <poll.h>
 
 #include <uORB/uORB.h>
-#include <uORB/topics/sensor_combined.h>
 #include <uORB/topics/battery_status.h>
 #include <uORB/topics/manual_control_setpoint.h>
 #include <uORB/topics/offboard_control_setpoint.h>
@@ -198,6 +197,48 @@ void usage(const char *reason);
  */
 bool handle_command(struct vehicle_status_s *status, const struct safety_s *safety, struct vehicle_command_s *cmd, struct actuator_armed_s *armed, struct home_position_s *home, struct vehicle_global_position_s *global_pos, orb_advert_t *home_pub);
 
+/**
+ * Parameters read by the main loop.
+ */
+struct commander_param_handles_s {
+	param_t sys_type;
+	param_t system_id;
+	param_t component_id;
+	param_t takeoff_alt;
+	param_t enable_parachute;
+};
+
+/**
+ * Handle a parameter_update: re-read the system parameters and re-check the RC calibration.
+ *
+ * @return		true if the vehicle status changed
+ */
+bool handle_parameter_update(int param_changed_sub, const struct commander_param_handles_s *h, bool *rc_calibration_ok);
+
+/**
+ * Handle a safety update, disarm if the safety switch was engaged while armed.
+ *
+ * px4io publishes the safety topic with every status poll, so only
+ * changes of the switch state are acted upon.
+ *
+ * @return		true if the safety switch state changed
+ */
+bool handle_safety_update(int safety_sub);
+
+/**
+ * Handle a subsystem_info update, mark the subsystem present / enabled / healthy.
+ *
+ * @return		true if the vehicle status changed
+ */
+bool handle_subsystem_info(int subsys_sub);
+
+/**
+ * Handle a vehicle_command.
+ *
+ * @return		true if the vehicle status changed
+ */
+bool handle_vehicle_command(int cmd_sub, struct home_position_s *home, struct vehicle_global_position_s *global_pos, orb_advert_t *home_pub);
+
 /**
  * Mainloop of commander.
  */
@@ -363,6 +404,8 @@ void print_status()
 
 
 	warnx("arming: %s", armed_str);
+
+	print_state_history();
 }
 
 static orb_advert_t status_pub;
@@ -638,11 +681,12 @@ int commander_thread_main(int argc, char *argv[])
 	bool was_armed = false;
 
 	/* set parameters */
-	param_t _param_sys_type = param_find("MAV_TYPE");
-	param_t _param_system_id = param_find("MAV_SYS_ID");
-	param_t _param_component_id = param_find("MAV_COMP_ID");
-	param_t _param_takeoff_alt = param_find("NAV_TAKEOFF_ALT");
-	param_t _param_enable_parachute = param_find("NAV_PARACHUTE_EN");
+	struct commander_param_handles_s param_handles;
+	param_handles.sys_type = param_find("MAV_TYPE");
+	param_handles.system_id = param_find("MAV_SYS_ID");
+	param_handles.component_id = param_find("MAV_COMP_ID");
+	param_handles.takeoff_alt = param_find("NAV_TAKEOFF_ALT");
+	param_handles.enable_parachute = param_find("NAV_PARACHUTE_EN");
 
 	/* welcome user */
 	warnx("starting");
@@ -743,7 +787,8 @@ int commander_thread_main(int argc, char *argv[])
 
 	pthread_attr_t commander_low_prio_attr;
 	pthread_attr_init(&commander_low_prio_attr);
-	pthread_attr_setstacksize(&commander_low_prio_attr, 2900);
+	/* calibrations save parameters from deep in their own frames, the BSON encoder adds BSON_FILE_WINDOW */
+	pthread_attr_setstacksize(&commander_low_prio_attr, 3050);
 
 	struct sched_param param;
 	(void)pthread_attr_getschedparam(&commander_low_prio_attr, &param);
@@ -813,11 +858,6 @@ int commander_thread_main(int argc, char *argv[])
 	struct vehicle_gps_position_s gps_position;
 	memset(&gps_position, 0, sizeof(gps_position));
 
-	/* Subscribe to sensor topic */
-	int sensor_sub = orb_subscribe(ORB_ID(sensor_combined));
-	struct sensor_combined_s sensors;
-	memset(&sensors, 0, sizeof(sensors));
-
 	/* Subscribe to differential pressure topic */
 	int diff_pres_sub = orb_subscribe(ORB_ID(differential_pressure));
 	struct differential_pressure_s diff_pres;
@@ -825,13 +865,9 @@ int commander_thread_main(int argc, char *argv[])
 
 	/* Subscribe to command topic */
 	int cmd_sub = orb_subscribe(ORB_ID(vehicle_command));
-	struct vehicle_command_s cmd;
-	memset(&cmd, 0, sizeof(cmd));
 
 	/* Subscribe to parameters changed topic */
 	int param_changed_sub = orb_subscribe(ORB_ID(parameter_update));
-	struct parameter_update_s param_changed;
-	memset(&param_changed, 0, sizeof(param_changed));
 
 	/* Subscribe to battery topic */
 	int battery_sub = orb_subscribe(ORB_ID(battery_status));
@@ -840,68 +876,105 @@ int commander_thread_main(int argc, char *argv[])
 
 	/* Subscribe to subsystem info topic */
 	int subsys_sub = orb_subscribe(ORB_ID(subsystem_info));
-	struct subsystem_info_s info;
-	memset(&info, 0, sizeof(info));
 
 	/* Subscribe to position setpoint triplet */
 	int pos_sp_triplet_sub = orb_subscribe(ORB_ID(position_setpoint_triplet));
 	struct position_setpoint_triplet_s pos_sp_triplet;
 	memset(&pos_sp_triplet, 0, sizeof(pos_sp_triplet));
 
+	/*
+	 * Wakeup sources. Topics that change the state of the system directly
+	 * wake the loop up as soon as they are published, all other topics are
+	 * sampled on the monitoring tick. Each wakeup source has its handler.
+	 */
+	enum {
+		POLL_CMD = 0,
+		POLL_PARAM,
+		POLL_SAFETY,
+		POLL_SUBSYS,
+		POLL_COUNT
+	};
+
+	struct pollfd fds[POLL_COUNT];
+	fds[POLL_CMD].fd = cmd_sub;
+	fds[POLL_PARAM].fd = param_changed_sub;
+	fds[POLL_SAFETY].fd = safety_sub;
+	fds[POLL_SUBSYS].fd = subsys_sub;
+
+	for (unsigned i = 0; i < POLL_COUNT; i++) {
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	}
+
 	control_status_leds(&status, &armed, true);
 
+	/* status changes not yet shown on the LEDs, which are driven on the monitoring tick */
+	bool leds_changed = false;
+
 	/* now initialized */
 	commander_initialized = true;
 	thread_running = true;
 
 	start_time = hrt_absolute_time();
 
+	/* run the first monitoring pass right away */
+	hrt_abstime next_monitoring_tick = start_time;
+
 	while (!thread_should_exit) {
 
-		if (mavlink_fd < 0 && counter % (1000000 / MAVLINK_OPEN_INTERVAL) == 0) {
-			/* try to open the mavlink log device every once in a while */
-			mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
+		/* wait for an event or the next monitoring tick, whichever comes first */
+		hrt_abstime now = hrt_absolute_time();
+		int timeout = (now < next_monitoring_tick) ? (int)((next_monitoring_tick - now + 999) / 1000) : 0;
+
+		int pret = poll(&fds[0], POLL_COUNT, timeout);
+
+		/* this is undesirable but not much we can do - might want to flag unhappy status */
+		if (pret < 0) {
+			warn("poll error %d, %d", pret, errno);
+			usleep(COMMANDER_MONITORING_INTERVAL);
+			continue;
 		}
 
-		/* update parameters */
-		orb_check(param_changed_sub, &updated);
+		/*
+		 * Hysteresis counters and rate dividers count monitoring ticks,
+		 * passes triggered by events in between leave them untouched.
+		 */
+		now = hrt_absolute_time();
+		bool monitoring_tick = (now >= next_monitoring_tick);
 
-		if (updated || param_init_forced) {
-			param_init_forced = false;
-			/* parameters changed */
-			orb_copy(ORB_ID(parameter_update), param_changed_sub, &param_changed);
+		if (monitoring_tick) {
+			next_monitoring_tick += COMMANDER_MONITORING_INTERVAL;
 
-			/* update parameters */
-			if (!armed.armed) {
-				if (param_get(_param_sys_type, &(status.system_type)) != OK) {
-					warnx("failed getting new system type");
-				}
+			/* don't try to catch up after a stall */
+			if (next_monitoring_tick <= now) {
+				next_monitoring_tick = now + COMMANDER_MONITORING_INTERVAL;
+			}
+		}
 
-				/* disable manual override for all systems that rely on electronic stabilization */
-				if (status.system_type == VEHICLE_TYPE_COAXIAL ||
-				    status.system_type == VEHICLE_TYPE_HELICOPTER ||
-				    status.system_type == VEHICLE_TYPE_TRICOPTER ||
-				    status.system_type == VEHICLE_TYPE_QUADROTOR ||
-				    status.system_type == VEHICLE_TYPE_HEXAROTOR ||
-				    status.system_type == VEHICLE_TYPE_OCTOROTOR) {
-					status.is_rotary_wing = true;
+		/* the safety topic is published with every px4io status poll, most updates change nothing */
+		bool safety_changed = (fds[POLL_SAFETY].revents & POLLIN) && handle_safety_update(safety_sub);
 
-				} else {
-					status.is_rotary_wing = false;
-				}
+		bool event = safety_changed || param_init_forced ||
+			     (fds[POLL_PARAM].revents & POLLIN) ||
+			     (fds[POLL_SUBSYS].revents & POLLIN) ||
+			     (fds[POLL_CMD].revents & POLLIN);
 
-				/* check and update system / component ID */
-				param_get(_param_system_id, &(status.system_id));
-				param_get(_param_component_id, &(status.component_id));
-				status_changed = true;
+		if (!monitoring_tick && !event) {
+			continue;
+		}
 
-				/* re-check RC calibration */
-				rc_calibration_ok = (OK == rc_calibration_check(mavlink_fd));
-			}
+		if (monitoring_tick && mavlink_fd < 0 && counter % (1000000 / MAVLINK_OPEN_INTERVAL) == 0) {
+			/* try to open the mavlink log device every once in a while */
+			mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
+		}
 
-			/* navigation parameters */
-			param_get(_param_takeoff_alt, &takeoff_alt);
-			param_get(_param_enable_parachute, &parachute_enabled);
+		/* update parameters */
+		if ((fds[POLL_PARAM].revents & POLLIN) || param_init_forced) {
+			param_init_forced = false;
+
+			if (handle_parameter_update(param_changed_sub, &param_handles, &rc_calibration_ok)) {
+				status_changed = true;
+			}
 		}
 
 		orb_check(sp_man_sub, &updated);
@@ -916,12 +989,6 @@ int commander_thread_main(int argc, char *argv[])
 			orb_copy(ORB_ID(offboard_control_setpoint), sp_offboard_sub, &sp_offboard);
 		}
 
-		orb_check(sensor_sub, &updated);
-
-		if (updated) {
-			orb_copy(ORB_ID(sensor_combined), sensor_sub, &sensors);
-		}
-
 		orb_check(diff_pres_sub, &updated);
 
 		if (updated) {
@@ -930,22 +997,6 @@ int commander_thread_main(int argc, char *argv[])
 
 		check_valid(diff_pres.timestamp, DIFFPRESS_TIMEOUT, true, &(status.condition_airspeed_valid), &status_changed);
 
-		/* update safety topic */
-		orb_check(safety_sub, &updated);
-
-		if (updated) {
-			orb_copy(ORB_ID(safety), safety_sub, &safety);
-
-			/* disarm if safety is now on and still armed */
-			if (status.hil_state == HIL_STATE_OFF && safety.safety_switch_available && !safety.safety_off && armed.armed) {
-				arming_state_t new_arming_state = (status.arming_state == ARMING_STATE_ARMED ? ARMING_STATE_STANDBY : ARMING_STATE_STANDBY_ERROR);
-
-				if (TRANSITION_CHANGED == arming_state_transition(&status, &safety, new_arming_state, &armed)) {
-					mavlink_log_info(mavlink_fd, "[cmd] DISARMED by safety switch");
-				}
-			}
-		}
-
 		/* update global position estimate */
 		orb_check(global_position_sub, &updated);
 
@@ -1055,37 +1106,7 @@ int commander_thread_main(int argc, char *argv[])
 		}
 
 		/* update subsystem */
-		orb_check(subsys_sub, &updated);
-
-		if (updated) {
-			orb_copy(ORB_ID(subsystem_info), subsys_sub, &info);
-
-			warnx("subsystem changed: %d\n", (int)info.subsystem_type);
-
-			/* mark / unmark as present */
-			if (info.present) {
-				status.onboard_control_sensors_present |= info.subsystem_type;
-
-			} else {
-				status.onboard_control_sensors_present &= ~info.subsystem_type;
-			}
-
-			/* mark / unmark as enabled */
-			if (info.enabled) {
-				status.onboard_control_sensors_enabled |= info.subsystem_type;
-
-			} else {
-				status.onboard_control_sensors_enabled &= ~info.subsystem_type;
-			}
-
-			/* mark / unmark as ok */
-			if (info.ok) {
-				status.onboard_control_sensors_health |= info.subsystem_type;
-
-			} else {
-				status.onboard_control_sensors_health &= ~info.subsystem_type;
-			}
-
+		if ((fds[POLL_SUBSYS].revents & POLLIN) && handle_subsystem_info(subsys_sub)) {
 			status_changed = true;
 		}
 
@@ -1096,7 +1117,7 @@ int commander_thread_main(int argc, char *argv[])
 			orb_copy(ORB_ID(position_setpoint_triplet), pos_sp_triplet_sub, &pos_sp_triplet);
 		}
 
-		if (counter % (1000000 / COMMANDER_MONITORING_INTERVAL) == 0) {
+		if (monitoring_tick && counter % (1000000 / COMMANDER_MONITORING_INTERVAL) == 0) {
 			/* compute system load */
 			uint64_t interval_runtime = system_load.tasks[0].total_runtime - last_idle_time;
 
@@ -1196,7 +1217,7 @@ int commander_thread_main(int argc, char *argv[])
 					arming_res = arming_state_transition(&status, &safety, new_arming_state, &armed);
 					stick_off_counter = 0;
 
-				} else {
+				} else if (monitoring_tick) {
 					stick_off_counter++;
 				}
 
@@ -1220,7 +1241,7 @@ int commander_thread_main(int argc, char *argv[])
 
 					stick_on_counter = 0;
 
-				} else {
+				} else if (monitoring_tick) {
 					stick_on_counter++;
 				}
 
@@ -1350,16 +1371,8 @@ int commander_thread_main(int argc, char *argv[])
 		}
 
 		/* handle commands last, as the system needs to be updated to handle them */
-		orb_check(cmd_sub, &updated);
-
-		if (updated) {
-			/* got command */
-			orb_copy(ORB_ID(vehicle_command), cmd_sub, &cmd);
-
-			/* handle it */
-			if (handle_command(&status, &safety, &cmd, &armed, &home, &global_position, &home_pub)) {
-				status_changed = true;
-			}
+		if ((fds[POLL_CMD].revents & POLLIN) && handle_vehicle_command(cmd_sub, &home, &global_position, &home_pub)) {
+			status_changed = true;
 		}
 
 		/* check which state machines for changes, clear "changed" flag */
@@ -1412,7 +1425,7 @@ int commander_thread_main(int argc, char *argv[])
 		}
 
 		/* publish states (armed, control mode, vehicle status) at least with 5 Hz */
-		if (counter % (200000 / COMMANDER_MONITORING_INTERVAL) == 0 || status_changed) {
+		if ((monitoring_tick && counter % (200000 / COMMANDER_MONITORING_INTERVAL) == 0) || status_changed) {
 			set_control_mode();
 			control_mode.timestamp = t1;
 			orb_publish(ORB_ID(vehicle_control_mode), control_mode_pub, &control_mode);
@@ -1447,26 +1460,31 @@ int commander_thread_main(int argc, char *argv[])
 			arm_tune_played = false;
 		}
 
-		fflush(stdout);
-		counter++;
+		/* LED blink patterns count monitoring ticks */
+		leds_changed = leds_changed || status_changed;
 
-		int blink_state = blink_msg_state();
+		if (monitoring_tick) {
+			int blink_state = blink_msg_state();
 
-		if (blink_state > 0) {
-			/* blinking LED message, don't touch LEDs */
-			if (blink_state == 2) {
-				/* blinking LED message completed, restore normal state */
-				control_status_leds(&status, &armed, true);
+			if (blink_state > 0) {
+				/* blinking LED message, don't touch LEDs */
+				if (blink_state == 2) {
+					/* blinking LED message completed, restore normal state */
+					control_status_leds(&status, &armed, true);
+					leds_changed = false;
+				}
+
+			} else {
+				/* normal state */
+				control_status_leds(&status, &armed, leds_changed);
+				leds_changed = false;
 			}
 
-		} else {
-			/* normal state */
-			control_status_leds(&status, &armed, status_changed);
+			fflush(stdout);
+			counter++;
 		}
 
 		status_changed = false;
-
-		usleep(COMMANDER_MONITORING_INTERVAL);
 	}
 
 	/* wait for threads to complete */
@@ -1486,7 +1504,6 @@ int commander_thread_main(int argc, char *argv[])
 	close(local_position_sub);
 	close(global_position_sub);
 	close(gps_sub);
-	close(sensor_sub);
 	close(safety_sub);
 	close(cmd_sub);
 	close(subsys_sub);
@@ -1511,6 +1528,121 @@ check_valid(hrt_abstime timestamp, hrt_abstime timeout, bool valid_in, bool *val
 	}
 }
 
+bool
+handle_parameter_update(int param_changed_sub, const struct commander_param_handles_s *h, bool *rc_calibration_ok)
+{
+	bool changed = false;
+
+	/* parameters changed */
+	struct parameter_update_s param_changed;
+	orb_copy(ORB_ID(parameter_update), param_changed_sub, &param_changed);
+
+	/* update parameters */
+	if (!armed.armed) {
+		if (param_get(h->sys_type, &(status.system_type)) != OK) {
+			warnx("failed getting new system type");
+		}
+
+		/* disable manual override for all systems that rely on electronic stabilization */
+		if (status.system_type == VEHICLE_TYPE_COAXIAL ||
+		    status.system_type == VEHICLE_TYPE_HELICOPTER ||
+		    status.system_type == VEHICLE_TYPE_TRICOPTER ||
+		    status.system_type == VEHICLE_TYPE_QUADROTOR ||
+		    status.system_type == VEHICLE_TYPE_HEXAROTOR ||
+		    status.system_type == VEHICLE_TYPE_OCTOROTOR) {
+			status.is_rotary_wing = true;
+
+		} else {
+			status.is_rotary_wing = false;
+		}
+
+		/* check and update system / component ID */
+		param_get(h->system_id, &(status.system_id));
+		param_get(h->component_id, &(status.component_id));
+		changed = true;
+
+		/* re-check RC calibration */
+		*rc_calibration_ok = (OK == rc_calibration_check(mavlink_fd));
+	}
+
+	/* navigation parameters */
+	param_get(h->takeoff_alt, &takeoff_alt);
+	param_get(h->enable_parachute, &parachute_enabled);
+
+	return changed;
+}
+
+bool
+handle_safety_update(int safety_sub)
+{
+	struct safety_s safety_new;
+	orb_copy(ORB_ID(safety), safety_sub, &safety_new);
+
+	bool changed = (safety_new.safety_switch_available != safety.safety_switch_available ||
+			safety_new.safety_off != safety.safety_off);
+
+	safety = safety_new;
+
+	if (!changed) {
+		return false;
+	}
+
+	/* disarm if safety is now on and still armed */
+	if (status.hil_state == HIL_STATE_OFF && safety.safety_switch_available && !safety.safety_off && armed.armed) {
+		arming_state_t new_arming_state = (status.arming_state == ARMING_STATE_ARMED ? ARMING_STATE_STANDBY : ARMING_STATE_STANDBY_ERROR);
+
+		if (TRANSITION_CHANGED == arming_state_transition(&status, &safety, new_arming_state, &armed)) {
+			mavlink_log_info(mavlink_fd, "[cmd] DISARMED by safety switch");
+		}
+	}
+
+	return true;
+}
+
+bool
+handle_subsystem_info(int subsys_sub)
+{
+	struct subsystem_info_s info;
+	orb_copy(ORB_ID(subsystem_info), subsys_sub, &info);
+
+	warnx("subsystem changed: %d\n", (int)info.subsystem_type);
+
+	/* mark / unmark as present */
+	if (info.present) {
+		status.onboard_control_sensors_present |= info.subsystem_type;
+
+	} else {
+		status.onboard_control_sensors_present &= ~info.subsystem_type;
+	}
+
+	/* mark / unmark as enabled */
+	if (info.enabled) {
+		status.onboard_control_sensors_enabled |= info.subsystem_type;
+
+	} else {
+		status.onboard_control_sensors_enabled &= ~info.subsystem_type;
+	}
+
+	/* mark / unmark as ok */
+	if (info.ok) {
+		status.onboard_control_sensors_health |= info.subsystem_type;
+
+	} else {
+		status.onboard_control_sensors_health &= ~info.subsystem_type;
+	}
+
+	return true;
+}
+
+bool
+handle_vehicle_command(int cmd_sub, struct home_position_s *home, struct vehicle_global_position_s *global_pos, orb_advert_t *home_pub)
+{
+	struct vehicle_command_s cmd;
+	orb_copy(ORB_ID(vehicle_command), cmd_sub, &cmd);
+
+	return handle_command(&status, &safety, &cmd, &armed, home, global_pos, home_pub);
+}
+
 void
 control_status_leds(vehicle_status_s *status, const actuator_armed_s *actuator_armed, bool changed)
 {
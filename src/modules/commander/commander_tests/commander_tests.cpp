@@ -48,7 +48,9 @@ extern "C" __EXPORT int commander_tests_main(int argc, char *argv[]);
 
 int commander_tests_main(int argc, char *argv[])
 {
-	stateMachineHelperTest();
+	if (!stateMachineHelperTest()) {
+		return 1;
+	}
 
 	return 0;
 }
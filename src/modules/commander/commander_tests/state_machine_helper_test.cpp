@@ -38,10 +38,13 @@
  *
  */
 
+#include <string.h>
+
 #include "state_machine_helper_test.h"
 
 #include "../state_machine_helper.h"
 #include <unit_test/unit_test.h>
+#include <systemlib/state_table.h>
 
 class StateMachineHelperTest : public UnitTest
 {
@@ -53,8 +56,12 @@ public:
 
 private:
 	bool armingStateTransitionTest();
+	bool armingStateTransitionAllPairsTest();
 	bool mainStateTransitionTest();
+	bool mainStateTransitionAllPairsTest();
+	bool failsafeStateTransitionAllPairsTest();
 	bool isSafeTest();
+	bool stateTableTest();
 };
 
 StateMachineHelperTest::StateMachineHelperTest() {
@@ -298,10 +305,76 @@ bool StateMachineHelperTest::armingStateTransitionTest(void)
 	return true;
 }
 
+bool StateMachineHelperTest::armingStateTransitionAllPairsTest(void)
+{
+	struct vehicle_status_s status;
+	struct safety_s         safety;
+	struct actuator_armed_s armed;
+
+	memset(&status, 0, sizeof(status));
+	memset(&safety, 0, sizeof(safety));
+	memset(&armed, 0, sizeof(armed));
+
+	// Every current/requested state pair, with every combination of HIL, sensors and safety switch
+	for (unsigned conditions = 0; conditions < 16; conditions++) {
+		for (unsigned current = 0; current < ARMING_STATE_MAX; current++) {
+			for (unsigned requested = 0; requested < ARMING_STATE_MAX; requested++) {
+				status.hil_state = (conditions & 1) ? HIL_STATE_ON : HIL_STATE_OFF;
+				status.condition_system_sensors_initialized = (conditions & 2);
+				safety.safety_switch_available = (conditions & 4);
+				safety.safety_off = (conditions & 8);
+
+				bool was_armed = (current == ARMING_STATE_ARMED || current == ARMING_STATE_ARMED_ERROR);
+				status.arming_state = (arming_state_t)current;
+				armed.armed = was_armed;
+				armed.ready_to_arm = (current == ARMING_STATE_ARMED || current == ARMING_STATE_STANDBY);
+
+				transition_result_t result = arming_state_transition(&status, &safety, (arming_state_t)requested, &armed);
+
+				if (requested == current) {
+					ut_assert("identical states never transition", result == TRANSITION_NOT_CHANGED);
+					ut_assert("identical states keep the state", status.arming_state == current);
+					continue;
+				}
+
+				ut_assert("different states always change or are denied", result != TRANSITION_NOT_CHANGED);
+
+				if (result == TRANSITION_DENIED) {
+					ut_assert("denied transition keeps the state", status.arming_state == current);
+					ut_assert("denied transition keeps armed", armed.armed == was_armed);
+					continue;
+				}
+
+				arming_state_t next = status.arming_state;
+
+				ut_assert("armed flag follows the state",
+					  armed.armed == (next == ARMING_STATE_ARMED || next == ARMING_STATE_ARMED_ERROR));
+				ut_assert("ready to arm flag follows the state",
+					  armed.ready_to_arm == (next == ARMING_STATE_ARMED || next == ARMING_STATE_STANDBY));
+				ut_assert("only arm from standby or in air restore",
+					  next != ARMING_STATE_ARMED || current == ARMING_STATE_STANDBY || current == ARMING_STATE_IN_AIR_RESTORE);
+				ut_assert("no arming with the safety switch on",
+					  next != ARMING_STATE_ARMED || current == ARMING_STATE_IN_AIR_RESTORE ||
+					  status.hil_state == HIL_STATE_ON || !safety.safety_switch_available || safety.safety_off);
+				ut_assert("no reboot or init while armed",
+					  !was_armed || (next != ARMING_STATE_REBOOT && next != ARMING_STATE_INIT));
+				ut_assert("standby requires initialized sensors",
+					  next != ARMING_STATE_STANDBY || status.condition_system_sensors_initialized);
+			}
+		}
+	}
+
+	return true;
+}
+
 bool StateMachineHelperTest::mainStateTransitionTest(void)
 {
 	struct vehicle_status_s current_state;
 	main_state_t new_main_state;
+
+	// Rotary wing, the altitude controlled mode then needs an altitude estimate
+	memset(&current_state, 0, sizeof(current_state));
+	current_state.is_rotary_wing = true;
 	
 	// Identical states.
 	current_state.main_state = MAIN_STATE_MANUAL;
@@ -368,6 +441,110 @@ bool StateMachineHelperTest::mainStateTransitionTest(void)
 	return true;
 }
 
+bool StateMachineHelperTest::mainStateTransitionAllPairsTest(void)
+{
+	struct vehicle_status_s status;
+	memset(&status, 0, sizeof(status));
+
+	// Every current/requested state pair with every combination of the conditions the modes depend on
+	for (unsigned conditions = 0; conditions < 16; conditions++) {
+		for (unsigned current = 0; current < MAIN_STATE_MAX; current++) {
+			for (unsigned requested = 0; requested < MAIN_STATE_MAX; requested++) {
+				status.is_rotary_wing = (conditions & 1);
+				status.condition_local_altitude_valid = (conditions & 2);
+				status.condition_local_position_valid = (conditions & 4);
+				status.condition_global_position_valid = (conditions & 8);
+				status.main_state = (main_state_t)current;
+
+				bool allowed = false;
+
+				switch (requested) {
+				case MAIN_STATE_MANUAL:
+					allowed = true;
+					break;
+
+				case MAIN_STATE_ALTCTL:
+					allowed = !status.is_rotary_wing || status.condition_local_altitude_valid || status.condition_global_position_valid;
+					break;
+
+				case MAIN_STATE_POSCTL:
+					allowed = status.condition_local_position_valid || status.condition_global_position_valid;
+					break;
+
+				case MAIN_STATE_AUTO:
+					allowed = status.condition_global_position_valid;
+					break;
+				}
+
+				transition_result_t result = main_state_transition(&status, (main_state_t)requested);
+
+				if (!allowed) {
+					ut_assert("main state denied without the required estimate", result == TRANSITION_DENIED);
+					ut_assert("denied main state keeps the state", status.main_state == current);
+
+				} else if (requested == current) {
+					ut_assert("identical main state not changed", result == TRANSITION_NOT_CHANGED);
+
+				} else {
+					ut_assert("allowed main state changed", result == TRANSITION_CHANGED);
+					ut_assert("main state set", status.main_state == requested);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool StateMachineHelperTest::failsafeStateTransitionAllPairsTest(void)
+{
+	struct vehicle_status_s status;
+	memset(&status, 0, sizeof(status));
+
+	for (unsigned conditions = 0; conditions < 8; conditions++) {
+		for (unsigned current = 0; current < FAILSAFE_STATE_MAX; current++) {
+			for (unsigned requested = 0; requested < FAILSAFE_STATE_MAX; requested++) {
+				status.condition_local_altitude_valid = (conditions & 1);
+				status.condition_global_position_valid = (conditions & 2);
+				status.condition_home_position_valid = (conditions & 4);
+				status.failsafe_state = (failsafe_state_t)current;
+
+				bool allowed = false;
+
+				if (current == FAILSAFE_STATE_TERMINATION) {
+					// termination can not be left
+					allowed = (requested == FAILSAFE_STATE_TERMINATION);
+
+				} else if (requested == FAILSAFE_STATE_RTL) {
+					allowed = status.condition_global_position_valid && status.condition_home_position_valid;
+
+				} else if (requested == FAILSAFE_STATE_LAND) {
+					allowed = status.condition_local_altitude_valid || status.condition_global_position_valid;
+
+				} else {
+					allowed = true;
+				}
+
+				transition_result_t result = failsafe_state_transition(&status, (failsafe_state_t)requested);
+
+				if (!allowed) {
+					ut_assert("failsafe state denied", result == TRANSITION_DENIED);
+					ut_assert("denied failsafe state keeps the state", status.failsafe_state == current);
+
+				} else if (requested == current) {
+					ut_assert("identical failsafe state not changed", result == TRANSITION_NOT_CHANGED);
+
+				} else {
+					ut_assert("allowed failsafe state changed", result == TRANSITION_CHANGED);
+					ut_assert("failsafe state set", status.failsafe_state == requested);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
 bool StateMachineHelperTest::isSafeTest(void)
 {
 	struct vehicle_status_s current_state;
@@ -407,16 +584,90 @@ bool StateMachineHelperTest::isSafeTest(void)
 	return true;
 }
 
+// Minimal state machine on the shared table engine: OFF <-> ON, with a counter action
+class Switch : public StateTable
+{
+public:
+	enum State { OFF = 0, ON, NUM_STATES };
+	enum Signal { TURN_ON = 0, TURN_OFF, NUM_SIGNALS };
+
+	Switch();
+
+	unsigned state() const { return myState; }
+
+	unsigned actions;
+
+private:
+	void count() { actions++; }
+
+	static const StateTable::Tran table[NUM_STATES][NUM_SIGNALS];
+};
+
+constexpr StateTable::Tran const Switch::table[Switch::NUM_STATES][Switch::NUM_SIGNALS] = {
+	{
+		/* OFF */
+		/* TURN_ON */	{ACTION(&Switch::count), Switch::ON},
+		/* TURN_OFF */	{NO_ACTION, Switch::OFF},
+	},
+	{
+		/* ON */
+		/* TURN_ON */	{NO_ACTION, Switch::ON},
+		/* TURN_OFF */	{ACTION(&Switch::count), Switch::OFF},
+	},
+};
+
+Switch::Switch() : StateTable(&table[0][0], NUM_STATES, NUM_SIGNALS), actions(0)
+{
+	static_assert(StateTable::valid(table), "invalid switch state table");
+	myState = OFF;
+}
+
+bool StateMachineHelperTest::stateTableTest(void)
+{
+	Switch sw;
+
+	sw.dispatch(Switch::TURN_OFF);
+	ut_assert("ignored signal keeps the state", sw.state() == Switch::OFF && sw.actions == 0);
+	ut_assert("ignored signal not recorded", sw.history().count() == 0);
+
+	sw.dispatch(Switch::TURN_ON);
+	ut_assert("transition to on", sw.state() == Switch::ON && sw.actions == 1);
+	ut_assert("transition recorded", sw.history().count() == 1);
+	ut_assert("recorded from", sw.history().get(0).state == Switch::OFF);
+	ut_assert("recorded signal", sw.history().get(0).signal == Switch::TURN_ON);
+	ut_assert("recorded to", sw.history().get(0).nextState == Switch::ON);
+
+	// overrun the history ring, it keeps the most recent transitions
+	for (unsigned i = 0; i < 2 * StateTable::HISTORY_SIZE; i++) {
+		sw.dispatch((i % 2) ? Switch::TURN_ON : Switch::TURN_OFF);
+	}
+
+	ut_assert("all transitions executed", sw.actions == 1 + 2 * StateTable::HISTORY_SIZE);
+	ut_assert("history is bounded", sw.history().count() == StateTable::HISTORY_SIZE);
+	ut_assert("most recent transition first", sw.history().get(0).nextState == Switch::ON);
+	ut_assert("previous transition second", sw.history().get(1).nextState == Switch::OFF);
+
+	return true;
+}
+
 void StateMachineHelperTest::runTests(void)
 {
 	ut_run_test(armingStateTransitionTest);
+	ut_run_test(armingStateTransitionAllPairsTest);
 	ut_run_test(mainStateTransitionTest);
+	ut_run_test(mainStateTransitionAllPairsTest);
+	ut_run_test(failsafeStateTransitionAllPairsTest);
 	ut_run_test(isSafeTest);
+	ut_run_test(stateTableTest);
 }
 
-void stateMachineHelperTest(void)
+bool stateMachineHelperTest(void)
 {
 	StateMachineHelperTest* test = new StateMachineHelperTest();
     test->runTests();
 	test->printResults();
+
+	bool passed = (test->mu_tests_failed() == 0);
+	delete test;
+	return passed;
 }
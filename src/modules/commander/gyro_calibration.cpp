@@ -31,17 +31,25 @@
  *
  ****************************************************************************/
 
+
 /**
  * @file gyro_calibration.cpp
  *
  * Gyroscope calibration routine
+ *
+ * All gyro instances are read at the full sensor rate from their device
+ * nodes and their offsets are averaged in the same pass. Rest is checked
+ * on the primary gyro over short windows; the average is restarted if the
+ * vehicle moves.
  */
 
 #include "gyro_calibration.h"
 #include "calibration_messages.h"
+#include "calibration_routines.h"
 #include "commander_helper.h"
 
 #include <stdio.h>
+#include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <math.h>
@@ -60,6 +68,21 @@ static const int ERROR = -1;
 
 static const char *sensor_name = "gyro";
 
+/* rest detection on the primary gyro: 0.05 rad/s standard deviation over 250 ms windows */
+static const unsigned still_window_us = 250000;
+static const float still_threshold = 0.05f * 0.05f;
+
+/* windows at rest to average, 3 s */
+static const unsigned collect_windows = 12;
+
+/* abort if not at rest long enough within 30 s */
+static const hrt_abstime calibration_timeout = 30000000;
+
+/* driver queue depth while calibrating, enough to not lose samples between polls */
+static const unsigned queue_depth = 20;
+
+int do_gyro_calibration_measurements(int mavlink_fd, const int fds[], unsigned count, float gyro_offs[][3]);
+
 int do_gyro_calibration(int mavlink_fd)
 {
 	mavlink_log_info(mavlink_fd, CAL_STARTED_MSG, sensor_name);
@@ -76,78 +99,51 @@ int do_gyro_calibration(int mavlink_fd)
 
 	int res = OK;
 
-	/* reset all offsets to zero and all scales to one */
-	int fd = open(GYRO_DEVICE_PATH, 0);
-	res = ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale);
-	close(fd);
-
-	if (res != OK) {
-		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
-	}
+	/* open all instances, reset all offsets to zero and all scales to one */
+	int fds[CALIBRATION_MAX_SENSORS];
+	int queue_depths[CALIBRATION_MAX_SENSORS];
+	unsigned count = 0;
 
-	if (res == OK) {
-		/* determine gyro mean values */
-		const unsigned calibration_count = 5000;
-		unsigned calibration_counter = 0;
-		unsigned poll_errcount = 0;
-
-		/* subscribe to gyro sensor topic */
-		int sub_sensor_gyro = orb_subscribe(ORB_ID(sensor_gyro));
-		struct gyro_report gyro_report;
-
-		while (calibration_counter < calibration_count) {
-			/* wait blocking for new data */
-			struct pollfd fds[1];
-			fds[0].fd = sub_sensor_gyro;
-			fds[0].events = POLLIN;
-
-			int poll_ret = poll(fds, 1, 1000);
-
-			if (poll_ret > 0) {
-				orb_copy(ORB_ID(sensor_gyro), sub_sensor_gyro, &gyro_report);
-				gyro_scale.x_offset += gyro_report.x;
-				gyro_scale.y_offset += gyro_report.y;
-				gyro_scale.z_offset += gyro_report.z;
-				calibration_counter++;
-
-				if (calibration_counter % (calibration_count / 20) == 0) {
-					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, (calibration_counter * 100) / calibration_count);
-				}
+	for (unsigned s = 0; s < CALIBRATION_MAX_SENSORS; s++) {
+		char path[20];
 
-			} else {
-				poll_errcount++;
-			}
+		if (s == 0) {
+			snprintf(path, sizeof(path), "%s", GYRO_DEVICE_PATH);
 
-			if (poll_errcount > 1000) {
-				mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
-				res = ERROR;
-				break;
-			}
+		} else {
+			snprintf(path, sizeof(path), "%s%u", GYRO_DEVICE_PATH, s);
 		}
 
-		close(sub_sensor_gyro);
+		int fd = open(path, O_RDONLY);
 
-		gyro_scale.x_offset /= calibration_count;
-		gyro_scale.y_offset /= calibration_count;
-		gyro_scale.z_offset /= calibration_count;
-	}
+		/* instances are numbered without gaps */
+		if (fd < 0) {
+			break;
+		}
 
-	if (res == OK) {
-		/* check offsets */
-		if (!isfinite(gyro_scale.x_offset) || !isfinite(gyro_scale.y_offset) || !isfinite(gyro_scale.z_offset)) {
-			mavlink_log_critical(mavlink_fd, "ERROR: offset is NaN");
+		if (ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale) != OK) {
+			mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
+			close(fd);
 			res = ERROR;
+			break;
 		}
+
+		queue_depths[count] = ioctl(fd, SENSORIOCGQUEUEDEPTH, 0);
+		ioctl(fd, SENSORIOCSQUEUEDEPTH, queue_depth);
+		fds[count++] = fd;
+	}
+
+	if (res == OK && count == 0) {
+		mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+		res = ERROR;
 	}
 
+	float gyro_offs[CALIBRATION_MAX_SENSORS][3];
+
 	if (res == OK) {
-		/* set offset parameters to new values */
-		if (param_set(param_find("SENS_GYRO_XOFF"), &(gyro_scale.x_offset))
-		    || param_set(param_find("SENS_GYRO_YOFF"), &(gyro_scale.y_offset))
-		    || param_set(param_find("SENS_GYRO_ZOFF"), &(gyro_scale.z_offset))) {
-			mavlink_log_critical(mavlink_fd, "ERROR: failed to set offset params");
-			res = ERROR;
-		}
+		/* determine gyro mean values */
+		mavlink_log_info(mavlink_fd, "calibrating %u gyro%s", count, (count > 1) ? "s" : "");
+		res = do_gyro_calibration_measurements(mavlink_fd, fds, count, gyro_offs);
 	}
 
 #if 0
@@ -266,27 +262,60 @@ int do_gyro_calibration(int mavlink_fd)
 
 #endif
 
-	if (res == OK) {
-		/* set scale parameters to new values */
-		if (param_set(param_find("SENS_GYRO_XSCALE"), &(gyro_scale.x_scale))
-		    || param_set(param_find("SENS_GYRO_YSCALE"), &(gyro_scale.y_scale))
-		    || param_set(param_find("SENS_GYRO_ZSCALE"), &(gyro_scale.z_scale))) {
-			mavlink_log_critical(mavlink_fd, "ERROR: failed to set scale params");
+	for (unsigned s = 0; s < count && res == OK; s++) {
+		gyro_scale.x_offset = gyro_offs[s][0];
+		gyro_scale.y_offset = gyro_offs[s][1];
+		gyro_scale.z_offset = gyro_offs[s][2];
+
+		/* check offsets */
+		if (!isfinite(gyro_scale.x_offset) || !isfinite(gyro_scale.y_offset) || !isfinite(gyro_scale.z_offset)) {
+			mavlink_log_critical(mavlink_fd, "ERROR: offset is NaN");
 			res = ERROR;
+			break;
 		}
-	}
 
-	if (res == OK) {
-		/* apply new scaling and offsets */
-		fd = open(GYRO_DEVICE_PATH, 0);
-		res = ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale);
-		close(fd);
+		/* set parameters, SENS_GYRO_* for the primary and SENS_GYR<n>_* for further instances */
+		const float values[6] = {
+			gyro_scale.x_offset, gyro_scale.y_offset, gyro_scale.z_offset,
+			gyro_scale.x_scale, gyro_scale.y_scale, gyro_scale.z_scale
+		};
+		const char *names[6] = { "XOFF", "YOFF", "ZOFF", "XSCALE", "YSCALE", "ZSCALE" };
 
-		if (res != OK) {
-			mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+		for (unsigned i = 0; i < 6; i++) {
+			char name[20];
+
+			if (s == 0) {
+				snprintf(name, sizeof(name), "SENS_GYRO_%s", names[i]);
+
+			} else {
+				snprintf(name, sizeof(name), "SENS_GYR%u_%s", s, names[i]);
+			}
+
+			if (param_set(param_find(name), &values[i])) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
+				res = ERROR;
+				break;
+			}
+		}
+
+		if (res == OK) {
+			/* apply new scaling and offsets */
+			res = ioctl(fds[s], GYROIOCSSCALE, (long unsigned int)&gyro_scale);
+
+			if (res != OK) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+			}
 		}
 	}
 
+	for (unsigned s = 0; s < count; s++) {
+		if (queue_depths[s] > 0) {
+			ioctl(fds[s], SENSORIOCSQUEUEDEPTH, queue_depths[s]);
+		}
+
+		close(fds[s]);
+	}
+
 	if (res == OK) {
 		/* auto-save to EEPROM */
 		res = param_save_default();
@@ -305,3 +334,124 @@ int do_gyro_calibration(int mavlink_fd)
 
 	return res;
 }
+
+/*
+ * Average all gyros over collect_windows windows at rest.
+ *
+ * The windows of all sensors are added to the average when the primary
+ * gyro was at rest during the window; motion restarts the average.
+ */
+int do_gyro_calibration_measurements(int mavlink_fd, const int fds[], unsigned count, float gyro_offs[][3])
+{
+	struct still_detector_s detector;
+	still_detector_init(&detector, still_window_us, still_threshold);
+
+	struct calibration_stats_s window[CALIBRATION_MAX_SENSORS];
+	struct calibration_stats_s total[CALIBRATION_MAX_SENSORS];
+
+	for (unsigned s = 0; s < count; s++) {
+		calibration_stats_reset(&window[s]);
+		calibration_stats_reset(&total[s]);
+	}
+
+	unsigned collected = 0;
+	bool moved = false;
+
+	struct pollfd pfds[CALIBRATION_MAX_SENSORS];
+
+	for (unsigned s = 0; s < count; s++) {
+		pfds[s].fd = fds[s];
+		pfds[s].events = POLLIN;
+	}
+
+	hrt_abstime t_timeout = hrt_absolute_time() + calibration_timeout;
+	unsigned poll_errcount = 0;
+
+	while (collected < collect_windows) {
+		if (hrt_absolute_time() > t_timeout) {
+			mavlink_log_critical(mavlink_fd, "ERROR: system not still, calibration timed out");
+			return ERROR;
+		}
+
+		int poll_ret = poll(pfds, count, 1000);
+
+		if (poll_ret <= 0) {
+			if (++poll_errcount > 10) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+				return ERROR;
+			}
+
+			continue;
+		}
+
+		/* drain the further sensors before the primary, see do_accel_calibration_measurements() */
+		for (unsigned n = 0; n < count && collected < collect_windows; n++) {
+			unsigned s = (n + 1) % count;
+			struct gyro_report reports[4];
+			ssize_t ret;
+
+			do {
+				ret = read(fds[s], reports, sizeof(reports));
+				unsigned num = (ret > 0) ? ret / sizeof(reports[0]) : 0;
+
+				for (unsigned i = 0; i < num && collected < collect_windows; i++) {
+					calibration_stats_add(&window[s], reports[i].x, reports[i].y, reports[i].z);
+
+					if (s != 0) {
+						continue;
+					}
+
+					int still = still_detector_add(&detector, reports[i].timestamp, reports[i].x, reports[i].y, reports[i].z);
+
+					if (still == 0) {
+						continue;
+					}
+
+					if (still == STILL_DETECTOR_UNDECIDED) {
+						/* too noisy for the offsets, drop the window */
+
+					} else if (still < 0) {
+						if (!moved) {
+							mavlink_log_info(mavlink_fd, "detected motion, hold still...");
+							moved = true;
+						}
+
+						collected = 0;
+
+						for (unsigned k = 0; k < count; k++) {
+							calibration_stats_reset(&total[k]);
+						}
+
+					} else {
+						moved = false;
+
+						for (unsigned k = 0; k < count; k++) {
+							calibration_stats_merge(&total[k], &window[k]);
+						}
+
+						collected++;
+						mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, (collected * 100) / collect_windows);
+					}
+
+					for (unsigned k = 0; k < count; k++) {
+						calibration_stats_reset(&window[k]);
+					}
+				}
+
+			} while (ret == sizeof(reports) && collected < collect_windows);
+		}
+	}
+
+	for (unsigned s = 0; s < count; s++) {
+		if (total[s].count == 0) {
+			mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+			return ERROR;
+		}
+
+		for (unsigned j = 0; j < 3; j++) {
+			gyro_offs[s][j] = total[s].mean[j];
+		}
+	}
+
+	return OK;
+}
@@ -63,6 +63,32 @@ static const int ERROR = -1;
 
 static const char *sensor_name = "mag";
 
+/* sample rate of the magnetometer during calibration */
+static const unsigned mag_sample_interval_ms = 20;
+
+/* minimum number of samples, and solve the fit every this many samples */
+static const unsigned calibration_mincount = 200;
+static const unsigned calibration_solve_interval = 50;
+
+/* finish early once this many of the direction sectors are covered by a good fit */
+static const unsigned coverage_required = 22;
+static const float residual_max = 0.05f;
+
+/* soft iron scales outside this range indicate a bad fit */
+static const float scale_min = 0.7f;
+static const float scale_max = 1.4f;
+
+static bool scales_valid(const float scale[3])
+{
+	for (unsigned i = 0; i < 3; i++) {
+		if (!(scale[i] > scale_min && scale[i] < scale_max)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 int do_mag_calibration(int mavlink_fd)
 {
 	mavlink_log_info(mavlink_fd, CAL_STARTED_MSG, sensor_name);
@@ -71,10 +97,6 @@ int do_mag_calibration(int mavlink_fd)
 	/* 45 seconds */
 	uint64_t calibration_interval = 45 * 1000 * 1000;
 
-	/* maximum 500 values */
-	const unsigned int calibration_maxcount = 240;
-	unsigned int calibration_counter;
-
 	struct mag_scale mscale_null = {
 		0.0f,
 		1.0f,
@@ -107,60 +129,47 @@ int do_mag_calibration(int mavlink_fd)
 
 	close(fd);
 
-	float *x = NULL;
-	float *y = NULL;
-	float *z = NULL;
+	/* the fit keeps sums only, its size does not depend on the number of samples */
+	struct ellipsoid_fit_s *fit = NULL;
 
 	if (res == OK) {
 		/* allocate memory */
 		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20);
 
-		x = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
-		y = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
-		z = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
+		fit = reinterpret_cast<struct ellipsoid_fit_s *>(malloc(sizeof(struct ellipsoid_fit_s)));
 
-		if (x == NULL || y == NULL || z == NULL) {
+		if (fit == NULL) {
 			mavlink_log_critical(mavlink_fd, "ERROR: out of memory");
-
-			/* clean up */
-			if (x != NULL) {
-				free(x);
-			}
-
-			if (y != NULL) {
-				free(y);
-			}
-
-			if (z != NULL) {
-				free(z);
-			}
-
-			res = ERROR;
-			return res;
+			return ERROR;
 		}
 
+		ellipsoid_fit_init(fit);
+
 	} else {
 		/* exit */
 		return ERROR;
 	}
 
+	float center[3];
+	float scale[3];
+	float radius;
+	float residual = 0.0f;
+
 	if (res == OK) {
 		int sub_mag = orb_subscribe(ORB_ID(sensor_mag));
 		struct mag_report mag;
 
 		/* limit update rate to get equally spaced measurements over time (in ms) */
-		orb_set_interval(sub_mag, (calibration_interval / 1000) / calibration_maxcount);
+		orb_set_interval(sub_mag, mag_sample_interval_ms);
 
 		/* calibrate offsets */
 		uint64_t calibration_deadline = hrt_absolute_time() + calibration_interval;
 		unsigned poll_errcount = 0;
+		int progress = 20;
 
 		mavlink_log_info(mavlink_fd, "rotate in a figure 8 around all axis");
 
-		calibration_counter = 0;
-
-		while (hrt_absolute_time() < calibration_deadline &&
-		       calibration_counter < calibration_maxcount) {
+		while (hrt_absolute_time() < calibration_deadline) {
 
 			/* wait blocking for new data */
 			struct pollfd fds[1];
@@ -172,14 +181,27 @@ int do_mag_calibration(int mavlink_fd)
 			if (poll_ret > 0) {
 				orb_copy(ORB_ID(sensor_mag), sub_mag, &mag);
 
-				x[calibration_counter] = mag.x;
-				y[calibration_counter] = mag.y;
-				z[calibration_counter] = mag.z;
+				ellipsoid_fit_add(fit, mag.x, mag.y, mag.z);
+
+				if (fit->count % calibration_solve_interval == 0) {
+					unsigned coverage = ellipsoid_fit_coverage(fit);
+					bool fit_ok = (ellipsoid_fit_solve(fit, false, center, scale, &radius, &residual) == OK);
+
+					/* progress follows the coverage of the directions */
+					int new_progress = 20 + (coverage * 50) / ELLIPSOID_FIT_SECTORS;
 
-				calibration_counter++;
+					if (new_progress != progress) {
+						progress = new_progress;
+						mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, progress);
+						mavlink_log_info(mavlink_fd, "mag: %u samples, %u/%u directions, fit error %.1f%%",
+								 fit->count, coverage, ELLIPSOID_FIT_SECTORS, fit_ok ? (double)(residual * 100.0f) : 100.0);
+					}
 
-				if (calibration_counter % (calibration_maxcount / 20) == 0) {
-					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20 + (calibration_counter * 50) / calibration_maxcount);
+					if (fit_ok && fit->count >= calibration_mincount && coverage >= coverage_required &&
+					    residual < residual_max && scales_valid(scale)) {
+						/* enough directions seen, no need to wait for the deadline */
+						break;
+					}
 				}
 
 			} else {
@@ -196,35 +218,33 @@ int do_mag_calibration(int mavlink_fd)
 		close(sub_mag);
 	}
 
-	float sphere_x;
-	float sphere_y;
-	float sphere_z;
-	float sphere_radius;
-
 	if (res == OK) {
 
-		/* sphere fit */
+		/* ellipsoid fit, fall back to a sphere if the directions did not determine it */
 		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 70);
-		sphere_fit_least_squares(x, y, z, calibration_counter, 100, 0.0f, &sphere_x, &sphere_y, &sphere_z, &sphere_radius);
+		unsigned coverage = ellipsoid_fit_coverage(fit);
+
+		if (coverage < coverage_required ||
+		    ellipsoid_fit_solve(fit, false, center, scale, &radius, &residual) != OK ||
+		    !scales_valid(scale)) {
+
+			mavlink_log_info(mavlink_fd, "mag: %u/%u directions, offsets only", coverage, ELLIPSOID_FIT_SECTORS);
+
+			if (ellipsoid_fit_solve(fit, true, center, scale, &radius, &residual) != OK) {
+				mavlink_log_critical(mavlink_fd, "ERROR: sphere fit failed");
+				res = ERROR;
+			}
+		}
+
 		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 80);
 
-		if (!isfinite(sphere_x) || !isfinite(sphere_y) || !isfinite(sphere_z)) {
+		if (res == OK && (!isfinite(center[0]) || !isfinite(center[1]) || !isfinite(center[2]))) {
 			mavlink_log_critical(mavlink_fd, "ERROR: NaN in sphere fit");
 			res = ERROR;
 		}
 	}
 
-	if (x != NULL) {
-		free(x);
-	}
-
-	if (y != NULL) {
-		free(y);
-	}
-
-	if (z != NULL) {
-		free(z);
-	}
+	free(fit);
 
 	if (res == OK) {
 		/* apply calibration and set parameters */
@@ -238,9 +258,15 @@ int do_mag_calibration(int mavlink_fd)
 		}
 
 		if (res == OK) {
-			mscale.x_offset = sphere_x;
-			mscale.y_offset = sphere_y;
-			mscale.z_offset = sphere_z;
+			/* the samples were scaled by the current scale but not offset */
+			mscale.x_offset = center[0] / mscale.x_scale;
+			mscale.y_offset = center[1] / mscale.y_scale;
+			mscale.z_offset = center[2] / mscale.z_scale;
+
+			/* soft iron correction on top of the range calibration */
+			mscale.x_scale *= scale[0];
+			mscale.y_scale *= scale[1];
+			mscale.z_scale *= scale[2];
 
 			res = ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale);
 
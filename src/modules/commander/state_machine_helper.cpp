@@ -52,6 +52,7 @@
 #include <systemlib/systemlib.h>
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
+#include <systemlib/state_table.h>
 #include <drivers/drv_hrt.h>
 #include <drivers/drv_device.h>
 #include <mavlink/mavlink_log.h>
@@ -69,12 +70,17 @@ static bool arming_state_changed = true;
 static bool main_state_changed = true;
 static bool failsafe_state_changed = true;
 
+/* most recent transitions of each state machine, for diagnostics */
+static StateHistory<8> arming_history;
+static StateHistory<8> main_history;
+static StateHistory<8> failsafe_history;
+
 // This array defines the arming state transitions. The rows are the new state, and the columns
 // are the current state. Using new state and current  state you can index into the array which
 // will be true for a valid transition or false for a invalid transition. In some cases even
 // though the transition is marked as true additional checks must be made. See arming_state_transition
 // code for those checks.
-static const bool arming_transitions[ARMING_STATE_MAX][ARMING_STATE_MAX] = {
+static constexpr bool arming_transitions[ARMING_STATE_MAX][ARMING_STATE_MAX] = {
 	//                                  INIT,   STANDBY,    ARMED,  ARMED_ERROR,    STANDBY_ERROR,  REBOOT,     IN_AIR_RESTORE
 	{ /* ARMING_STATE_INIT */           true,   true,       false,  false,          false,          false,      false },
 	{ /* ARMING_STATE_STANDBY */        true,   true,       true,   true,           false,          false,      false },
@@ -85,6 +91,22 @@ static const bool arming_transitions[ARMING_STATE_MAX][ARMING_STATE_MAX] = {
 	{ /* ARMING_STATE_IN_AIR_RESTORE */ false,  false,      false,  false,          false,          false,      false }, // NYI
 };
 
+#define ARMING_MASK(_state) (1u << (_state))
+
+// The safety relevant properties of the table are checked at compile time
+static_assert(state_reachable_only_from(arming_transitions, ARMING_STATE_ARMED,
+					ARMING_MASK(ARMING_STATE_STANDBY) | ARMING_MASK(ARMING_STATE_ARMED) | ARMING_MASK(ARMING_STATE_IN_AIR_RESTORE)),
+	      "arming is only allowed from standby or in air restore");
+static_assert(state_reachable_only_from(arming_transitions, ARMING_STATE_ARMED_ERROR,
+					ARMING_MASK(ARMING_STATE_ARMED) | ARMING_MASK(ARMING_STATE_ARMED_ERROR)),
+	      "armed error can only be entered while armed");
+static_assert(state_reachable_only_from(arming_transitions, ARMING_STATE_REBOOT,
+					~(ARMING_MASK(ARMING_STATE_ARMED) | ARMING_MASK(ARMING_STATE_ARMED_ERROR))),
+	      "no reboot while armed");
+static_assert(state_reachable_only_from(arming_transitions, ARMING_STATE_INIT,
+					~(ARMING_MASK(ARMING_STATE_ARMED) | ARMING_MASK(ARMING_STATE_ARMED_ERROR))),
+	      "no reinitialization while armed");
+
 // You can index into the array with an arming_state_t in order to get it's textual representation
 static const char *state_names[ARMING_STATE_MAX] = {
 	"ARMING_STATE_INIT",
@@ -113,6 +135,7 @@ arming_state_transition(struct vehicle_status_s *status,            /// current
 	irqstate_t flags = irqsave();
 
 	transition_result_t ret = TRANSITION_DENIED;
+	arming_state_t requested_arming_state = new_arming_state;
 
 	/* only check transition if the new state is actually different from the current one */
 	if (new_arming_state == status->arming_state) {
@@ -164,6 +187,7 @@ arming_state_transition(struct vehicle_status_s *status,            /// current
 			armed->armed = new_arming_state == ARMING_STATE_ARMED || new_arming_state == ARMING_STATE_ARMED_ERROR;
 			armed->ready_to_arm = new_arming_state == ARMING_STATE_ARMED || new_arming_state == ARMING_STATE_STANDBY;
 			ret = TRANSITION_CHANGED;
+			arming_history.record(status->arming_state, requested_arming_state, new_arming_state);
 			status->arming_state = new_arming_state;
 			arming_state_changed = true;
 		}
@@ -255,6 +279,7 @@ main_state_transition(struct vehicle_status_s *status, main_state_t new_main_sta
 
 	if (ret == TRANSITION_CHANGED) {
 		if (status->main_state != new_main_state) {
+			main_history.record(status->main_state, new_main_state, new_main_state);
 			status->main_state = new_main_state;
 			main_state_changed = true;
 
@@ -290,6 +315,31 @@ check_failsafe_state_changed()
 	}
 }
 
+template <unsigned N>
+static void
+print_history(const char *name, const StateHistory<N> &history, const char *const names[], unsigned num_names)
+{
+	for (unsigned i = 0; i < history.count(); i++) {
+		const typename StateHistory<N>::Entry &e = history.get(i);
+
+		if (e.state < num_names && e.nextState < num_names) {
+			warnx("%s: %s -> %s", name, names[e.state], names[e.nextState]);
+		}
+	}
+}
+
+void
+print_state_history()
+{
+	static const char *const main_names[MAIN_STATE_MAX] = { "MANUAL", "ALTCTL", "POSCTL", "AUTO" };
+	static const char *const failsafe_names[FAILSAFE_STATE_MAX] = { "NORMAL", "RTL", "LAND", "TERMINATION" };
+
+	/* most recent transitions first */
+	print_history("arming", arming_history, state_names, ARMING_STATE_MAX);
+	print_history("main", main_history, main_names, MAIN_STATE_MAX);
+	print_history("failsafe", failsafe_history, failsafe_names, FAILSAFE_STATE_MAX);
+}
+
 /**
 * Transition from one hil state to another
 */
@@ -474,6 +524,7 @@ transition_result_t failsafe_state_transition(struct vehicle_status_s *status, f
 
 		if (ret == TRANSITION_CHANGED) {
 			if (status->failsafe_state != new_failsafe_state) {
+				failsafe_history.record(status->failsafe_state, new_failsafe_state, new_failsafe_state);
 				status->failsafe_state = new_failsafe_state;
 				failsafe_state_changed = true;
 
@@ -75,6 +75,11 @@ bool check_failsafe_state_changed();
 
 void set_navigation_state_changed();
 
+/**
+ * Print the most recent transitions of the arming, main and failsafe state machines.
+ */
+void print_state_history();
+
 int hil_state_transition(hil_state_t new_state, int status_pub, struct vehicle_status_s *current_state, const int mavlink_fd);
 
 #endif /* STATE_MACHINE_HELPER_H_ */
@@ -309,7 +309,7 @@ FixedwingAttitudeControl::FixedwingAttitudeControl() :
 	_actuators_1_pub(-1),
 
 /* performance counters */
-	_loop_perf(perf_alloc(PC_ELAPSED, "fw att control")),
+	_loop_perf(perf_alloc(PC_ELAPSED_HIST, "fw att control")),
 /* states */
 	_setpoint_valid(false)
 {
@@ -839,7 +839,9 @@ FixedwingAttitudeControl::task_main()
 
 			/* lazily publish the setpoint only once available */
 			_actuators.timestamp = hrt_absolute_time();
+			_actuators.timestamp_sample = _att.timestamp;
 			_actuators_airframe.timestamp = hrt_absolute_time();
+			_actuators_airframe.timestamp_sample = _att.timestamp;
 
 			if (_actuators_0_pub > 0) {
 				/* publish the attitude setpoint */
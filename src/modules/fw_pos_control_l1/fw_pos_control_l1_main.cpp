@@ -199,6 +199,13 @@ private:
 	bool _global_pos_valid;				///< global position is valid
 	math::Matrix<3, 3> _R_nb;			///< current attitude
 
+	/* waypoint geometry, updated when the triplet changes */
+	bool _wp_cache_valid;				///< false when the triplet changed since the last update
+	struct map_projection_reference_s _wp_ref;	///< local frame centered on the current waypoint
+	math::Vector<2> _prev_wp_local;			///< previous waypoint in the local frame (m), origin if invalid
+	float _prev_wp_distance;			///< distance from the previous to the current waypoint (m)
+	float _prev_wp_bearing;				///< bearing from the previous to the current waypoint
+
 	ECL_L1_Pos_Controller				_l1_control;
 	TECS						_tecs;
 
@@ -350,8 +357,16 @@ private:
 	bool		control_position(const math::Vector<2> &global_pos, const math::Vector<2> &ground_speed,
 					 const struct position_setpoint_triplet_s &_pos_sp_triplet);
 
+	/**
+	 * Project the waypoints of the triplet into a local frame.
+	 *
+	 * The frame is centered on the current waypoint, so distances and
+	 * bearings from the vehicle to it are preserved by the projection.
+	 */
+	void		update_waypoint_cache(const struct position_setpoint_triplet_s &pos_sp_triplet);
+
 	float calculate_target_airspeed(float airspeed_demand);
-	void calculate_gndspeed_undershoot(const math::Vector<2> &current_position, const math::Vector<2> &ground_speed, const struct position_setpoint_triplet_s &pos_sp_triplet);
+	void calculate_gndspeed_undershoot(const math::Vector<2> &current_position_local, const math::Vector<2> &ground_speed, const struct position_setpoint_triplet_s &pos_sp_triplet);
 
 	/**
 	 * Shim for calling task_main from task_create.
@@ -426,6 +441,11 @@ FixedwingPositionControl::FixedwingPositionControl() :
 	_airspeed_valid(false),
 	_groundspeed_undershoot(0.0f),
 	_global_pos_valid(false),
+	_wp_cache_valid(false),
+	_wp_ref(),
+	_prev_wp_local(),
+	_prev_wp_distance(0.0f),
+	_prev_wp_bearing(0.0f),
 	_att(),
 	_att_sp(),
 	_nav_capabilities(),
@@ -699,9 +719,36 @@ FixedwingPositionControl::vehicle_setpoint_poll()
 	if (pos_sp_triplet_updated) {
 		orb_copy(ORB_ID(position_setpoint_triplet), _pos_sp_triplet_sub, &_pos_sp_triplet);
 		_setpoint_valid = true;
+		_wp_cache_valid = false;
 	}
 }
 
+void
+FixedwingPositionControl::update_waypoint_cache(const struct position_setpoint_triplet_s &pos_sp_triplet)
+{
+	map_projection_init(&_wp_ref, pos_sp_triplet.current.lat, pos_sp_triplet.current.lon);
+
+	if (pos_sp_triplet.previous.valid) {
+		map_projection_project(&_wp_ref, pos_sp_triplet.previous.lat, pos_sp_triplet.previous.lon,
+				       &_prev_wp_local(0), &_prev_wp_local(1));
+		_prev_wp_distance = get_distance_to_next_waypoint(pos_sp_triplet.previous.lat, pos_sp_triplet.previous.lon,
+				    pos_sp_triplet.current.lat, pos_sp_triplet.current.lon);
+		_prev_wp_bearing = get_bearing_to_next_waypoint(pos_sp_triplet.previous.lat, pos_sp_triplet.previous.lon,
+				   pos_sp_triplet.current.lat, pos_sp_triplet.current.lon);
+
+	} else {
+		/*
+		 * No valid previous waypoint, go for the current wp.
+		 * This is automatically handled by the L1 library.
+		 */
+		_prev_wp_local.zero();
+		_prev_wp_distance = 0.0f;
+		_prev_wp_bearing = 0.0f;
+	}
+
+	_wp_cache_valid = true;
+}
+
 void
 FixedwingPositionControl::task_main_trampoline(int argc, char *argv[])
 {
@@ -740,7 +787,7 @@ FixedwingPositionControl::calculate_target_airspeed(float airspeed_demand)
 }
 
 void
-FixedwingPositionControl::calculate_gndspeed_undershoot(const math::Vector<2> &current_position, const math::Vector<2> &ground_speed, const struct position_setpoint_triplet_s &pos_sp_triplet)
+FixedwingPositionControl::calculate_gndspeed_undershoot(const math::Vector<2> &current_position_local, const math::Vector<2> &ground_speed, const struct position_setpoint_triplet_s &pos_sp_triplet)
 {
 
 	if (_global_pos_valid && !(pos_sp_triplet.current.type == SETPOINT_TYPE_LOITER)) {
@@ -754,10 +801,11 @@ FixedwingPositionControl::calculate_gndspeed_undershoot(const math::Vector<2> &c
 		float distance = 0.0f;
 		float delta_altitude = 0.0f;
 		if (pos_sp_triplet.previous.valid) {
-			distance = get_distance_to_next_waypoint(pos_sp_triplet.previous.lat, pos_sp_triplet.previous.lon, pos_sp_triplet.current.lat, pos_sp_triplet.current.lon);
+			distance = _prev_wp_distance;
 			delta_altitude = pos_sp_triplet.current.alt - pos_sp_triplet.previous.alt;
 		} else {
-			distance = get_distance_to_next_waypoint(current_position(0), current_position(1), pos_sp_triplet.current.lat, pos_sp_triplet.current.lon);
+			/* the local frame is centered on the current waypoint */
+			distance = current_position_local.length();
 			delta_altitude = pos_sp_triplet.current.alt -  _global_pos.alt;
 		}
 
@@ -812,7 +860,15 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 {
 	bool setpoint = true;
 
-	calculate_gndspeed_undershoot(current_position, ground_speed, pos_sp_triplet);
+	if (!_wp_cache_valid) {
+		update_waypoint_cache(pos_sp_triplet);
+	}
+
+	/* vehicle position in the local frame of the current waypoint, from the full precision estimate */
+	math::Vector<2> current_position_local;
+	map_projection_project(&_wp_ref, _global_pos.lat, _global_pos.lon, &current_position_local(0), &current_position_local(1));
+
+	calculate_gndspeed_undershoot(current_position_local, ground_speed, pos_sp_triplet);
 
 	float eas2tas = 1.0f; // XXX calculate actual number based on current measurements
 
@@ -841,33 +897,15 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 		/* restore speed weight, in case changed intermittently (e.g. in landing handling) */
 		_tecs.set_speed_weight(_parameters.speed_weight);
 
-		/* current waypoint (the one currently heading for) */
-		math::Vector<2> next_wp((float)pos_sp_triplet.current.lat, (float)pos_sp_triplet.current.lon);
-
-		/* current waypoint (the one currently heading for) */
-		math::Vector<2> curr_wp((float)pos_sp_triplet.current.lat, (float)pos_sp_triplet.current.lon);
-
+		/* current waypoint (the one currently heading for), the origin of the local frame */
+		math::Vector<2> curr_wp(0.0f, 0.0f);
 
 		/* previous waypoint */
-		math::Vector<2> prev_wp;
-
-		if (pos_sp_triplet.previous.valid) {
-			prev_wp(0) = (float)pos_sp_triplet.previous.lat;
-			prev_wp(1) = (float)pos_sp_triplet.previous.lon;
-
-		} else {
-			/*
-			 * No valid previous waypoint, go for the current wp.
-			 * This is automatically handled by the L1 library.
-			 */
-			prev_wp(0) = (float)pos_sp_triplet.current.lat;
-			prev_wp(1) = (float)pos_sp_triplet.current.lon;
-
-		}
+		const math::Vector<2> &prev_wp = _prev_wp_local;
 
 		if (pos_sp_triplet.current.type == SETPOINT_TYPE_NORMAL) {
 			/* waypoint is a plain navigation waypoint */
-			_l1_control.navigate_waypoints(prev_wp, curr_wp, current_position, ground_speed);
+			_l1_control.navigate_waypoints_local(prev_wp, curr_wp, current_position_local, ground_speed);
 			_att_sp.roll_body = _l1_control.nav_roll();
 			_att_sp.yaw_body = _l1_control.nav_bearing();
 
@@ -880,7 +918,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 		} else if (pos_sp_triplet.current.type == SETPOINT_TYPE_LOITER) {
 
 			/* waypoint is a loiter waypoint */
-			_l1_control.navigate_loiter(curr_wp, current_position, pos_sp_triplet.current.loiter_radius,
+			_l1_control.navigate_loiter_local(curr_wp, current_position_local, pos_sp_triplet.current.loiter_radius,
 						  pos_sp_triplet.current.loiter_direction, ground_speed);
 			_att_sp.roll_body = _l1_control.nav_roll();
 			_att_sp.yaw_body = _l1_control.nav_bearing();
@@ -893,11 +931,11 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 
 		} else if (pos_sp_triplet.current.type == SETPOINT_TYPE_LAND) {
 
-			float bearing_lastwp_currwp = get_bearing_to_next_waypoint(prev_wp(0), prev_wp(1), curr_wp(0), curr_wp(1));
+			float bearing_lastwp_currwp = _prev_wp_bearing;
 
 			/* Horizontal landing control */
 			/* switch to heading hold for the last meters, continue heading hold after */
-			float wp_distance = get_distance_to_next_waypoint(current_position(0), current_position(1), curr_wp(0), curr_wp(1));
+			float wp_distance = (curr_wp - current_position_local).length();
 			//warnx("wp dist: %d, alt err: %d, noret: %s", (int)wp_distance, (int)altitude_error, (land_noreturn) ? "YES" : "NO");
 			if (wp_distance < _parameters.land_heading_hold_horizontal_distance || land_noreturn_horizontal) {
 
@@ -924,7 +962,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 			} else {
 
 				/* normal navigation */
-				_l1_control.navigate_waypoints(prev_wp, curr_wp, current_position, ground_speed);
+				_l1_control.navigate_waypoints_local(prev_wp, curr_wp, current_position_local, ground_speed);
 			}
 
 			_att_sp.roll_body = _l1_control.nav_roll();
@@ -947,10 +985,10 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 			float airspeed_approach = 1.3f * _parameters.airspeed_min;
 
 			/* Calculate distance (to landing waypoint) and altitude of last ordinary waypoint L */
-			float L_wp_distance = get_distance_to_next_waypoint(prev_wp(0), prev_wp(1), curr_wp(0), curr_wp(1));
+			float L_wp_distance = _prev_wp_distance;
 			float L_altitude_rel = landingslope.getLandingSlopeRelativeAltitude(L_wp_distance);
 
-			float bearing_airplane_currwp = get_bearing_to_next_waypoint(current_position(0), current_position(1), curr_wp(0), curr_wp(1));
+			float bearing_airplane_currwp = atan2f(curr_wp(1) - current_position_local(1), curr_wp(0) - current_position_local(0));
 			float landing_slope_alt_rel_desired = landingslope.getLandingSlopeRelativeAltitudeSave(wp_distance, bearing_lastwp_currwp, bearing_airplane_currwp);
 
 			float relative_alt = get_relative_landingalt(_pos_sp_triplet.current.alt, _global_pos.alt, _range_finder, _parameters.range_finder_rel_alt);
@@ -1047,7 +1085,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 				}
 			}
 
-			_l1_control.navigate_waypoints(prev_wp, curr_wp, current_position, ground_speed);
+			_l1_control.navigate_waypoints_local(prev_wp, curr_wp, current_position_local, ground_speed);
 			_att_sp.roll_body = _l1_control.nav_roll();
 			_att_sp.yaw_body = _l1_control.nav_bearing();
 
@@ -1083,8 +1121,8 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 
 		// warnx("nav bearing: %8.4f bearing err: %8.4f target bearing: %8.4f", (double)_l1_control.nav_bearing(),
 		//       (double)_l1_control.bearing_error(), (double)_l1_control.target_bearing());
-		// warnx("prev wp: %8.4f/%8.4f, next wp: %8.4f/%8.4f prev:%s", (double)prev_wp(0), (double)prev_wp(1),
-		//       (double)next_wp(0), (double)next_wp(1), (pos_sp_triplet.previous_valid) ? "valid" : "invalid");
+		// warnx("prev wp: %8.1f/%8.1f m, pos: %8.1f/%8.1f m prev:%s", (double)prev_wp(0), (double)prev_wp(1),
+		//       (double)current_position_local(0), (double)current_position_local(1), (pos_sp_triplet.previous.valid) ? "valid" : "invalid");
 
 		// XXX at this point we always want no loiter hold if a
 		// mission is active
@@ -95,6 +95,9 @@ static const int ERROR = -1;
 
 static Mavlink *_mavlink_instances = nullptr;
 
+/* text messages for all instances, each instance reads it with its own cursor */
+static struct mavlink_logqueue _mavlink_logqueue;
+
 /* TODO: if this is a class member it crashes */
 static struct file_operations fops;
 
@@ -216,6 +219,7 @@ Mavlink::Mavlink() :
 	_task_should_exit(false),
 	_mavlink_fd(-1),
 	_task_running(false),
+	_logqueue_reader(-1),
 	_hil_enabled(false),
 	_use_hil_gps(false),
 	_is_usb_uart(false),
@@ -362,6 +366,37 @@ Mavlink::get_instance_for_device(const char *device_name)
 	return nullptr;
 }
 
+void
+Mavlink::status()
+{
+	printf("\t%s: %d B/s", _device_name, _datarate);
+
+	if (_logqueue_reader >= 0) {
+		const struct mavlink_logqueue_reader *r = &_mavlink_logqueue.readers[_logqueue_reader];
+		printf(", text messages sent: %u lost: %u\n", (unsigned)r->read, (unsigned)r->lost);
+
+	} else {
+		printf(", no text messages\n");
+	}
+}
+
+int
+Mavlink::status_all_instances()
+{
+	Mavlink *inst;
+
+	warnx("%u instances", Mavlink::instance_count());
+
+	LL_FOREACH(::_mavlink_instances, inst) {
+		inst->status();
+	}
+
+	printf("\ttext messages queued: %u dropped: %u\n",
+	       (unsigned)_mavlink_logqueue.head, (unsigned)_mavlink_logqueue.dropped);
+
+	return OK;
+}
+
 int
 Mavlink::destroy_all_instances()
 {
@@ -471,18 +506,25 @@ Mavlink::mavlink_dev_ioctl(struct file *filep, int cmd, unsigned long arg)
 	case (int)MAVLINK_IOC_SEND_TEXT_EMERGENCY: {
 
 			const char *txt = (const char *)arg;
-//		printf("logmsg: %s\n", txt);
-			struct mavlink_logmessage msg;
-			strncpy(msg.text, txt, sizeof(msg.text));
+			int severity;
 
-			Mavlink *inst;
-			LL_FOREACH(_mavlink_instances, inst) {
-				if (!inst->_task_should_exit) {
-					mavlink_logbuffer_write(&inst->_logbuffer, &msg);
-					inst->_total_counter++;
-				}
+			switch (cmd) {
+			case (int)MAVLINK_IOC_SEND_TEXT_EMERGENCY:
+				severity = MAV_SEVERITY_EMERGENCY;
+				break;
+
+			case (int)MAVLINK_IOC_SEND_TEXT_CRITICAL:
+				severity = MAV_SEVERITY_CRITICAL;
+				break;
+
+			default:
+				severity = MAV_SEVERITY_INFO;
+				break;
 			}
 
+			/* lock-free, callers never wait for the links */
+			mavlink_logqueue_write(&_mavlink_logqueue, severity, txt);
+
 			return OK;
 		}
 
@@ -1543,10 +1585,16 @@ Mavlink::mavlink_missionlib_send_message(mavlink_message_t *msg)
 
 int
 Mavlink::mavlink_missionlib_send_gcs_string(const char *string)
+{
+	return send_statustext(MAV_SEVERITY_INFO, string);
+}
+
+int
+Mavlink::send_statustext(int severity, const char *string)
 {
 	const int len = MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN;
 	mavlink_statustext_t statustext;
-	statustext.severity = MAV_SEVERITY_INFO;
+	statustext.severity = severity;
 
 	int i = 0;
 
@@ -1918,8 +1966,12 @@ Mavlink::task_main(int argc, char *argv[])
 		return ERROR;
 	}
 
-	/* initialize mavlink text message buffering */
-	mavlink_logbuffer_init(&_logbuffer, 5);
+	/* receive text messages */
+	_logqueue_reader = mavlink_logqueue_attach(&_mavlink_logqueue);
+
+	if (_logqueue_reader < 0) {
+		warnx("no text message reader left, not sending text messages");
+	}
 
 	/* if we are passing on mavlink messages, we need to prepare a buffer for this instance */
 	if (_passing_on) {
@@ -2074,13 +2126,11 @@ Mavlink::task_main(int argc, char *argv[])
 			mavlink_pm_queued_send();
 			mavlink_waypoint_eventloop(hrt_absolute_time());
 
-			if (!mavlink_logbuffer_is_empty(&_logbuffer)) {
-				struct mavlink_logmessage msg;
-				int lb_ret = mavlink_logbuffer_read(&_logbuffer, &msg);
+			/* one text message per tick, the tick rate scales with the link data rate */
+			struct mavlink_logmessage msg;
 
-				if (lb_ret == OK) {
-					mavlink_missionlib_send_gcs_string(msg.text);
-				}
+			if ((_logqueue_reader >= 0) && (mavlink_logqueue_read(&_mavlink_logqueue, _logqueue_reader, &msg) == 0)) {
+				send_statustext(msg.severity, msg.text);
 			}
 		}
 
@@ -2163,8 +2213,8 @@ Mavlink::task_main(int argc, char *argv[])
 		message_buffer_destroy();
 		pthread_mutex_destroy(&_message_buffer_mutex);
 	}
-	/* destroy log buffer */
-	mavlink_logbuffer_destroy(&_logbuffer);
+	/* stop receiving text messages */
+	mavlink_logqueue_detach(&_mavlink_logqueue, _logqueue_reader);
 
 	warnx("exiting");
 	_task_running = false;
@@ -2231,12 +2281,6 @@ Mavlink::start(int argc, char *argv[])
 	return OK;
 }
 
-void
-Mavlink::status()
-{
-	warnx("running");
-}
-
 int
 Mavlink::stream(int argc, char *argv[])
 {
@@ -2302,7 +2346,7 @@ Mavlink::stream(int argc, char *argv[])
 
 static void usage()
 {
-	warnx("usage: mavlink {start|stop-all|stream} [-d device] [-b baudrate] [-r rate] [-m mode] [-s stream] [-f] [-p] [-v] [-w]");
+	warnx("usage: mavlink {start|stop-all|stream|status} [-d device] [-b baudrate] [-r rate] [-m mode] [-s stream] [-f] [-p] [-v] [-w]");
 }
 
 int mavlink_main(int argc, char *argv[])
@@ -2323,8 +2367,8 @@ int mavlink_main(int argc, char *argv[])
 	} else if (!strcmp(argv[1], "stop-all")) {
 		return Mavlink::destroy_all_instances();
 
-		// } else if (!strcmp(argv[1], "status")) {
-		// 	mavlink::g_mavlink->status();
+	} else if (!strcmp(argv[1], "status")) {
+		return Mavlink::status_all_instances();
 
 	} else if (!strcmp(argv[1], "stream")) {
 		return Mavlink::stream(argc, argv);
@@ -124,6 +124,11 @@ public:
 	 */
 	void		status();
 
+	/**
+	 * Display the status of all instances and the shared text message queue.
+	 */
+	static int	status_all_instances();
+
 	static int stream(int argc, char *argv[]);
 
 	static int	instance_count();
@@ -242,8 +247,7 @@ private:
 	uint8_t _mavlink_wpm_comp_id;
 	mavlink_channel_t _channel;
 
-	struct mavlink_logbuffer _logbuffer;
-	unsigned int _total_counter;
+	int _logqueue_reader;	/**< cursor in the shared text message queue, -1 if none */
 
 	pthread_t _receive_thread;
 
@@ -342,6 +346,11 @@ private:
 	void mavlink_missionlib_send_message(mavlink_message_t *msg);
 	int mavlink_missionlib_send_gcs_string(const char *string);
 
+	/**
+	 * Send a STATUSTEXT message with the given MAV_SEVERITY.
+	 */
+	int send_statustext(int severity, const char *string);
+
 	int mavlink_open_uart(int baudrate, const char *uart_name, struct termios *uart_config_original, bool *is_usb);
 
 	int configure_stream(const char *stream_name, const float rate);
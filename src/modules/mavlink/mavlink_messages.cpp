@@ -40,6 +40,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <commander/px4_custom_mode.h>
 #include <lib/geo/geo.h>
 
@@ -70,6 +71,7 @@
 #include <uORB/topics/airspeed.h>
 #include <uORB/topics/battery_status.h>
 #include <uORB/topics/navigation_capabilities.h>
+#include <uORB/topics/system_profile.h>
 #include <drivers/drv_rc_input.h>
 #include <drivers/drv_pwm_output.h>
 #include <drivers/drv_range_finder.h>
@@ -1272,6 +1274,72 @@ protected:
 	}
 };
 
+/**
+ * Stream the system profile as NAMED_VALUE_FLOAT messages.
+ *
+ * One value is sent per call, cycling through the CPU share of every task
+ * (in percent, named after the task) and the p99 or average of every perf
+ * counter (in microseconds), so the stream rate sets the bandwidth used.
+ */
+class MavlinkStreamSystemProfile : public MavlinkStream
+{
+public:
+	const char *get_name()
+	{
+		return "SYSTEM_PROFILE";
+	}
+
+	MavlinkStream *new_instance()
+	{
+		return new MavlinkStreamSystemProfile();
+	}
+
+private:
+	MavlinkOrbSubscription *profile_sub;
+	struct system_profile_s *profile;
+	unsigned next;
+
+protected:
+	void subscribe(Mavlink *mavlink)
+	{
+		profile_sub = mavlink->add_orb_subscription(ORB_ID(system_profile));
+		profile = (struct system_profile_s *)profile_sub->get_data();
+		next = 0;
+	}
+
+	void send(const hrt_abstime t)
+	{
+		(void)profile_sub->update(t);
+
+		unsigned entries = profile->task_count + profile->counter_count;
+
+		if (entries == 0) {
+			return;
+		}
+
+		if (next >= entries) {
+			next = 0;
+		}
+
+		char name[10];
+		float value;
+
+		if (next < profile->task_count) {
+			strncpy(name, profile->tasks[next].name, sizeof(name));
+			value = profile->tasks[next].load * 0.01f;
+
+		} else {
+			struct system_profile_counter_s *ctr = &profile->counters[next - profile->task_count];
+			strncpy(name, ctr->name, sizeof(name));
+			value = (ctr->p99 > 0) ? ctr->p99 : ctr->average;
+		}
+
+		/* the name field is not necessarily null terminated */
+		mavlink_msg_named_value_float_send(_channel, profile->timestamp / 1000, name, value);
+		next++;
+	}
+};
+
 class MavlinkStreamCameraCapture : public MavlinkStream
 {
 public:
@@ -1384,6 +1452,7 @@ MavlinkStream *streams_list[] = {
 	new MavlinkStreamOpticalFlow(),
 	new MavlinkStreamAttitudeControls(),
 	new MavlinkStreamNamedValueFloat(),
+	new MavlinkStreamSystemProfile(),
 	new MavlinkStreamCameraCapture(),
 	new MavlinkStreamDistanceSensor(),
 	new MavlinkStreamViconPositionEstimate(),
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file attitude_error.cpp
+ *
+ * Attitude error computation of the multicopter attitude controller.
+ *
+ * @author Anton Babushkin <anton.babushkin@me.com>
+ */
+
+#include <math.h>
+
+#include "attitude_error.h"
+
+namespace mc_att_control
+{
+
+void
+attitude_error_dcm(const math::Matrix<3, 3> &R, const math::Matrix<3, 3> &R_sp,
+		   math::Vector<3> &e_R, float &yaw_w)
+{
+	math::Matrix<3, 3> I;
+	I.identity();
+
+	/* try to move thrust vector shortest way, because yaw response is slower than roll/pitch */
+	math::Vector<3> R_z(R(0, 2), R(1, 2), R(2, 2));
+	math::Vector<3> R_sp_z(R_sp(0, 2), R_sp(1, 2), R_sp(2, 2));
+
+	/* axis and sin(angle) of desired rotation */
+	e_R = R.transposed() * (R_z % R_sp_z);
+
+	/* calculate angle error */
+	float e_R_z_sin = e_R.length();
+	float e_R_z_cos = R_z * R_sp_z;
+
+	/* calculate weight for yaw control */
+	yaw_w = R_sp(2, 2) * R_sp(2, 2);
+
+	/* calculate rotation matrix after roll/pitch only rotation */
+	math::Matrix<3, 3> R_rp;
+
+	if (e_R_z_sin > 0.0f) {
+		/* get axis-angle representation */
+		float e_R_z_angle = atan2f(e_R_z_sin, e_R_z_cos);
+		math::Vector<3> e_R_z_axis = e_R / e_R_z_sin;
+
+		e_R = e_R_z_axis * e_R_z_angle;
+
+		/* cross product matrix for e_R_axis */
+		math::Matrix<3, 3> e_R_cp;
+		e_R_cp.zero();
+		e_R_cp(0, 1) = -e_R_z_axis(2);
+		e_R_cp(0, 2) = e_R_z_axis(1);
+		e_R_cp(1, 0) = e_R_z_axis(2);
+		e_R_cp(1, 2) = -e_R_z_axis(0);
+		e_R_cp(2, 0) = -e_R_z_axis(1);
+		e_R_cp(2, 1) = e_R_z_axis(0);
+
+		/* rotation matrix for roll/pitch only rotation */
+		R_rp = R * (I + e_R_cp * e_R_z_sin + e_R_cp * e_R_cp * (1.0f - e_R_z_cos));
+
+	} else {
+		/* zero roll/pitch rotation */
+		R_rp = R;
+	}
+
+	/* R_rp and R_sp has the same Z axis, calculate yaw error */
+	math::Vector<3> R_sp_x(R_sp(0, 0), R_sp(1, 0), R_sp(2, 0));
+	math::Vector<3> R_rp_x(R_rp(0, 0), R_rp(1, 0), R_rp(2, 0));
+	e_R(2) = atan2f((R_rp_x % R_sp_x) * R_sp_z, R_rp_x * R_sp_x) * yaw_w;
+
+	if (e_R_z_cos < 0.0f) {
+		/* for large thrust vector rotations use another rotation method:
+		 * calculate angle and axis for R -> R_sp rotation directly */
+		math::Quaternion q;
+		q.from_dcm(R.transposed() * R_sp);
+		math::Vector<3> e_R_d = q.imag();
+		float e_R_d_sin = e_R_d.length();
+
+		if (q(0) < 0.0f) {
+			/* take the shortest way, q and -q describe the same rotation */
+			e_R_d *= -1.0f;
+			q(0) = -q(0);
+		}
+
+		if (e_R_d_sin > 0.0f) {
+			e_R_d *= 2.0f * atan2f(e_R_d_sin, q(0)) / e_R_d_sin;
+		}
+
+		/* use fusion of Z axis based rotation and direct rotation */
+		float direct_w = e_R_z_cos * e_R_z_cos * yaw_w;
+		e_R = e_R * (1.0f - direct_w) + e_R_d * direct_w;
+	}
+}
+
+void
+attitude_error_quat(const math::Quaternion &q, const math::Quaternion &q_sp,
+		    math::Vector<3> &e_R, float &yaw_w)
+{
+	/* rotation from current to setpoint attitude in body frame, i.e. R^T * R_sp */
+	math::Quaternion q_e = q.conjugated() * q_sp;
+
+	/* setpoint thrust axis in body frame, third column of R^T * R_sp */
+	float v_x = 2.0f * (q_e(0) * q_e(2) + q_e(1) * q_e(3));
+	float v_y = 2.0f * (q_e(2) * q_e(3) - q_e(0) * q_e(1));
+	float v_z = q_e(0) * q_e(0) - q_e(1) * q_e(1) - q_e(2) * q_e(2) + q_e(3) * q_e(3);
+
+	/* axis (body Z cross setpoint Z) and sin / cos of the thrust vector error */
+	float e_R_z_sin = sqrtf(v_x * v_x + v_y * v_y);
+	float e_R_z_cos = v_z;
+
+	/* calculate weight for yaw control, R_sp(2, 2) squared */
+	float R_sp_22 = q_sp(0) * q_sp(0) - q_sp(1) * q_sp(1) - q_sp(2) * q_sp(2) + q_sp(3) * q_sp(3);
+	yaw_w = R_sp_22 * R_sp_22;
+
+	/* remaining rotation after the roll/pitch only rotation, a rotation around Z */
+	math::Quaternion q_yaw = q_e;
+
+	if (e_R_z_sin > 0.0f) {
+		/* roll/pitch error in axis-angle representation */
+		float k = atan2f(e_R_z_sin, e_R_z_cos) / e_R_z_sin;
+		e_R(0) = -v_y * k;
+		e_R(1) = v_x * k;
+
+		/* shortest arc rotation of body Z to setpoint Z: (1 + cos, axis * sin) normalized */
+		float w = 1.0f + e_R_z_cos;
+		float n = sqrtf(w * w + e_R_z_sin * e_R_z_sin);
+
+		if (n > 0.0f) {
+			math::Quaternion q_rp_inv(w / n, v_y / n, -v_x / n, 0.0f);
+			q_yaw = q_rp_inv * q_e;
+		}
+
+	} else {
+		e_R(0) = 0.0f;
+		e_R(1) = 0.0f;
+	}
+
+	/* yaw error, taking the shortest way */
+	if (q_yaw(0) < 0.0f) {
+		e_R(2) = 2.0f * atan2f(-q_yaw(3), -q_yaw(0)) * yaw_w;
+
+	} else {
+		e_R(2) = 2.0f * atan2f(q_yaw(3), q_yaw(0)) * yaw_w;
+	}
+
+	if (e_R_z_cos < 0.0f) {
+		/* for large thrust vector rotations use another rotation method:
+		 * angle and axis of the direct rotation to the setpoint */
+		float s = (q_e(0) < 0.0f) ? -1.0f : 1.0f;
+		math::Vector<3> e_R_d(s * q_e(1), s * q_e(2), s * q_e(3));
+		float e_R_d_sin = e_R_d.length();
+
+		if (e_R_d_sin > 0.0f) {
+			e_R_d *= 2.0f * atan2f(e_R_d_sin, s * q_e(0)) / e_R_d_sin;
+		}
+
+		/* use fusion of Z axis based rotation and direct rotation */
+		float direct_w = e_R_z_cos * e_R_z_cos * yaw_w;
+		e_R = e_R * (1.0f - direct_w) + e_R_d * direct_w;
+	}
+}
+
+}
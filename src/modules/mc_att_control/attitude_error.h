@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file attitude_error.h
+ *
+ * Attitude error computation of the multicopter attitude controller.
+ *
+ * Both functions compute the same error vector: the roll/pitch part
+ * rotates the thrust vector the shortest way to the setpoint, the yaw
+ * part is weighted by how vertical the setpoint thrust vector is, and for
+ * large thrust vector errors the direct rotation to the setpoint is blended in.
+ *
+ * The direct rotation always takes the shortest way, i.e. its angle is
+ * within [-pi, pi] independent of the sign of the quaternion representing
+ * it. Before the error computation was moved here the DCM path used the
+ * sign from_dcm() happened to produce, so for a roll error of -170 degrees
+ * it commanded +190 degrees instead.
+ *
+ * The DCM variant is the original rotation matrix formulation, the
+ * quaternion variant works on the relative rotation only and needs no
+ * matrix temporaries. They are kept side by side for A/B comparison.
+ */
+
+#pragma once
+
+#include <mathlib/mathlib.h>
+
+namespace mc_att_control
+{
+
+/**
+ * Attitude error from rotation matrices.
+ *
+ * @param R		current attitude, body to world
+ * @param R_sp		attitude setpoint, body to world
+ * @param e_R		attitude error in body frame, rad
+ * @param yaw_w		weight of the yaw control
+ */
+void	attitude_error_dcm(const math::Matrix<3, 3> &R, const math::Matrix<3, 3> &R_sp,
+			   math::Vector<3> &e_R, float &yaw_w);
+
+/**
+ * Attitude error from quaternions.
+ *
+ * @param q		current attitude, body to world, unit length
+ * @param q_sp		attitude setpoint, body to world, unit length
+ * @param e_R		attitude error in body frame, rad
+ * @param yaw_w		weight of the yaw control
+ */
+void	attitude_error_quat(const math::Quaternion &q, const math::Quaternion &q_sp,
+			    math::Vector<3> &e_R, float &yaw_w);
+
+}
@@ -75,6 +75,8 @@
 #include <lib/mathlib/mathlib.h>
 #include <lib/geo/geo.h>
 
+#include "attitude_error.h"
+
 /**
  * Multicopter attitude control app start / stop handling function
  *
@@ -132,6 +134,7 @@ private:
 	struct actuator_armed_s				_armed;				/**< actuator arming status */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
+	perf_counter_t	_att_err_perf;		/**< attitude error computation performance counter */
 
 	math::Vector<3>		_rates_prev;	/**< angular rates on previous step */
 	math::Vector<3>		_rates_sp;		/**< angular rates setpoint */
@@ -139,8 +142,6 @@ private:
 	float				_thrust_sp;		/**< thrust setpoint */
 	math::Vector<3>		_att_control;	/**< attitude control vector */
 
-	math::Matrix<3, 3>  _I;				/**< identity matrix */
-
 	bool	_reset_yaw_sp;			/**< reset yaw setpoint flag */
 
 	struct {
@@ -162,6 +163,8 @@ private:
 		param_t man_roll_max;
 		param_t man_pitch_max;
 		param_t man_yaw_max;
+
+		param_t att_quat;
 	}		_params_handles;		/**< handles for interesting parameters */
 
 	struct {
@@ -175,6 +178,8 @@ private:
 		float man_roll_max;
 		float man_pitch_max;
 		float man_yaw_max;
+
+		bool att_quat;						/**< use quaternion based attitude error */
 	}		_params;
 
 	/**
@@ -264,7 +269,8 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_actuators_0_pub(-1),
 
 /* performance counters */
-	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control"))
+	_loop_perf(perf_alloc(PC_ELAPSED_HIST, "mc_att_control")),
+	_att_err_perf(perf_alloc(PC_ELAPSED, "mc_att_control_err"))
 
 {
 	memset(&_v_att, 0, sizeof(_v_att));
@@ -284,6 +290,7 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_params.man_roll_max = 0.0f;
 	_params.man_pitch_max = 0.0f;
 	_params.man_yaw_max = 0.0f;
+	_params.att_quat = false;
 
 	_rates_prev.zero();
 	_rates_sp.zero();
@@ -291,8 +298,6 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_thrust_sp = 0.0f;
 	_att_control.zero();
 
-	_I.identity();
-
 	_params_handles.roll_p			= 	param_find("MC_ROLL_P");
 	_params_handles.roll_rate_p		= 	param_find("MC_ROLLRATE_P");
 	_params_handles.roll_rate_i		= 	param_find("MC_ROLLRATE_I");
@@ -310,6 +315,7 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_params_handles.man_roll_max	= 	param_find("MC_MAN_R_MAX");
 	_params_handles.man_pitch_max	= 	param_find("MC_MAN_P_MAX");
 	_params_handles.man_yaw_max		= 	param_find("MC_MAN_Y_MAX");
+	_params_handles.att_quat		= 	param_find("MC_ATT_QUAT");
 
 	/* fetch initial parameter values */
 	parameters_update();
@@ -386,6 +392,11 @@ MulticopterAttitudeControl::parameters_update()
 	_params.man_pitch_max = math::radians(_params.man_pitch_max);
 	_params.man_yaw_max = math::radians(_params.man_yaw_max);
 
+	/* attitude error formulation */
+	int32_t att_quat;
+	param_get(_params_handles.att_quat, &att_quat);
+	_params.att_quat = (att_quat != 0);
+
 	return OK;
 }
 
@@ -573,73 +584,40 @@ MulticopterAttitudeControl::control_attitude(float dt)
 		}
 	}
 
-	/* rotation matrix for current state */
-	math::Matrix<3, 3> R;
-	R.set(_v_att.R);
-
 	/* all input data is ready, run controller itself */
+	math::Vector<3> e_R;
+	float yaw_w;
 
-	/* try to move thrust vector shortest way, because yaw response is slower than roll/pitch */
-	math::Vector<3> R_z(R(0, 2), R(1, 2), R(2, 2));
-	math::Vector<3> R_sp_z(R_sp(0, 2), R_sp(1, 2), R_sp(2, 2));
-
-	/* axis and sin(angle) of desired rotation */
-	math::Vector<3> e_R = R.transposed() * (R_z % R_sp_z);
-
-	/* calculate angle error */
-	float e_R_z_sin = e_R.length();
-	float e_R_z_cos = R_z * R_sp_z;
+	perf_begin(_att_err_perf);
 
-	/* calculate weight for yaw control */
-	float yaw_w = R_sp(2, 2) * R_sp(2, 2);
-
-	/* calculate rotation matrix after roll/pitch only rotation */
-	math::Matrix<3, 3> R_rp;
+	if (_params.att_quat) {
+		/* current attitude as quaternion, from the estimator if it provides one */
+		math::Quaternion q;
 
-	if (e_R_z_sin > 0.0f) {
-		/* get axis-angle representation */
-		float e_R_z_angle = atan2f(e_R_z_sin, e_R_z_cos);
-		math::Vector<3> e_R_z_axis = e_R / e_R_z_sin;
+		if (_v_att.q_valid) {
+			q.set(_v_att.q);
 
-		e_R = e_R_z_axis * e_R_z_angle;
+		} else {
+			math::Matrix<3, 3> R;
+			R.set(_v_att.R);
+			q.from_dcm(R);
+		}
 
-		/* cross product matrix for e_R_axis */
-		math::Matrix<3, 3> e_R_cp;
-		e_R_cp.zero();
-		e_R_cp(0, 1) = -e_R_z_axis(2);
-		e_R_cp(0, 2) = e_R_z_axis(1);
-		e_R_cp(1, 0) = e_R_z_axis(2);
-		e_R_cp(1, 2) = -e_R_z_axis(0);
-		e_R_cp(2, 0) = -e_R_z_axis(1);
-		e_R_cp(2, 1) = e_R_z_axis(0);
+		math::Quaternion q_sp;
+		q_sp.from_dcm(R_sp);
 
-		/* rotation matrix for roll/pitch only rotation */
-		R_rp = R * (_I + e_R_cp * e_R_z_sin + e_R_cp * e_R_cp * (1.0f - e_R_z_cos));
+		mc_att_control::attitude_error_quat(q, q_sp, e_R, yaw_w);
 
 	} else {
-		/* zero roll/pitch rotation */
-		R_rp = R;
-	}
-
-	/* R_rp and R_sp has the same Z axis, calculate yaw error */
-	math::Vector<3> R_sp_x(R_sp(0, 0), R_sp(1, 0), R_sp(2, 0));
-	math::Vector<3> R_rp_x(R_rp(0, 0), R_rp(1, 0), R_rp(2, 0));
-	e_R(2) = atan2f((R_rp_x % R_sp_x) * R_sp_z, R_rp_x * R_sp_x) * yaw_w;
+		/* rotation matrix for current state */
+		math::Matrix<3, 3> R;
+		R.set(_v_att.R);
 
-	if (e_R_z_cos < 0.0f) {
-		/* for large thrust vector rotations use another rotation method:
-		 * calculate angle and axis for R -> R_sp rotation directly */
-		math::Quaternion q;
-		q.from_dcm(R.transposed() * R_sp);
-		math::Vector<3> e_R_d = q.imag();
-		e_R_d.normalize();
-		e_R_d *= 2.0f * atan2f(e_R_d.length(), q(0));
-
-		/* use fusion of Z axis based rotation and direct rotation */
-		float direct_w = e_R_z_cos * e_R_z_cos * yaw_w;
-		e_R = e_R * (1.0f - direct_w) + e_R_d * direct_w;
+		mc_att_control::attitude_error_dcm(R, R_sp, e_R, yaw_w);
 	}
 
+	perf_end(_att_err_perf);
+
 	/* calculate angular rates setpoint */
 	_rates_sp = _params.att_p.emult(e_R);
 
@@ -798,6 +776,7 @@ MulticopterAttitudeControl::task_main()
 				_actuators.control[2] = (isfinite(_att_control(2))) ? _att_control(2) : 0.0f;
 				_actuators.control[3] = (isfinite(_thrust_sp)) ? _thrust_sp : 0.0f;
 				_actuators.timestamp = hrt_absolute_time();
+				_actuators.timestamp_sample = _v_att.timestamp;
 
 				if (_actuators_0_pub > 0) {
 					orb_publish(ORB_ID(actuator_controls_0), _actuators_0_pub, &_actuators);
@@ -215,3 +215,15 @@ PARAM_DEFINE_FLOAT(MC_MAN_P_MAX, 35.0f);
  * @group Multicopter Attitude Control
  */
 PARAM_DEFINE_FLOAT(MC_MAN_Y_MAX, 120.0f);
+
+/**
+ * Quaternion based attitude error
+ *
+ * Compute the attitude error from quaternions instead of rotation matrices.
+ * Both formulations give the same result, the quaternion one is cheaper.
+ *
+ * @min 0
+ * @max 1
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_INT32(MC_ATT_QUAT, 0);
@@ -38,4 +38,5 @@
 MODULE_COMMAND	= mc_att_control
 
 SRCS		= mc_att_control_main.cpp \
+			  attitude_error.cpp \
 			  mc_att_control_params.c
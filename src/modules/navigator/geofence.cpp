@@ -43,6 +43,7 @@
 #include <string.h>
 #include <dataman/dataman.h>
 #include <systemlib/err.h>
+#include <mathlib/mathlib.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
@@ -62,6 +63,7 @@ Geofence::Geofence() :
 		_altitude_min(0),
 		_altitude_max(0),
 		_verticesCount(0),
+		_verticesLoaded(false),
 		param_geofence_on(this, "ON")
 {
 	/* Load initial params */
@@ -103,17 +105,18 @@ bool Geofence::inside(double lat, double lon, float altitude)
 
 			bool c = false;
 
-			struct fence_vertex_s temp_vertex_i;
-			struct fence_vertex_s temp_vertex_j;
+			if (!loadVertices()) {
+				return c;
+			}
+
+			/* quick reject */
+			if (lat < _fenceBox.lat_min || lat > _fenceBox.lat_max || lon < _fenceBox.lon_min || lon > _fenceBox.lon_max) {
+				return c;
+			}
 
-			/* Red until fence is finished */
 			for (unsigned i = 0, j = _verticesCount - 1; i < _verticesCount; j = i++) {
-				if (dm_read(DM_KEY_FENCE_POINTS, i, &temp_vertex_i, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
-				if (dm_read(DM_KEY_FENCE_POINTS, j, &temp_vertex_j, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
-				}
+				const struct fence_vertex_s &temp_vertex_i = _vertices[i];
+				const struct fence_vertex_s &temp_vertex_j = _vertices[j];
 
 				// skip vertex 0 (return point)
 				if (((temp_vertex_i.lon) >= lon != (temp_vertex_j.lon >= lon)) &&
@@ -136,6 +139,99 @@ bool Geofence::inside(double lat, double lon, float altitude)
 	}
 }
 
+/*
+ * Orientation of point c relative to the line a-b, > 0 if left, < 0 if right.
+ */
+static double
+orientation(double lat_a, double lon_a, double lat_b, double lon_b, double lat_c, double lon_c)
+{
+	return (lon_b - lon_a) * (lat_c - lat_a) - (lat_b - lat_a) * (lon_c - lon_a);
+}
+
+bool Geofence::crosses(double lat_a, double lon_a, double lat_b, double lon_b)
+{
+	if (!active() || !loadVertices()) {
+		return false;
+	}
+
+	struct box leg;
+	leg.lat_min = (lat_a < lat_b) ? lat_a : lat_b;
+	leg.lat_max = (lat_a < lat_b) ? lat_b : lat_a;
+	leg.lon_min = (lon_a < lon_b) ? lon_a : lon_b;
+	leg.lon_max = (lon_a < lon_b) ? lon_b : lon_a;
+
+	/* a leg that does not touch the fence box can't cross an edge */
+	if (leg.lat_max < _fenceBox.lat_min || leg.lat_min > _fenceBox.lat_max ||
+	    leg.lon_max < _fenceBox.lon_min || leg.lon_min > _fenceBox.lon_max) {
+		return false;
+	}
+
+	for (unsigned i = 0, j = _verticesCount - 1; i < _verticesCount; j = i++) {
+		const struct box &e = _edgeBox[i];
+
+		if (leg.lat_max < e.lat_min || leg.lat_min > e.lat_max ||
+		    leg.lon_max < e.lon_min || leg.lon_min > e.lon_max) {
+			continue;
+		}
+
+		double lat_i = _vertices[i].lat;
+		double lon_i = _vertices[i].lon;
+		double lat_j = _vertices[j].lat;
+		double lon_j = _vertices[j].lon;
+
+		/* proper or touching intersection: the end points of each segment are not on the same side of the other */
+		double o1 = orientation(lat_a, lon_a, lat_b, lon_b, lat_j, lon_j);
+		double o2 = orientation(lat_a, lon_a, lat_b, lon_b, lat_i, lon_i);
+		double o3 = orientation(lat_j, lon_j, lat_i, lon_i, lat_a, lon_a);
+		double o4 = orientation(lat_j, lon_j, lat_i, lon_i, lat_b, lon_b);
+
+		if (((o1 <= 0.0 && o2 >= 0.0) || (o1 >= 0.0 && o2 <= 0.0)) &&
+		    ((o3 <= 0.0 && o4 >= 0.0) || (o3 >= 0.0 && o4 <= 0.0)) &&
+		    !(o1 == 0.0 && o2 == 0.0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool
+Geofence::loadVertices()
+{
+	if (_verticesLoaded) {
+		return true;
+	}
+
+	if (_verticesCount == 0 || _verticesCount > GEOFENCE_MAX_VERTICES) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < _verticesCount; i++) {
+		if (dm_read(DM_KEY_FENCE_POINTS, i, &_vertices[i], sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
+			return false;
+		}
+	}
+
+	_fenceBox.lat_min = _fenceBox.lat_max = _vertices[0].lat;
+	_fenceBox.lon_min = _fenceBox.lon_max = _vertices[0].lon;
+
+	for (unsigned i = 0, j = _verticesCount - 1; i < _verticesCount; j = i++) {
+		struct box &e = _edgeBox[i];
+		e.lat_min = math::min(_vertices[i].lat, _vertices[j].lat);
+		e.lat_max = math::max(_vertices[i].lat, _vertices[j].lat);
+		e.lon_min = math::min(_vertices[i].lon, _vertices[j].lon);
+		e.lon_max = math::max(_vertices[i].lon, _vertices[j].lon);
+
+		_fenceBox.lat_min = math::min(_fenceBox.lat_min, e.lat_min);
+		_fenceBox.lat_max = math::max(_fenceBox.lat_max, e.lat_max);
+		_fenceBox.lon_min = math::min(_fenceBox.lon_min, e.lon_min);
+		_fenceBox.lon_max = math::max(_fenceBox.lon_max, e.lon_max);
+	}
+
+	_verticesLoaded = true;
+	return true;
+}
+
 bool
 Geofence::valid()
 {
@@ -160,6 +256,9 @@ Geofence::addPoint(int argc, char *argv[])
 	struct fence_vertex_s vertex;
 	char *end;
 
+	/* the stored fence changes */
+	_verticesLoaded = false;
+
 	if ((argc == 1) && (strcmp("-clear", argv[0]) == 0)) {
 		dm_clear(DM_KEY_FENCE_POINTS);
 		publishFence(0);
@@ -293,5 +392,6 @@ Geofence::loadFromFile(const char *filename)
 
 int Geofence::clearDm()
 {
+	_verticesLoaded = false;
 	dm_clear(DM_KEY_FENCE_POINTS);
 }
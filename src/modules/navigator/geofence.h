@@ -57,6 +57,27 @@ private:
 
 	unsigned 			_verticesCount;
 
+	/* in memory copy of the fence vertices, loaded from the dataman on first use */
+	struct fence_vertex_s	_vertices[GEOFENCE_MAX_VERTICES];
+	bool			_verticesLoaded;
+
+	/* bounding boxes of the fence and of each edge (edge i runs from vertex i - 1 to i) */
+	struct box {
+		double lat_min;
+		double lat_max;
+		double lon_min;
+		double lon_max;
+	};
+	struct box		_fenceBox;
+	struct box		_edgeBox[GEOFENCE_MAX_VERTICES];
+
+	/**
+	 * Load the vertices from the dataman into memory, if not done yet.
+	 *
+	 * @return true if the vertices are available
+	 */
+	bool loadVertices();
+
 	/* Params */
 	control::BlockParamInt param_geofence_on;
 public:
@@ -74,6 +95,22 @@ public:
 	bool inside(const struct vehicle_global_position_s *craft);
 	bool inside(double lat, double lon, float altitude);
 
+	/**
+	 * Return whether the straight leg from A to B crosses the fence boundary.
+	 *
+	 * Uses the same planar lat/lon approximation as inside(). Edges whose
+	 * bounding box does not overlap the one of the leg are skipped.
+	 *
+	 * @return true if the leg intersects any fence edge, false otherwise
+	 *	   or if the geofence is disabled, empty or invalid
+	 */
+	bool crosses(double lat_a, double lon_a, double lat_b, double lon_b);
+
+	/**
+	 * Return whether the geofence is enabled and has vertices to check against.
+	 */
+	bool active() { return param_geofence_on.get() == 1 && !isEmpty() && valid(); }
+
 	int clearDm();
 
 	bool valid();
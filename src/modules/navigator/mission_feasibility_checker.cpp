@@ -57,6 +57,9 @@
 #endif
 static const int ERROR = -1;
 
+/* number of geofence violations reported individually */
+#define GEOFENCE_REPORT_MAX	5
+
 MissionFeasibilityChecker::MissionFeasibilityChecker() : _mavlink_fd(-1), _capabilities_sub(-1), _initDone(false)
 {
 	_nav_caps = {0};
@@ -96,27 +99,83 @@ bool MissionFeasibilityChecker::checkMissionFeasibleFixedwing(dm_item_t dm_curre
 	return (checkFixedWingLanding(dm_current, nMissionItems) && checkGeofence(dm_current, nMissionItems, geofence));
 }
 
+/*
+ * Mission items that carry a position the vehicle flies to.
+ */
+static bool
+has_position(const struct mission_item_s &item)
+{
+	switch (item.nav_cmd) {
+	case NAV_CMD_WAYPOINT:
+	case NAV_CMD_LOITER_UNLIMITED:
+	case NAV_CMD_LOITER_TURN_COUNT:
+	case NAV_CMD_LOITER_TIME_LIMIT:
+	case NAV_CMD_LAND:
+	case NAV_CMD_TAKEOFF:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
 bool MissionFeasibilityChecker::checkGeofence(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence)
 {
-	/* Check if all mission items are inside the geofence (if we have a valid geofence) */
-	if (geofence.valid()) {
-		for (size_t i = 0; i < nMissionItems; i++) {
-			struct mission_item_s missionitem;
-			const ssize_t len = sizeof(missionitem);
-
-			if (dm_read(dm_current, i, &missionitem, len) != len) {
-				/* not supposed to happen unless the datamanager can't access the SD card, etc. */
-				return false;
-			}
+	/*
+	 * Check if all mission items and the legs between them are inside the
+	 * geofence (if we have an active geofence). Every item is read once and
+	 * the fence is kept in memory by Geofence, all violations are reported.
+	 */
+	if (!geofence.active()) {
+		return true;
+	}
+
+	unsigned violations = 0;
+	bool have_previous = false;
+	size_t previous_index = 0;
+	double previous_lat = 0.0;
+	double previous_lon = 0.0;
+
+	for (size_t i = 0; i < nMissionItems; i++) {
+		struct mission_item_s missionitem;
+		const ssize_t len = sizeof(missionitem);
 
-			if (!geofence.inside(missionitem.lat, missionitem.lon, missionitem.altitude)) { //xxx: handle relative altitude
+		if (dm_read(dm_current, i, &missionitem, len) != len) {
+			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
+			return false;
+		}
+
+		if (!has_position(missionitem)) {
+			continue;
+		}
+
+		if (!geofence.inside(missionitem.lat, missionitem.lon, missionitem.altitude)) { //xxx: handle relative altitude
+			if (violations < GEOFENCE_REPORT_MAX) {
 				mavlink_log_info(_mavlink_fd, "#audio: Geofence violation waypoint %d", i);
-				return false;
 			}
+
+			violations++;
+
+		} else if (have_previous && geofence.crosses(previous_lat, previous_lon, missionitem.lat, missionitem.lon)) {
+			/* both ends inside, but the leg leaves the (non convex) fence */
+			if (violations < GEOFENCE_REPORT_MAX) {
+				mavlink_log_info(_mavlink_fd, "#audio: Geofence violation leg %d to %d", previous_index, i);
+			}
+
+			violations++;
 		}
+
+		have_previous = true;
+		previous_index = i;
+		previous_lat = missionitem.lat;
+		previous_lon = missionitem.lon;
+	}
+
+	if (violations > GEOFENCE_REPORT_MAX) {
+		mavlink_log_info(_mavlink_fd, "#audio: %u geofence violations in total", violations);
 	}
 
-	return true;
+	return violations == 0;
 }
 
 bool MissionFeasibilityChecker::checkFixedWingLanding(dm_item_t dm_current, size_t nMissionItems)
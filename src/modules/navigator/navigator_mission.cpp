@@ -61,20 +61,27 @@ Mission::Mission() :
 	_onboard_mission_item_count(0),
 	_onboard_mission_allowed(false),
 	_current_mission_type(MISSION_TYPE_NONE),
-	_mission_result_pub(-1)
+	_mission_result_pub(-1),
+	_cache_hits(perf_alloc(PC_COUNT, "mission cache hit")),
+	_cache_stalls(perf_alloc(PC_COUNT, "mission cache stall")),
+	_cache_prefetches(perf_alloc(PC_COUNT, "mission cache prefetch"))
 {
 	memset(&_mission_result, 0, sizeof(struct mission_result_s));
+	invalidate_cache();
 }
 
 Mission::~Mission()
 {
-
+	perf_free(_cache_hits);
+	perf_free(_cache_stalls);
+	perf_free(_cache_prefetches);
 }
 
 void
 Mission::set_offboard_dataman_id(int new_id)
 {
 	_offboard_dataman_id = new_id;
+	invalidate_cache();
 }
 
 void
@@ -112,13 +119,16 @@ Mission::set_current_onboard_mission_index(int new_index)
 void
 Mission::set_offboard_mission_count(unsigned new_count)
 {
+	/* called on every mission update, the stored items may have changed */
 	_offboard_mission_item_count = new_count;
+	invalidate_cache();
 }
 
 void
 Mission::set_onboard_mission_count(unsigned new_count)
 {
 	_onboard_mission_item_count = new_count;
+	invalidate_cache();
 }
 
 void
@@ -146,9 +156,7 @@ Mission::get_current_mission_item(struct mission_item_s *new_mission_item, bool
 	/* try onboard mission first */
 	if (current_onboard_mission_available()) {
 
-		const ssize_t len = sizeof(struct mission_item_s);
-
-		if (dm_read(DM_KEY_WAYPOINTS_ONBOARD, _current_onboard_mission_index, new_mission_item, len) != len) {
+		if (read_mission_item(DM_KEY_WAYPOINTS_ONBOARD, _current_onboard_mission_index, new_mission_item) != OK) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return ERROR;
 		}
@@ -161,18 +169,7 @@ Mission::get_current_mission_item(struct mission_item_s *new_mission_item, bool
 
 	} else if (current_offboard_mission_available()) {
 
-		dm_item_t dm_current;
-
-		if (_offboard_dataman_id == 0) {
-			dm_current = DM_KEY_WAYPOINTS_OFFBOARD_0;
-
-		} else {
-			dm_current = DM_KEY_WAYPOINTS_OFFBOARD_1;
-		}
-
-		const ssize_t len = sizeof(struct mission_item_s);
-
-		if (dm_read(dm_current, _current_offboard_mission_index, new_mission_item, len) != len) {
+		if (read_mission_item(offboard_dm_item(), _current_offboard_mission_index, new_mission_item) != OK) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			_current_mission_type = MISSION_TYPE_NONE;
 			return ERROR;
@@ -197,9 +194,7 @@ Mission::get_next_mission_item(struct mission_item_s *new_mission_item)
 	/* try onboard mission first */
 	if (next_onboard_mission_available()) {
 
-		const ssize_t len = sizeof(struct mission_item_s);
-
-		if (dm_read(DM_KEY_WAYPOINTS_ONBOARD, _current_onboard_mission_index + 1, new_mission_item, len) != len) {
+		if (read_mission_item(DM_KEY_WAYPOINTS_ONBOARD, _current_onboard_mission_index + 1, new_mission_item) != OK) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return ERROR;
 		}
@@ -208,18 +203,7 @@ Mission::get_next_mission_item(struct mission_item_s *new_mission_item)
 
 	} else if (next_offboard_mission_available()) {
 
-		dm_item_t dm_current;
-
-		if (_offboard_dataman_id == 0) {
-			dm_current = DM_KEY_WAYPOINTS_OFFBOARD_0;
-
-		} else {
-			dm_current = DM_KEY_WAYPOINTS_OFFBOARD_1;
-		}
-
-		const ssize_t len = sizeof(struct mission_item_s);
-
-		if (dm_read(dm_current, _current_offboard_mission_index + 1, new_mission_item, len) != len) {
+		if (read_mission_item(offboard_dm_item(), _current_offboard_mission_index + 1, new_mission_item) != OK) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return ERROR;
 		}
@@ -232,6 +216,124 @@ Mission::get_next_mission_item(struct mission_item_s *new_mission_item)
 	return OK;
 }
 
+dm_item_t
+Mission::offboard_dm_item()
+{
+	if (_offboard_dataman_id == 0) {
+		return DM_KEY_WAYPOINTS_OFFBOARD_0;
+
+	} else {
+		return DM_KEY_WAYPOINTS_OFFBOARD_1;
+	}
+}
+
+int
+Mission::read_mission_item(dm_item_t dm_item, unsigned index, struct mission_item_s *mission_item)
+{
+	for (unsigned i = 0; i < MISSION_CACHE_SIZE; i++) {
+		if (_cache[i].valid && _cache[i].dm_item == dm_item && _cache[i].index == index) {
+			memcpy(mission_item, &_cache[i].mission_item, sizeof(struct mission_item_s));
+			perf_count(_cache_hits);
+			return OK;
+		}
+	}
+
+	/* not prefetched, this blocks on the storage */
+	perf_count(_cache_stalls);
+
+	const ssize_t len = sizeof(struct mission_item_s);
+
+	if (dm_read(dm_item, index, mission_item, len) != len) {
+		/* not supposed to happen unless the datamanager can't access the SD card, etc. */
+		return ERROR;
+	}
+
+	return OK;
+}
+
+void
+Mission::invalidate_cache()
+{
+	for (unsigned i = 0; i < MISSION_CACHE_SIZE; i++) {
+		_cache[i].valid = false;
+	}
+}
+
+bool
+Mission::cache_window(dm_item_t *dm_item, unsigned *first, unsigned *count)
+{
+	/* same precedence as get_current_mission_item */
+	if (current_onboard_mission_available()) {
+		*dm_item = DM_KEY_WAYPOINTS_ONBOARD;
+		*first = _current_onboard_mission_index;
+		*count = _onboard_mission_item_count;
+
+	} else if (current_offboard_mission_available()) {
+		*dm_item = offboard_dm_item();
+		*first = _current_offboard_mission_index;
+		*count = _offboard_mission_item_count;
+
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+void
+Mission::prefetch()
+{
+	dm_item_t dm_item;
+	unsigned first;
+	unsigned count;
+
+	if (!cache_window(&dm_item, &first, &count)) {
+		return;
+	}
+
+	for (unsigned index = first; index < first + MISSION_CACHE_SIZE && index < count; index++) {
+
+		bool cached = false;
+		int victim = -1;
+
+		for (unsigned i = 0; i < MISSION_CACHE_SIZE; i++) {
+			if (_cache[i].valid && _cache[i].dm_item == dm_item && _cache[i].index == index) {
+				cached = true;
+				break;
+			}
+
+			/* entries outside of the window are free to reuse */
+			if (victim < 0 && (!_cache[i].valid || _cache[i].dm_item != dm_item ||
+					   _cache[i].index < first || _cache[i].index >= first + MISSION_CACHE_SIZE)) {
+				victim = i;
+			}
+		}
+
+		if (cached) {
+			continue;
+		}
+
+		if (victim < 0) {
+			/* cannot happen, the window is as large as the cache */
+			return;
+		}
+
+		struct cache_entry &entry = _cache[victim];
+		const ssize_t len = sizeof(struct mission_item_s);
+
+		entry.valid = false;
+
+		if (dm_read(dm_item, index, &entry.mission_item, len) == len) {
+			entry.dm_item = dm_item;
+			entry.index = index;
+			entry.valid = true;
+			perf_count(_cache_prefetches);
+		}
+
+		/* at most one read per call, do not hold up the navigator loop */
+		return;
+	}
+}
 
 bool
 Mission::current_onboard_mission_available()
@@ -42,6 +42,8 @@
 
 #include <uORB/topics/mission.h>
 #include <uORB/topics/mission_result.h>
+#include <dataman/dataman.h>
+#include <systemlib/perf_counter.h>
 
 
 class __EXPORT Mission
@@ -73,6 +75,16 @@ public:
 
 	void		move_to_next();
 
+	/**
+	 * Read ahead the mission items around the current one.
+	 *
+	 * Fills one missing entry of the look-ahead window (current, next
+	 * and the one after) per call, so that the items are in memory when
+	 * a waypoint is reached. Call this once per navigator loop, after
+	 * the time critical work.
+	 */
+	void		prefetch();
+
 	void		report_mission_item_reached();
 	void		report_current_offboard_mission_item();
 	void		publish_mission_result();
@@ -83,6 +95,26 @@ private:
 	bool		next_onboard_mission_available();
 	bool		next_offboard_mission_available();
 
+	dm_item_t	offboard_dm_item();
+
+	/**
+	 * Get a mission item from the look-ahead window, or read it from the
+	 * dataman if it has not been prefetched.
+	 */
+	int		read_mission_item(dm_item_t dm_item, unsigned index, struct mission_item_s *mission_item);
+
+	/**
+	 * Drop all prefetched items, the stored missions have changed.
+	 */
+	void		invalidate_cache();
+
+	/**
+	 * Look-ahead window of the active mission: storage and first index.
+	 *
+	 * @return false if no mission is active
+	 */
+	bool		cache_window(dm_item_t *dm_item, unsigned *first, unsigned *count);
+
 	int 		_offboard_dataman_id;
 	unsigned	_current_offboard_mission_index;
 	unsigned	_current_onboard_mission_index;
@@ -100,6 +132,21 @@ private:
 	int		_mission_result_pub;
 
 	struct mission_result_s _mission_result;
+
+	static const unsigned MISSION_CACHE_SIZE = 3;	/**< current, next and the one after */
+
+	struct cache_entry {
+		bool			valid;
+		dm_item_t		dm_item;
+		unsigned		index;
+		struct mission_item_s	mission_item;
+	};
+
+	struct cache_entry _cache[MISSION_CACHE_SIZE];
+
+	perf_counter_t	_cache_hits;		/**< items served from the look-ahead window */
+	perf_counter_t	_cache_stalls;		/**< items read from the dataman on demand */
+	perf_counter_t	_cache_prefetches;	/**< items read ahead */
 };
 
 #endif
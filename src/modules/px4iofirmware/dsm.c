@@ -61,6 +61,14 @@ static unsigned dsm_partial_frame_count;	/**< Count of bytes received for curren
 static unsigned dsm_channel_shift;			/**< Channel resolution, 0=unknown, 1=10 bit, 2=11 bit */
 static unsigned dsm_frame_drops;			/**< Count of incomplete DSM frames */
 
+/**
+ * Map from DSM channel numbers to R/C input channels.
+ *
+ * The first four channels in rc_channel_data are roll, pitch, thrust, yaw,
+ * but the first four channels from the DSM receiver are thrust, roll, pitch, yaw.
+ */
+static const uint8_t dsm_channel_map[16] = { 2, 0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
 /**
  * Attempt to decode a single channel raw channel datum
  *
@@ -107,9 +115,10 @@ dsm_decode_channel(uint16_t raw, unsigned shift, unsigned *channel, unsigned *va
  * Attempt to guess if receiving 10 or 11 bit channel values
  *
  * @param[in] reset true=reset the 10/11 bit state to unknown
+ * @param[in] frame dsm frame to sniff, unused on reset
  */
 static void
-dsm_guess_format(bool reset)
+dsm_guess_format(bool reset, const uint8_t *frame)
 {
 	static uint32_t	cs10;
 	static uint32_t	cs11;
@@ -127,7 +136,7 @@ dsm_guess_format(bool reset)
 	/* scan the channels in the current dsm_frame in both 10- and 11-bit mode */
 	for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++) {
 
-		uint8_t *dp = &dsm_frame[2 + (2 * i)];
+		const uint8_t *dp = &frame[2 + (2 * i)];
 		uint16_t raw = (dp[0] << 8) | dp[1];
 		unsigned channel, value;
 
@@ -191,7 +200,7 @@ dsm_guess_format(bool reset)
 
 	/* call ourselves to reset our state ... we have to try again */
 	debug("DSM: format detect fail, 10: 0x%08x %d 11: 0x%08x %d", cs10, votes10, cs11, votes11);
-	dsm_guess_format(true);
+	dsm_guess_format(true, NULL);
 }
 
 /**
@@ -228,7 +237,7 @@ dsm_init(const char *device)
 		dsm_last_rx_time = hrt_absolute_time();
 
 		/* reset the format detector */
-		dsm_guess_format(true);
+		dsm_guess_format(true, NULL);
 
 		debug("DSM: ready");
 
@@ -279,7 +288,7 @@ dsm_bind(uint16_t cmd, int pulses)
 #else /* CONFIG_ARCH_BOARD_PX4IO_V2 */
 		POWER_SPEKTRUM(1);
 #endif
-		dsm_guess_format(true);
+		dsm_guess_format(true, NULL);
 		break;
 
 	case dsm_bind_set_rx_out:
@@ -313,31 +322,32 @@ dsm_bind(uint16_t cmd, int pulses)
  * Decode the entire dsm frame (all contained channels)
  *
  * @param[in] frame_time timestamp when this dsm frame was received. Used to detect RX loss in order to reset 10/11 bit guess.
+ * @param[in] frame the DSM_FRAME_SIZE bytes of the dsm frame
  * @param[out] values pointer to per channel array of decoded values
  * @param[out] num_values pointer to number of raw channel values returned
  * @return true=DSM frame successfully decoded, false=no update
  */
-static bool
-dsm_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values)
+bool
+dsm_decode(hrt_abstime frame_time, const uint8_t *frame, uint16_t *values, uint16_t *num_values)
 {
 	/*
 	debug("DSM dsm_frame %02x%02x %02x%02x %02x%02x %02x%02x %02x%02x %02x%02x %02x%02x %02x%02x",
-		dsm_frame[0], dsm_frame[1], dsm_frame[2], dsm_frame[3], dsm_frame[4], dsm_frame[5], dsm_frame[6], dsm_frame[7],
-		dsm_frame[8], dsm_frame[9], dsm_frame[10], dsm_frame[11], dsm_frame[12], dsm_frame[13], dsm_frame[14], dsm_frame[15]);
+		frame[0], frame[1], frame[2], frame[3], frame[4], frame[5], frame[6], frame[7],
+		frame[8], frame[9], frame[10], frame[11], frame[12], frame[13], frame[14], frame[15]);
 	*/
 	/*
 	 * If we have lost signal for at least a second, reset the
 	 * format guessing heuristic.
 	 */
 	if (((frame_time - dsm_last_frame_time) > 1000000) && (dsm_channel_shift != 0))
-		dsm_guess_format(true);
+		dsm_guess_format(true, NULL);
 
 	/* we have received something we think is a dsm_frame */
 	dsm_last_frame_time = frame_time;
 
 	/* if we don't know the dsm_frame format, update the guessing state machine */
 	if (dsm_channel_shift == 0) {
-		dsm_guess_format(false);
+		dsm_guess_format(false, frame);
 		return false;
 	}
 
@@ -350,17 +360,27 @@ dsm_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values)
 	 * either 10 or 11 bits. The MSB may also be set to indicate the
 	 * second dsm_frame in variants of the protocol where more than
 	 * seven channels are being transmitted.
+	 *
+	 * The format is locked at this point, so the field layout is
+	 * fixed for the whole frame.
 	 */
+	const unsigned shift = dsm_channel_shift;
+	const unsigned data_mask = (1 << shift) - 1;
+
+	/* convert 0-1024 / 0-2048 values to 1000-2000 ppm encoding, 10 bit values are doubled */
+	const unsigned value_shift = 11 - shift;
 
 	for (unsigned i = 0; i < DSM_FRAME_CHANNELS; i++) {
 
-		uint8_t *dp = &dsm_frame[2 + (2 * i)];
-		uint16_t raw = (dp[0] << 8) | dp[1];
-		unsigned channel, value;
+		const uint8_t *dp = &frame[2 + (2 * i)];
+		unsigned raw = (dp[0] << 8) | dp[1];
 
-		if (!dsm_decode_channel(raw, dsm_channel_shift, &channel, &value))
+		/* unused channel slot */
+		if (raw == 0xffff)
 			continue;
 
+		unsigned channel = (raw >> shift) & 0xf;
+
 		/* ignore channels out of range */
 		if (channel >= PX4IO_RC_INPUT_CHANNELS)
 			continue;
@@ -369,9 +389,7 @@ dsm_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values)
 		if (channel >= *num_values)
 			*num_values = channel + 1;
 
-		/* convert 0-1024 / 0-2048 values to 1000-2000 ppm encoding. */
-		if (dsm_channel_shift == 10)
-			value *= 2;
+		int value = (raw & data_mask) << value_shift;
 
 		/*
 		 * Spektrum scaling is special. There are these basic considerations
@@ -387,32 +405,13 @@ dsm_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values)
 		 */
 
 		/* scaled integer for decent accuracy while staying efficient */
-		value = ((((int)value - 1024) * 1000) / 1700) + 1500;
+		value = (((value - 1024) * 1000) / 1700) + 1500;
 
 		/*
 		 * Store the decoded channel into the R/C input buffer, taking into
 		 * account the different ideas about channel assignement that we have.
-		 *
-		 * Specifically, the first four channels in rc_channel_data are roll, pitch, thrust, yaw,
-		 * but the first four channels from the DSM receiver are thrust, roll, pitch, yaw.
 		 */
-		switch (channel) {
-		case 0:
-			channel = 2;
-			break;
-
-		case 1:
-			channel = 0;
-			break;
-
-		case 2:
-			channel = 1;
-
-		default:
-			break;
-		}
-
-		values[channel] = value;
+		values[dsm_channel_map[channel]] = value;
 	}
 
 	/*
@@ -499,5 +498,5 @@ dsm_input(uint16_t *values, uint16_t *num_values)
 	 * decode it.
 	 */
 	dsm_partial_frame_count = 0;
-	return dsm_decode(now, values, num_values);
+	return dsm_decode(now, dsm_frame, values, num_values);
 }
@@ -74,7 +74,10 @@
 #define REG_TO_FLOAT(_reg)	((float)REG_TO_SIGNED(_reg) / 10000.0f)
 #define FLOAT_TO_REG(_float)	SIGNED_TO_REG((int16_t)((_float) * 10000.0f))
 
-#define PX4IO_PROTOCOL_VERSION		4
+#define PX4IO_PROTOCOL_VERSION		5
+
+/* oldest protocol version the FMU still talks to, without PX4IO_PAGE_EXCHANGE */
+#define PX4IO_PROTOCOL_VERSION_MIN	4
 
 /* maximum allowable sizes on this protocol version */
 #define PX4IO_PROTOCOL_MAX_CONTROL_COUNT	8	/**< The protocol does not support more than set here, individual units might support less - see PX4IO_P_CONFIG_CONTROL_COUNT */
@@ -162,6 +165,22 @@
 #define PX4IO_PAGE_PWM_INFO		7
 #define PX4IO_RATE_MAP_BASE			0	/* 0..CONFIG_ACTUATOR_COUNT bitmaps of PWM rate groups */
 
+/*
+ * Combined status summary, protocol version 5 and later.
+ *
+ * Snapshot of the registers the FMU polls every cycle, so that they can be
+ * fetched in a single read, or returned as the reply to a PKT_CODE_EXCHANGE
+ * transaction that also carries the actuator controls.
+ */
+#define PX4IO_PAGE_EXCHANGE		8
+#define PX4IO_P_EXCHANGE_STATUS			0	/* PX4IO_P_STATUS_FLAGS..PX4IO_P_STATUS_VRSSI */
+#define PX4IO_P_EXCHANGE_STATUS_COUNT		6
+#define PX4IO_P_EXCHANGE_SERVOS			6	/* first PX4IO_P_EXCHANGE_SERVO_COUNT servo PWM values */
+#define PX4IO_P_EXCHANGE_SERVO_COUNT		8
+#define PX4IO_P_EXCHANGE_RAW_RC			14	/* PX4IO_P_RAW_RC_COUNT..PX4IO_P_RAW_RC_BASE + PX4IO_P_EXCHANGE_RC_COUNT - 1 */
+#define PX4IO_P_EXCHANGE_RC_COUNT		10	/* raw RC channels included */
+#define PX4IO_P_EXCHANGE_SIZE			30	/* fits the 62 byte I2C transfer limit */
+
 /* setup page */
 #define PX4IO_PAGE_SETUP		50
 #define PX4IO_P_SETUP_FEATURES			0
@@ -303,6 +322,7 @@ struct IOPacket {
 
 #define PKT_CODE_READ		0x00	/* FMU->IO read transaction */
 #define PKT_CODE_WRITE		0x40	/* FMU->IO write transaction */
+#define PKT_CODE_EXCHANGE	0x80	/* FMU->IO write transaction, reply carries PX4IO_PAGE_EXCHANGE */
 #define PKT_CODE_SUCCESS	0x00	/* IO->FMU success reply */
 #define PKT_CODE_CORRUPT	0x40	/* IO->FMU bad packet reply */
 #define PKT_CODE_ERROR		0x80	/* IO->FMU register op error reply */
@@ -44,6 +44,8 @@
 
 #include <board_config.h>
 
+#include <drivers/drv_hrt.h>
+
 #include "protocol.h"
 
 #include <systemlib/pwm_limit/pwm_limit.h>
@@ -201,6 +203,17 @@ extern void	interface_tick(void);
 extern int	registers_set(uint8_t page, uint8_t offset, const uint16_t *values, unsigned num_values);
 extern int	registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_values);
 
+/**
+ * Handle a serial request packet, replacing it with the reply.
+ *
+ * The packet CRC must have been checked by the caller, which keeps the
+ * only user of the CRC table in serial.c.
+ *
+ * @return	0 on success, -EINVAL on register access error,
+ *		-EPROTO on an unknown request code.
+ */
+extern int	registers_handle_packet(struct IOPacket *pkt);
+
 /**
  * Sensors/misc inputs
  */
@@ -216,9 +229,11 @@ extern void	controls_init(void);
 extern void	controls_tick(void);
 extern int	dsm_init(const char *device);
 extern bool	dsm_input(uint16_t *values, uint16_t *num_values);
+extern bool	dsm_decode(hrt_abstime frame_time, const uint8_t *frame, uint16_t *values, uint16_t *num_values);
 extern void	dsm_bind(uint16_t cmd, int pulses);
 extern int	sbus_init(const char *device);
 extern bool	sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, uint16_t max_channels);
+extern bool	sbus_decode(hrt_abstime frame_time, const uint8_t *frame, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, uint16_t max_channels);
 extern bool	sbus1_output(uint16_t *values, uint16_t num_values);
 extern bool	sbus2_output(uint16_t *values, uint16_t num_values);
 
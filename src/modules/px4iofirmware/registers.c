@@ -42,6 +42,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include <drivers/drv_hrt.h>
 #include <drivers/drv_pwm_output.h>
@@ -138,6 +139,7 @@ uint16_t		r_page_rc_input[] = {
  *
  * PAGE 6 Raw ADC input.
  * PAGE 7 PWM rate maps.
+ * PAGE 8 Combined status summary.
  */
 uint16_t		r_page_scratch[32];
 
@@ -704,111 +706,119 @@ registers_set_one(uint8_t page, uint8_t offset, uint16_t value)
 	return 0;
 }
 
-uint8_t last_page;
-uint8_t last_offset;
-
-int
-registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_values)
+/*
+ * Refresh the status page values that are sampled at read time.
+ */
+static void
+registers_update_status(void)
 {
-#define SELECT_PAGE(_page_name)							\
-	do {									\
-		*values = &_page_name[0];					\
-		*num_values = sizeof(_page_name) / sizeof(_page_name[0]);	\
-	} while(0)
-
-	switch (page) {
-
-	/*
-	 * Handle pages that are updated dynamically at read time.
-	 */
-	case PX4IO_PAGE_STATUS:
-		/* PX4IO_P_STATUS_FREEMEM */
-		{
-			struct mallinfo minfo = mallinfo();
-			r_page_status[PX4IO_P_STATUS_FREEMEM] = minfo.fordblks;
-		}
+	/* PX4IO_P_STATUS_FREEMEM */
+	{
+		struct mallinfo minfo = mallinfo();
+		r_page_status[PX4IO_P_STATUS_FREEMEM] = minfo.fordblks;
+	}
 
-		/* XXX PX4IO_P_STATUS_CPULOAD */
+	/* XXX PX4IO_P_STATUS_CPULOAD */
 
-		/* PX4IO_P_STATUS_FLAGS maintained externally */
+	/* PX4IO_P_STATUS_FLAGS maintained externally */
 
-		/* PX4IO_P_STATUS_ALARMS maintained externally */
+	/* PX4IO_P_STATUS_ALARMS maintained externally */
 
 #ifdef ADC_VBATT
-		/* PX4IO_P_STATUS_VBATT */
-		{
-			/*
-			 * Coefficients here derived by measurement of the 5-16V
-			 * range on one unit:
-			 *
-			 * V   counts
-			 *  5  1001
-			 *  6  1219
-			 *  7  1436
-			 *  8  1653
-			 *  9  1870
-			 * 10  2086
-			 * 11  2303
-			 * 12  2522
-			 * 13  2738
-			 * 14  2956
-			 * 15  3172
-			 * 16  3389
-			 *
-			 * slope = 0.0046067
-			 * intercept = 0.3863
-			 *
-			 * Intercept corrected for best results @ 12V.
-			 */
-			unsigned counts = adc_measure(ADC_VBATT);
-			if (counts != 0xffff) {
-				unsigned mV = (4150 + (counts * 46)) / 10 - 200;
-				unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
+	/* PX4IO_P_STATUS_VBATT */
+	{
+		/*
+		 * Coefficients here derived by measurement of the 5-16V
+		 * range on one unit:
+		 *
+		 * V   counts
+		 *  5  1001
+		 *  6  1219
+		 *  7  1436
+		 *  8  1653
+		 *  9  1870
+		 * 10  2086
+		 * 11  2303
+		 * 12  2522
+		 * 13  2738
+		 * 14  2956
+		 * 15  3172
+		 * 16  3389
+		 *
+		 * slope = 0.0046067
+		 * intercept = 0.3863
+		 *
+		 * Intercept corrected for best results @ 12V.
+		 */
+		unsigned counts = adc_measure(ADC_VBATT);
+		if (counts != 0xffff) {
+			unsigned mV = (4150 + (counts * 46)) / 10 - 200;
+			unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
 
-				r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
-			}
+			r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
 		}
+	}
 #endif
 #ifdef ADC_IBATT
-		/* PX4IO_P_STATUS_IBATT */
-		{
-			/*
-			  note that we have no idea what sort of
-			  current sensor is attached, so we just
-			  return the raw 12 bit ADC value and let the
-			  FMU sort it out, with user selectable
-			  configuration for their sensor
-			 */
-			unsigned counts = adc_measure(ADC_IBATT);
-			if (counts != 0xffff) {
-				r_page_status[PX4IO_P_STATUS_IBATT] = counts;
-			}
+	/* PX4IO_P_STATUS_IBATT */
+	{
+		/*
+		  note that we have no idea what sort of
+		  current sensor is attached, so we just
+		  return the raw 12 bit ADC value and let the
+		  FMU sort it out, with user selectable
+		  configuration for their sensor
+		 */
+		unsigned counts = adc_measure(ADC_IBATT);
+		if (counts != 0xffff) {
+			r_page_status[PX4IO_P_STATUS_IBATT] = counts;
 		}
+	}
 #endif
 #ifdef ADC_VSERVO
-		/* PX4IO_P_STATUS_VSERVO */
-		{
-			unsigned counts = adc_measure(ADC_VSERVO);
-			if (counts != 0xffff) {
-				// use 3:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 9900 / 4096;
-				r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
-			}
+	/* PX4IO_P_STATUS_VSERVO */
+	{
+		unsigned counts = adc_measure(ADC_VSERVO);
+		if (counts != 0xffff) {
+			// use 3:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 9900 / 4096;
+			r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
 		}
+	}
 #endif
 #ifdef ADC_RSSI
-		/* PX4IO_P_STATUS_VRSSI */
-		{
-			unsigned counts = adc_measure(ADC_RSSI);
-			if (counts != 0xffff) {
-				// use 1:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 3300 / 4096;
-				r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
-			}
+	/* PX4IO_P_STATUS_VRSSI */
+	{
+		unsigned counts = adc_measure(ADC_RSSI);
+		if (counts != 0xffff) {
+			// use 1:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 3300 / 4096;
+			r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
 		}
+	}
 #endif
-		/* XXX PX4IO_P_STATUS_PRSSI */
+	/* XXX PX4IO_P_STATUS_PRSSI */
+}
+
+uint8_t last_page;
+uint8_t last_offset;
+
+int
+registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_values)
+{
+#define SELECT_PAGE(_page_name)							\
+	do {									\
+		*values = &_page_name[0];					\
+		*num_values = sizeof(_page_name) / sizeof(_page_name[0]);	\
+	} while(0)
+
+	switch (page) {
 
+	/*
+	 * Handle pages that are updated dynamically at read time.
+	 */
+	case PX4IO_PAGE_STATUS:
+		registers_update_status();
 		SELECT_PAGE(r_page_status);
 		break;
 
@@ -830,6 +840,20 @@ registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_val
 		SELECT_PAGE(r_page_scratch);
 		break;
 
+	case PX4IO_PAGE_EXCHANGE:
+		registers_update_status();
+
+		memcpy(&r_page_scratch[PX4IO_P_EXCHANGE_STATUS], &r_page_status[PX4IO_P_STATUS_FLAGS],
+		       PX4IO_P_EXCHANGE_STATUS_COUNT * sizeof(uint16_t));
+		memcpy(&r_page_scratch[PX4IO_P_EXCHANGE_SERVOS], &r_page_servos[0],
+		       PX4IO_P_EXCHANGE_SERVO_COUNT * sizeof(uint16_t));
+		memcpy(&r_page_scratch[PX4IO_P_EXCHANGE_RAW_RC], &r_page_raw_rc_input[PX4IO_P_RAW_RC_COUNT],
+		       (PX4IO_P_RAW_RC_BASE + PX4IO_P_EXCHANGE_RC_COUNT) * sizeof(uint16_t));
+
+		SELECT_PAGE(r_page_scratch);
+		*num_values = PX4IO_P_EXCHANGE_SIZE;
+		break;
+
 	case PX4IO_PAGE_PWM_INFO:
 		memset(r_page_scratch, 0, sizeof(r_page_scratch));
 		for (unsigned i = 0; i < PX4IO_SERVO_COUNT; i++)
@@ -946,3 +970,66 @@ pwm_configure_rates(uint16_t map, uint16_t defaultrate, uint16_t altrate)
 	r_setup_pwm_defaultrate = defaultrate;
 	r_setup_pwm_altrate = altrate;
 }
+
+int
+registers_handle_packet(struct IOPacket *pkt)
+{
+	if (PKT_CODE(*pkt) == PKT_CODE_WRITE) {
+
+		/* it's a blind write - pass it on */
+		if (registers_set(pkt->page, pkt->offset, &pkt->regs[0], PKT_COUNT(*pkt))) {
+			pkt->count_code = PKT_CODE_ERROR;
+			return -EINVAL;
+		}
+
+		pkt->count_code = PKT_CODE_SUCCESS;
+		return 0;
+	}
+
+	if (PKT_CODE(*pkt) == PKT_CODE_EXCHANGE) {
+
+		/* write the controls, then reply with the status summary in the same packet */
+		unsigned count;
+		uint16_t *registers;
+
+		if (registers_set(pkt->page, pkt->offset, &pkt->regs[0], PKT_COUNT(*pkt)) ||
+		    registers_get(PX4IO_PAGE_EXCHANGE, 0, &registers, &count) < 0) {
+			pkt->count_code = PKT_CODE_ERROR;
+			return -EINVAL;
+		}
+
+		memcpy((void *)&pkt->regs[0], registers, count * 2);
+		pkt->count_code = count | PKT_CODE_SUCCESS;
+		return 0;
+	}
+
+	if (PKT_CODE(*pkt) == PKT_CODE_READ) {
+
+		/* it's a read - get register pointer for reply */
+		unsigned count;
+		uint16_t *registers;
+
+		if (registers_get(pkt->page, pkt->offset, &registers, &count) < 0) {
+			pkt->count_code = PKT_CODE_ERROR;
+			return -EINVAL;
+		}
+
+		/* constrain reply to requested size */
+		if (count > PKT_MAX_REGS)
+			count = PKT_MAX_REGS;
+		if (count > PKT_COUNT(*pkt))
+			count = PKT_COUNT(*pkt);
+
+		/* copy reply registers into the packet */
+		memcpy((void *)&pkt->regs[0], registers, count * 2);
+		pkt->count_code = count | PKT_CODE_SUCCESS;
+		return 0;
+	}
+
+	/* send a bad-packet error reply */
+	pkt->count_code = PKT_CODE_CORRUPT;
+	pkt->page = 0xff;
+	pkt->offset = 0xfe;
+
+	return -EPROTO;
+}
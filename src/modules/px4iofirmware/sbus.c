@@ -66,29 +66,32 @@
 */
 
 /* define range mapping here, -+100% -> 1000..2000 */
-#define SBUS_RANGE_MIN 200.0f
-#define SBUS_RANGE_MAX 1800.0f
+#define SBUS_RANGE_MIN 200
+#define SBUS_RANGE_MAX 1800
 
-#define SBUS_TARGET_MIN 1000.0f
-#define SBUS_TARGET_MAX 2000.0f
+#define SBUS_TARGET_MIN 1000
+#define SBUS_TARGET_MAX 2000
 
-/* pre-calculate the floating point stuff as far as possible at compile time */
-#define SBUS_SCALE_FACTOR ((SBUS_TARGET_MAX - SBUS_TARGET_MIN) / (SBUS_RANGE_MAX - SBUS_RANGE_MIN))
-#define SBUS_SCALE_OFFSET (int)(SBUS_TARGET_MIN - (SBUS_SCALE_FACTOR * SBUS_RANGE_MIN + 0.5f))
+/*
+ * Scale factor as a fraction, so the IO (which has no FPU) scales in integer
+ * arithmetic. Rounding matches the former float conversion
+ * (uint16_t)(value * factor + 0.5f) + (int)(TARGET_MIN - (factor * RANGE_MIN + 0.5f)).
+ */
+#define SBUS_SCALE_NUM (SBUS_TARGET_MAX - SBUS_TARGET_MIN)
+#define SBUS_SCALE_DEN (SBUS_RANGE_MAX - SBUS_RANGE_MIN)
+#define SBUS_SCALE_OFFSET ((SBUS_TARGET_MIN * SBUS_SCALE_DEN - SBUS_SCALE_NUM * SBUS_RANGE_MIN - SBUS_SCALE_DEN / 2) / SBUS_SCALE_DEN)
 
 static int sbus_fd = -1;
 
 static hrt_abstime last_rx_time;
 static hrt_abstime last_frame_time;
 
-static uint8_t	frame[SBUS_FRAME_SIZE];
+static uint8_t	sbus_frame[SBUS_FRAME_SIZE];
 
 static unsigned partial_frame_count;
 
 unsigned sbus_frame_drops;
 
-static bool sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, uint16_t max_channels);
-
 int
 sbus_init(const char *device)
 {
@@ -119,13 +122,15 @@ sbus_init(const char *device)
 bool
 sbus1_output(uint16_t *values, uint16_t num_values)
 {
-	write(sbus_fd, 'A', 1);
+	write(sbus_fd, "A", 1);
+	return true;
 }
 
 bool
 sbus2_output(uint16_t *values, uint16_t num_values)
 {
-	write(sbus_fd, 'B', 1);
+	write(sbus_fd, "B", 1);
+	return true;
 }
 
 bool
@@ -162,7 +167,7 @@ sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sb
 	 * Fetch bytes, but no more than we would need to complete
 	 * the current frame.
 	 */
-	ret = read(sbus_fd, &frame[partial_frame_count], SBUS_FRAME_SIZE - partial_frame_count);
+	ret = read(sbus_fd, &sbus_frame[partial_frame_count], SBUS_FRAME_SIZE - partial_frame_count);
 
 	/* if the read failed for any reason, just give up here */
 	if (ret < 1)
@@ -186,47 +191,30 @@ sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sb
 	 * decode it.
 	 */
 	partial_frame_count = 0;
-	return sbus_decode(now, values, num_values, sbus_failsafe, sbus_frame_drop, max_channels);
+	return sbus_decode(now, sbus_frame, values, num_values, sbus_failsafe, sbus_frame_drop, max_channels);
 }
 
 /*
- * S.bus decoder matrix.
+ * Extract eight 11-bit channel values from 11 data bytes.
  *
- * Each channel value can come from up to 3 input bytes. Each row in the
- * matrix describes up to three bytes, and each entry gives:
- *
- * - byte offset in the data portion of the frame
- * - right shift applied to the data byte
- * - mask for the data byte
- * - left shift applied to the result into the channel value
+ * The channels are packed LSB first, so each value is assembled from
+ * two or three neighbouring bytes with fixed shifts and a single mask.
  */
-struct sbus_bit_pick {
-	uint8_t byte;
-	uint8_t rshift;
-	uint8_t mask;
-	uint8_t lshift;
-};
-static const struct sbus_bit_pick sbus_decoder[SBUS_INPUT_CHANNELS][3] = {
-	/*  0 */ { { 0, 0, 0xff, 0}, { 1, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
-	/*  1 */ { { 1, 3, 0x1f, 0}, { 2, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
-	/*  2 */ { { 2, 6, 0x03, 0}, { 3, 0, 0xff, 2}, { 4, 0, 0x01, 10} },
-	/*  3 */ { { 4, 1, 0x7f, 0}, { 5, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
-	/*  4 */ { { 5, 4, 0x0f, 0}, { 6, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
-	/*  5 */ { { 6, 7, 0x01, 0}, { 7, 0, 0xff, 1}, { 8, 0, 0x03,  9} },
-	/*  6 */ { { 8, 2, 0x3f, 0}, { 9, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
-	/*  7 */ { { 9, 5, 0x07, 0}, {10, 0, 0xff, 3}, { 0, 0, 0x00,  0} },
-	/*  8 */ { {11, 0, 0xff, 0}, {12, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
-	/*  9 */ { {12, 3, 0x1f, 0}, {13, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
-	/* 10 */ { {13, 6, 0x03, 0}, {14, 0, 0xff, 2}, {15, 0, 0x01, 10} },
-	/* 11 */ { {15, 1, 0x7f, 0}, {16, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
-	/* 12 */ { {16, 4, 0x0f, 0}, {17, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
-	/* 13 */ { {17, 7, 0x01, 0}, {18, 0, 0xff, 1}, {19, 0, 0x03,  9} },
-	/* 14 */ { {19, 2, 0x3f, 0}, {20, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
-	/* 15 */ { {20, 5, 0x07, 0}, {21, 0, 0xff, 3}, { 0, 0, 0x00,  0} }
-};
-
-static bool
-sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, uint16_t max_values)
+static inline void
+sbus_decode_8(const uint8_t *d, unsigned *raw)
+{
+	raw[0] = (d[0]      | d[1] << 8)               & 0x07ff;
+	raw[1] = (d[1] >> 3 | d[2] << 5)               & 0x07ff;
+	raw[2] = (d[2] >> 6 | d[3] << 2 | d[4] << 10)  & 0x07ff;
+	raw[3] = (d[4] >> 1 | d[5] << 7)               & 0x07ff;
+	raw[4] = (d[5] >> 4 | d[6] << 4)               & 0x07ff;
+	raw[5] = (d[6] >> 7 | d[7] << 1 | d[8] << 9)   & 0x07ff;
+	raw[6] = (d[8] >> 2 | d[9] << 6)               & 0x07ff;
+	raw[7] = (d[9] >> 5 | d[10] << 3)              & 0x07ff;
+}
+
+bool
+sbus_decode(hrt_abstime frame_time, const uint8_t *frame, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop, uint16_t max_values)
 {
 	/* check frame boundary markers to avoid out-of-sync cases */
 	if ((frame[0] != 0x0f)) {
@@ -262,26 +250,14 @@ sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool
 	unsigned chancount = (max_values > SBUS_INPUT_CHANNELS) ?
 			     SBUS_INPUT_CHANNELS : max_values;
 
-	/* use the decoder matrix to extract channel data */
-	for (unsigned channel = 0; channel < chancount; channel++) {
-		unsigned value = 0;
-
-		for (unsigned pick = 0; pick < 3; pick++) {
-			const struct sbus_bit_pick *decode = &sbus_decoder[channel][pick];
-
-			if (decode->mask != 0) {
-				unsigned piece = frame[1 + decode->byte];
-				piece >>= decode->rshift;
-				piece &= decode->mask;
-				piece <<= decode->lshift;
-
-				value |= piece;
-			}
-		}
-
+	/* extract all channels, 8 channels per 11 bytes of channel data */
+	unsigned raw[SBUS_INPUT_CHANNELS];
+	sbus_decode_8(&frame[1], &raw[0]);
+	sbus_decode_8(&frame[12], &raw[8]);
 
+	for (unsigned channel = 0; channel < chancount; channel++) {
 		/* convert 0-2048 values to 1000-2000 ppm encoding in a not too sloppy fashion */
-		values[channel] = (uint16_t)(value * SBUS_SCALE_FACTOR +.5f) + SBUS_SCALE_OFFSET;
+		values[channel] = (raw[channel] * SBUS_SCALE_NUM + SBUS_SCALE_DEN / 2) / SBUS_SCALE_DEN + SBUS_SCALE_OFFSET;
 	}
 
 	/* decode switch channels if data fields are wide enough */
@@ -42,6 +42,7 @@
 #include <termios.h>
 #include <fcntl.h>
 #include <string.h>
+#include <errno.h>
 
 #include <nuttx/arch.h>
 #include <arch/board/board.h>
@@ -164,45 +165,10 @@ rx_handle_packet(void)
 		return;
 	}
 
-	if (PKT_CODE(dma_packet) == PKT_CODE_WRITE) {
-
-		/* it's a blind write - pass it on */
-		if (registers_set(dma_packet.page, dma_packet.offset, &dma_packet.regs[0], PKT_COUNT(dma_packet))) {
-			perf_count(pc_regerr);
-			dma_packet.count_code = PKT_CODE_ERROR;
-		} else {
-			dma_packet.count_code = PKT_CODE_SUCCESS;
-		}
-		return;
-	} 
-
-	if (PKT_CODE(dma_packet) == PKT_CODE_READ) {
-
-		/* it's a read - get register pointer for reply */
-		unsigned count;
-		uint16_t *registers;
-
-		if (registers_get(dma_packet.page, dma_packet.offset, &registers, &count) < 0) {
-			perf_count(pc_regerr);
-			dma_packet.count_code = PKT_CODE_ERROR;
-		} else {
-			/* constrain reply to requested size */
-			if (count > PKT_MAX_REGS)
-				count = PKT_MAX_REGS;
-			if (count > PKT_COUNT(dma_packet))
-				count = PKT_COUNT(dma_packet);
-
-			/* copy reply registers into DMA buffer */
-			memcpy((void *)&dma_packet.regs[0], registers, count * 2);
-			dma_packet.count_code = count | PKT_CODE_SUCCESS;
-		}
-		return;
+	/* decode the request and turn the packet into the reply */
+	if (registers_handle_packet(&dma_packet) == -EINVAL) {
+		perf_count(pc_regerr);
 	}
-
-	/* send a bad-packet error reply */
-	dma_packet.count_code = PKT_CODE_CORRUPT;
-	dma_packet.page = 0xff;
-	dma_packet.offset = 0xfe;
 }
 
 static void
@@ -86,6 +86,7 @@
 #include <uORB/topics/estimator_status.h>
 #include <uORB/topics/system_power.h>
 #include <uORB/topics/servorail_status.h>
+#include <uORB/topics/system_profile.h>
 
 #include <systemlib/systemlib.h>
 #include <systemlib/param/param.h>
@@ -804,6 +805,9 @@ int sdlog2_thread_main(int argc, char *argv[])
 
 	memset(&buf, 0, sizeof(buf));
 
+	/* the system profile is large, keep it off the stack */
+	static struct system_profile_s buf_profile;
+
 	/* log message buffer: header + body */
 #pragma pack(push, 1)
 	struct {
@@ -836,6 +840,8 @@ int sdlog2_thread_main(int argc, char *argv[])
 			struct log_VICN_s log_VICN;
 			struct log_GSN0_s log_GSN0;
 			struct log_GSN1_s log_GSN1;
+			struct log_PROF_s log_PROF;
+			struct log_PRFC_s log_PRFC;
 		} body;
 	} log_msg = {
 		LOG_PACKET_HEADER_INIT(0)
@@ -869,6 +875,7 @@ int sdlog2_thread_main(int argc, char *argv[])
 		int estimator_status_sub;
 		int system_power_sub;
 		int servorail_status_sub;
+		int system_profile_sub;
 	} subs;
 
 	subs.cmd_sub = orb_subscribe(ORB_ID(vehicle_command));
@@ -896,6 +903,7 @@ int sdlog2_thread_main(int argc, char *argv[])
 	subs.estimator_status_sub = orb_subscribe(ORB_ID(estimator_status));
 	subs.system_power_sub = orb_subscribe(ORB_ID(system_power));
 	subs.servorail_status_sub = orb_subscribe(ORB_ID(servorail_status));
+	subs.system_profile_sub = orb_subscribe(ORB_ID(system_profile));
 
 	thread_running = true;
 
@@ -1279,6 +1287,28 @@ int sdlog2_thread_main(int argc, char *argv[])
 			LOGBUFFER_WRITE_AND_COUNT(TELE);
 		}
 
+		/* --- SYSTEM PROFILE --- */
+		if (copy_if_updated(ORB_ID(system_profile), subs.system_profile_sub, &buf_profile)) {
+			for (unsigned i = 0; i < buf_profile.task_count; i++) {
+				log_msg.msg_type = LOG_PROF_MSG;
+				strncpy(log_msg.body.log_PROF.name, buf_profile.tasks[i].name, sizeof(log_msg.body.log_PROF.name));
+				log_msg.body.log_PROF.pid = buf_profile.tasks[i].pid;
+				log_msg.body.log_PROF.load = buf_profile.tasks[i].load * 1e-4f;
+				log_msg.body.log_PROF.stack_size = buf_profile.tasks[i].stack_size;
+				log_msg.body.log_PROF.stack_free = buf_profile.tasks[i].stack_free;
+				LOGBUFFER_WRITE_AND_COUNT(PROF);
+			}
+
+			for (unsigned i = 0; i < buf_profile.counter_count; i++) {
+				log_msg.msg_type = LOG_PRFC_MSG;
+				strncpy(log_msg.body.log_PRFC.name, buf_profile.counters[i].name, sizeof(log_msg.body.log_PRFC.name));
+				log_msg.body.log_PRFC.events = buf_profile.counters[i].events;
+				log_msg.body.log_PRFC.average = buf_profile.counters[i].average;
+				log_msg.body.log_PRFC.p99 = buf_profile.counters[i].p99;
+				LOGBUFFER_WRITE_AND_COUNT(PRFC);
+			}
+		}
+
 		/* --- BOTTOM DISTANCE --- */
 		if (copy_if_updated(ORB_ID(sensor_range_finder), subs.range_finder_sub, &buf.range_finder)) {
 			log_msg.msg_type = LOG_DIST_MSG;
@@ -329,6 +329,25 @@ struct log_GSN1_s {
 	uint8_t satellite_snr[16];			/**< Signal to noise ratio of satellite. 0 for none, 255 for max. */
 };
 
+/* --- PROF - TASK PROFILE --- */
+#define LOG_PROF_MSG 28
+struct log_PROF_s {
+	char name[16];
+	uint16_t pid;
+	float load;
+	uint16_t stack_size;
+	uint16_t stack_free;
+};
+
+/* --- PRFC - PERF COUNTER PROFILE --- */
+#define LOG_PRFC_MSG 29
+struct log_PRFC_s {
+	char name[16];
+	uint32_t events;
+	uint32_t average;
+	uint32_t p99;
+};
+
 /********** SYSTEM MESSAGES, ID > 0x80 **********/
 
 /* --- TIME - TIME STAMP --- */
@@ -382,6 +401,8 @@ static const struct log_format_s log_formats[] = {
 	LOG_FORMAT(VICN, "ffffff",		"X,Y,Z,Roll,Pitch,Yaw"),
 	LOG_FORMAT(GSN0, "BBBBBBBBBBBBBBBB",	"s0,s1,s2,s3,s4,s5,s6,s7,s8,s9,s10,s11,s12,s13,s14,s15"),
 	LOG_FORMAT(GSN1, "BBBBBBBBBBBBBBBB",	"s0,s1,s2,s3,s4,s5,s6,s7,s8,s9,s10,s11,s12,s13,s14,s15"),
+	LOG_FORMAT(PROF, "NHfHH",		"Name,PID,Load,StackSize,StackFree"),
+	LOG_FORMAT(PRFC, "NIII",		"Name,Events,Avg,P99"),
 
 	/* system-level messages, ID >= 0x80 */
 	/* FMT: don't write format of format message, it's useless */
@@ -190,6 +190,90 @@ PARAM_DEFINE_FLOAT(SENS_ACC_YSCALE, 1.0f);
  */
 PARAM_DEFINE_FLOAT(SENS_ACC_ZSCALE, 1.0f);
 
+/**
+ * Secondary gyro X-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_XOFF, 0.0f);
+
+/**
+ * Secondary gyro Y-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_YOFF, 0.0f);
+
+/**
+ * Secondary gyro Z-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_ZOFF, 0.0f);
+
+/**
+ * Secondary gyro X-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_XSCALE, 1.0f);
+
+/**
+ * Secondary gyro Y-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_YSCALE, 1.0f);
+
+/**
+ * Secondary gyro Z-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_GYR1_ZSCALE, 1.0f);
+
+/**
+ * Secondary accelerometer X-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_XOFF, 0.0f);
+
+/**
+ * Secondary accelerometer Y-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_YOFF, 0.0f);
+
+/**
+ * Secondary accelerometer Z-axis offset
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_ZOFF, 0.0f);
+
+/**
+ * Secondary accelerometer X-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_XSCALE, 1.0f);
+
+/**
+ * Secondary accelerometer Y-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_YSCALE, 1.0f);
+
+/**
+ * Secondary accelerometer Z-axis scaling factor
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_ACC1_ZSCALE, 1.0f);
+
 
 /**
  * Differential pressure sensor offset
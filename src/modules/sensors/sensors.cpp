@@ -247,6 +247,10 @@ private:
 		float mag_scale[3];
 		float accel_offset[3];
 		float accel_scale[3];
+		float gyro1_offset[3];
+		float gyro1_scale[3];
+		float accel1_offset[3];
+		float accel1_scale[3];
 		float diff_pres_offset_pa;
 		float diff_pres_analog_enabled;
 
@@ -302,6 +306,10 @@ private:
 		param_t accel_scale[3];
 		param_t mag_offset[3];
 		param_t mag_scale[3];
+		param_t gyro1_offset[3];
+		param_t gyro1_scale[3];
+		param_t accel1_offset[3];
+		param_t accel1_scale[3];
 		param_t diff_pres_offset_pa;
 		param_t diff_pres_analog_enabled;
 
@@ -561,6 +569,20 @@ Sensors::Sensors() :
 	_parameter_handles.accel_scale[1] = param_find("SENS_ACC_YSCALE");
 	_parameter_handles.accel_scale[2] = param_find("SENS_ACC_ZSCALE");
 
+	/* secondary gyro and accel offsets */
+	_parameter_handles.gyro1_offset[0] = param_find("SENS_GYR1_XOFF");
+	_parameter_handles.gyro1_offset[1] = param_find("SENS_GYR1_YOFF");
+	_parameter_handles.gyro1_offset[2] = param_find("SENS_GYR1_ZOFF");
+	_parameter_handles.gyro1_scale[0] = param_find("SENS_GYR1_XSCALE");
+	_parameter_handles.gyro1_scale[1] = param_find("SENS_GYR1_YSCALE");
+	_parameter_handles.gyro1_scale[2] = param_find("SENS_GYR1_ZSCALE");
+	_parameter_handles.accel1_offset[0] = param_find("SENS_ACC1_XOFF");
+	_parameter_handles.accel1_offset[1] = param_find("SENS_ACC1_YOFF");
+	_parameter_handles.accel1_offset[2] = param_find("SENS_ACC1_ZOFF");
+	_parameter_handles.accel1_scale[0] = param_find("SENS_ACC1_XSCALE");
+	_parameter_handles.accel1_scale[1] = param_find("SENS_ACC1_YSCALE");
+	_parameter_handles.accel1_scale[2] = param_find("SENS_ACC1_ZSCALE");
+
 	/* mag offsets */
 	_parameter_handles.mag_offset[0] = param_find("SENS_MAG_XOFF");
 	_parameter_handles.mag_offset[1] = param_find("SENS_MAG_YOFF");
@@ -748,6 +770,14 @@ Sensors::parameters_update()
 	param_get(_parameter_handles.accel_scale[1], &(_parameters.accel_scale[1]));
 	param_get(_parameter_handles.accel_scale[2], &(_parameters.accel_scale[2]));
 
+	/* secondary gyro and accel offsets */
+	for (unsigned i = 0; i < 3; i++) {
+		param_get(_parameter_handles.gyro1_offset[i], &(_parameters.gyro1_offset[i]));
+		param_get(_parameter_handles.gyro1_scale[i], &(_parameters.gyro1_scale[i]));
+		param_get(_parameter_handles.accel1_offset[i], &(_parameters.accel1_offset[i]));
+		param_get(_parameter_handles.accel1_scale[i], &(_parameters.accel1_scale[i]));
+	}
+
 	/* mag offsets */
 	param_get(_parameter_handles.mag_offset[0], &(_parameters.mag_offset[0]));
 	param_get(_parameter_handles.mag_offset[1], &(_parameters.mag_offset[1]));
@@ -1153,6 +1183,45 @@ Sensors::parameter_update_poll(bool forced)
 
 		close(fd);
 
+		/* the secondary gyro and accel are optional, skip them without error */
+		fd = open(GYRO_DEVICE_PATH "1", 0);
+
+		if (fd >= 0) {
+			struct gyro_scale gscale1 = {
+				_parameters.gyro1_offset[0],
+				_parameters.gyro1_scale[0],
+				_parameters.gyro1_offset[1],
+				_parameters.gyro1_scale[1],
+				_parameters.gyro1_offset[2],
+				_parameters.gyro1_scale[2],
+			};
+
+			if (OK != ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gscale1)) {
+				warn("WARNING: failed to set scale / offsets for gyro1");
+			}
+
+			close(fd);
+		}
+
+		fd = open(ACCEL_DEVICE_PATH "1", 0);
+
+		if (fd >= 0) {
+			struct accel_scale ascale1 = {
+				_parameters.accel1_offset[0],
+				_parameters.accel1_scale[0],
+				_parameters.accel1_offset[1],
+				_parameters.accel1_scale[1],
+				_parameters.accel1_offset[2],
+				_parameters.accel1_scale[2],
+			};
+
+			if (OK != ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&ascale1)) {
+				warn("WARNING: failed to set scale / offsets for accel1");
+			}
+
+			close(fd);
+		}
+
 		fd = open(MAG_DEVICE_PATH, 0);
 		struct mag_scale mscale = {
 			_parameters.mag_offset[0],
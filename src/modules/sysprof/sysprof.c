@@ -0,0 +1,365 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sysprof.c
+ *
+ * Periodic system profile sampler.
+ *
+ * Publishes the CPU share and stack headroom of every task and the
+ * activity of selected performance counters as the system_profile
+ * topic, so that they can be logged and streamed during flight.
+ *
+ * The sampler runs on the low priority work queue. Stack headroom is
+ * found by sweeping the unused (0xff filled) end of a stack, which is
+ * the expensive part of a sample; it is spread over several samples,
+ * a few tasks at a time.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/sched.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/clock.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+
+#include <drivers/drv_hrt.h>
+#include <systemlib/err.h>
+#include <systemlib/cpuload.h>
+#include <systemlib/perf_counter.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/system_profile.h>
+
+#ifndef CONFIG_SCHED_INSTRUMENTATION
+# error sysprof requires CONFIG_SCHED_INSTRUMENTATION
+#endif
+
+/** number of stacks swept per sample */
+#define SYSPROF_STACK_SWEEPS	4
+
+#if CONFIG_MAX_TASKS > SYSTEM_PROFILE_MAX_TASKS
+# error SYSTEM_PROFILE_MAX_TASKS is too small for CONFIG_MAX_TASKS
+#endif
+
+struct sysprof_slot_s {
+	FAR struct tcb_s	*tcb;		/**< task the slot was last sampled for */
+	uint64_t		runtime;	/**< runtime at the last sample */
+	uint16_t		stack_free;	/**< last stack sweep result */
+};
+
+struct sysprof_counter_s {
+	const char		*name;
+	uint64_t		events;		/**< event count at the last sample */
+	uint64_t		time_total;	/**< accumulated time at the last sample */
+};
+
+struct sysprof_s {
+	struct work_s		work;
+	unsigned		interval_ticks;
+	hrt_abstime		last_sample;
+	unsigned		next_sweep;	/**< first slot to sweep the stack of in the next sample */
+	struct sysprof_slot_s	slots[CONFIG_MAX_TASKS];
+	struct sysprof_counter_s counters[SYSTEM_PROFILE_MAX_COUNTERS];
+	unsigned		counter_count;
+	orb_advert_t		pub;
+	struct system_profile_s	profile;
+};
+
+static struct sysprof_s sysprof_data;
+static bool sysprof_started = false;
+
+__EXPORT int sysprof_main(int argc, char *argv[]);
+
+static void sysprof_cycle(FAR void *arg);
+
+static void
+usage(void)
+{
+	errx(1, "usage: sysprof {start|stop|status} [-r <rate>] [-c <perf counter>]...\n"
+	     "\t-r <rate>\tsample rate in Hz (default 1)\n"
+	     "\t-c <name>\tinclude this perf counter, up to %d times",
+	     SYSTEM_PROFILE_MAX_COUNTERS);
+}
+
+/*
+ * Count the never used bytes at the end of a stack.
+ */
+static uint16_t
+sysprof_stack_free(FAR struct tcb_s *tcb, unsigned stack_size)
+{
+	uint8_t *sweeper = (uint8_t *)tcb->stack_alloc_ptr;
+	unsigned stack_free = 0;
+
+	while ((stack_free < stack_size) && (*sweeper++ == 0xff))
+		stack_free++;
+
+	return (stack_free > UINT16_MAX) ? UINT16_MAX : stack_free;
+}
+
+static void
+sysprof_sample_tasks(struct sysprof_s *priv, uint64_t interval)
+{
+	struct system_profile_s *profile = &priv->profile;
+
+	profile->task_count = 0;
+	profile->load = 0.0f;
+
+	for (unsigned i = 0; i < CONFIG_MAX_TASKS; i++) {
+		struct sysprof_slot_s *slot = &priv->slots[i];
+		struct system_load_taskinfo_s *info = &system_load.tasks[i];
+
+		/* keep the task from exiting while its TCB and stack are looked at */
+		sched_lock();
+
+		if (!info->valid) {
+			sched_unlock();
+			slot->tcb = NULL;
+			continue;
+		}
+
+		FAR struct tcb_s *tcb = info->tcb;
+		uint64_t runtime = info->total_runtime;
+		bool new_task = (slot->tcb != tcb);
+		unsigned stack_size = (uintptr_t)tcb->adj_stack_ptr - (uintptr_t)tcb->stack_alloc_ptr;
+
+		struct system_profile_task_s *task = &profile->tasks[profile->task_count++];
+		strncpy(task->name, tcb->name, sizeof(task->name) - 1);
+		task->name[sizeof(task->name) - 1] = '\0';
+		task->pid = tcb->pid;
+		task->stack_size = (stack_size > UINT16_MAX) ? UINT16_MAX : stack_size;
+
+		/* sweep new tasks and the slots whose turn it is */
+		if (new_task || (((i + CONFIG_MAX_TASKS - priv->next_sweep) % CONFIG_MAX_TASKS) < SYSPROF_STACK_SWEEPS))
+			slot->stack_free = sysprof_stack_free(tcb, stack_size);
+
+		sched_unlock();
+
+		/* CPU share since the last sample, or since the task started */
+		uint64_t last = new_task ? 0 : slot->runtime;
+		uint64_t share = (runtime > last && interval > 0) ? ((runtime - last) * 10000) / interval : 0;
+
+		task->load = (share > 10000) ? 10000 : share;
+		task->stack_free = slot->stack_free;
+
+		/* the load is what the idle task did not get */
+		if (task->pid == 0)
+			profile->load = 1.0f - 1e-4f * task->load;
+
+		slot->tcb = tcb;
+		slot->runtime = runtime;
+	}
+
+	priv->next_sweep = (priv->next_sweep + SYSPROF_STACK_SWEEPS) % CONFIG_MAX_TASKS;
+}
+
+static void
+sysprof_sample_counters(struct sysprof_s *priv)
+{
+	struct system_profile_s *profile = &priv->profile;
+
+	profile->counter_count = priv->counter_count;
+
+	for (unsigned i = 0; i < priv->counter_count; i++) {
+		struct sysprof_counter_s *ctr = &priv->counters[i];
+		struct system_profile_counter_s *out = &profile->counters[i];
+
+		strncpy(out->name, ctr->name, sizeof(out->name) - 1);
+		out->name[sizeof(out->name) - 1] = '\0';
+		out->events = 0;
+		out->average = 0;
+		out->p99 = 0;
+
+		/* counters are looked up every time, they may come and go */
+		sched_lock();
+		perf_counter_t handle = perf_find(ctr->name);
+
+		if (handle == NULL) {
+			sched_unlock();
+			ctr->events = 0;
+			ctr->time_total = 0;
+			continue;
+		}
+
+		uint64_t events = perf_event_count(handle);
+		uint64_t time_total = perf_time_total(handle);
+		out->p99 = perf_percentile(handle, 990);
+		sched_unlock();
+
+		/* a counter reset shows as a step back, count from zero then */
+		if ((events < ctr->events) || (time_total < ctr->time_total)) {
+			ctr->events = 0;
+			ctr->time_total = 0;
+		}
+
+		out->events = events - ctr->events;
+
+		if (out->events > 0)
+			out->average = (time_total - ctr->time_total) / out->events;
+
+		ctr->events = events;
+		ctr->time_total = time_total;
+	}
+}
+
+static void
+sysprof_cycle(FAR void *arg)
+{
+	struct sysprof_s *priv = (struct sysprof_s *)arg;
+
+	if (!sysprof_started)
+		return;
+
+	hrt_abstime now = hrt_absolute_time();
+	uint64_t interval = now - priv->last_sample;
+
+	sysprof_sample_tasks(priv, interval);
+	sysprof_sample_counters(priv);
+
+	priv->profile.timestamp = now;
+	priv->profile.interval = interval;
+	priv->last_sample = now;
+
+	if (priv->pub > 0) {
+		orb_publish(ORB_ID(system_profile), priv->pub, &priv->profile);
+
+	} else {
+		priv->pub = orb_advertise(ORB_ID(system_profile), &priv->profile);
+	}
+
+	work_queue(LPWORK, &priv->work, sysprof_cycle, priv, priv->interval_ticks);
+}
+
+static void
+sysprof_status(void)
+{
+	struct system_profile_s *profile = &sysprof_data.profile;
+
+	printf("load %.1f%%, %u tasks, interval %uus\n",
+	       (double)(profile->load * 100.0f), (unsigned)profile->task_count, (unsigned)profile->interval);
+
+	for (unsigned i = 0; i < profile->task_count; i++) {
+		struct system_profile_task_s *task = &profile->tasks[i];
+
+		printf("%4u %-16s %3u.%02u%% stack %5u/%5u\n",
+		       (unsigned)task->pid, task->name, task->load / 100, task->load % 100,
+		       (unsigned)(task->stack_size - task->stack_free), (unsigned)task->stack_size);
+	}
+
+	for (unsigned i = 0; i < profile->counter_count; i++) {
+		struct system_profile_counter_s *ctr = &profile->counters[i];
+
+		printf("%-16s %u events, avg %uus, p99 %uus\n",
+		       ctr->name, (unsigned)ctr->events, (unsigned)ctr->average, (unsigned)ctr->p99);
+	}
+}
+
+int
+sysprof_main(int argc, char *argv[])
+{
+	if (argc < 2)
+		usage();
+
+	if (!strcmp(argv[1], "start")) {
+		if (sysprof_started)
+			errx(1, "already running");
+
+		unsigned rate = 1;
+
+		/* a cycle of a previous run may still be queued, it must not see the state change */
+		work_cancel(LPWORK, &sysprof_data.work);
+
+		/* counter names from a previous run */
+		for (unsigned i = 0; i < sysprof_data.counter_count; i++)
+			free((void *)sysprof_data.counters[i].name);
+
+		memset(&sysprof_data, 0, sizeof(sysprof_data));
+
+		for (int i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "-r") && (i + 1 < argc)) {
+				rate = strtoul(argv[++i], NULL, 10);
+
+			} else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) {
+				if (sysprof_data.counter_count >= SYSTEM_PROFILE_MAX_COUNTERS)
+					errx(1, "too many counters");
+
+				/* the argument strings do not outlive this command */
+				sysprof_data.counters[sysprof_data.counter_count++].name = strdup(argv[++i]);
+
+			} else {
+				usage();
+			}
+		}
+
+		if ((rate < 1) || (rate > 10))
+			errx(1, "rate must be 1..10 Hz");
+
+		sysprof_data.interval_ticks = USEC2TICK(1000000 / rate);
+		sysprof_data.last_sample = system_load.start_time;
+		sysprof_started = true;
+
+		int ret = work_queue(LPWORK, &sysprof_data.work, sysprof_cycle, &sysprof_data, 0);
+
+		if (ret != 0) {
+			sysprof_started = false;
+			errx(1, "failed to queue work: %d", ret);
+		}
+
+		exit(0);
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		if (!sysprof_started)
+			errx(1, "not running");
+
+		sysprof_started = false;
+		work_cancel(LPWORK, &sysprof_data.work);
+		exit(0);
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		if (!sysprof_started)
+			errx(1, "not running");
+
+		sysprof_status();
+		exit(0);
+	}
+
+	usage();
+	return 1;
+}
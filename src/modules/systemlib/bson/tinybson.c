@@ -53,13 +53,53 @@
 #define CODER_CHECK(_c)		do { if (_c->dead) { debug("coder dead"); return -1; }} while(0)
 #define CODER_KILL(_c, _reason)	do { debug("killed: %s", _reason); _c->dead = true; return -1; } while(0)
 
+/*
+ * Read from the file through the window, refilling it as it runs dry.
+ */
+static int
+read_file(bson_decoder_t decoder, uint8_t *p, size_t s)
+{
+	while (s > 0) {
+		if (decoder->window_pos == decoder->window_len) {
+			size_t want = BSON_FILE_WINDOW;
+
+			/* don't read beyond the document if we know where it ends */
+			if ((decoder->file_remaining >= 0) && (want > (size_t)decoder->file_remaining))
+				want = decoder->file_remaining;
+
+			ssize_t got = (want > 0) ? read(decoder->fd, decoder->window, want) : 0;
+
+			if (got <= 0)
+				return -1;
+
+			if (decoder->file_remaining >= 0)
+				decoder->file_remaining -= got;
+
+			decoder->window_pos = 0;
+			decoder->window_len = got;
+		}
+
+		size_t n = decoder->window_len - decoder->window_pos;
+
+		if (n > s)
+			n = s;
+
+		memcpy(p, &decoder->window[decoder->window_pos], n);
+		decoder->window_pos += n;
+		p += n;
+		s -= n;
+	}
+
+	return 0;
+}
+
 static int
 read_x(bson_decoder_t decoder, void *p, size_t s)
 {
 	CODER_CHECK(decoder);
 
 	if (decoder->fd > -1)
-		return (read(decoder->fd, p, s) == (int)s) ? 0 : -1;
+		return read_file(decoder, (uint8_t *)p, s);
 
 	if (decoder->buf != NULL) {
 		/* staged operations to avoid integer overflow for corrupt data */
@@ -102,9 +142,12 @@ read_double(bson_decoder_t decoder, double *d)
 int
 bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback callback, void *private)
 {
-	int32_t	junk;
+	int32_t	len;
 
 	decoder->fd = fd;
+	decoder->window_pos = 0;
+	decoder->window_len = 0;
+	decoder->file_remaining = sizeof(len);
 	decoder->buf = NULL;
 	decoder->dead = false;
 	decoder->callback = callback;
@@ -113,9 +156,11 @@ bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback cal
 	decoder->pending = 0;
 	decoder->node.type = BSON_UNDEFINED;
 
-	/* read and discard document size */
-	if (read_int32(decoder, &junk))
-		CODER_KILL(decoder, "failed discarding length");
+	/* read the document size, files we wrote ourselves don't record it */
+	if (read_int32(decoder, &len))
+		CODER_KILL(decoder, "failed reading length");
+
+	decoder->file_remaining = (len > (int32_t)sizeof(len)) ? (len - (int32_t)sizeof(len)) : -1;
 
 	/* ready for decoding */
 	return 0;
@@ -295,13 +340,52 @@ bson_decoder_data_pending(bson_decoder_t decoder)
 	return decoder->pending;
 }
 
+static int
+write_flush(bson_encoder_t encoder)
+{
+	if (encoder->window_len > 0) {
+		if (write(encoder->fd, encoder->window, encoder->window_len) != (int)encoder->window_len)
+			CODER_KILL(encoder, "file write error");
+
+		encoder->window_len = 0;
+	}
+
+	return 0;
+}
+
+/*
+ * Stage file output in the window, writing it out each time it fills.
+ */
+static int
+write_file(bson_encoder_t encoder, const void *p, size_t s)
+{
+	const uint8_t *b = (const uint8_t *)p;
+
+	while (s > 0) {
+		size_t n = BSON_FILE_WINDOW - encoder->window_len;
+
+		if (n > s)
+			n = s;
+
+		memcpy(&encoder->window[encoder->window_len], b, n);
+		encoder->window_len += n;
+		b += n;
+		s -= n;
+
+		if ((encoder->window_len == BSON_FILE_WINDOW) && write_flush(encoder))
+			return -1;
+	}
+
+	return 0;
+}
+
 static int
 write_x(bson_encoder_t encoder, const void *p, size_t s)
 {
 	CODER_CHECK(encoder);
 
 	if (encoder->fd > -1)
-		return (write(encoder->fd, p, s) == (int)s) ? 0 : -1;
+		return write_file(encoder, p, s);
 
 	/* do we need to extend the buffer? */
 	while ((encoder->bufpos + s) > encoder->bufsize) {
@@ -363,6 +447,7 @@ int
 bson_encoder_init_file(bson_encoder_t encoder, int fd)
 {
 	encoder->fd = fd;
+	encoder->window_len = 0;
 	encoder->buf = NULL;
 	encoder->dead = false;
 
@@ -407,8 +492,13 @@ bson_encoder_fini(bson_encoder_t encoder)
 		memcpy(encoder->buf, &len, sizeof(len));
 	}
 
-	/* sync file */
-	fsync(encoder->fd);
+	/* write out what is left in the window and sync file */
+	if (encoder->fd > -1) {
+		if (write_flush(encoder))
+			return -1;
+
+		fsync(encoder->fd);
+	}
 
 	return 0;
 }
@@ -78,6 +78,17 @@ typedef enum bson_binary_subtype {
  */
 #define BSON_BUF_INCREMENT	128
 
+/**
+ * Size of the I/O window used when reading from or writing to a file.
+ *
+ * File data is moved through this window, so a document costs one read
+ * or write call per window rather than several calls per node.
+ *
+ * The window is part of the coder state, which callers usually keep on
+ * the stack: account for it in the stack size of any task using a coder.
+ */
+#define BSON_FILE_WINDOW	128
+
 /**
  * Node structure passed to the callback.
  */
@@ -104,6 +115,10 @@ typedef int	(* bson_decoder_callback)(bson_decoder_t decoder, void *private, bso
 struct bson_decoder_s {
 	/* file reader state */
 	int			fd;
+	uint8_t			window[BSON_FILE_WINDOW];
+	unsigned		window_pos;	/**< next unread byte in the window */
+	unsigned		window_len;	/**< valid bytes in the window */
+	int32_t			file_remaining;	/**< document bytes still in the file, -1 if unknown */
 
 	/* buffer reader state */
 	uint8_t			*buf;
@@ -121,6 +136,10 @@ struct bson_decoder_s {
 /**
  * Initialise the decoder to read from a file.
  *
+ * The file is read through a BSON_FILE_WINDOW sized window. If the
+ * document carries its length, reads stop at the end of the document,
+ * otherwise the file may be read ahead by up to one window.
+ *
  * @param decoder		Decoder state structure to be initialised.
  * @param fd			File to read BSON data from.
  * @param callback		Callback to be invoked by bson_decoder_next
@@ -172,6 +191,8 @@ __EXPORT size_t bson_decoder_data_pending(bson_decoder_t decoder);
 typedef struct bson_encoder_s {
 	/* file writer state */
 	int		fd;
+	uint8_t		window[BSON_FILE_WINDOW];
+	unsigned	window_len;	/**< bytes staged in the window */
 
 	/* buffer writer state */
 	uint8_t		*buf;
@@ -186,6 +207,9 @@ typedef struct bson_encoder_s {
 /**
  * Initialze the encoder for writing to a file.
  *
+ * Output is staged in a BSON_FILE_WINDOW sized window and written out
+ * when the window fills and by bson_encoder_fini.
+ *
  * @param encoder		Encoder state structure to be initialised.
  * @param fd			File to write to.
  * @return			Zero on success.
@@ -43,77 +43,143 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <sched.h>
 
 #include <mavlink/mavlink_log.h>
 
-__EXPORT void mavlink_logbuffer_init(struct mavlink_logbuffer *lb, int size)
-{
-	lb->size  = size;
-	lb->start = 0;
-	lb->count = 0;
-	lb->elems = calloc(lb->size, sizeof(struct mavlink_logmessage));
-}
+#define SLOT(_q, _seq)	(&(_q)->slots[(_seq) & (MAVLINK_LOGQUEUE_SIZE - 1)])
 
-__EXPORT void mavlink_logbuffer_destroy(struct mavlink_logbuffer *lb)
+/*
+ * Number of messages the slowest reader has not read yet.
+ */
+static uint32_t mavlink_logqueue_backlog(struct mavlink_logqueue *q, uint32_t head)
 {
-	lb->size  = 0;
-	lb->start = 0;
-	lb->count = 0;
-	free(lb->elems);
-}
+	uint32_t backlog = 0;
 
-__EXPORT int mavlink_logbuffer_is_full(struct mavlink_logbuffer *lb)
-{
-	return lb->count == (int)lb->size;
-}
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_READERS; i++) {
+		if (q->readers[i].in_use) {
+			uint32_t behind = head - q->readers[i].next;
 
-__EXPORT int mavlink_logbuffer_is_empty(struct mavlink_logbuffer *lb)
-{
-	return lb->count == 0;
+			if (behind > backlog)
+				backlog = behind;
+		}
+	}
+
+	return backlog;
 }
 
-__EXPORT void mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem)
+__EXPORT int mavlink_logqueue_write(struct mavlink_logqueue *q, int severity, const char *text)
 {
-	int end = (lb->start + lb->count) % lb->size;
-	memcpy(&(lb->elems[end]), elem, sizeof(struct mavlink_logmessage));
+	/*
+	 * Writers are serialized. With preemption off the lock is always free
+	 * on the single core, it only spins where writers run truly parallel.
+	 */
+	sched_lock();
+
+	while (!__sync_bool_compare_and_swap(&q->write_lock, 0, 1))
+		;
+
+	/* keep the last slots for severe messages */
+	if ((severity > MAVLINK_LOGQUEUE_KEEP_SEVERITY) &&
+	    (mavlink_logqueue_backlog(q, q->head) >= (MAVLINK_LOGQUEUE_SIZE - MAVLINK_LOGQUEUE_RESERVE))) {
+		q->dropped++;
+		__sync_lock_release(&q->write_lock);
+		sched_unlock();
+		return -1;
+	}
 
-	if (mavlink_logbuffer_is_full(lb)) {
-		lb->start = (lb->start + 1) % lb->size; /* full, overwrite */
+	uint32_t seq = q->head;
+	struct mavlink_logslot *slot = SLOT(q, seq);
 
-	} else {
-		++lb->count;
-	}
+	/* readers treat the slot as unpublished while it is written */
+	slot->seq = 0;
+	__sync_synchronize();
+
+	strncpy(slot->msg.text, text, sizeof(slot->msg.text) - 1);
+	slot->msg.text[sizeof(slot->msg.text) - 1] = '\0';
+	slot->msg.severity = severity;
+
+	__sync_synchronize();
+	slot->seq = seq + 1;
+	q->head = seq + 1;
+
+	__sync_lock_release(&q->write_lock);
+	sched_unlock();
+
+	return 0;
 }
 
-__EXPORT int mavlink_logbuffer_read(struct mavlink_logbuffer *lb, struct mavlink_logmessage *elem)
+__EXPORT int mavlink_logqueue_attach(struct mavlink_logqueue *q)
 {
-	if (!mavlink_logbuffer_is_empty(lb)) {
-		memcpy(elem, &(lb->elems[lb->start]), sizeof(struct mavlink_logmessage));
-		lb->start = (lb->start + 1) % lb->size;
-		--lb->count;
+	for (unsigned i = 0; i < MAVLINK_LOGQUEUE_READERS; i++) {
+		struct mavlink_logqueue_reader *r = &q->readers[i];
+
+		if (__sync_bool_compare_and_swap(&r->in_use, 0, 1)) {
+			r->next = q->head;
+			r->lost = 0;
+			r->read = 0;
+			return i;
+		}
+	}
 
-		return 0;
+	return -1;
+}
 
-	} else {
-		return 1;
+__EXPORT void mavlink_logqueue_detach(struct mavlink_logqueue *q, int reader)
+{
+	if ((reader >= 0) && (reader < MAVLINK_LOGQUEUE_READERS)) {
+		__sync_synchronize();
+		q->readers[reader].in_use = 0;
 	}
 }
 
-__EXPORT void mavlink_logbuffer_vasprintf(struct mavlink_logbuffer *lb, int severity, const char *fmt, ...)
+__EXPORT int mavlink_logqueue_read(struct mavlink_logqueue *q, int reader, struct mavlink_logmessage *msg)
 {
-	va_list ap;
-	va_start(ap, fmt);
-	int end = (lb->start + lb->count) % lb->size;
-	lb->elems[end].severity = severity;
-	vsnprintf(lb->elems[end].text, sizeof(lb->elems[0].text), fmt, ap);
-	va_end(ap);
-
-	/* increase count */
-	if (mavlink_logbuffer_is_full(lb)) {
-		lb->start = (lb->start + 1) % lb->size; /* full, overwrite */
-
-	} else {
-		++lb->count;
+	struct mavlink_logqueue_reader *r = &q->readers[reader];
+
+	for (;;) {
+		uint32_t next = r->next;
+		uint32_t head = q->head;
+
+		if (next == head)
+			return 1;
+
+		/* fallen behind by more than the queue holds */
+		if ((head - next) > MAVLINK_LOGQUEUE_SIZE) {
+			r->lost += (head - next) - MAVLINK_LOGQUEUE_SIZE;
+			r->next = head - MAVLINK_LOGQUEUE_SIZE;
+			continue;
+		}
+
+		struct mavlink_logslot *slot = SLOT(q, next);
+		uint32_t seq = slot->seq;
+
+		if (seq != next + 1) {
+			/* a later message is in the slot, ours was overwritten */
+			if ((seq != 0) && ((int32_t)(seq - (next + 1)) > 0)) {
+				r->lost++;
+				r->next = next + 1;
+				continue;
+			}
+
+			/* still being written */
+			return 1;
+		}
+
+		__sync_synchronize();
+		memcpy(msg, &slot->msg, sizeof(*msg));
+		__sync_synchronize();
+
+		/* overwritten while copying */
+		if (slot->seq != next + 1) {
+			r->lost++;
+			r->next = next + 1;
+			continue;
+		}
+
+		r->next = next + 1;
+		r->read++;
+		return 0;
 	}
 }
 
@@ -354,76 +354,100 @@ param_get(param_t param, void *val)
 	return result;
 }
 
+/**
+ * Store a parameter value, with the parameter store locked.
+ *
+ * @param param			The parameter to set.
+ * @param val			The value to store.
+ * @param mark_saved		If true, the value is not marked unsaved.
+ * @param sort			If false, a newly modified parameter is appended
+ *				without sorting the modified values; the caller
+ *				sorts them once it is done setting values.
+ * @return			Zero on success.
+ */
 static int
-param_set_internal(param_t param, const void *val, bool mark_saved)
+param_set_locked(param_t param, const void *val, bool mark_saved, bool sort)
 {
-	int result = -1;
-	bool params_changed = false;
-
-	param_lock();
+	param_assert_locked();
 
 	if (param_values == NULL)
 		utarray_new(param_values, &param_icd);
 
 	if (param_values == NULL) {
 		debug("failed to allocate modified values array");
-		goto out;
+		return -1;
 	}
 
-	if (handle_in_range(param)) {
+	if (!handle_in_range(param))
+		return -1;
 
-		struct param_wbuf_s *s = param_find_changed(param);
+	struct param_wbuf_s *s = param_find_changed(param);
 
-		if (s == NULL) {
+	if (s == NULL) {
 
-			/* construct a new parameter */
-			struct param_wbuf_s buf = {
-				.param = param,
-				.val.p = NULL,
-				.unsaved = false
-			};
+		/* construct a new parameter */
+		struct param_wbuf_s buf = {
+			.param = param,
+			.val.p = NULL,
+			.unsaved = false
+		};
 
-			/* add it to the array and sort */
-			utarray_push_back(param_values, &buf);
+		/* add it to the array */
+		utarray_push_back(param_values, &buf);
+
+		if (sort) {
 			utarray_sort(param_values, param_compare_values);
 
 			/* find it after sorting */
 			s = param_find_changed(param);
+
+		} else {
+			s = (struct param_wbuf_s *)utarray_back(param_values);
 		}
+	}
 
-		/* update the changed value */
-		switch (param_type(param)) {
-		case PARAM_TYPE_INT32:
-			s->val.i = *(int32_t *)val;
-			break;
+	/* update the changed value */
+	switch (param_type(param)) {
+	case PARAM_TYPE_INT32:
+		s->val.i = *(int32_t *)val;
+		break;
 
-		case PARAM_TYPE_FLOAT:
-			s->val.f = *(float *)val;
-			break;
+	case PARAM_TYPE_FLOAT:
+		s->val.f = *(float *)val;
+		break;
 
-		case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX:
-			if (s->val.p == NULL) {
-				s->val.p = malloc(param_size(param));
+	case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX:
+		if (s->val.p == NULL) {
+			s->val.p = malloc(param_size(param));
 
-				if (s->val.p == NULL) {
-					debug("failed to allocate parameter storage");
-					goto out;
-				}
+			if (s->val.p == NULL) {
+				debug("failed to allocate parameter storage");
+				return -1;
 			}
-
-			memcpy(s->val.p, val, param_size(param));
-			break;
-
-		default:
-			goto out;
 		}
 
-		s->unsaved = !mark_saved;
-		params_changed = true;
-		result = 0;
+		memcpy(s->val.p, val, param_size(param));
+		break;
+
+	default:
+		return -1;
 	}
 
-out:
+	s->unsaved = !mark_saved;
+	return 0;
+}
+
+static int
+param_set_internal(param_t param, const void *val, bool mark_saved)
+{
+	int result;
+	bool params_changed;
+
+	param_lock();
+
+	result = param_set_locked(param, val, mark_saved, true);
+	params_changed = (result == 0);
+
 	param_unlock();
 
 	/*
@@ -467,10 +491,10 @@ param_reset(param_t param)
 		param_notify_changes();
 }
 
-void
-param_reset_all(void)
+static void
+param_reset_all_locked(void)
 {
-	param_lock();
+	param_assert_locked();
 
 	if (param_values != NULL) {
 		utarray_free(param_values);
@@ -478,6 +502,14 @@ param_reset_all(void)
 
 	/* mark as reset / deleted */
 	param_values = NULL;
+}
+
+void
+param_reset_all(void)
+{
+	param_lock();
+
+	param_reset_all_locked();
 
 	param_unlock();
 
@@ -644,6 +676,7 @@ out:
 
 struct param_import_state {
 	bool mark_saved;
+	unsigned changed;	/**< number of values set */
 };
 
 static int
@@ -732,11 +765,14 @@ param_import_callback(bson_decoder_t decoder, void *private, bson_node_t node)
 		goto out;
 	}
 
-	if (param_set_internal(param, v, state->mark_saved)) {
+	/* the store is locked for the whole import, sort once at the end */
+	if (param_set_locked(param, v, state->mark_saved, false)) {
 		debug("error setting value for '%s'", node->name);
 		goto out;
 	}
 
+	state->changed++;
+
 	if (tmp != NULL) {
 		free(tmp);
 		tmp = NULL;
@@ -753,20 +789,31 @@ out:
 	return result;
 }
 
+/*
+ * Apply all values in a parameter file in one pass over the locked store,
+ * then notify subscribers once. With reset, all values are reset to their
+ * defaults first, as part of the same pass.
+ */
 static int
-param_import_internal(int fd, bool mark_saved)
+param_import_internal(int fd, bool mark_saved, bool reset)
 {
 	struct bson_decoder_s decoder;
 	int result = -1;
 	struct param_import_state state;
 
+	state.mark_saved = mark_saved;
+	state.changed = 0;
+
+	param_lock();
+
+	if (reset)
+		param_reset_all_locked();
+
 	if (bson_decoder_init_file(&decoder, fd, param_import_callback, &state)) {
 		debug("decoder init failed");
 		goto out;
 	}
 
-	state.mark_saved = mark_saved;
-
 	do {
 		result = bson_decoder_next(&decoder);
 
@@ -774,6 +821,15 @@ param_import_internal(int fd, bool mark_saved)
 
 out:
 
+	/* values set before an error are kept, as they would have been one by one */
+	if ((state.changed > 0) && (param_values != NULL))
+		utarray_sort(param_values, param_compare_values);
+
+	param_unlock();
+
+	if (reset || (state.changed > 0))
+		param_notify_changes();
+
 	if (result < 0)
 		debug("BSON error decoding parameters");
 
@@ -783,14 +839,13 @@ out:
 int
 param_import(int fd)
 {
-	return param_import_internal(fd, false);
+	return param_import_internal(fd, false, false);
 }
 
 int
 param_load(int fd)
 {
-	param_reset_all();
-	return param_import_internal(fd, true);
+	return param_import_internal(fd, true, true);
 }
 
 void
@@ -39,6 +39,9 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/queue.h>
 #include <drivers/drv_hrt.h>
 
@@ -87,11 +90,100 @@ struct perf_ctr_interval {
 
 };
 
+/**
+ * Histogram of the samples of a PC_ELAPSED_HIST or PC_INTERVAL_HIST counter.
+ */
+struct perf_ctr_histogram {
+	uint32_t		bucket[PERF_HIST_BUCKETS];
+};
+
+/**
+ * PC_ELAPSED_HIST counter.
+ */
+struct perf_ctr_elapsed_hist {
+	struct perf_ctr_elapsed	elapsed;
+	struct perf_ctr_histogram hist;
+};
+
+/**
+ * PC_INTERVAL_HIST counter.
+ */
+struct perf_ctr_interval_hist {
+	struct perf_ctr_interval interval;
+	struct perf_ctr_histogram hist;
+};
+
 /**
  * List of all known counters.
  */
 static sq_queue_t	perf_counters;
 
+/**
+ * Histogram of a counter, NULL if the counter does not keep one.
+ */
+static struct perf_ctr_histogram *
+perf_histogram(perf_counter_t handle)
+{
+	switch (handle->type) {
+	case PC_ELAPSED_HIST:
+		return &((struct perf_ctr_elapsed_hist *)handle)->hist;
+
+	case PC_INTERVAL_HIST:
+		return &((struct perf_ctr_interval_hist *)handle)->hist;
+
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Bucket index for a sample.
+ *
+ * Small values map to a bucket each, larger ones to one of the
+ * sub-buckets of their power of two; this is a count-leading-zeros
+ * and a shift, cheap enough for interrupt context.
+ */
+static unsigned
+perf_hist_index(uint64_t value)
+{
+	if (value >= (1ULL << PERF_HIST_MAX_BITS))
+		return PERF_HIST_BUCKETS - 1;
+
+	uint32_t v = value;
+
+	if (v < (1 << (PERF_HIST_SUB_BITS + 1)))
+		return v;
+
+	unsigned msb = 31 - __builtin_clz(v);
+	unsigned shift = msb - PERF_HIST_SUB_BITS;
+
+	return ((shift + 1) << PERF_HIST_SUB_BITS) + ((v >> shift) & ((1 << PERF_HIST_SUB_BITS) - 1));
+}
+
+/**
+ * Largest value that falls into a bucket.
+ */
+static uint64_t
+perf_hist_upper(unsigned index)
+{
+	if (index < (1 << (PERF_HIST_SUB_BITS + 1)))
+		return index;
+
+	unsigned shift = (index >> PERF_HIST_SUB_BITS) - 1;
+	uint64_t lower = (uint64_t)((1 << PERF_HIST_SUB_BITS) + (index & ((1 << PERF_HIST_SUB_BITS) - 1))) << shift;
+
+	return lower + (1ULL << shift) - 1;
+}
+
+static void
+perf_hist_record(perf_counter_t handle, uint64_t value)
+{
+	struct perf_ctr_histogram *hist = perf_histogram(handle);
+
+	if (hist != NULL)
+		hist->bucket[perf_hist_index(value)]++;
+}
+
 
 perf_counter_t
 perf_alloc(enum perf_counter_type type, const char *name)
@@ -111,6 +203,14 @@ perf_alloc(enum perf_counter_type type, const char *name)
 		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_interval), 1);
 		break;
 
+	case PC_ELAPSED_HIST:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_elapsed_hist), 1);
+		break;
+
+	case PC_INTERVAL_HIST:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_interval_hist), 1);
+		break;
+
 	default:
 		break;
 	}
@@ -145,7 +245,8 @@ perf_count(perf_counter_t handle)
 		((struct perf_ctr_count *)handle)->event_count++;
 		break;
 
-	case PC_INTERVAL: {
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 		hrt_abstime now = hrt_absolute_time();
 
@@ -156,6 +257,7 @@ perf_count(perf_counter_t handle)
 		case 1:
 			pci->time_least = now - pci->time_last;
 			pci->time_most = now - pci->time_last;
+			perf_hist_record(handle, now - pci->time_last);
 			break;
 		default: {
 			hrt_abstime interval = now - pci->time_last;
@@ -163,6 +265,7 @@ perf_count(perf_counter_t handle)
 				pci->time_least = interval;
 			if (interval > pci->time_most)
 				pci->time_most = interval;
+			perf_hist_record(handle, interval);
 			break;
 		}
 		}
@@ -184,6 +287,7 @@ perf_begin(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_ELAPSED:
+	case PC_ELAPSED_HIST:
 		((struct perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
 		break;
 
@@ -192,6 +296,26 @@ perf_begin(perf_counter_t handle)
 	}
 }
 
+/**
+ * Record one elapsed time in a PC_ELAPSED or PC_ELAPSED_HIST counter.
+ */
+static void
+perf_elapsed_record(perf_counter_t handle, hrt_abstime elapsed)
+{
+	struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+
+	pce->event_count++;
+	pce->time_total += elapsed;
+
+	if ((pce->time_least > elapsed) || (pce->time_least == 0))
+		pce->time_least = elapsed;
+
+	if (pce->time_most < elapsed)
+		pce->time_most = elapsed;
+
+	perf_hist_record(handle, elapsed);
+}
+
 void
 perf_end(perf_counter_t handle)
 {
@@ -199,24 +323,34 @@ perf_end(perf_counter_t handle)
 		return;
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 
 			if (pce->time_start != 0) {
-				hrt_abstime elapsed = hrt_absolute_time() - pce->time_start;
+				perf_elapsed_record(handle, hrt_absolute_time() - pce->time_start);
+				pce->time_start = 0;
+			}
+		}
+		break;
 
-				pce->event_count++;
-				pce->time_total += elapsed;
+	default:
+		break;
+	}
+}
 
-				if ((pce->time_least > elapsed) || (pce->time_least == 0))
-					pce->time_least = elapsed;
+void
+perf_set(perf_counter_t handle, int64_t elapsed)
+{
+	if (handle == NULL)
+		return;
 
-				if (pce->time_most < elapsed)
-					pce->time_most = elapsed;
+	switch (handle->type) {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST:
+		if (elapsed >= 0)
+			perf_elapsed_record(handle, (hrt_abstime)elapsed);
 
-				pce->time_start = 0;
-			}
-		}
 		break;
 
 	default:
@@ -231,7 +365,8 @@ perf_cancel(perf_counter_t handle)
 		return;
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
 			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 
 			pce->time_start = 0;
@@ -256,7 +391,8 @@ perf_reset(perf_counter_t handle)
 		((struct perf_ctr_count *)handle)->event_count = 0;
 		break;
 
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
 		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 		pce->event_count = 0;
 		pce->time_start = 0;
@@ -266,7 +402,8 @@ perf_reset(perf_counter_t handle)
 		break;
 	}
 
-	case PC_INTERVAL: {
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 		pci->event_count = 0;
 		pci->time_event = 0;
@@ -277,6 +414,11 @@ perf_reset(perf_counter_t handle)
 		break;
 	}
 	}
+
+	struct perf_ctr_histogram *hist = perf_histogram(handle);
+
+	if (hist != NULL)
+		memset(hist, 0, sizeof(*hist));
 }
 
 void
@@ -292,7 +434,8 @@ perf_print_counter(perf_counter_t handle)
 		       ((struct perf_ctr_count *)handle)->event_count);
 		break;
 
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
 		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 
 		printf("%s: %llu events, %lluus elapsed, %llu avg, min %lluus max %lluus\n",
@@ -305,7 +448,8 @@ perf_print_counter(perf_counter_t handle)
 		break;
 	}
 
-	case PC_INTERVAL: {
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 
 		printf("%s: %llu events, %llu avg, min %lluus max %lluus\n",
@@ -320,6 +464,149 @@ perf_print_counter(perf_counter_t handle)
 	default:
 		break;
 	}
+
+	if ((perf_histogram(handle) != NULL) && (perf_event_count(handle) > 0)) {
+		printf("%s: p50 %lluus p90 %lluus p99 %lluus p99.9 %lluus\n",
+		       handle->name,
+		       perf_percentile(handle, 500),
+		       perf_percentile(handle, 900),
+		       perf_percentile(handle, 990),
+		       perf_percentile(handle, 999));
+	}
+}
+
+uint64_t
+perf_percentile(perf_counter_t handle, unsigned permille)
+{
+	if (handle == NULL)
+		return 0;
+
+	struct perf_ctr_histogram *hist = perf_histogram(handle);
+
+	if (hist == NULL)
+		return 0;
+
+	uint64_t samples = 0;
+
+	for (unsigned i = 0; i < PERF_HIST_BUCKETS; i++)
+		samples += hist->bucket[i];
+
+	if (samples == 0)
+		return 0;
+
+	/* rank of the requested sample, counting from 1 */
+	uint64_t rank = (samples * permille + 999) / 1000;
+
+	if (rank < 1)
+		rank = 1;
+
+	uint64_t most = (handle->type == PC_ELAPSED_HIST) ?
+			((struct perf_ctr_elapsed *)handle)->time_most :
+			((struct perf_ctr_interval *)handle)->time_most;
+	uint64_t seen = 0;
+
+	for (unsigned i = 0; i < PERF_HIST_BUCKETS; i++) {
+		seen += hist->bucket[i];
+
+		/* the last bucket is open ended */
+		if ((seen >= rank) && (i < PERF_HIST_BUCKETS - 1)) {
+			uint64_t upper = perf_hist_upper(i);
+			return (upper < most) ? upper : most;
+		}
+	}
+
+	return most;
+}
+
+/*
+ * Append to a line buffer, tracking the remaining space.
+ */
+static void
+perf_line_append(char *line, size_t size, size_t *len, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (*len < size) {
+		va_start(ap, fmt);
+		int n = vsnprintf(&line[*len], size - *len, fmt, ap);
+		va_end(ap);
+
+		if (n > 0)
+			*len += n;
+
+		if (*len > size - 1)
+			*len = size - 1;
+	}
+}
+
+int
+perf_dump_counter(perf_counter_t handle, int fd)
+{
+	char line[160];
+	size_t len = 0;
+
+	if (handle == NULL)
+		return 0;
+
+	/* the line is written in pieces, as the bucket list can be long */
+	perf_line_append(line, sizeof(line), &len, "%s,%u,%llu", handle->name, (unsigned)handle->type, perf_event_count(handle));
+
+	switch (handle->type) {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
+		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+		perf_line_append(line, sizeof(line), &len, ",%llu,%llu,%llu",
+				 pce->time_least,
+				 pce->time_most,
+				 (pce->event_count > 0) ? pce->time_total / pce->event_count : 0);
+		break;
+	}
+
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
+		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+		perf_line_append(line, sizeof(line), &len, ",%llu,%llu,%llu",
+				 pci->time_least,
+				 pci->time_most,
+				 (pci->event_count > 0) ? (pci->time_last - pci->time_first) / pci->event_count : 0);
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	struct perf_ctr_histogram *hist = perf_histogram(handle);
+
+	if (hist != NULL) {
+		perf_line_append(line, sizeof(line), &len, ",%llu,%llu,%llu,%llu",
+				 perf_percentile(handle, 500),
+				 perf_percentile(handle, 900),
+				 perf_percentile(handle, 990),
+				 perf_percentile(handle, 999));
+
+		for (unsigned i = 0; i < PERF_HIST_BUCKETS; i++) {
+			if (hist->bucket[i] == 0)
+				continue;
+
+			/* leave room for one more bucket, then write out */
+			if (len > (sizeof(line) - 32)) {
+				if (write(fd, line, len) != (ssize_t)len)
+					return -1;
+
+				len = 0;
+			}
+
+			perf_line_append(line, sizeof(line), &len, ",%llu:%lu", perf_hist_upper(i), (unsigned long)hist->bucket[i]);
+		}
+	}
+
+	perf_line_append(line, sizeof(line), &len, "\n");
+
+	if (write(fd, line, len) != (ssize_t)len)
+		return -1;
+
+	return 0;
 }
 
 uint64_t
@@ -332,12 +619,14 @@ perf_event_count(perf_counter_t handle)
 	case PC_COUNT:
 		return ((struct perf_ctr_count *)handle)->event_count;
 
-	case PC_ELAPSED: {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST: {
 		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
 		return pce->event_count;
 	}
 
-	case PC_INTERVAL: {
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 		return pci->event_count;
 	}
@@ -348,6 +637,44 @@ perf_event_count(perf_counter_t handle)
 	return 0;
 }
 
+uint64_t
+perf_time_total(perf_counter_t handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	switch (handle->type) {
+	case PC_ELAPSED:
+	case PC_ELAPSED_HIST:
+		return ((struct perf_ctr_elapsed *)handle)->time_total;
+
+	case PC_INTERVAL:
+	case PC_INTERVAL_HIST: {
+		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+		return pci->time_last - pci->time_first;
+	}
+
+	default:
+		break;
+	}
+	return 0;
+}
+
+perf_counter_t
+perf_find(const char *name)
+{
+	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+
+	while (handle != NULL) {
+		if (strcmp(handle->name, name) == 0)
+			return handle;
+
+		handle = (perf_counter_t)sq_next(&handle->link);
+	}
+
+	return NULL;
+}
+
 void
 perf_print_all(void)
 {
@@ -359,6 +686,27 @@ perf_print_all(void)
 	}
 }
 
+int
+perf_dump_all(int fd)
+{
+	char line[40];
+	int len = snprintf(line, sizeof(line), "# perf %llu\n", hrt_absolute_time());
+
+	if (write(fd, line, len) != len)
+		return -1;
+
+	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+
+	while (handle != NULL) {
+		if (perf_dump_counter(handle, fd))
+			return -1;
+
+		handle = (perf_counter_t)sq_next(&handle->link);
+	}
+
+	return 0;
+}
+
 void
 perf_reset_all(void)
 {
@@ -47,9 +47,24 @@
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
 	PC_ELAPSED,		/**< measure the time elapsed performing an event */
-	PC_INTERVAL		/**< measure the interval between instances of an event */
+	PC_INTERVAL,		/**< measure the interval between instances of an event */
+	PC_ELAPSED_HIST,	/**< PC_ELAPSED, also recording the distribution of elapsed times */
+	PC_INTERVAL_HIST	/**< PC_INTERVAL, also recording the distribution of intervals */
 };
 
+/**
+ * Histogram layout.
+ *
+ * Histogram counters sort each sample (in microseconds) into log-scaled
+ * buckets: values below 2^(PERF_HIST_SUB_BITS + 1) have a bucket each,
+ * above that every power of two is split into 2^PERF_HIST_SUB_BITS
+ * buckets, so the bucket width is at most 1/4 of the value. Samples of
+ * 2^24us (16.7s) and more are counted in the last bucket.
+ */
+#define PERF_HIST_SUB_BITS	2
+#define PERF_HIST_MAX_BITS	24
+#define PERF_HIST_BUCKETS	((PERF_HIST_MAX_BITS - PERF_HIST_SUB_BITS + 1) << PERF_HIST_SUB_BITS)
+
 struct perf_ctr_header;
 typedef struct perf_ctr_header	*perf_counter_t;
 
@@ -101,6 +116,18 @@ __EXPORT extern void		perf_begin(perf_counter_t handle);
  */
 __EXPORT extern void		perf_end(perf_counter_t handle);
 
+/**
+ * Record an elapsed time measured by the caller.
+ *
+ * This call applies to counters that operate over ranges of time; PC_ELAPSED etc.
+ * It is used where the start of the event is a timestamp carried in data,
+ * e.g. the sample time of a sensor reading. Negative times are ignored.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param elapsed		The elapsed time in microseconds.
+ */
+__EXPORT extern void		perf_set(perf_counter_t handle, int64_t elapsed);
+
 /**
  * Cancel a performance event.
  *
@@ -137,6 +164,46 @@ __EXPORT extern void		perf_print_all(void);
  */
 __EXPORT extern void		perf_reset_all(void);
 
+/**
+ * Return a percentile of a histogram counter.
+ *
+ * The result is the upper bound of the bucket holding the requested
+ * percentile, limited to the largest value recorded.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ * @param permille		The percentile in tenths of a percent, e.g. 990 for p99.
+ * @return			The percentile in microseconds, or zero if the counter
+ *				is not a histogram counter or has no samples.
+ */
+__EXPORT extern uint64_t	perf_percentile(perf_counter_t handle, unsigned permille);
+
+/**
+ * Write one performance counter to a file in machine-readable form.
+ *
+ * One line of comma separated fields is written per counter:
+ *
+ *   name,type,events[,least,most,average[,p50,p90,p99,p999,bucket:count...]]
+ *
+ * where type is the perf_counter_type value, times are in microseconds,
+ * and for histogram counters each nonzero bucket is given as the
+ * bucket's upper bound and its sample count.
+ *
+ * @param handle		The counter to write.
+ * @param fd			File to write to.
+ * @return			Zero on success, -1 on a write error.
+ */
+__EXPORT extern int		perf_dump_counter(perf_counter_t handle, int fd);
+
+/**
+ * Write all of the performance counters to a file in machine-readable form.
+ *
+ * The counters are preceded by a comment line carrying the current time.
+ *
+ * @param fd			File to write to.
+ * @return			Zero on success, -1 on a write error.
+ */
+__EXPORT extern int		perf_dump_all(int fd);
+
 /**
  * Return current event_count
  *
@@ -145,6 +212,25 @@ __EXPORT extern void		perf_reset_all(void);
  */
 __EXPORT extern uint64_t	perf_event_count(perf_counter_t handle);
 
+/**
+ * Return the time accumulated by a counter
+ *
+ * For PC_ELAPSED counters this is the total time elapsed in events, for
+ * PC_INTERVAL counters the time from the first to the last event.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ * @return			Accumulated time in microseconds, zero for PC_COUNT counters.
+ */
+__EXPORT extern uint64_t	perf_time_total(perf_counter_t handle);
+
+/**
+ * Find a counter by name
+ *
+ * @param name			The counter name passed to perf_alloc.
+ * @return			The first counter with this name, or NULL if there is none.
+ */
+__EXPORT extern perf_counter_t	perf_find(const char *name);
+
 __END_DECLS
 
 #endif
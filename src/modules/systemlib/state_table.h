@@ -33,13 +33,77 @@
 
 /**
  * @file state_table.h
- * 
+ *
  * Finite-State-Machine helper class for state table
+ *
+ * The transition table of a state machine is a [state][signal] array, so
+ * dispatching a signal is a single table lookup. Tables defined constexpr
+ * can be checked at compile time with StateTable::valid(). The most recent
+ * transitions are kept in a small ring for diagnostics.
  */
 
 #ifndef __SYSTEMLIB_STATE_TABLE_H
 #define __SYSTEMLIB_STATE_TABLE_H
 
+#include <stdint.h>
+
+/**
+ * Fixed size ring of the most recent state transitions.
+ *
+ * @param N		number of transitions kept
+ */
+template <unsigned N>
+class StateHistory
+{
+public:
+	struct Entry {
+		uint8_t state;		/**< state before the transition */
+		uint8_t signal;		/**< signal or requested state */
+		uint8_t nextState;	/**< state after the transition */
+	};
+
+	StateHistory() : _next(0), _count(0) {}
+
+	void record(unsigned state, unsigned signal, unsigned nextState) {
+		Entry &e = _entries[_next];
+		e.state = state;
+		e.signal = signal;
+		e.nextState = nextState;
+		_next = (_next + 1) % N;
+
+		if (_count < N) {
+			_count++;
+		}
+	}
+
+	/**
+	 * Number of transitions recorded, at most N
+	 */
+	unsigned count() const { return _count; }
+
+	/**
+	 * Recorded transition, 0 is the most recent one
+	 */
+	const Entry &get(unsigned i) const { return _entries[(_next + N - 1 - i) % N]; }
+
+private:
+	Entry		_entries[N];
+	unsigned	_next;
+	unsigned	_count;
+};
+
+/**
+ * Check at compile time that a [next state][current state] matrix of allowed
+ * transitions only enters state to from the states set in from_mask.
+ */
+template <unsigned S>
+constexpr bool state_reachable_only_from(const bool (&allowed)[S][S], unsigned to, uint32_t from_mask, unsigned from = 0)
+{
+	return from == S ||
+	       ((!allowed[to][from] || (from_mask & (1u << from))) &&
+		state_reachable_only_from(allowed, to, from_mask, from + 1));
+}
+
 class StateTable
 {
 public:
@@ -48,7 +112,10 @@ public:
 		Action action;
 		unsigned nextState;
 	};
-	
+
+	/* number of transitions kept for diagnostics */
+	static const unsigned HISTORY_SIZE = 8;
+
 	StateTable(Tran const *table, unsigned nStates, unsigned nSignals)
 	: myTable(table), myNsignals(nSignals), myNstates(nStates) {}
 	
@@ -56,20 +123,45 @@ public:
 	#define ACTION(_target) static_cast<StateTable::Action>(_target)
 
 	virtual ~StateTable() {}
+
+	/**
+	 * Check a constexpr transition table at compile time.
+	 *
+	 * Every state/signal pair must have an action (use NO_ACTION to ignore a
+	 * signal) and a valid next state. Use in a static_assert.
+	 */
+	template <unsigned S, unsigned E>
+	static constexpr bool valid(Tran const (&table)[S][E], unsigned i = 0) {
+		return i == S * E ||
+		       (table[i / E][i % E].action != nullptr &&
+			table[i / E][i % E].nextState < S &&
+			valid(table, i + 1));
+	}
 	
 	void dispatch(unsigned const sig) {
 		register Tran const *t = myTable + myState*myNsignals + sig;
 		(this->*(t->action))();
 
+		/* only record signals that did something */
+		if (t->nextState != myState || t->action != NO_ACTION) {
+			myHistory.record(myState, sig, t->nextState);
+		}
+
 		myState = t->nextState;
 	}
 	void doNothing() {}
+
+	/**
+	 * Most recent transitions, for diagnostics
+	 */
+	const StateHistory<HISTORY_SIZE> &history() const { return myHistory; }
 protected:
 	unsigned myState;
 private:
 	Tran const *myTable;
 	unsigned myNsignals;
 	unsigned myNstates;
+	StateHistory<HISTORY_SIZE> myHistory;
 };
 
-#endif
\ No newline at end of file
+#endif
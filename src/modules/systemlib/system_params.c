@@ -82,3 +82,15 @@ PARAM_DEFINE_INT32(SYS_USE_IO, 1);
 * @group System
 */
 PARAM_DEFINE_INT32(SYS_RESTART_TYPE, 2);
+
+/**
+* Start the system profiler on boot
+*
+* Set to 1 to publish and log CPU use, stack headroom and the multicopter
+* attitude loop timing (sysprof).
+*
+* @min 0
+* @max 1
+* @group System
+*/
+PARAM_DEFINE_INT32(SYS_PROFILE, 0);
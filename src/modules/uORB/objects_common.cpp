@@ -90,6 +90,9 @@ ORB_DEFINE(battery_status, struct battery_status_s);
 #include "topics/servorail_status.h"
 ORB_DEFINE(servorail_status, struct servorail_status_s);
 
+#include "topics/system_profile.h"
+ORB_DEFINE(system_profile, struct system_profile_s);
+
 #include "topics/system_power.h"
 ORB_DEFINE(system_power, struct system_power_s);
 
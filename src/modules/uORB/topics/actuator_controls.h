@@ -62,6 +62,7 @@
 
 struct actuator_controls_s {
 	uint64_t timestamp;
+	uint64_t timestamp_sample;	/**< timestamp of the sensor sample the controls were computed from, 0 if unknown */
 	float	control[NUM_ACTUATOR_CONTROLS];
 };
 
@@ -59,6 +59,7 @@
 
 struct actuator_outputs_s {
 	uint64_t timestamp;				/**< output timestamp in us since system boot */
+	uint64_t timestamp_sample;			/**< sensor sample the outputs derive from, see actuator_controls_s */
 	float	output[NUM_ACTUATOR_OUTPUTS];		/**< output data, in natural output units */
 	unsigned noutputs;					/**< valid outputs */
 };
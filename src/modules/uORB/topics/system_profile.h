@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file system_profile.h
+ *
+ * Definition of the system profile uORB topic.
+ */
+
+#ifndef SYSTEM_PROFILE_H_
+#define SYSTEM_PROFILE_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+#define SYSTEM_PROFILE_MAX_TASKS	32
+#define SYSTEM_PROFILE_MAX_COUNTERS	8
+#define SYSTEM_PROFILE_NAME_LEN		16
+
+/**
+ * CPU share and stack use of one task.
+ */
+struct system_profile_task_s {
+	char		name[SYSTEM_PROFILE_NAME_LEN];	/**< task name, truncated */
+	uint16_t	pid;
+	uint16_t	load;		/**< CPU share over the interval, in 1/10000 */
+	uint16_t	stack_size;	/**< stack size in bytes */
+	uint16_t	stack_free;	/**< stack never used so far in bytes */
+};
+
+/**
+ * Activity of one performance counter during the interval.
+ */
+struct system_profile_counter_s {
+	char		name[SYSTEM_PROFILE_NAME_LEN];	/**< counter name, truncated */
+	uint32_t	events;		/**< events during the interval */
+	uint32_t	average;	/**< average elapsed time or interval during the interval in microseconds */
+	uint32_t	p99;		/**< p99 since the last counter reset in microseconds, histogram counters only */
+};
+
+/**
+ * Periodic sample of the CPU use of all tasks and of selected performance counters.
+ */
+struct system_profile_s {
+	uint64_t	timestamp;	/**< microseconds since system boot */
+	uint32_t	interval;	/**< sampled interval in microseconds */
+	float		load;		/**< CPU load over the interval, 0..1 */
+	uint8_t		task_count;
+	uint8_t		counter_count;
+	struct system_profile_task_s	tasks[SYSTEM_PROFILE_MAX_TASKS];
+	struct system_profile_counter_s	counters[SYSTEM_PROFILE_MAX_COUNTERS];
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(system_profile);
+
+#endif
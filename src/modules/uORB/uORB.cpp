@@ -96,6 +96,8 @@ node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta)
 	return OK;
 }
 
+int	node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool advertiser);
+
 }
 
 /**
@@ -115,6 +117,11 @@ public:
 
 	static ssize_t		publish(const orb_metadata *meta, orb_advert_t handle, const void *data);
 
+	/**
+	 * Path of the node in the VFS.
+	 */
+	const char		*path() const { return _path; }
+
 protected:
 	virtual pollevent_t	poll_state(struct file *filp);
 	virtual void		poll_notify_one(struct pollfd *fds, pollevent_t events);
@@ -129,6 +136,7 @@ private:
 	};
 
 	const struct orb_metadata *_meta;	/**< object metadata information */
+	const char		*_path;		/**< permanent copy of the node path */
 	uint8_t			*_data;		/**< allocated object buffer */
 	hrt_abstime		_last_update;	/**< time the object was last updated */
 	volatile unsigned 	_generation;	/**< object generation count */
@@ -163,6 +171,7 @@ private:
 ORBDevNode::ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path) :
 	CDev(name, path),
 	_meta(meta),
+	_path(path),
 	_data(nullptr),
 	_last_update(0),
 	_generation(0),
@@ -523,6 +532,12 @@ ORBDevNode::update_deferred_trampoline(void *arg)
  *
  * Used primarily to create new objects via the ORBIOCCREATE
  * ioctl.
+ *
+ * The master also keeps a table of the nodes it created, keyed by the
+ * topic metadata, so that orb_advertise and orb_subscribe can find the
+ * node directly instead of formatting its path and looking it up in the
+ * VFS. The device nodes are still registered, so the shell and
+ * applications opening /obj paths keep working.
  */
 class ORBDevMaster : public device::CDev
 {
@@ -531,8 +546,44 @@ public:
 	~ORBDevMaster();
 
 	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	/**
+	 * Look up the node for a topic.
+	 *
+	 * Does not lock and may be called from any context.
+	 *
+	 * @param meta		The topic metadata.
+	 * @return		The node, or nullptr if it has not been created.
+	 */
+	ORBDevNode		*find_node(const struct orb_metadata *meta);
+
+	/**
+	 * Create the node for a topic unless it exists already.
+	 *
+	 * @param meta		The topic metadata.
+	 * @param node		If not nullptr, returns the node if it is in the table.
+	 * @return		OK if the node exists or was created, negative errno otherwise.
+	 */
+	int			advertise(const struct orb_metadata *meta, ORBDevNode **node);
+
 private:
+	/* power of two, larger than the number of topics in the system */
+	static const unsigned	_node_table_size = 128;
+
 	Flavor			_flavor;
+
+	/*
+	 * Open addressed hash table. Nodes are never destroyed, so entries are
+	 * only ever added: the node is stored before the key, so a reader
+	 * finding the key also finds the node without taking the lock.
+	 */
+	const struct orb_metadata * volatile _node_meta[_node_table_size];
+	ORBDevNode		*_node[_node_table_size];
+
+	static unsigned		node_hash(const struct orb_metadata *meta) {
+		/* metadata is word aligned, mix the remaining bits */
+		return (((uintptr_t)meta >> 2) * 2654435761u) >> 16;
+	}
 };
 
 ORBDevMaster::ORBDevMaster(Flavor f) :
@@ -543,55 +594,128 @@ ORBDevMaster::ORBDevMaster(Flavor f) :
 	// enable debug() calls
 	_debug_enabled = true;
 
+	memset((void *)_node_meta, 0, sizeof(_node_meta));
+	memset(_node, 0, sizeof(_node));
 }
 
 ORBDevMaster::~ORBDevMaster()
 {
 }
 
+ORBDevNode *
+ORBDevMaster::find_node(const struct orb_metadata *meta)
+{
+	unsigned index = node_hash(meta);
+
+	for (unsigned i = 0; i < _node_table_size; i++) {
+		index &= _node_table_size - 1;
+
+		const struct orb_metadata *m = _node_meta[index];
+
+		if (m == meta)
+			return _node[index];
+
+		if (m == nullptr)
+			break;
+
+		index++;
+	}
+
+	return nullptr;
+}
+
 int
-ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
+ORBDevMaster::advertise(const struct orb_metadata *meta, ORBDevNode **nodep)
 {
+	char nodepath[orb_maxpath];
+	ORBDevNode *node;
+	const char *objname;
+	const char *objpath;
 	int ret;
 
-	switch (cmd) {
-	case ORBIOCADVERTISE: {
-			const struct orb_metadata *meta = (const struct orb_metadata *)arg;
-			const char *objname;
-			char nodepath[orb_maxpath];
-			ORBDevNode *node;
+	lock();
 
-			/* construct a path to the node - this also checks the node name */
-			ret = node_mkpath(nodepath, _flavor, meta);
+	/* somebody else may have created it since the caller looked */
+	node = find_node(meta);
 
-			if (ret != OK)
-				return ret;
+	if (node != nullptr) {
+		ret = OK;
+		goto out;
+	}
+
+	/* construct a path to the node - this also checks the node name */
+	ret = node_mkpath(nodepath, _flavor, meta);
+
+	if (ret != OK)
+		goto out;
+
+	/* driver wants a permanent copy of the node name and path, so make one here */
+	objname = strdup(meta->o_name);
+	objpath = strdup(nodepath);
+
+	if ((objname == nullptr) || (objpath == nullptr)) {
+		free((void *)objname);
+		free((void *)objpath);
+		ret = -ENOMEM;
+		goto out;
+	}
 
-			/* driver wants a permanent copy of the node name, so make one here */
-			objname = strdup(meta->o_name);
+	/* construct the new node */
+	node = new ORBDevNode(meta, objname, objpath);
 
-			if (objname == nullptr)
-				return -ENOMEM;
+	/* if we didn't get a device, that's bad */
+	if (node == nullptr) {
+		free((void *)objname);
+		free((void *)objpath);
+		ret = -ENOMEM;
+		goto out;
+	}
 
-			/* construct the new node */
-			node = new ORBDevNode(meta, objname, nodepath);
+	/* initialise the node - this may fail if e.g. a node with this name already exists */
+	ret = node->init();
 
-			/* initialise the node - this may fail if e.g. a node with this name already exists */
-			if (node != nullptr)
-				ret = node->init();
+	/* if init failed, discard the node and its name */
+	if (ret != OK) {
+		delete node;
+		free((void *)objname);
+		free((void *)objpath);
+		node = nullptr;
+		goto out;
+	}
+
+	/* enter it into the table; if the table is full the node is only reachable by path */
+	{
+		unsigned index = node_hash(meta);
 
-			/* if we didn't get a device, that's bad */
-			if (node == nullptr)
-				return -ENOMEM;
+		for (unsigned i = 0; i < _node_table_size; i++) {
+			index &= _node_table_size - 1;
 
-			/* if init failed, discard the node and its name */
-			if (ret != OK) {
-				delete node;
-				free((void *)objname);
+			if (_node_meta[index] == nullptr) {
+				_node[index] = node;
+				__sync_synchronize();
+				_node_meta[index] = meta;
+				break;
 			}
 
-			return ret;
+			index++;
 		}
+	}
+
+out:
+	unlock();
+
+	if (nodep != nullptr)
+		*nodep = find_node(meta);
+
+	return ret;
+}
+
+int
+ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+	case ORBIOCADVERTISE:
+		return advertise((const struct orb_metadata *)arg, nullptr);
 
 	default:
 		/* give it to the superclass */
@@ -746,6 +870,79 @@ test()
 	return test_note("PASS");
 }
 
+/*
+ * Time advertise and subscribe through the node table against the
+ * path based open of the node, which is what they cost before.
+ */
+int
+bench()
+{
+	const unsigned rounds = 100;
+	struct orb_test t;
+	hrt_abstime start, direct, path;
+	int fd;
+
+	t.val = 0;
+
+	/* make sure the node exists, its creation is not part of the measurement */
+	if (orb_advertise(ORB_ID(orb_test), &t) == ERROR)
+		return test_fail("advertise failed: %d", errno);
+
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < rounds; i++) {
+		if (orb_advertise(ORB_ID(orb_test), &t) == ERROR)
+			return test_fail("advertise failed: %d", errno);
+	}
+
+	direct = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < rounds; i++) {
+		orb_advert_t advertiser;
+
+		fd = node_open(PUBSUB, ORB_ID(orb_test), &t, true);
+
+		if (fd < 0)
+			return test_fail("open failed: %d", errno);
+
+		ioctl(fd, ORBIOCGADVERTISER, (unsigned long)&advertiser);
+		close(fd);
+		orb_publish(ORB_ID(orb_test), advertiser, &t);
+	}
+
+	path = hrt_absolute_time() - start;
+	test_note("advertise: %llu us direct, %llu us by path (%u calls)", direct, path, rounds);
+
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < rounds; i++) {
+		fd = orb_subscribe(ORB_ID(orb_test));
+
+		if (fd < 0)
+			return test_fail("subscribe failed: %d", errno);
+
+		orb_unsubscribe(fd);
+	}
+
+	direct = hrt_absolute_time() - start;
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < rounds; i++) {
+		fd = node_open(PUBSUB, ORB_ID(orb_test), nullptr, false);
+
+		if (fd < 0)
+			return test_fail("open failed: %d", errno);
+
+		orb_unsubscribe(fd);
+	}
+
+	path = hrt_absolute_time() - start;
+	test_note("subscribe+unsubscribe: %llu us direct, %llu us by path (%u calls)", direct, path, rounds);
+
+	return OK;
+}
+
 int
 info()
 {
@@ -801,13 +998,19 @@ uorb_main(int argc, char *argv[])
 	if (!strcmp(argv[1], "test"))
 		return test();
 
+	/*
+	 * Time advertise/subscribe.
+	 */
+	if (!strcmp(argv[1], "bench"))
+		return bench();
+
 	/*
 	 * Print driver information.
 	 */
 	if (!strcmp(argv[1], "status"))
 		return info();
 
-	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'status'\n");
+	fprintf(stderr, "unrecognised command, try 'start', 'test', 'bench' or 'status'\n");
 	return -EINVAL;
 }
 
@@ -925,6 +1128,29 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 	return fd;
 }
 
+/**
+ * Find the node for a topic in the master's table, creating the node
+ * if it does not exist yet.
+ *
+ * @return		The node, or nullptr if the caller has to fall back
+ *			to opening the node by path.
+ */
+ORBDevNode *
+node_get(const struct orb_metadata *meta)
+{
+	ORBDevNode *node;
+
+	if (g_dev == nullptr)
+		return nullptr;
+
+	node = g_dev->find_node(meta);
+
+	if (node == nullptr)
+		g_dev->advertise(meta, &node);
+
+	return node;
+}
+
 } // namespace
 
 orb_advert_t
@@ -933,16 +1159,36 @@ orb_advertise(const struct orb_metadata *meta, const void *data)
 	int result, fd;
 	orb_advert_t advertiser;
 
-	/* open the node as an advertiser */
-	fd = node_open(PUBSUB, meta, data, true);
-	if (fd == ERROR)
+	if (nullptr == meta) {
+		errno = ENOENT;
 		return ERROR;
+	}
 
-	/* get the advertiser handle and close the node */
-	result = ioctl(fd, ORBIOCGADVERTISER, (unsigned long)&advertiser);
-	close(fd);
-	if (result == ERROR)
+	if (nullptr == data) {
+		errno = EINVAL;
 		return ERROR;
+	}
+
+	/* the advertiser handle is the node itself, no need to open it */
+	ORBDevNode *node = node_get(meta);
+
+	if (node != nullptr) {
+		advertiser = (orb_advert_t)node;
+
+	} else {
+		/* open the node as an advertiser */
+		fd = node_open(PUBSUB, meta, data, true);
+
+		if (fd == ERROR)
+			return ERROR;
+
+		/* get the advertiser handle and close the node */
+		result = ioctl(fd, ORBIOCGADVERTISER, (unsigned long)&advertiser);
+		close(fd);
+
+		if (result == ERROR)
+			return ERROR;
+	}
 
 	/* the advertiser must perform an initial publish to initialise the object */
 	result= orb_publish(meta, advertiser, data);
@@ -955,6 +1201,25 @@ orb_advertise(const struct orb_metadata *meta, const void *data)
 int
 orb_subscribe(const struct orb_metadata *meta)
 {
+	if (nullptr == meta) {
+		errno = ENOENT;
+		return ERROR;
+	}
+
+	/* open the node by its stored path, skips formatting it and advertising through the master */
+	ORBDevNode *node = node_get(meta);
+
+	if (node != nullptr) {
+		int fd = open(node->path(), O_RDONLY);
+
+		if (fd < 0) {
+			errno = EIO;
+			return ERROR;
+		}
+
+		return fd;
+	}
+
 	return node_open(PUBSUB, meta, nullptr, false);
 }
 
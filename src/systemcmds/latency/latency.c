@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file latency.c
+ *
+ * Report the latency from the sensor sample to the actuator controls
+ * and outputs computed from it.
+ *
+ * The attitude estimators stamp vehicle_attitude with the time of the
+ * sensor_combined sample they used, the attitude controllers carry it
+ * on as actuator_controls.timestamp_sample and the output drivers as
+ * actuator_outputs.timestamp_sample. The difference to the publication
+ * time of each topic is collected in a histogram counter.
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <systemlib/err.h>
+#include <systemlib/perf_counter.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/actuator_controls.h>
+#include <uORB/topics/actuator_outputs.h>
+
+/* anything older is a stale or bogus stamp, not a latency */
+#define LATENCY_MAX_US		1000000
+
+__EXPORT int latency_main(int argc, char *argv[]);
+
+static void
+usage(void)
+{
+	errx(1, "usage: latency [-n samples] [-o output group 0..3]");
+}
+
+/*
+ * Record the age of the sample a publication was computed from, once per sample.
+ */
+static void
+record(perf_counter_t pc, uint64_t timestamp, uint64_t timestamp_sample, uint64_t *last_sample)
+{
+	if ((timestamp_sample == 0) || (timestamp_sample == *last_sample) || (timestamp_sample > timestamp))
+		return;
+
+	*last_sample = timestamp_sample;
+
+	if (timestamp - timestamp_sample < LATENCY_MAX_US)
+		perf_set(pc, timestamp - timestamp_sample);
+}
+
+static void
+report(const char *title, perf_counter_t pc)
+{
+	uint64_t events = perf_event_count(pc);
+
+	if (events == 0) {
+		printf("%-20s no samples\n", title);
+		return;
+	}
+
+	printf("%-20s %6llu samples, mean %4llu us, p50 %4llu us, p90 %4llu us, p99 %4llu us, p99.9 %4llu us\n",
+	       title, events, perf_time_total(pc) / events,
+	       perf_percentile(pc, 500), perf_percentile(pc, 900),
+	       perf_percentile(pc, 990), perf_percentile(pc, 999));
+}
+
+int
+latency_main(int argc, char *argv[])
+{
+	static const struct orb_metadata *output_topics[] = {
+		ORB_ID(actuator_outputs_0),
+		ORB_ID(actuator_outputs_1),
+		ORB_ID(actuator_outputs_2),
+		ORB_ID(actuator_outputs_3)
+	};
+
+	unsigned samples = 1000;
+	unsigned group = 0;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:o:")) != EOF) {
+		switch (ch) {
+		case 'n':
+			samples = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'o':
+			group = strtoul(optarg, NULL, 0);
+			break;
+
+		default:
+			usage();
+		}
+	}
+
+	if ((samples < 1) || (group > 3))
+		usage();
+
+	int controls_sub = orb_subscribe(ORB_ID(actuator_controls_0));
+	int outputs_sub = orb_subscribe(output_topics[group]);
+
+	if ((controls_sub < 0) || (outputs_sub < 0))
+		errx(1, "subscribe failed");
+
+	perf_counter_t pc_controls = perf_alloc(PC_ELAPSED_HIST, "latency sensor->controls");
+	perf_counter_t pc_outputs = perf_alloc(PC_ELAPSED_HIST, "latency sensor->outputs");
+
+	if ((pc_controls == NULL) || (pc_outputs == NULL))
+		errx(1, "no memory for counters");
+
+	struct pollfd fds[2];
+	fds[0].fd = controls_sub;
+	fds[0].events = POLLIN;
+	fds[1].fd = outputs_sub;
+	fds[1].events = POLLIN;
+
+	uint64_t last_controls_sample = 0;
+	uint64_t last_outputs_sample = 0;
+	unsigned timeouts = 0;
+
+	warnx("collecting %u samples of actuator_outputs_%u", samples, group);
+
+	while ((perf_event_count(pc_outputs) < samples) && (timeouts < 3)) {
+		int ret = poll(fds, 2, 1000);
+
+		if (ret < 0) {
+			warn("poll error");
+			break;
+		}
+
+		if (ret == 0) {
+			timeouts++;
+			continue;
+		}
+
+		timeouts = 0;
+
+		if (fds[0].revents & POLLIN) {
+			struct actuator_controls_s controls;
+			orb_copy(ORB_ID(actuator_controls_0), controls_sub, &controls);
+			record(pc_controls, controls.timestamp, controls.timestamp_sample, &last_controls_sample);
+		}
+
+		if (fds[1].revents & POLLIN) {
+			struct actuator_outputs_s outputs;
+			orb_copy(output_topics[group], outputs_sub, &outputs);
+			record(pc_outputs, outputs.timestamp, outputs.timestamp_sample, &last_outputs_sample);
+		}
+	}
+
+	if (timeouts > 0)
+		warnx("no updates for 3 s, stopped");
+
+	report("sensor -> controls", pc_controls);
+	report("sensor -> outputs", pc_outputs);
+
+	perf_free(pc_controls);
+	perf_free(pc_outputs);
+	orb_unsubscribe(controls_sub);
+	orb_unsubscribe(outputs_sub);
+
+	return 0;
+}
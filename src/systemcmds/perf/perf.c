@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
 
 #include "systemlib/perf_counter.h"
 
@@ -69,7 +70,22 @@ int perf_main(int argc, char *argv[])
 			perf_reset_all();
 			return 0;
 		}
-		printf("Usage: perf <reset>\n");
+
+		if ((strcmp(argv[1], "dump") == 0) && (argc > 2)) {
+			/* append, so that successive dumps collect in one file */
+			int fd = open(argv[2], O_WRONLY | O_CREAT | O_APPEND, 0666);
+
+			if (fd < 0) {
+				printf("failed opening %s\n", argv[2]);
+				return -1;
+			}
+
+			int ret = perf_dump_all(fd);
+			close(fd);
+			return ret;
+		}
+
+		printf("Usage: perf <reset|dump <file>>\n");
 		return -1;
 	}
 
@@ -35,6 +35,9 @@
  * @file test_mathlib.cpp
  *
  * Mathlib test
+ *
+ * For regression tracking with variance and baselines, use the host
+ * benchmark in Tools/tests-host/mathlib_bench.cpp instead.
  */
 
 #include <stdio.h>